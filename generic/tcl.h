@@ -1240,6 +1240,7 @@ typedef void (Tcl_ScaleTimeProc) (Tcl_Time *timebuf, void *clientData);
  */
 
 #define TCL_CHANNEL_VERSION_5	((Tcl_ChannelTypeVersion) 0x5)
+#define TCL_CHANNEL_VERSION_6	((Tcl_ChannelTypeVersion) 0x6)
 
 /*
  * TIP #218: Channel Actions, Ids for Tcl_DriverThreadActionProc.
@@ -1285,6 +1286,18 @@ typedef void	(Tcl_DriverThreadActionProc) (void *instanceData,
  */
 typedef int	(Tcl_DriverTruncateProc) (void *instanceData,
 			long long length);
+/*
+ * Scatter/gather output (TCL_CHANNEL_VERSION_6). Each Tcl_ChannelOutputVec
+ * describes one run of bytes; the runs are written in order as though by a
+ * single call of the outputProc.
+ */
+typedef struct Tcl_ChannelOutputVec {
+    const char *buf;		/* First byte of the run. */
+    int toWrite;		/* Number of bytes in the run. */
+} Tcl_ChannelOutputVec;
+typedef int	(Tcl_DriverOutputVProc) (void *instanceData,
+			const Tcl_ChannelOutputVec *vecs, int numVecs,
+			int *errorCodePtr);
 
 /*
  * struct Tcl_ChannelType:
@@ -1348,6 +1361,10 @@ typedef struct Tcl_ChannelType {
 				/* Function to call to truncate the underlying
 				 * file to a particular length. May be NULL if
 				 * the channel does not support truncation. */
+    Tcl_DriverOutputVProc *outputVProc;
+				/* Function to call to write several runs of
+				 * bytes at once. Only present in version 6
+				 * channel types, and may be NULL there. */
 } Tcl_ChannelType;
 
 /*
@@ -1115,6 +1115,17 @@ Tcl_CreateInterp(void)
     Tcl_CreateObjCommand(interp, "::tcl::unsupported::corotype",
             CoroTypeObjCmd, NULL, NULL);
 
+    /* Persistent bytecode cache */
+    TclInitByteCodeCache(interp);
+
+    /* Precompilation of procedure bodies when idle */
+    Tcl_CreateObjCommand(interp, "::tcl::unsupported::precompile",
+	    TclPrecompileObjCmd, NULL, NULL);
+
+    /* Servicing of queued events in batches */
+    Tcl_CreateObjCommand(interp, "::tcl::unsupported::eventbatch",
+	    TclEventBatchObjCmd, NULL, NULL);
+
     /* Export unsupported commands */
     nsPtr = Tcl_FindNamespace(interp, "::tcl::unsupported", NULL, 0);
     if (nsPtr) {
@@ -1836,6 +1847,8 @@ DeleteInterpProc(
     }
     Tcl_MutexUnlock(&cancelLock);
 
+    TclFinalizeByteCodeCache(interp);
+
     /*
      * Shut down all limit handler callback scripts that call back into this
      * interpreter. Then eliminate all limit handlers for this interpreter.
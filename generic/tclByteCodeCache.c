@@ -0,0 +1,1708 @@
+/*
+ * tclByteCodeCache.c --
+ *
+ *	This file contains the persistent bytecode cache. When it is enabled,
+ *	the bytecode compiled for procedure bodies is written to a directory,
+ *	one file per body, and later processes (or interpreters) that need to
+ *	compile the same body in the same circumstances load it back instead
+ *	of running the compiler. Loading happens when the procedure is first
+ *	called, exactly where it would otherwise have been compiled.
+ *
+ *	A cache entry holds everything the compiler leaves in a CompileEnv:
+ *	the instructions, the literals, the exception ranges, the command
+ *	location map, the AuxData items, the compiled locals that were added
+ *	to the procedure and the per-word line information of TIP #280. It is
+ *	keyed by the source of the body, the namespace it is compiled in and
+ *	the procedure's arguments.
+ *
+ *	What the compiler produces also depends on the commands it compiled
+ *	inline, which another process may have renamed, shadowed, traced or
+ *	reconfigured; the compile epochs that track this within a process
+ *	mean nothing across processes. So an entry also records each command
+ *	name the compiler looked up to compile a command inline and what it
+ *	found, and is only used where the same names still lead to the same
+ *	commands. Loaded bytecode is then checked to refer only to literals,
+ *	locals, AuxData and code that it actually has, before it is run.
+ *
+ * Copyright © 2026 The Tcl Core Team.
+ *
+ * See the file "license.terms" for information on usage and redistribution of
+ * this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ */
+
+#include "tclInt.h"
+#include "tclCompile.h"
+
+/*
+ * The state of the cache of an interpreter, hanging off Interp.
+ */
+
+typedef struct ByteCodeCache {
+    Tcl_Obj *dirPtr;		/* The directory holding the cache entries.
+				 * May be inside a mounted zipfs archive, in
+				 * which case the cache is only read. */
+    size_t hits;		/* Number of bodies loaded from the cache. */
+    size_t misses;		/* Number of bodies looked up in the cache but
+				 * not found there. */
+    size_t stores;		/* Number of cache entries written. */
+} ByteCodeCache;
+
+/*
+ * Bump this whenever the layout of the cache entries changes. The layout of
+ * the bytecode itself is covered by the Tcl patchlevel being in the key.
+ */
+
+#define CACHE_FORMAT_VERSION	2
+
+/*
+ * Bodies shorter than this are not worth caching: compiling them is quicker
+ * than opening and reading a file.
+ */
+
+#define CACHE_MIN_SOURCE_BYTES	256
+
+/*
+ * Bits of the compilation flags that are part of the key.
+ */
+
+#define CACHE_KEY_COMPACT	0x1	/* INST_START_CMD may be left out. */
+#define CACHE_KEY_OPTIMIZE	0x2	/* The bytecode optimizer is in use. */
+#define CACHE_KEY_NO_INLINE	0x4	/* Commands are not compiled inline. */
+
+/*
+ * Cursor used to decode a cache entry. Reading past the end sets the
+ * overrun flag and yields zeroes, so that decoding can check for truncated
+ * or damaged entries once per section.
+ */
+
+typedef struct {
+    const unsigned char *p;	/* Next byte to read. */
+    const unsigned char *end;	/* End of the data. */
+    int overrun;		/* Set when the data ended too soon. */
+} Reader;
+
+/*
+ * Serialization functions for the AuxData types generated by the compiler,
+ * looked up by name. Bytecode using any other AuxData type is not cached.
+ */
+
+typedef void (AuxDataSaveProc)(void *clientData, Tcl_DString *dsPtr);
+typedef void *(AuxDataLoadProc)(Reader *rdPtr);
+
+typedef struct {
+    const char *name;		/* Name of the AuxData type. */
+    AuxDataSaveProc *saveProc;	/* Appends the serialized AuxData. */
+    AuxDataLoadProc *loadProc;	/* Rebuilds the AuxData; NULL on failure. */
+} AuxDataSerializer;
+
+/*
+ * Prototypes for procedures defined later in this file:
+ */
+
+static int		BuildKey(Interp *iPtr, Proc *procPtr,
+			    Namespace *nsPtr, const char *source,
+			    size_t numBytes, Tcl_DString *keyPtr);
+static int		ByteCodeCacheObjCmd(void *clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const objv[]);
+static int		CacheUsable(Interp *iPtr, Namespace *nsPtr);
+static int		CheckDependencies(Interp *iPtr, Reader *rdPtr);
+static Tcl_Obj *	DescribeCommand(Interp *iPtr, Command *cmdPtr);
+static void		DiscardCompiledLocals(Proc *procPtr);
+static Tcl_Obj *	EntryPath(ByteCodeCache *bccPtr,
+			    Tcl_DString *keyPtr);
+static int		GetInt(Reader *rdPtr);
+static Tcl_WideUInt	HashBytes(const char *bytes, size_t length);
+static const char *	GetString(Reader *rdPtr, size_t *lengthPtr);
+static const AuxDataSerializer *FindSerializer(const char *name);
+static void *		LoadDictUpdateInfo(Reader *rdPtr);
+static void *		LoadForeachInfo(Reader *rdPtr);
+static void *		LoadJumptableInfo(Reader *rdPtr);
+static int		LoadEntry(CompileEnv *envPtr, Reader *rdPtr);
+static void		PutInt(Tcl_DString *dsPtr, int value);
+static void		PutString(Tcl_DString *dsPtr, const char *bytes,
+			    size_t length);
+static int		ReadEntry(Tcl_Obj *pathPtr, Tcl_DString *dsPtr);
+static void		SaveDictUpdateInfo(void *clientData,
+			    Tcl_DString *dsPtr);
+static int		SaveEntry(Interp *iPtr, CompileEnv *envPtr,
+			    Tcl_DString *dsPtr);
+static void		SaveForeachInfo(void *clientData,
+			    Tcl_DString *dsPtr);
+static void		SaveJumptableInfo(void *clientData,
+			    Tcl_DString *dsPtr);
+static void		SetCacheDir(Interp *iPtr, Tcl_Obj *dirPtr);
+static int		VerifyByteCode(CompileEnv *envPtr);
+static void		WriteEntry(ByteCodeCache *bccPtr,
+			    Tcl_Obj *pathPtr, Tcl_DString *dsPtr);
+
+static const AuxDataSerializer auxDataSerializers[] = {
+    {"ForeachInfo",	SaveForeachInfo,	LoadForeachInfo},
+    {"NewForeachInfo",	SaveForeachInfo,	LoadForeachInfo},
+    {"DictUpdateInfo",	SaveDictUpdateInfo,	LoadDictUpdateInfo},
+    {"JumptableInfo",	SaveJumptableInfo,	LoadJumptableInfo},
+    {NULL, NULL, NULL}
+};
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclInitByteCodeCache --
+ *
+ *	Creates the [::tcl::unsupported::bytecodecache] command and enables
+ *	the cache if the TCL_BYTECODE_CACHE environment variable names a
+ *	directory.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	See above.
+ *
+ *----------------------------------------------------------------------
+ */
+
+void
+TclInitByteCodeCache(
+    Tcl_Interp *interp)
+{
+    Interp *iPtr = (Interp *) interp;
+    Tcl_DString ds;
+    const char *dir;
+
+    iPtr->byteCodeCache = NULL;
+    Tcl_CreateObjCommand(interp, "::tcl::unsupported::bytecodecache",
+	    ByteCodeCacheObjCmd, NULL, NULL);
+
+    dir = TclGetEnv("TCL_BYTECODE_CACHE", &ds);
+    if (dir != NULL) {
+	if (*dir != '\0') {
+	    SetCacheDir(iPtr, Tcl_NewStringObj(dir, TCL_INDEX_NONE));
+	}
+	Tcl_DStringFree(&ds);
+    }
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclFinalizeByteCodeCache --
+ *
+ *	Releases the cache state of an interpreter that is being deleted.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	Frees memory.
+ *
+ *----------------------------------------------------------------------
+ */
+
+void
+TclFinalizeByteCodeCache(
+    Tcl_Interp *interp)
+{
+    SetCacheDir((Interp *) interp, NULL);
+}
+
+static void
+SetCacheDir(
+    Interp *iPtr,
+    Tcl_Obj *dirPtr)		/* New directory, or NULL to disable. */
+{
+    ByteCodeCache *bccPtr = (ByteCodeCache *)iPtr->byteCodeCache;
+
+    if (dirPtr == NULL) {
+	if (bccPtr != NULL) {
+	    Tcl_DecrRefCount(bccPtr->dirPtr);
+	    Tcl_Free(bccPtr);
+	    iPtr->byteCodeCache = NULL;
+	}
+	return;
+    }
+    Tcl_IncrRefCount(dirPtr);
+    if (bccPtr == NULL) {
+	bccPtr = (ByteCodeCache *)Tcl_Alloc(sizeof(ByteCodeCache));
+	bccPtr->hits = bccPtr->misses = bccPtr->stores = 0;
+	iPtr->byteCodeCache = bccPtr;
+    } else {
+	Tcl_DecrRefCount(bccPtr->dirPtr);
+    }
+    bccPtr->dirPtr = dirPtr;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * ByteCodeCacheObjCmd --
+ *
+ *	Implementation of the "::tcl::unsupported::bytecodecache" command,
+ *	which configures the bytecode cache of the current interpreter:
+ *
+ *	    bytecodecache dir ?directory?
+ *		Returns the cache directory, or sets it. The empty string
+ *		means that the cache is not in use.
+ *	    bytecodecache stats
+ *		Returns a dictionary with the number of hits, misses and
+ *		stores since the cache was enabled.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+ByteCodeCacheObjCmd(
+    TCL_UNUSED(void *),
+    Tcl_Interp *interp,		/* Current interpreter. */
+    int objc,			/* Number of arguments. */
+    Tcl_Obj *const objv[])	/* Argument objects. */
+{
+    static const char *const options[] = {
+	"dir", "stats", NULL
+    };
+    enum Options {
+	BCC_DIR, BCC_STATS
+    } idx;
+    Interp *iPtr = (Interp *) interp;
+    ByteCodeCache *bccPtr = (ByteCodeCache *)iPtr->byteCodeCache;
+    Tcl_Obj *resultPtr;
+
+    if (objc < 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "option ?arg?");
+	return TCL_ERROR;
+    }
+    if (Tcl_GetIndexFromObj(interp, objv[1], options, "option", 0,
+	    &idx) != TCL_OK) {
+	return TCL_ERROR;
+    }
+
+    switch (idx) {
+    case BCC_DIR:
+	if (objc > 3) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "?directory?");
+	    return TCL_ERROR;
+	}
+	if (objc == 3) {
+	    if (Tcl_IsSafe(interp)) {
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(
+			"can't use the bytecode cache in a safe interpreter",
+			-1));
+		Tcl_SetErrorCode(interp, "TCL", "SAFE", "BYTECODECACHE",
+			NULL);
+		return TCL_ERROR;
+	    }
+	    SetCacheDir(iPtr, (TclGetString(objv[2])[0] == '\0')
+		    ? NULL : objv[2]);
+	    bccPtr = (ByteCodeCache *)iPtr->byteCodeCache;
+	}
+	if (bccPtr != NULL) {
+	    Tcl_SetObjResult(interp, bccPtr->dirPtr);
+	}
+	return TCL_OK;
+    case BCC_STATS:
+	if (objc != 2) {
+	    Tcl_WrongNumArgs(interp, 2, objv, NULL);
+	    return TCL_ERROR;
+	}
+	TclNewObj(resultPtr);
+	Tcl_DictObjPut(NULL, resultPtr, Tcl_NewStringObj("hits", -1),
+		Tcl_NewWideIntObj(bccPtr ? bccPtr->hits : 0));
+	Tcl_DictObjPut(NULL, resultPtr, Tcl_NewStringObj("misses", -1),
+		Tcl_NewWideIntObj(bccPtr ? bccPtr->misses : 0));
+	Tcl_DictObjPut(NULL, resultPtr, Tcl_NewStringObj("stores", -1),
+		Tcl_NewWideIntObj(bccPtr ? bccPtr->stores : 0));
+	Tcl_SetObjResult(interp, resultPtr);
+	return TCL_OK;
+    }
+    return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclLoadCachedByteCode --
+ *
+ *	Called by TclProcCompileProc, in place of compiling the body of a
+ *	procedure, to try to get its bytecode from the cache instead. The
+ *	caller must have set up the interpreter as for compiling the body:
+ *	compiledProcPtr and invokeCmdFramePtr set, the compiled locals
+ *	trimmed to the arguments and a frame for the procedure's namespace
+ *	pushed.
+ *
+ * Results:
+ *	TCL_OK if the body has been given its bytecode from the cache, or
+ *	TCL_ERROR if it still needs to be compiled. No error message is left
+ *	in the interpreter: a missing or unusable cache entry is not an
+ *	error.
+ *
+ * Side effects:
+ *	Reads from the filesystem. May add compiled locals to the procedure
+ *	and literals to the interpreter's literal table.
+ *
+ *----------------------------------------------------------------------
+ */
+
+int
+TclLoadCachedByteCode(
+    Tcl_Interp *interp,		/* Interpreter compiling the body. */
+    Tcl_Obj *bodyPtr)		/* Body of the procedure. */
+{
+    Interp *iPtr = (Interp *) interp;
+    ByteCodeCache *bccPtr = (ByteCodeCache *)iPtr->byteCodeCache;
+    Proc *procPtr = iPtr->compiledProcPtr;
+    Namespace *nsPtr = iPtr->varFramePtr->nsPtr;
+    Tcl_DString key, entry;
+    Tcl_Obj *pathPtr;
+    CompileEnv compEnv;
+    Reader rd;
+    const char *source;
+    size_t numBytes, keyLength, entryLength;
+    Tcl_WideUInt checksum;
+    int result = TCL_ERROR;
+
+    if ((bccPtr == NULL) || !CacheUsable(iPtr, nsPtr)
+	    || (TclContinuationsGet(bodyPtr) != NULL)) {
+	return TCL_ERROR;
+    }
+    source = Tcl_GetStringFromObj(bodyPtr, &numBytes);
+    if (numBytes < CACHE_MIN_SOURCE_BYTES) {
+	return TCL_ERROR;
+    }
+    if (BuildKey(iPtr, procPtr, nsPtr, source, numBytes, &key) != TCL_OK) {
+	return TCL_ERROR;
+    }
+
+    pathPtr = EntryPath(bccPtr, &key);
+    Tcl_IncrRefCount(pathPtr);
+    if (ReadEntry(pathPtr, &entry) != TCL_OK) {
+	bccPtr->misses++;
+	goto done;
+    }
+
+    /*
+     * The entry starts with the full key, which protects against hash
+     * collisions as well as against entries for other versions of Tcl.
+     */
+
+    keyLength = Tcl_DStringLength(&key);
+    entryLength = Tcl_DStringLength(&entry);
+    if ((entryLength < keyLength + 8)
+	    || memcmp(Tcl_DStringValue(&entry), Tcl_DStringValue(&key),
+		    keyLength)) {
+	bccPtr->misses++;
+	goto freeEntry;
+    }
+
+    /*
+     * And it ends with a checksum of everything else, so that damaged
+     * entries never get to be executed.
+     */
+
+    entryLength -= 8;
+    rd.p = (unsigned char *) Tcl_DStringValue(&entry) + entryLength;
+    rd.end = rd.p + 8;
+    rd.overrun = 0;
+    checksum = ((Tcl_WideUInt) (unsigned) GetInt(&rd) << 32);
+    checksum |= (unsigned) GetInt(&rd);
+    if (checksum != HashBytes(Tcl_DStringValue(&entry), entryLength)) {
+	bccPtr->misses++;
+	goto freeEntry;
+    }
+    rd.p = (unsigned char *) Tcl_DStringValue(&entry) + keyLength;
+    rd.end = (unsigned char *) Tcl_DStringValue(&entry) + entryLength;
+
+    /*
+     * Set up a compilation environment just as TclSetByteCodeFromAny would,
+     * fill it from the cache entry instead of compiling, and hand it on to
+     * become the ByteCode.
+     */
+
+    TclInitCompileEnv(interp, &compEnv, source, numBytes,
+	    iPtr->invokeCmdFramePtr, iPtr->invokeWord);
+    if (LoadEntry(&compEnv, &rd) == TCL_OK) {
+	(void) TclInitByteCodeObj(bodyPtr, &tclByteCodeType, &compEnv);
+	bccPtr->hits++;
+	result = TCL_OK;
+    } else {
+	bccPtr->misses++;
+	DiscardCompiledLocals(procPtr);
+	iPtr->compiledProcPtr = procPtr;
+    }
+    TclFreeCompileEnv(&compEnv);
+
+  freeEntry:
+    Tcl_DStringFree(&entry);
+  done:
+    Tcl_DecrRefCount(pathPtr);
+    Tcl_DStringFree(&key);
+    return result;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclStoreCachedByteCode --
+ *
+ *	Compilation hook (see TclSetByteCodeFromAny) that writes the freshly
+ *	compiled body of a procedure to the cache. The clientData is the body
+ *	object.
+ *
+ * Results:
+ *	Always TCL_OK: failing to write to the cache must not make the
+ *	compilation fail.
+ *
+ * Side effects:
+ *	Writes to the filesystem.
+ *
+ *----------------------------------------------------------------------
+ */
+
+int
+TclStoreCachedByteCode(
+    Tcl_Interp *interp,		/* Interpreter compiling the body. */
+    CompileEnv *envPtr,		/* The result of the compilation. */
+    void *clientData)		/* The body of the procedure. */
+{
+    Interp *iPtr = (Interp *) interp;
+    ByteCodeCache *bccPtr = (ByteCodeCache *)iPtr->byteCodeCache;
+    Namespace *nsPtr = iPtr->varFramePtr->nsPtr;
+    Tcl_DString entry;
+    Tcl_Obj *pathPtr;
+
+    if ((bccPtr == NULL) || (envPtr->procPtr == NULL)
+	    || (envPtr->numSrcBytes < CACHE_MIN_SOURCE_BYTES)
+	    || !CacheUsable(iPtr, nsPtr)
+	    || (TclContinuationsGet((Tcl_Obj *)clientData) != NULL)) {
+	return TCL_OK;
+    }
+    if (BuildKey(iPtr, envPtr->procPtr, nsPtr, envPtr->source,
+	    envPtr->numSrcBytes, &entry) != TCL_OK) {
+	return TCL_OK;
+    }
+    pathPtr = EntryPath(bccPtr, &entry);
+    Tcl_IncrRefCount(pathPtr);
+    if (SaveEntry(iPtr, envPtr, &entry) == TCL_OK) {
+	Tcl_WideUInt checksum = HashBytes(Tcl_DStringValue(&entry),
+		Tcl_DStringLength(&entry));
+
+	PutInt(&entry, (int) (checksum >> 32));
+	PutInt(&entry, (int) checksum);
+	WriteEntry(bccPtr, pathPtr, &entry);
+    }
+    Tcl_DecrRefCount(pathPtr);
+    Tcl_DStringFree(&entry);
+    return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclNoteCompiledCommand --
+ *
+ *	Called by the compiler whenever it looks up a command name to compile
+ *	a command inline, with what it found (possibly NULL). When the code
+ *	being compiled is a procedure body that may go to the cache, this is
+ *	recorded in the compilation environment, to be saved with it.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	May allocate the dictionary of dependencies of envPtr.
+ *
+ *----------------------------------------------------------------------
+ */
+
+void
+TclNoteCompiledCommand(
+    CompileEnv *envPtr,		/* The compilation environment. */
+    Tcl_Obj *nameObj,		/* The command name, as looked up. */
+    Command *cmdPtr)		/* The command found, or NULL. */
+{
+    Interp *iPtr = envPtr->iPtr;
+
+    if ((iPtr->byteCodeCache == NULL) || (envPtr->procPtr == NULL)) {
+	return;
+    }
+    if (envPtr->cmdDepsPtr == NULL) {
+	TclNewObj(envPtr->cmdDepsPtr);
+	Tcl_IncrRefCount(envPtr->cmdDepsPtr);
+    }
+    Tcl_DictObjPut(NULL, envPtr->cmdDepsPtr, nameObj,
+	    DescribeCommand(iPtr, cmdPtr));
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * DescribeCommand --
+ *
+ *	Returns a new object describing a command as far as the compiler is
+ *	concerned: its full name and, if the compiler may compile it inline,
+ *	its compile procedure and, for an ensemble, its configuration. The
+ *	empty string stands for no command. Compile procedures are told apart
+ *	by their address relative to the compiler's own, which only changes
+ *	with the build of Tcl.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static Tcl_Obj *
+DescribeCommand(
+    Interp *iPtr,
+    Command *cmdPtr)
+{
+    Tcl_Obj *descPtr, *namePtr, *objPtr;
+    Tcl_Command token = (Tcl_Command) cmdPtr;
+    int flags;
+
+    TclNewObj(descPtr);
+    if (cmdPtr == NULL) {
+	return descPtr;
+    }
+    TclNewObj(namePtr);
+    Tcl_GetCommandFullName((Tcl_Interp *) iPtr, token, namePtr);
+    Tcl_ListObjAppendElement(NULL, descPtr, namePtr);
+    if ((cmdPtr->compileProc == NULL)
+	    || (cmdPtr->nsPtr->flags & NS_SUPPRESS_COMPILATION)
+	    || (cmdPtr->flags & CMD_HAS_EXEC_TRACES)) {
+	return descPtr;
+    }
+    Tcl_ListObjAppendElement(NULL, descPtr, Tcl_NewWideIntObj((Tcl_WideInt)
+	    ((size_t) cmdPtr->compileProc - (size_t) TclCompileScript)));
+    Tcl_ListObjAppendElement(NULL, descPtr,
+	    Tcl_NewWideIntObj(cmdPtr->flags & CMD_COMPILES_EXPANDED));
+    if (cmdPtr->compileProc == TclCompileEnsemble) {
+	Tcl_GetEnsembleMappingDict(NULL, token, &objPtr);
+	Tcl_ListObjAppendElement(NULL, descPtr,
+		objPtr ? objPtr : Tcl_NewObj());
+	Tcl_GetEnsembleSubcommandList(NULL, token, &objPtr);
+	Tcl_ListObjAppendElement(NULL, descPtr,
+		objPtr ? objPtr : Tcl_NewObj());
+	Tcl_GetEnsembleParameterList(NULL, token, &objPtr);
+	Tcl_ListObjAppendElement(NULL, descPtr,
+		objPtr ? objPtr : Tcl_NewObj());
+	Tcl_GetEnsembleFlags(NULL, token, &flags);
+	Tcl_ListObjAppendElement(NULL, descPtr, Tcl_NewWideIntObj(flags));
+    }
+    return descPtr;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * CheckDependencies --
+ *
+ *	Reads the commands a cache entry depends on and checks that their
+ *	names, looked up in the current namespace, still lead to the same
+ *	commands as when the entry was written.
+ *
+ * Results:
+ *	TCL_OK if they all do, TCL_ERROR if not or if the entry is damaged.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+CheckDependencies(
+    Interp *iPtr,
+    Reader *rdPtr)
+{
+    int i, count = GetInt(rdPtr), match = 1;
+
+    for (i = 0; i < count && match && !rdPtr->overrun; i++) {
+	const char *name, *desc;
+	size_t nameLength, descLength, length;
+	Tcl_Obj *nameObj, *descPtr;
+
+	name = GetString(rdPtr, &nameLength);
+	desc = GetString(rdPtr, &descLength);
+	if (rdPtr->overrun) {
+	    break;
+	}
+	nameObj = Tcl_NewStringObj(name, nameLength);
+	Tcl_IncrRefCount(nameObj);
+	descPtr = DescribeCommand(iPtr, (Command *)
+		Tcl_GetCommandFromObj((Tcl_Interp *) iPtr, nameObj));
+	Tcl_IncrRefCount(descPtr);
+	name = Tcl_GetStringFromObj(descPtr, &length);
+	match = (length == descLength) && !memcmp(name, desc, length);
+	Tcl_DecrRefCount(descPtr);
+	Tcl_DecrRefCount(nameObj);
+    }
+    return (match && !rdPtr->overrun) ? TCL_OK : TCL_ERROR;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * CacheUsable --
+ *
+ *	Decides whether the cache can be used for code compiled in a
+ *	namespace. It can't when variable resolvers are involved, as those
+ *	attach state to the compiled locals, nor in safe interpreters, which
+ *	have no business with the filesystem.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+CacheUsable(
+    Interp *iPtr,
+    Namespace *nsPtr)
+{
+    return !Tcl_IsSafe((Tcl_Interp *) iPtr) && (iPtr->resolverPtr == NULL)
+	    && (nsPtr->compiledVarResProc == NULL);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * DiscardCompiledLocals --
+ *
+ *	Removes the compiled locals that a failed attempt to load a body
+ *	added to its procedure, so that the compiler starts from the
+ *	arguments again.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+DiscardCompiledLocals(
+    Proc *procPtr)
+{
+    CompiledLocal *localPtr = procPtr->firstLocalPtr, *lastPtr = NULL;
+    int i;
+
+    for (i = 0; i < procPtr->numArgs; i++) {
+	lastPtr = localPtr;
+	localPtr = localPtr->nextPtr;
+    }
+    if (lastPtr != NULL) {
+	lastPtr->nextPtr = NULL;
+    } else {
+	procPtr->firstLocalPtr = NULL;
+    }
+    procPtr->lastLocalPtr = lastPtr;
+    while (localPtr != NULL) {
+	CompiledLocal *toFree = localPtr;
+
+	localPtr = localPtr->nextPtr;
+	Tcl_Free(toFree);
+    }
+    procPtr->numCompiledLocals = procPtr->numArgs;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * BuildKey --
+ *
+ *	Initializes a DString with the key of the cache entry for a body: the
+ *	cache format, the Tcl version and instruction set, the flags of the
+ *	interpreter that affect compilation, the namespace, the arguments of
+ *	the procedure and the source itself.
+ *
+ * Results:
+ *	TCL_OK, or TCL_ERROR if the arguments of the procedure have resolver
+ *	information, in which case the DString is left free.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+BuildKey(
+    Interp *iPtr,
+    Proc *procPtr,
+    Namespace *nsPtr,
+    const char *source,
+    size_t numBytes,
+    Tcl_DString *keyPtr)
+{
+    CompiledLocal *localPtr;
+    int i, flags = 0;
+
+    if (Tcl_GetParent((Tcl_Interp *) iPtr) == NULL
+	    && !Tcl_LimitTypeEnabled((Tcl_Interp *) iPtr,
+		    TCL_LIMIT_COMMANDS|TCL_LIMIT_TIME)) {
+	flags |= CACHE_KEY_COMPACT;
+    }
+    if (iPtr->optimizer != NULL) {
+	flags |= CACHE_KEY_OPTIMIZE;
+    }
+    if (iPtr->flags & DONT_COMPILE_CMDS_INLINE) {
+	flags |= CACHE_KEY_NO_INLINE;
+    }
+
+    Tcl_DStringInit(keyPtr);
+    PutString(keyPtr, "TclByteCodeCache", 16);
+    PutInt(keyPtr, CACHE_FORMAT_VERSION);
+    PutString(keyPtr, TCL_PATCH_LEVEL, strlen(TCL_PATCH_LEVEL));
+    PutInt(keyPtr, LAST_INST_OPCODE);
+    PutInt(keyPtr, flags);
+    PutString(keyPtr, nsPtr->fullName, strlen(nsPtr->fullName));
+
+    PutInt(keyPtr, procPtr->numArgs);
+    for (i = 0, localPtr = procPtr->firstLocalPtr; i < procPtr->numArgs;
+	    i++, localPtr = localPtr->nextPtr) {
+	if (localPtr->resolveInfo != NULL) {
+	    Tcl_DStringFree(keyPtr);
+	    return TCL_ERROR;
+	}
+	PutInt(keyPtr, localPtr->flags);
+	PutString(keyPtr, localPtr->name, localPtr->nameLength);
+    }
+
+    PutString(keyPtr, source, numBytes);
+    return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * EntryPath --
+ *
+ *	Returns the (unshared) path of the cache entry for a key: the hash of
+ *	the key, in hex, in the cache directory.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static Tcl_Obj *
+EntryPath(
+    ByteCodeCache *bccPtr,
+    Tcl_DString *keyPtr)
+{
+    char name[32];
+    Tcl_Obj *nameObj, *pathPtr;
+
+    snprintf(name, sizeof(name), "%016" TCL_LL_MODIFIER "x.tclbc",
+	    HashBytes(Tcl_DStringValue(keyPtr), Tcl_DStringLength(keyPtr)));
+    nameObj = Tcl_NewStringObj(name, TCL_INDEX_NONE);
+    Tcl_IncrRefCount(nameObj);
+    pathPtr = Tcl_FSJoinToPath(bccPtr->dirPtr, 1, &nameObj);
+    Tcl_DecrRefCount(nameObj);
+    return pathPtr;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * HashBytes --
+ *
+ *	The 64-bit FNV-1a hash of a byte string. Used both to name the cache
+ *	entries and as the checksum that ends each of them.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static Tcl_WideUInt
+HashBytes(
+    const char *bytes,
+    size_t length)
+{
+    const unsigned char *p = (const unsigned char *) bytes;
+    const unsigned char *end = p + length;
+    Tcl_WideUInt hash = 0xCBF29CE484222325ULL;
+
+    for (; p < end; p++) {
+	hash = (hash ^ *p) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * ReadEntry, WriteEntry --
+ *
+ *	Read a whole cache entry into an (uninitialized) DString, and write
+ *	one. Entries are written to a temporary file that is then renamed, so
+ *	that readers never see a partly written entry.
+ *
+ * Results:
+ *	ReadEntry returns TCL_OK if the entry could be read, and otherwise
+ *	TCL_ERROR, leaving the DString free.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+ReadEntry(
+    Tcl_Obj *pathPtr,
+    Tcl_DString *dsPtr)
+{
+    Tcl_Channel chan;
+    char buffer[4096];
+    size_t count;
+
+    chan = Tcl_FSOpenFileChannel(NULL, pathPtr, "rb", 0);
+    if (chan == NULL) {
+	return TCL_ERROR;
+    }
+    Tcl_DStringInit(dsPtr);
+    while ((count = Tcl_Read(chan, buffer, sizeof(buffer))) > 0
+	    && count != TCL_IO_FAILURE) {
+	Tcl_DStringAppend(dsPtr, buffer, count);
+    }
+    if ((Tcl_Close(NULL, chan) != TCL_OK) || (count == TCL_IO_FAILURE)) {
+	Tcl_DStringFree(dsPtr);
+	return TCL_ERROR;
+    }
+    return TCL_OK;
+}
+
+static void
+WriteEntry(
+    ByteCodeCache *bccPtr,
+    Tcl_Obj *pathPtr,
+    Tcl_DString *dsPtr)
+{
+    Tcl_Channel chan;
+    Tcl_Obj *tmpPathPtr;
+    size_t length = Tcl_DStringLength(dsPtr);
+    int ok;
+
+    TclNewObj(tmpPathPtr);
+    Tcl_IncrRefCount(tmpPathPtr);
+    chan = TclpOpenTemporaryFile(bccPtr->dirPtr, NULL, NULL, tmpPathPtr);
+    if (chan == NULL) {
+	Tcl_DecrRefCount(tmpPathPtr);
+	return;
+    }
+    Tcl_SetChannelOption(NULL, chan, "-translation", "binary");
+    ok = (Tcl_Write(chan, Tcl_DStringValue(dsPtr), length) == length);
+    ok = (Tcl_Close(NULL, chan) == TCL_OK) && ok;
+    if (ok && (Tcl_FSRenameFile(tmpPathPtr, pathPtr) == TCL_OK)) {
+	bccPtr->stores++;
+    } else {
+	Tcl_FSDeleteFile(tmpPathPtr);
+    }
+    Tcl_DecrRefCount(tmpPathPtr);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * SaveEntry --
+ *
+ *	Appends the contents of a compilation environment to a cache entry.
+ *	This mirrors what TclInitByteCode takes from the CompileEnv, and what
+ *	the disassembler shows of the resulting ByteCode.
+ *
+ * Results:
+ *	TCL_OK, or TCL_ERROR if the compiled code uses something that can't
+ *	be saved.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+SaveEntry(
+    Interp *iPtr,
+    CompileEnv *envPtr,
+    Tcl_DString *dsPtr)
+{
+    Proc *procPtr = envPtr->procPtr;
+    ExtCmdLoc *eclPtr = envPtr->extCmdMapPtr;
+    CompiledLocal *localPtr;
+    const char *bytes;
+    size_t length;
+    int i, j, done;
+
+    /*
+     * The commands the code depends on come first, so that an entry that
+     * doesn't fit can be rejected before anything is built from it.
+     */
+
+    if (envPtr->cmdDepsPtr == NULL) {
+	PutInt(dsPtr, 0);
+    } else {
+	Tcl_DictSearch search;
+	Tcl_Obj *namePtr, *descPtr;
+
+	Tcl_DictObjSize(NULL, envPtr->cmdDepsPtr, &i);
+	PutInt(dsPtr, i);
+	Tcl_DictObjFirst(NULL, envPtr->cmdDepsPtr, &search, &namePtr,
+		&descPtr, &done);
+	for (; !done; Tcl_DictObjNext(&search, &namePtr, &descPtr, &done)) {
+	    bytes = Tcl_GetStringFromObj(namePtr, &length);
+	    PutString(dsPtr, bytes, length);
+	    bytes = Tcl_GetStringFromObj(descPtr, &length);
+	    PutString(dsPtr, bytes, length);
+	}
+	Tcl_DictObjDone(&search);
+    }
+
+    PutInt(dsPtr, envPtr->numCommands);
+    PutInt(dsPtr, envPtr->maxStackDepth);
+    PutInt(dsPtr, envPtr->maxExceptDepth);
+
+    PutString(dsPtr, (char *) envPtr->codeStart,
+	    envPtr->codeNext - envPtr->codeStart);
+
+    /*
+     * For each literal, how it is shared through the interpreter's literal
+     * table, so that it can be registered again in the same way.
+     */
+
+    PutInt(dsPtr, envPtr->literalArrayNext);
+    for (i = 0; i < envPtr->literalArrayNext; i++) {
+	Tcl_Obj *objPtr = envPtr->literalArrayPtr[i].objPtr;
+
+	bytes = Tcl_GetStringFromObj(objPtr, &length);
+	PutInt(dsPtr, TclGetLiteralFlags(iPtr, objPtr));
+	PutString(dsPtr, bytes, length);
+    }
+
+    PutInt(dsPtr, envPtr->exceptArrayNext);
+    for (i = 0; i < envPtr->exceptArrayNext; i++) {
+	ExceptionRange *rangePtr = &envPtr->exceptArrayPtr[i];
+
+	PutInt(dsPtr, rangePtr->type);
+	PutInt(dsPtr, rangePtr->nestingLevel);
+	PutInt(dsPtr, rangePtr->codeOffset);
+	PutInt(dsPtr, rangePtr->numCodeBytes);
+	PutInt(dsPtr, rangePtr->breakOffset);
+	PutInt(dsPtr, rangePtr->continueOffset);
+	PutInt(dsPtr, rangePtr->catchOffset);
+    }
+
+    for (i = 0; i < envPtr->numCommands; i++) {
+	CmdLocation *locPtr = &envPtr->cmdMapPtr[i];
+
+	PutInt(dsPtr, locPtr->codeOffset);
+	PutInt(dsPtr, locPtr->numCodeBytes);
+	PutInt(dsPtr, locPtr->srcOffset);
+	PutInt(dsPtr, locPtr->numSrcBytes);
+    }
+
+    PutInt(dsPtr, envPtr->auxDataArrayNext);
+    for (i = 0; i < envPtr->auxDataArrayNext; i++) {
+	AuxData *auxPtr = &envPtr->auxDataArrayPtr[i];
+	const AuxDataSerializer *serPtr = FindSerializer(auxPtr->type->name);
+
+	if (serPtr == NULL || TclGetAuxDataType(serPtr->name) != auxPtr->type) {
+	    return TCL_ERROR;
+	}
+	PutString(dsPtr, serPtr->name, strlen(serPtr->name));
+	serPtr->saveProc(auxPtr->clientData, dsPtr);
+    }
+
+    /*
+     * The compiled locals the compiler added after the arguments.
+     */
+
+    PutInt(dsPtr, procPtr->numCompiledLocals - procPtr->numArgs);
+    for (i = 0, localPtr = procPtr->firstLocalPtr; localPtr != NULL;
+	    i++, localPtr = localPtr->nextPtr) {
+	if (localPtr->resolveInfo != NULL) {
+	    return TCL_ERROR;
+	}
+	if (i >= procPtr->numArgs) {
+	    PutInt(dsPtr, localPtr->flags);
+	    PutString(dsPtr, localPtr->name, localPtr->nameLength);
+	}
+    }
+
+    /*
+     * TIP #280 line information, relative to the first line of the body so
+     * that moving the procedure around in its file doesn't invalidate it.
+     */
+
+    PutInt(dsPtr, eclPtr->nuloc);
+    for (i = 0; i < eclPtr->nuloc; i++) {
+	ECL *locPtr = &eclPtr->loc[i];
+
+	PutInt(dsPtr, (int) locPtr->srcOffset);
+	PutInt(dsPtr, locPtr->nline);
+	for (j = 0; j < locPtr->nline; j++) {
+	    PutInt(dsPtr, (locPtr->line[j] < 0) ? -1
+		    : locPtr->line[j] - eclPtr->start);
+	}
+    }
+    return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * LoadEntry --
+ *
+ *	Fills a freshly initialized compilation environment from the part of
+ *	a cache entry written by SaveEntry, after checking that the commands
+ *	it depends on are still the same, and verifies the result.
+ *
+ * Results:
+ *	TCL_OK, or TCL_ERROR if the entry is damaged or doesn't fit. The
+ *	environment must be freed with TclFreeCompileEnv either way.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+LoadEntry(
+    CompileEnv *envPtr,
+    Reader *rdPtr)
+{
+    Proc *procPtr = envPtr->procPtr;
+    ExtCmdLoc *eclPtr = envPtr->extCmdMapPtr;
+    const char *bytes;
+    size_t length;
+    int i, j, count;
+
+    if (CheckDependencies(envPtr->iPtr, rdPtr) != TCL_OK) {
+	return TCL_ERROR;
+    }
+
+    envPtr->numCommands = GetInt(rdPtr);
+    envPtr->maxStackDepth = GetInt(rdPtr);
+    envPtr->maxExceptDepth = GetInt(rdPtr);
+
+    bytes = GetString(rdPtr, &length);
+    if (rdPtr->overrun || length == 0) {
+	return TCL_ERROR;
+    }
+    while ((size_t) (envPtr->codeEnd - envPtr->codeStart) < length) {
+	TclExpandCodeArray(envPtr);
+    }
+    memcpy(envPtr->codeStart, bytes, length);
+    envPtr->codeNext = envPtr->codeStart + length;
+
+    count = GetInt(rdPtr);
+    for (i = 0; i < count && !rdPtr->overrun; i++) {
+	int flags = GetInt(rdPtr);
+
+	bytes = GetString(rdPtr, &length);
+	if (rdPtr->overrun) {
+	    break;
+	}
+	if (flags < 0) {
+	    Tcl_Obj *objPtr = Tcl_NewStringObj(bytes, length);
+
+	    TclAddLiteralObj(envPtr, objPtr, NULL);
+	} else if (TclRegisterLiteral(envPtr, bytes, length,
+		flags & LITERAL_CMD_NAME) != i) {
+	    return TCL_ERROR;
+	}
+    }
+
+    count = GetInt(rdPtr);
+    for (i = 0; i < count && !rdPtr->overrun; i++) {
+	ExceptionRange *rangePtr;
+	int range = TclCreateExceptRange((ExceptionRangeType) GetInt(rdPtr),
+		envPtr);
+
+	/*
+	 * Creating a range may move the array, so look it up afterwards.
+	 */
+
+	rangePtr = &envPtr->exceptArrayPtr[range];
+	rangePtr->nestingLevel = GetInt(rdPtr);
+	rangePtr->codeOffset = GetInt(rdPtr);
+	rangePtr->numCodeBytes = GetInt(rdPtr);
+	rangePtr->breakOffset = GetInt(rdPtr);
+	rangePtr->continueOffset = GetInt(rdPtr);
+	rangePtr->catchOffset = GetInt(rdPtr);
+    }
+
+    if (rdPtr->overrun || envPtr->numCommands < 0
+	    || (size_t) envPtr->numCommands * 16 > (size_t) (rdPtr->end - rdPtr->p)) {
+	return TCL_ERROR;
+    }
+    if (envPtr->numCommands > envPtr->cmdMapEnd) {
+	envPtr->cmdMapPtr = (CmdLocation *)Tcl_Alloc(
+		envPtr->numCommands * sizeof(CmdLocation));
+	envPtr->cmdMapEnd = envPtr->numCommands;
+	envPtr->mallocedCmdMap = 1;
+    }
+    for (i = 0; i < envPtr->numCommands; i++) {
+	CmdLocation *locPtr = &envPtr->cmdMapPtr[i];
+
+	locPtr->codeOffset = GetInt(rdPtr);
+	locPtr->numCodeBytes = GetInt(rdPtr);
+	locPtr->srcOffset = GetInt(rdPtr);
+	locPtr->numSrcBytes = GetInt(rdPtr);
+    }
+
+    count = GetInt(rdPtr);
+    for (i = 0; i < count && !rdPtr->overrun; i++) {
+	const AuxDataSerializer *serPtr;
+	void *clientData;
+
+	bytes = GetString(rdPtr, &length);
+	if (rdPtr->overrun) {
+	    break;
+	}
+	for (serPtr = auxDataSerializers; serPtr->name != NULL; serPtr++) {
+	    if (strlen(serPtr->name) == length
+		    && !memcmp(serPtr->name, bytes, length)) {
+		break;
+	    }
+	}
+	if (serPtr->name == NULL
+		|| (clientData = serPtr->loadProc(rdPtr)) == NULL) {
+	    return TCL_ERROR;
+	}
+	TclCreateAuxData(clientData, TclGetAuxDataType(serPtr->name), envPtr);
+    }
+
+    /*
+     * Recreate the compiled locals; these must come out in the same slots.
+     */
+
+    count = GetInt(rdPtr);
+    if (rdPtr->overrun || procPtr->numCompiledLocals != procPtr->numArgs) {
+	return TCL_ERROR;
+    }
+    for (i = 0; i < count; i++) {
+	int flags = GetInt(rdPtr);
+
+	bytes = GetString(rdPtr, &length);
+	if (rdPtr->overrun || TclFindCompiledLocal(
+		(flags & VAR_TEMPORARY) ? NULL : bytes, length, 1,
+		envPtr) != procPtr->numArgs + i) {
+	    return TCL_ERROR;
+	}
+	procPtr->lastLocalPtr->flags = flags;
+    }
+
+    count = GetInt(rdPtr);
+    if (rdPtr->overrun || count < 0
+	    || (size_t) count * 8 > (size_t) (rdPtr->end - rdPtr->p)) {
+	return TCL_ERROR;
+    }
+    if (count > 0) {
+	eclPtr->loc = (ECL *)Tcl_Alloc(count * sizeof(ECL));
+	eclPtr->nloc = count;
+    }
+    for (i = 0; i < count; i++) {
+	ECL *locPtr = &eclPtr->loc[i];
+	int nline;
+
+	locPtr->srcOffset = GetInt(rdPtr);
+	nline = GetInt(rdPtr);
+	if (rdPtr->overrun || nline < 0
+		|| (size_t) nline * 4 > (size_t) (rdPtr->end - rdPtr->p)) {
+	    return TCL_ERROR;
+	}
+	locPtr->nline = nline;
+	locPtr->line = (int *)Tcl_Alloc((nline ? nline : 1) * sizeof(int));
+	locPtr->next = NULL;
+	eclPtr->nuloc++;
+	for (j = 0; j < nline; j++) {
+	    int line = GetInt(rdPtr);
+
+	    locPtr->line[j] = (line < 0) ? -1 : line + eclPtr->start;
+	}
+    }
+
+    if (rdPtr->overrun || rdPtr->p != rdPtr->end) {
+	return TCL_ERROR;
+    }
+    return VerifyByteCode(envPtr);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * VerifyByteCode --
+ *
+ *	Checks that bytecode loaded from a cache entry is well formed for the
+ *	compilation environment it was loaded into: every instruction is
+ *	known and complete, its operands index literals, compiled locals and
+ *	AuxData items that exist (of the right type), jumps land at the start
+ *	of instructions, and the exception ranges, the command map and the
+ *	AuxData items stay within the code, the source and the locals.
+ *
+ * Results:
+ *	TCL_OK if so, TCL_ERROR if not.
+ *
+ *----------------------------------------------------------------------
+ */
+
+#define IsInstStart(target) \
+    ((target) >= 0 && (target) < (Tcl_WideInt) codeLength && starts[(target)])
+
+static int
+VerifyByteCode(
+    CompileEnv *envPtr)
+{
+    const unsigned char *code = envPtr->codeStart;
+    size_t codeLength = envPtr->codeNext - envPtr->codeStart, pc;
+    unsigned numLocals = envPtr->procPtr->numCompiledLocals;
+    unsigned numLiterals = envPtr->literalArrayNext;
+    unsigned numAux = envPtr->auxDataArrayNext;
+    const AuxDataType *jumptableType = TclGetAuxDataType("JumptableInfo");
+    const AuxDataType *foreachType = TclGetAuxDataType("ForeachInfo");
+    const AuxDataType *newForeachType = TclGetAuxDataType("NewForeachInfo");
+    const AuxDataType *dictUpdateType = TclGetAuxDataType("DictUpdateInfo");
+    char *starts;		/* Whether each byte starts an instruction. */
+    int i, j, ok = 0;
+
+    if (envPtr->maxStackDepth < 0 || envPtr->maxExceptDepth < -1) {
+	return TCL_ERROR;
+    }
+
+    starts = (char *)Tcl_Alloc(codeLength);
+    memset(starts, 0, codeLength);
+    for (pc = 0; pc < codeLength; pc += tclInstructionTable[code[pc]].numBytes) {
+	if ((code[pc] >= LAST_INST_OPCODE)
+		|| (pc + tclInstructionTable[code[pc]].numBytes > codeLength)) {
+	    goto done;
+	}
+	starts[pc] = 1;
+    }
+
+    for (pc = 0; pc < codeLength; pc += tclInstructionTable[code[pc]].numBytes) {
+	const InstructionDesc *instPtr = &tclInstructionTable[code[pc]];
+	const unsigned char *opndPtr = code + pc + 1;
+	Tcl_WideInt target;
+	unsigned index;
+
+	for (i = 0; i < instPtr->numOperands; i++) {
+	    switch (instPtr->opTypes[i]) {
+	    case OPERAND_NONE:
+		break;
+	    case OPERAND_INT1:
+	    case OPERAND_UINT1:
+		opndPtr += 1;
+		break;
+	    case OPERAND_INT4:
+	    case OPERAND_UINT4:
+	    case OPERAND_IDX4:
+		opndPtr += 4;
+		break;
+	    case OPERAND_SCLS1:
+		if (TclGetUInt1AtPtr(opndPtr) > STR_CLASS_UNICODE) {
+		    goto done;
+		}
+		opndPtr += 1;
+		break;
+	    case OPERAND_LVT1:
+	    case OPERAND_LVT4:
+		if (instPtr->opTypes[i] == OPERAND_LVT1) {
+		    index = TclGetUInt1AtPtr(opndPtr);
+		    opndPtr += 1;
+		} else {
+		    index = TclGetUInt4AtPtr(opndPtr);
+		    opndPtr += 4;
+		}
+		if (index >= numLocals) {
+		    goto done;
+		}
+		break;
+	    case OPERAND_LIT1:
+	    case OPERAND_LIT4:
+		if (instPtr->opTypes[i] == OPERAND_LIT1) {
+		    index = TclGetUInt1AtPtr(opndPtr);
+		    opndPtr += 1;
+		} else {
+		    index = TclGetUInt4AtPtr(opndPtr);
+		    opndPtr += 4;
+		}
+		if (index >= numLiterals) {
+		    goto done;
+		}
+		break;
+	    case OPERAND_OFFSET1:
+	    case OPERAND_OFFSET4:
+		if (instPtr->opTypes[i] == OPERAND_OFFSET1) {
+		    target = (Tcl_WideInt) pc + TclGetInt1AtPtr(opndPtr);
+		    opndPtr += 1;
+		} else {
+		    target = (Tcl_WideInt) pc + TclGetInt4AtPtr(opndPtr);
+		    opndPtr += 4;
+		}
+		if (!IsInstStart(target)) {
+		    goto done;
+		}
+		break;
+	    case OPERAND_AUX4: {
+		const AuxData *auxPtr;
+
+		index = TclGetUInt4AtPtr(opndPtr);
+		opndPtr += 4;
+		if (index >= numAux) {
+		    goto done;
+		}
+		auxPtr = &envPtr->auxDataArrayPtr[index];
+		switch (code[pc]) {
+		case INST_JUMP_TABLE: {
+		    JumptableInfo *jtPtr = (JumptableInfo *)auxPtr->clientData;
+		    Tcl_HashEntry *hPtr;
+		    Tcl_HashSearch search;
+
+		    if (auxPtr->type != jumptableType) {
+			goto done;
+		    }
+		    for (hPtr = Tcl_FirstHashEntry(&jtPtr->hashTable, &search);
+			    hPtr != NULL; hPtr = Tcl_NextHashEntry(&search)) {
+			target = (Tcl_WideInt) pc
+				+ PTR2INT(Tcl_GetHashValue(hPtr));
+			if (!IsInstStart(target)) {
+			    goto done;
+			}
+		    }
+		    break;
+		}
+		case INST_FOREACH_START: {
+		    ForeachInfo *infoPtr = (ForeachInfo *)auxPtr->clientData;
+		    Tcl_WideInt step;
+
+		    /*
+		     * The loop starts by jumping to its INST_FOREACH_STEP,
+		     * which jumps back to the body right after this
+		     * instruction; loopCtTemp holds the size of that jump.
+		     */
+
+		    if (auxPtr->type != foreachType
+			    && auxPtr->type != newForeachType) {
+			goto done;
+		    }
+		    step = (Tcl_WideInt) pc + 5
+			    - (ptrdiff_t) infoPtr->loopCtTemp;
+		    if (!IsInstStart(step)
+			    || code[step] != INST_FOREACH_STEP) {
+			goto done;
+		    }
+		    break;
+		}
+		case INST_DICT_UPDATE_START:
+		case INST_DICT_UPDATE_END:
+		    if (auxPtr->type != dictUpdateType) {
+			goto done;
+		    }
+		    break;
+		default:
+		    goto done;
+		}
+		break;
+	    }
+	    }
+	}
+    }
+
+    /*
+     * The AuxData items hold indices of compiled locals too.
+     */
+
+    for (i = 0; i < envPtr->auxDataArrayNext; i++) {
+	const AuxData *auxPtr = &envPtr->auxDataArrayPtr[i];
+
+	if (auxPtr->type == foreachType || auxPtr->type == newForeachType) {
+	    ForeachInfo *infoPtr = (ForeachInfo *)auxPtr->clientData;
+	    size_t k;
+
+	    for (k = 0; k < infoPtr->numLists; k++) {
+		ForeachVarList *varListPtr = infoPtr->varLists[k];
+
+		for (j = 0; j < (int) varListPtr->numVars; j++) {
+		    if ((unsigned) varListPtr->varIndexes[j] >= numLocals) {
+			goto done;
+		    }
+		}
+	    }
+	} else if (auxPtr->type == dictUpdateType) {
+	    DictUpdateInfo *duiPtr = (DictUpdateInfo *)auxPtr->clientData;
+
+	    for (j = 0; j < (int) duiPtr->length; j++) {
+		if ((unsigned) duiPtr->varIndices[j] >= numLocals) {
+		    goto done;
+		}
+	    }
+	}
+    }
+
+    for (i = 0; i < envPtr->exceptArrayNext; i++) {
+	const ExceptionRange *rangePtr = &envPtr->exceptArrayPtr[i];
+
+	if (rangePtr->nestingLevel < 0
+		|| rangePtr->nestingLevel > envPtr->maxExceptDepth
+		|| rangePtr->codeOffset < 0 || rangePtr->numCodeBytes < 0
+		|| (size_t) rangePtr->codeOffset + rangePtr->numCodeBytes
+			> codeLength) {
+	    goto done;
+	}
+	if (rangePtr->type == LOOP_EXCEPTION_RANGE) {
+	    if (!IsInstStart(rangePtr->breakOffset)
+		    || (rangePtr->continueOffset != -1
+			&& !IsInstStart(rangePtr->continueOffset))) {
+		goto done;
+	    }
+	} else if (rangePtr->type != CATCH_EXCEPTION_RANGE
+		|| !IsInstStart(rangePtr->catchOffset)) {
+	    goto done;
+	}
+    }
+
+    for (i = 0; i < envPtr->numCommands; i++) {
+	const CmdLocation *locPtr = &envPtr->cmdMapPtr[i];
+
+	if (locPtr->codeOffset < 0 || locPtr->numCodeBytes < 0
+		|| (size_t) locPtr->codeOffset + locPtr->numCodeBytes
+			> codeLength
+		|| locPtr->srcOffset < 0 || locPtr->numSrcBytes < 0
+		|| locPtr->srcOffset + locPtr->numSrcBytes
+			> envPtr->numSrcBytes) {
+	    goto done;
+	}
+    }
+    for (i = 0; i < envPtr->extCmdMapPtr->nuloc; i++) {
+	if (envPtr->extCmdMapPtr->loc[i].srcOffset
+		> (size_t) envPtr->numSrcBytes) {
+	    goto done;
+	}
+    }
+    ok = 1;
+
+  done:
+    Tcl_Free(starts);
+    return ok ? TCL_OK : TCL_ERROR;
+}
+#undef IsInstStart
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * Save/Load ForeachInfo, DictUpdateInfo, JumptableInfo --
+ *
+ *	Serialization of the AuxData types generated by the compiler.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+SaveForeachInfo(
+    void *clientData,
+    Tcl_DString *dsPtr)
+{
+    ForeachInfo *infoPtr = (ForeachInfo *)clientData;
+    size_t i, j;
+
+    PutInt(dsPtr, (int) infoPtr->numLists);
+    PutInt(dsPtr, (int) infoPtr->firstValueTemp);
+    PutInt(dsPtr, (int) infoPtr->loopCtTemp);
+    for (i = 0; i < infoPtr->numLists; i++) {
+	ForeachVarList *varListPtr = infoPtr->varLists[i];
+
+	PutInt(dsPtr, (int) varListPtr->numVars);
+	for (j = 0; j < varListPtr->numVars; j++) {
+	    PutInt(dsPtr, varListPtr->varIndexes[j]);
+	}
+    }
+}
+
+static void *
+LoadForeachInfo(
+    Reader *rdPtr)
+{
+    ForeachInfo *infoPtr;
+    int i, j, numLists = GetInt(rdPtr);
+
+    if (rdPtr->overrun || numLists < 0
+	    || (size_t) numLists * 4 > (size_t) (rdPtr->end - rdPtr->p)) {
+	return NULL;
+    }
+    infoPtr = (ForeachInfo *)Tcl_Alloc(offsetof(ForeachInfo, varLists)
+	    + numLists * sizeof(ForeachVarList *));
+    infoPtr->numLists = 0;
+    infoPtr->firstValueTemp = GetInt(rdPtr);
+    infoPtr->loopCtTemp = GetInt(rdPtr);
+    for (i = 0; i < numLists; i++) {
+	ForeachVarList *varListPtr;
+	int numVars = GetInt(rdPtr);
+
+	if (rdPtr->overrun || numVars < 0
+		|| (size_t) numVars * 4 > (size_t) (rdPtr->end - rdPtr->p)) {
+	    break;
+	}
+	varListPtr = (ForeachVarList *)Tcl_Alloc(
+		offsetof(ForeachVarList, varIndexes) + numVars * sizeof(int));
+	varListPtr->numVars = numVars;
+	for (j = 0; j < numVars; j++) {
+	    varListPtr->varIndexes[j] = GetInt(rdPtr);
+	}
+	infoPtr->varLists[infoPtr->numLists++] = varListPtr;
+    }
+    if (infoPtr->numLists != (size_t) numLists) {
+	TclGetAuxDataType("ForeachInfo")->freeProc(infoPtr);
+	return NULL;
+    }
+    return infoPtr;
+}
+
+static void
+SaveDictUpdateInfo(
+    void *clientData,
+    Tcl_DString *dsPtr)
+{
+    DictUpdateInfo *duiPtr = (DictUpdateInfo *)clientData;
+    size_t i;
+
+    PutInt(dsPtr, (int) duiPtr->length);
+    for (i = 0; i < duiPtr->length; i++) {
+	PutInt(dsPtr, duiPtr->varIndices[i]);
+    }
+}
+
+static void *
+LoadDictUpdateInfo(
+    Reader *rdPtr)
+{
+    DictUpdateInfo *duiPtr;
+    int i, length = GetInt(rdPtr);
+
+    if (rdPtr->overrun || length < 0
+	    || (size_t) length * 4 > (size_t) (rdPtr->end - rdPtr->p)) {
+	return NULL;
+    }
+    duiPtr = (DictUpdateInfo *)Tcl_Alloc(
+	    offsetof(DictUpdateInfo, varIndices) + sizeof(int) * length);
+    duiPtr->length = length;
+    for (i = 0; i < length; i++) {
+	duiPtr->varIndices[i] = GetInt(rdPtr);
+    }
+    return duiPtr;
+}
+
+static void
+SaveJumptableInfo(
+    void *clientData,
+    Tcl_DString *dsPtr)
+{
+    JumptableInfo *jtPtr = (JumptableInfo *)clientData;
+    Tcl_HashEntry *hPtr;
+    Tcl_HashSearch search;
+
+    PutInt(dsPtr, jtPtr->hashTable.numEntries);
+    for (hPtr = Tcl_FirstHashEntry(&jtPtr->hashTable, &search);
+	    hPtr != NULL; hPtr = Tcl_NextHashEntry(&search)) {
+	const char *keyPtr = (const char *)
+		Tcl_GetHashKey(&jtPtr->hashTable, hPtr);
+
+	PutString(dsPtr, keyPtr, strlen(keyPtr));
+	PutInt(dsPtr, PTR2INT(Tcl_GetHashValue(hPtr)));
+    }
+}
+
+static void *
+LoadJumptableInfo(
+    Reader *rdPtr)
+{
+    JumptableInfo *jtPtr = (JumptableInfo *)Tcl_Alloc(sizeof(JumptableInfo));
+    int i, isNew, count = GetInt(rdPtr);
+
+    Tcl_InitHashTable(&jtPtr->hashTable, TCL_STRING_KEYS);
+    for (i = 0; i < count && !rdPtr->overrun; i++) {
+	Tcl_DString key;
+	size_t length;
+	const char *bytes = GetString(rdPtr, &length);
+	int offset = GetInt(rdPtr);
+
+	if (rdPtr->overrun) {
+	    break;
+	}
+	Tcl_DStringInit(&key);
+	Tcl_DStringAppend(&key, bytes, length);
+	Tcl_SetHashValue(Tcl_CreateHashEntry(&jtPtr->hashTable,
+		Tcl_DStringValue(&key), &isNew), INT2PTR(offset));
+	Tcl_DStringFree(&key);
+    }
+    if (rdPtr->overrun) {
+	Tcl_DeleteHashTable(&jtPtr->hashTable);
+	Tcl_Free(jtPtr);
+	return NULL;
+    }
+    return jtPtr;
+}
+
+static const AuxDataSerializer *
+FindSerializer(
+    const char *name)
+{
+    const AuxDataSerializer *serPtr;
+
+    for (serPtr = auxDataSerializers; serPtr->name != NULL; serPtr++) {
+	if (!strcmp(serPtr->name, name)) {
+	    return serPtr;
+	}
+    }
+    return NULL;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * PutInt, PutString, GetInt, GetString --
+ *
+ *	Encoding of the basic items of a cache entry: 4-byte big-endian
+ *	integers, and strings as a length followed by the bytes.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+PutInt(
+    Tcl_DString *dsPtr,
+    int value)
+{
+    unsigned char buf[4];
+
+    TclStoreInt4AtPtr(value, buf);
+    Tcl_DStringAppend(dsPtr, (char *) buf, 4);
+}
+
+static void
+PutString(
+    Tcl_DString *dsPtr,
+    const char *bytes,
+    size_t length)
+{
+    PutInt(dsPtr, (int) length);
+    Tcl_DStringAppend(dsPtr, bytes, length);
+}
+
+static int
+GetInt(
+    Reader *rdPtr)
+{
+    int value;
+
+    if (rdPtr->end - rdPtr->p < 4) {
+	rdPtr->overrun = 1;
+	rdPtr->p = rdPtr->end;
+	return 0;
+    }
+    value = TclGetInt4AtPtr(rdPtr->p);
+    rdPtr->p += 4;
+    return value;
+}
+
+static const char *
+GetString(
+    Reader *rdPtr,
+    size_t *lengthPtr)
+{
+    const char *bytes;
+    int length = GetInt(rdPtr);
+
+    if (length < 0 || rdPtr->end - rdPtr->p < length) {
+	rdPtr->overrun = 1;
+	rdPtr->p = rdPtr->end;
+	*lengthPtr = 0;
+	return "";
+    }
+    bytes = (const char *) rdPtr->p;
+    rdPtr->p += length;
+    *lengthPtr = length;
+    return bytes;
+}
+
+/*
+ * Local Variables:
+ * mode: c
+ * c-basic-offset: 4
+ * fill-column: 78
+ * End:
+ */
@@ -93,6 +93,65 @@ typedef struct {
 #define SORTMODE_DICTIONARY	4
 #define SORTMODE_ASCII_NC	8
 
+/*
+ * Integer, real and string sorts (-integer, -real, -ascii with or without
+ * -nocase) of at least KEYSORT_MIN elements are done by KeySort, over a packed
+ * array of the following structures rather than by merging lists of
+ * SortElements. The key of a number maps it to an unsigned integer in the
+ * same order, for an LSD radix sort. The key of a string holds its first
+ * bytes, for a merge sort that compares the strings themselves only when the
+ * keys do not settle their order.
+ */
+
+#define KEYSORT_MIN	64	/* Fewest elements sorted by KeySort. */
+#define KEYSORT_RUN	16	/* Length of the runs KeySort sorts by
+				 * insertion before merging. */
+#define KeySortMode(mode) \
+    ((mode) == SORTMODE_INTEGER || (mode) == SORTMODE_REAL \
+	    || (mode) == SORTMODE_ASCII || (mode) == SORTMODE_ASCII_NC)
+
+typedef struct SortKey {
+    Tcl_WideUInt bits;		/* The key. */
+    int index;			/* Index of the element in the array. */
+    int exact;			/* Strings only: the number of leading bytes
+				 * of the key that are ASCII characters of the
+				 * string, or padding after its end, and so
+				 * decide its order. */
+} SortKey;
+
+/*
+ * Sorts that do not call back into Tcl (anything but -command) and have at
+ * least LSORT_PARALLEL_MIN elements for each processor are shared out among
+ * up to LSORT_THREADS_MAX threads. The following structure describes the run
+ * of elements sorted by one of them.
+ */
+
+#ifndef LSORT_PARALLEL_MIN
+#define LSORT_PARALLEL_MIN	32768
+#endif
+#define LSORT_THREADS_MAX	16
+
+/*
+ * The number of threads to sort on instead of one per processor, or 0. Only
+ * the test suite sets it, see TclSetLsortThreadsForTest.
+ */
+
+static int lsortThreadsForTest = 0;
+
+typedef struct SortRun {
+    SortElement *elementArray;	/* First element of the run. */
+    int length;			/* Number of elements in the run. */
+    int index;			/* Position of the run among all of them. */
+    int numRuns;		/* Number of runs; they are stored together in
+				 * an array. */
+    SortInfo info;		/* Copy of the sort's information, whose
+				 * numElements counts the elements left by
+				 * -unique in this run and those merged in. */
+    SortElement *headPtr;	/* The sorted elements, once done. */
+    Tcl_ThreadId threadId;	/* Thread sorting the run, or NULL if it was
+				 * sorted by the thread that set it up. */
+} SortRun;
+
 /*
  * Forward declarations for procedures defined in this file:
  */
@@ -123,6 +182,23 @@ static Tcl_ObjCmdProc	InfoCmdTypeCmd;
 static Tcl_ObjCmdProc	InfoTclVersionCmd;
 static SortElement *	MergeLists(SortElement *leftPtr, SortElement *rightPtr,
 			    SortInfo *infoPtr);
+static SortElement *	MergeSort(SortElement *elementArray, int length,
+			    SortInfo *infoPtr);
+static SortElement *	KeySort(SortElement *elementArray, int length,
+			    SortInfo *infoPtr);
+static int		CompareKeys(const SortKey *key1, const SortKey *key2,
+			    SortElement *elementArray, SortInfo *infoPtr);
+static SortKey *	RadixSortKeys(SortKey *keys, SortKey *spare,
+			    size_t length);
+static SortKey *	MergeSortKeys(SortKey *keys, SortKey *spare,
+			    size_t length, SortElement *elementArray,
+			    SortInfo *infoPtr);
+#if TCL_THREADS
+static SortElement *	ParallelSort(SortElement *elementArray, int length,
+			    int numRuns, SortInfo *infoPtr);
+static void		SortRunMerge(SortRun *runPtr);
+static Tcl_ThreadCreateProc SortRunThread;
+#endif
 static int		SortCompare(SortElement *firstPtr, SortElement *second,
 			    SortInfo *infoPtr);
 static Tcl_Obj *	SelectObjFromSublist(Tcl_Obj *firstPtr,
@@ -3083,6 +3159,7 @@ Tcl_LreverseObjCmd(
     }
 
     if (Tcl_IsShared(objv[1])
+	    || !TclHasInternalRep(objv[1], &tclListType)
 	    || (ListRepPtr(objv[1])->refCount > 1)) {	/* Bug 1675044 */
 	Tcl_Obj *resultObj, **dataArray;
 	List *listRepPtr;
@@ -3105,6 +3182,7 @@ Tcl_LreverseObjCmd(
 	 * returning a pointer to the live array of Tcl_Obj values.
 	 */
 
+	TclListDiscardIndex(ListRepPtr(objv[1]));
 	for (i=0,j=elemc-1 ; i<j ; i++,j--) {
 	    Tcl_Obj *tmp = elemv[i];
 
@@ -3683,6 +3761,15 @@ Tcl_LsearchObjCmd(
 	if (bisect && index < 0) {
 	    index = lower;
 	}
+    } else if (mode == EXACT && dataType == ASCII && !noCase && !allMatches
+	    && !negatedMatch && groupSize == 1 && sortInfo.indexc == 0
+	    && TclListObjFind(objv[objc - 2], patObj, &index)
+	    && (index < 0 || (size_t) index >= start)) {
+	/*
+	 * The list has an index that tells where the first exact match is.
+	 */
+
+	i = index;
     } else {
 	/*
 	 * We need to do a linear search, because (at least one) of:
@@ -3691,6 +3778,7 @@ Tcl_LsearchObjCmd(
 	 *   - we're building a list of all matched items
 	 */
 
+	index = -1;
 	if (allMatches) {
 	    listPtr = Tcl_NewListObj(0, NULL);
 	}
@@ -3987,7 +4075,7 @@ Tcl_LsortObjCmd(
     int objc,			/* Number of arguments. */
     Tcl_Obj *const objv[])	/* Argument values. */
 {
-    int i, indices, length, nocase = 0, indexc;
+    int i, indices, length, nocase = 0, indexc, numRuns = 1, keySort;
     int sortMode = SORTMODE_ASCII;
     int group, allocatedIndexVector = 0;
     size_t j, idx, groupSize, groupOffset;
@@ -4306,6 +4394,29 @@ Tcl_LsortObjCmd(
 	sortMode = SORTMODE_ASCII;
     }
 
+#if TCL_THREADS
+    /*
+     * Decide whether to sort on several threads. The comparisons of every
+     * mode but -command only read the keys extracted below, and the strings
+     * they point to, so they are safe to make from other threads.
+     */
+
+    if (sortMode != SORTMODE_COMMAND && length >= 2 * LSORT_PARALLEL_MIN) {
+	numRuns = lsortThreadsForTest;
+	if (numRuns == 0) {
+	    numRuns = TclpGetCpuCount();
+	}
+	if (numRuns > length / LSORT_PARALLEL_MIN) {
+	    numRuns = length / LSORT_PARALLEL_MIN;
+	}
+	if (numRuns > LSORT_THREADS_MAX) {
+	    numRuns = LSORT_THREADS_MAX;
+	}
+    }
+#endif
+
+    keySort = (length >= KEYSORT_MIN && KeySortMode(sortInfo.sortMode));
+
     /*
      * Initialize the sublists. After the following loop, subList[i] will
      * contain a sorted sublist of length 2**i. Use one extra subList at the
@@ -4387,6 +4498,15 @@ Tcl_LsortObjCmd(
 	    elementArray[i].payload.objPtr = listObjPtrs[idx];
 	}
 
+	/*
+	 * Parallel sorts and sorts by KeySort only extract the keys here, and
+	 * sort them all below.
+	 */
+
+	if (numRuns > 1 || keySort) {
+	    continue;
+	}
+
 	/*
 	 * Merge this element in the pre-existing sublists (and merge together
 	 * sublists when we have two of the same size).
@@ -4408,9 +4528,18 @@ Tcl_LsortObjCmd(
      * Merge all sublists
      */
 
-    elementPtr = subList[0];
-    for (j=1 ; j<NUM_LISTS ; j++) {
-	elementPtr = MergeLists(subList[j], elementPtr, &sortInfo);
+#if TCL_THREADS
+    if (numRuns > 1) {
+	elementPtr = ParallelSort(elementArray, length, numRuns, &sortInfo);
+    } else
+#endif
+    if (keySort) {
+	elementPtr = KeySort(elementArray, length, &sortInfo);
+    } else {
+	elementPtr = subList[0];
+	for (j=1 ; j<NUM_LISTS ; j++) {
+	    elementPtr = MergeLists(subList[j], elementPtr, &sortInfo);
+	}
     }
 
     /*
@@ -4575,6 +4704,484 @@ MergeLists(
     return headPtr;
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * MergeSort --
+ *
+ *	This procedure sorts an array of SortElement structures into a list,
+ *	in the same way as Tcl_LsortObjCmd does as it creates them.
+ *
+ * Results:
+ *	The sorted list of SortElement structures.
+ *
+ * Side effects:
+ *	As for MergeLists.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static SortElement *
+MergeSort(
+    SortElement *elementArray,	/* Elements to sort. */
+    int length,			/* Number of elements. */
+    SortInfo *infoPtr)		/* Information needed by the comparison
+				 * operator. */
+{
+    SortElement *subList[NUM_LISTS+1], *elementPtr;
+    int i, j;
+
+    for (j=0 ; j<=NUM_LISTS ; j++) {
+	subList[j] = NULL;
+    }
+    for (i=0 ; i<length ; i++) {
+	elementArray[i].nextPtr = NULL;
+	elementPtr = &elementArray[i];
+	for (j=0 ; subList[j] ; j++) {
+	    elementPtr = MergeLists(subList[j], elementPtr, infoPtr);
+	    subList[j] = NULL;
+	}
+	if (j >= NUM_LISTS) {
+	    j = NUM_LISTS-1;
+	}
+	subList[j] = elementPtr;
+    }
+    elementPtr = subList[0];
+    for (j=1 ; j<NUM_LISTS ; j++) {
+	elementPtr = MergeLists(subList[j], elementPtr, infoPtr);
+    }
+    return elementPtr;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * KeySort --
+ *
+ *	This procedure sorts an array of SortElement structures into a list
+ *	by packing their keys into an array of SortKey structures and sorting
+ *	that: numbers with an LSD radix sort, strings with a merge sort that
+ *	compares their leading bytes before the strings themselves. Both sorts
+ *	are stable and equal elements are dropped afterwards for -unique, so
+ *	the result is the same as that of MergeSort, which is used instead for
+ *	other modes, short arrays, or if the keys cannot be allocated.
+ *
+ * Results:
+ *	The sorted list of SortElement structures.
+ *
+ * Side effects:
+ *	If infoPtr->unique is set then infoPtr->numElements may be updated.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static SortElement *
+KeySort(
+    SortElement *elementArray,	/* Elements to sort. */
+    int length,			/* Number of elements. */
+    SortInfo *infoPtr)		/* Information needed by the comparison
+				 * operator. */
+{
+    SortKey *keys, *sorted;
+    SortElement *headPtr = NULL, **tailPtrPtr = &headPtr;
+    size_t i, n;
+    int isNumber = (infoPtr->sortMode == SORTMODE_INTEGER
+	    || infoPtr->sortMode == SORTMODE_REAL);
+
+    if (length < KEYSORT_MIN || !KeySortMode(infoPtr->sortMode)
+	    || (size_t) length > ((size_t) -1) / (2 * sizeof(SortKey))) {
+	return MergeSort(elementArray, length, infoPtr);
+    }
+    keys = (SortKey *)Tcl_AttemptAlloc(2 * length * sizeof(SortKey));
+    if (keys == NULL) {
+	return MergeSort(elementArray, length, infoPtr);
+    }
+
+    for (i = 0; i < (size_t) length; i++) {
+	Tcl_WideUInt bits = 0;
+
+	keys[i].index = (int) i;
+	keys[i].exact = 0;
+	if (infoPtr->sortMode == SORTMODE_INTEGER) {
+	    bits = (Tcl_WideUInt) elementArray[i].collationKey.wideValue
+		    ^ ((Tcl_WideUInt) 1 << 63);
+	} else if (infoPtr->sortMode == SORTMODE_REAL) {
+	    double d = elementArray[i].collationKey.doubleValue;
+
+	    /*
+	     * Map the sign-magnitude bits of the double to an ascending
+	     * unsigned integer. -0.0 is equal to 0.0, so takes its key.
+	     */
+
+	    if (d == 0.0) {
+		d = 0.0;
+	    }
+	    memcpy(&bits, &d, sizeof(bits));
+	    bits = (bits >> 63) ? ~bits : (bits | ((Tcl_WideUInt) 1 << 63));
+	} else {
+	    const char *str = elementArray[i].collationKey.strValuePtr;
+	    int k;
+
+	    /*
+	     * Stop at the first byte that is not an ASCII character: it may
+	     * start a character in any order relative to those in other
+	     * strings, a NUL (\xC0\x80) included, or one whose lower case is
+	     * ASCII. The end of the string is padded with zero bytes, which
+	     * come before any character as the string ending does.
+	     */
+
+	    for (k = 0; k < 8; k++) {
+		unsigned char c = UCHAR(str[k]);
+
+		if (c == 0) {
+		    k = 8;
+		    break;
+		}
+		if (c >= 0x80) {
+		    break;
+		}
+		if (infoPtr->sortMode == SORTMODE_ASCII_NC
+			&& c >= 'A' && c <= 'Z') {
+		    c += 'a' - 'A';
+		}
+		bits |= (Tcl_WideUInt) c << (56 - 8 * k);
+	    }
+	    keys[i].exact = k;
+	}
+	if (isNumber && !infoPtr->isIncreasing) {
+	    bits = ~bits;
+	}
+	keys[i].bits = bits;
+    }
+
+    if (isNumber) {
+	sorted = RadixSortKeys(keys, keys + length, length);
+    } else {
+	sorted = MergeSortKeys(keys, keys + length, length, elementArray,
+		infoPtr);
+    }
+
+    /*
+     * Link the elements in order. Of equal elements, -unique keeps the last,
+     * as MergeLists does.
+     */
+
+    for (i = 0, n = length; i < n; i++) {
+	if (infoPtr->unique && i + 1 < n && CompareKeys(&sorted[i],
+		&sorted[i + 1], elementArray, infoPtr) == 0) {
+	    infoPtr->numElements--;
+	    continue;
+	}
+	*tailPtrPtr = &elementArray[sorted[i].index];
+	tailPtrPtr = &(*tailPtrPtr)->nextPtr;
+    }
+    *tailPtrPtr = NULL;
+    Tcl_Free(keys);
+    return headPtr;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * CompareKeys --
+ *
+ *	This procedure is invoked by KeySort to determine the proper ordering
+ *	between two elements from their keys, as SortCompare would.
+ *
+ * Results:
+ *	As for SortCompare.
+ *
+ * Side effects:
+ *	None.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static inline int
+CompareKeys(
+    const SortKey *key1, const SortKey *key2,
+				/* Keys to be compared. */
+    SortElement *elementArray,	/* Elements the keys are for. */
+    SortInfo *infoPtr)		/* Information passed from the top-level
+				 * "lsort" command. */
+{
+    Tcl_WideUInt diff = key1->bits ^ key2->bits;
+    int k, order;
+
+    if (infoPtr->sortMode == SORTMODE_INTEGER
+	    || infoPtr->sortMode == SORTMODE_REAL) {
+	return (key1->bits > key2->bits) - (key1->bits < key2->bits);
+    }
+
+    /*
+     * The first byte at which the string keys differ decides, if it is an
+     * exact byte of both. Otherwise compare the strings.
+     */
+
+    if (diff != 0) {
+	for (k = 0; (diff >> (56 - 8 * k)) == 0; k++) {
+	    /* Empty loop body. */
+	}
+	if (k < key1->exact && k < key2->exact) {
+	    order = (key1->bits < key2->bits) ? -1 : 1;
+	    return infoPtr->isIncreasing ? order : -order;
+	}
+    }
+    return SortCompare(&elementArray[key1->index],
+	    &elementArray[key2->index], infoPtr);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * RadixSortKeys, MergeSortKeys --
+ *
+ *	These procedures sort an array of SortKey structures stably, using a
+ *	second array of the same length as space to move them through.
+ *	RadixSortKeys is an LSD radix sort on a byte of the key at a time,
+ *	which skips the bytes that are the same in every key. MergeSortKeys
+ *	sorts short runs by insertion and then merges them pairwise.
+ *
+ * Results:
+ *	Whichever of the two arrays holds the sorted keys.
+ *
+ * Side effects:
+ *	None.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static SortKey *
+RadixSortKeys(
+    SortKey *keys,		/* Keys to sort. */
+    SortKey *spare,		/* Space for as many keys. */
+    size_t length)		/* Number of keys. */
+{
+    size_t counts[8][256], i, total;
+    int b, d;
+
+    memset(counts, 0, sizeof(counts));
+    for (i = 0; i < length; i++) {
+	for (b = 0; b < 8; b++) {
+	    counts[b][(keys[i].bits >> (8 * b)) & 0xFF]++;
+	}
+    }
+    for (b = 0; b < 8; b++) {
+	SortKey *swap;
+
+	if (counts[b][(keys[0].bits >> (8 * b)) & 0xFF] == length) {
+	    continue;
+	}
+	for (d = 0, total = 0; d < 256; d++) {
+	    size_t count = counts[b][d];
+
+	    counts[b][d] = total;
+	    total += count;
+	}
+	for (i = 0; i < length; i++) {
+	    spare[counts[b][(keys[i].bits >> (8 * b)) & 0xFF]++] = keys[i];
+	}
+	swap = keys;
+	keys = spare;
+	spare = swap;
+    }
+    return keys;
+}
+
+static SortKey *
+MergeSortKeys(
+    SortKey *keys,		/* Keys to sort. */
+    SortKey *spare,		/* Space for as many keys. */
+    size_t length,		/* Number of keys. */
+    SortElement *elementArray,	/* Elements the keys are for. */
+    SortInfo *infoPtr)		/* Information needed by the comparison
+				 * operator. */
+{
+    size_t lo, mid, hi, i, j, k, width;
+
+    for (lo = 0; lo < length; lo += KEYSORT_RUN) {
+	hi = (length - lo > KEYSORT_RUN) ? lo + KEYSORT_RUN : length;
+	for (i = lo + 1; i < hi; i++) {
+	    SortKey key = keys[i];
+
+	    for (j = i; j > lo && CompareKeys(&keys[j - 1], &key,
+		    elementArray, infoPtr) > 0; j--) {
+		keys[j] = keys[j - 1];
+	    }
+	    keys[j] = key;
+	}
+    }
+
+    for (width = KEYSORT_RUN; width < length; width *= 2) {
+	SortKey *swap;
+
+	for (lo = 0; lo < length; lo = hi) {
+	    mid = (length - lo > width) ? lo + width : length;
+	    hi = (length - mid > width) ? mid + width : length;
+	    for (i = lo, j = mid, k = lo; k < hi; k++) {
+		if (j >= hi || (i < mid && CompareKeys(&keys[i], &keys[j],
+			elementArray, infoPtr) <= 0)) {
+		    spare[k] = keys[i++];
+		} else {
+		    spare[k] = keys[j++];
+		}
+	    }
+	}
+	swap = keys;
+	keys = spare;
+	spare = swap;
+    }
+    return keys;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclSetLsortThreadsForTest --
+ *
+ *	Sets the number of threads that lsort sorts long lists on, whatever
+ *	the number of processors, so that the test suite covers ParallelSort
+ *	on machines with a single one. 0 restores the default of one thread
+ *	per processor, a negative number leaves the setting as it is. It
+ *	applies to all interpreters.
+ *
+ * Results:
+ *	The previous setting.
+ *
+ * Side effects:
+ *	None.
+ *
+ *----------------------------------------------------------------------
+ */
+
+int
+TclSetLsortThreadsForTest(
+    int numThreads)		/* Number of threads, 0 or -1. */
+{
+    int oldThreads = lsortThreadsForTest;
+
+    if (numThreads >= 0) {
+	lsortThreadsForTest = numThreads;
+    }
+    return oldThreads;
+}
+
+#if TCL_THREADS
+/*
+ *----------------------------------------------------------------------
+ *
+ * ParallelSort --
+ *
+ *	This procedure sorts an array of SortElement structures into a list
+ *	using several threads. The array is cut into consecutive runs, one per
+ *	thread. Each thread sorts its run, then merges in the sorted runs of
+ *	its neighbours pairwise, as a tree: run 0 takes in run 1, run 2 takes
+ *	in run 3, then run 0 takes in run 2, and so on. As a run on the left
+ *	always holds the earlier elements, the sort stays stable and -unique
+ *	keeps the last of equal elements, just as a sort on one thread does.
+ *
+ * Results:
+ *	The sorted list of SortElement structures.
+ *
+ * Side effects:
+ *	Threads are created and joined. With -unique, infoPtr->numElements is
+ *	updated.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static SortElement *
+ParallelSort(
+    SortElement *elementArray,	/* Elements to sort. */
+    int length,			/* Number of elements. */
+    int numRuns,		/* Number of threads to use, at most
+				 * LSORT_THREADS_MAX. */
+    SortInfo *infoPtr)		/* Information needed by the comparison
+				 * operator. */
+{
+    SortRun runs[LSORT_THREADS_MAX];
+    int k;
+
+    for (k = 0; k < numRuns; k++) {
+	runs[k].elementArray = elementArray;
+	runs[k].length = length / numRuns + (k < length % numRuns);
+	runs[k].index = k;
+	runs[k].numRuns = numRuns;
+	runs[k].info = *infoPtr;
+	runs[k].info.numElements = runs[k].length;
+	runs[k].headPtr = NULL;
+	runs[k].threadId = NULL;
+	elementArray += runs[k].length;
+    }
+
+    /*
+     * Start the threads from the last run down, so that the identity of any
+     * thread a run must wait for is known before the run is started. A run
+     * that cannot have its own thread is done here and now.
+     */
+
+    for (k = numRuns - 1; k > 0; k--) {
+	if (Tcl_CreateThread(&runs[k].threadId, SortRunThread, &runs[k],
+		TCL_THREAD_STACK_DEFAULT, TCL_THREAD_JOINABLE) != TCL_OK) {
+	    runs[k].threadId = NULL;
+	    SortRunMerge(&runs[k]);
+	}
+    }
+    SortRunMerge(&runs[0]);
+
+    infoPtr->numElements = runs[0].info.numElements;
+    return runs[0].headPtr;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * SortRunMerge, SortRunThread --
+ *
+ *	These procedures sort one run of a parallel sort (with KeySort, which
+ *	leaves it to MergeSort where it does not apply) and merge in the runs
+ *	of its neighbours, waiting for their threads to finish them first.
+ *	SortRunThread is the main procedure of the threads.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	The elements of the runs are linked into runPtr->headPtr.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+SortRunMerge(
+    SortRun *runPtr)		/* Run to sort. */
+{
+    int step, state;
+
+    runPtr->headPtr = KeySort(runPtr->elementArray, runPtr->length,
+	    &runPtr->info);
+    for (step = 1; runPtr->index % (2 * step) == 0
+	    && runPtr->index + step < runPtr->numRuns; step *= 2) {
+	SortRun *otherPtr = runPtr + step;
+
+	if (otherPtr->threadId != NULL) {
+	    Tcl_JoinThread(otherPtr->threadId, &state);
+	}
+	runPtr->info.numElements += otherPtr->info.numElements;
+	runPtr->headPtr = MergeLists(runPtr->headPtr, otherPtr->headPtr,
+		&runPtr->info);
+    }
+}
+
+static Tcl_ThreadCreateType
+SortRunThread(
+    void *clientData)		/* The SortRun to sort. */
+{
+    SortRunMerge((SortRun *)clientData);
+    TCL_THREAD_CREATE_RETURN;
+}
+#endif /* TCL_THREADS */
+
 /*
  *----------------------------------------------------------------------
  *
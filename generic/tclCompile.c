@@ -658,6 +658,52 @@ InstructionDesc const tclInstructionTable[] = {
     {"strge",		  1,   -1,         0,	{OPERAND_NONE}},
 	/* String Greater or equal:	push (stknext >= stktop) */
 
+    /*
+     * Superinstructions. The optimizer puts them in place of the opcode of
+     * an INST_LOAD_SCALAR1 that starts a known sequence, keeping the operand
+     * and the instructions that follow it. When the values at hand allow,
+     * the whole sequence runs in one step; otherwise these behave exactly
+     * like loadScalar1 and the sequence continues normally.
+     */
+
+    {"loadArithStore1",	  2,	+1,	  1,	{OPERAND_LVT1}},
+	/* Starts: loadScalar1 %a; push1 lit; add|sub; storeScalar1 %b
+	 * Stack:  ... => ... value */
+    {"loadCmpJump1",	  2,	+1,	  1,	{OPERAND_LVT1}},
+	/* Starts: loadScalar1 %a; loadScalar1 %b; eq|neq|lt|gt|le|ge;
+	 *	   jumpTrue|jumpFalse
+	 * Stack:  ... => ... value */
+    {"loadListIndex1",	  2,	+1,	  1,	{OPERAND_LVT1}},
+	/* Starts: loadScalar1 %list; loadScalar1 %index; listIndex
+	 * Stack:  ... => ... value */
+
+    /*
+     * Quickened forms of add, sub, mult, eq, neq, lt, gt, le and ge for
+     * operands that are both ints or both doubles. Only ever created at
+     * runtime, by the generic instructions rewriting themselves.
+     */
+
+    {"addInt",	  1,	-1,	  0,	{OPERAND_NONE}},
+    {"subInt",	  1,	-1,	  0,	{OPERAND_NONE}},
+    {"multInt",	  1,	-1,	  0,	{OPERAND_NONE}},
+    {"addDbl",	  1,	-1,	  0,	{OPERAND_NONE}},
+    {"subDbl",	  1,	-1,	  0,	{OPERAND_NONE}},
+    {"multDbl",	  1,	-1,	  0,	{OPERAND_NONE}},
+	/* Stack:  ... value1 value2 => ... result */
+    {"eqInt",	  1,	-1,	  0,	{OPERAND_NONE}},
+    {"neqInt",	  1,	-1,	  0,	{OPERAND_NONE}},
+    {"ltInt",	  1,	-1,	  0,	{OPERAND_NONE}},
+    {"gtInt",	  1,	-1,	  0,	{OPERAND_NONE}},
+    {"leInt",	  1,	-1,	  0,	{OPERAND_NONE}},
+    {"geInt",	  1,	-1,	  0,	{OPERAND_NONE}},
+    {"eqDbl",	  1,	-1,	  0,	{OPERAND_NONE}},
+    {"neqDbl",	  1,	-1,	  0,	{OPERAND_NONE}},
+    {"ltDbl",	  1,	-1,	  0,	{OPERAND_NONE}},
+    {"gtDbl",	  1,	-1,	  0,	{OPERAND_NONE}},
+    {"leDbl",	  1,	-1,	  0,	{OPERAND_NONE}},
+    {"geDbl",	  1,	-1,	  0,	{OPERAND_NONE}},
+	/* Stack:  ... value1 value2 => ... boolean */
+
     {NULL, 0, 0, 0, {OPERAND_NONE}}
 };
 
@@ -1435,6 +1481,7 @@ TclInitCompileEnv(
     envPtr->source = stringPtr;
     envPtr->numSrcBytes = numBytes;
     envPtr->procPtr = iPtr->compiledProcPtr;
+    envPtr->cmdDepsPtr = NULL;
     iPtr->compiledProcPtr = NULL;
     envPtr->numCommands = 0;
     envPtr->exceptDepth = 0;
@@ -1678,6 +1725,10 @@ TclFreeCompileEnv(
 	ReleaseCmdWordData(envPtr->extCmdMapPtr);
 	envPtr->extCmdMapPtr = NULL;
     }
+    if (envPtr->cmdDepsPtr) {
+	Tcl_DecrRefCount(envPtr->cmdDepsPtr);
+	envPtr->cmdDepsPtr = NULL;
+    }
 }
 
 /*
@@ -2081,6 +2132,7 @@ CompileCommandTokens(
 
     /* If cmdPtr != NULL, try to call cmdPtr->compileProc */
     if (cmdPtr) {
+	TclNoteCompiledCommand(envPtr, cmdObj, cmdPtr);
 	code = CompileCmdCompileProc(interp, parsePtr, cmdPtr, envPtr);
     }
 
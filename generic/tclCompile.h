@@ -385,6 +385,10 @@ typedef struct CompileEnv {
     int *clNext;		/* If not NULL, it refers to the next slot in
 				 * clLoc to check for an invisible
 				 * continuation line. */
+    Tcl_Obj *cmdDepsPtr;	/* Dictionary of the command names looked up
+				 * to compile commands inline, kept for the
+				 * persistent bytecode cache, or NULL. See
+				 * TclNoteCompiledCommand. */
 } CompileEnv;
 
 /*
@@ -825,6 +829,41 @@ enum TclInstruction {
 	INST_STR_LE,
 	INST_STR_GE,
 
+    /*
+     * Superinstructions, only generated by the bytecode optimizer over the
+     * INST_LOAD_SCALAR1 that starts a common sequence.
+     */
+    INST_LOAD_SCALAR1_ARITH_STORE,
+    INST_LOAD_SCALAR1_CMP_JUMP,
+    INST_LOAD_SCALAR1_LIST_INDEX,
+
+    /*
+     * Quickened numeric instructions, never emitted by the compiler. The
+     * generic arithmetic and comparison instructions rewrite themselves in
+     * place into these once they have seen int/int or double/double
+     * operands, and are rewritten back when that guess stops holding. The
+     * order within each group must match INST_ADD..INST_MULT and
+     * INST_EQ..INST_GE.
+     */
+    INST_ADD_INT,
+    INST_SUB_INT,
+    INST_MULT_INT,
+    INST_ADD_DBL,
+    INST_SUB_DBL,
+    INST_MULT_DBL,
+    INST_EQ_INT,
+    INST_NEQ_INT,
+    INST_LT_INT,
+    INST_GT_INT,
+    INST_LE_INT,
+    INST_GE_INT,
+    INST_EQ_DBL,
+    INST_NEQ_DBL,
+    INST_LT_DBL,
+    INST_GT_DBL,
+    INST_LE_DBL,
+    INST_GE_DBL,
+
     /* The last opcode */
     LAST_INST_OPCODE
 };
@@ -1126,6 +1165,7 @@ MODULE_SCOPE void	TclFreeCompileEnv(CompileEnv *envPtr);
 MODULE_SCOPE void	TclFreeJumpFixupArray(JumpFixupArray *fixupArrayPtr);
 MODULE_SCOPE int	TclGetIndexFromToken(Tcl_Token *tokenPtr,
 			    size_t before, size_t after, int *indexPtr);
+MODULE_SCOPE int	TclGetLiteralFlags(Interp *iPtr, Tcl_Obj *objPtr);
 MODULE_SCOPE ByteCode *	TclInitByteCode(CompileEnv *envPtr);
 MODULE_SCOPE ByteCode *	TclInitByteCodeObj(Tcl_Obj *objPtr,
 			    const Tcl_ObjType *typePtr, CompileEnv *envPtr);
@@ -1134,6 +1174,10 @@ MODULE_SCOPE void	TclInitCompileEnv(Tcl_Interp *interp,
 			    size_t numBytes, const CmdFrame *invoker, int word);
 MODULE_SCOPE void	TclInitJumpFixupArray(JumpFixupArray *fixupArrayPtr);
 MODULE_SCOPE void	TclInitLiteralTable(LiteralTable *tablePtr);
+MODULE_SCOPE int	TclLoadCachedByteCode(Tcl_Interp *interp,
+			    Tcl_Obj *bodyPtr);
+MODULE_SCOPE void	TclNoteCompiledCommand(CompileEnv *envPtr,
+			    Tcl_Obj *nameObj, Command *cmdPtr);
 MODULE_SCOPE ExceptionRange *TclGetInnermostExceptionRange(CompileEnv *envPtr,
 			    int returnCode, ExceptionAux **auxPtrPtr);
 MODULE_SCOPE void	TclAddLoopBreakFixup(CompileEnv *envPtr,
@@ -1168,6 +1212,8 @@ MODULE_SCOPE void	TclPushVarName(Tcl_Interp *interp,
 MODULE_SCOPE void	TclPreserveByteCode(ByteCode *codePtr);
 MODULE_SCOPE void	TclReleaseByteCode(ByteCode *codePtr);
 MODULE_SCOPE void	TclReleaseLiteral(Tcl_Interp *interp, Tcl_Obj *objPtr);
+MODULE_SCOPE int	TclStoreCachedByteCode(Tcl_Interp *interp,
+			    CompileEnv *envPtr, void *clientData);
 MODULE_SCOPE void	TclInvalidateCmdLiteral(Tcl_Interp *interp,
 			    const char *name, Namespace *nsPtr);
 MODULE_SCOPE int	TclSingleOpCmd(void *clientData,
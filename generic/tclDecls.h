@@ -1789,6 +1789,9 @@ EXTERN Tcl_Obj *	Tcl_GetRange(Tcl_Obj *objPtr, size_t first,
 				size_t last);
 /* 673 */
 EXTERN int		Tcl_GetUniChar(Tcl_Obj *objPtr, size_t index);
+/* 674 */
+EXTERN Tcl_DriverOutputVProc * Tcl_ChannelOutputVProc(
+				const Tcl_ChannelType *chanTypePtr);
 
 typedef struct {
     const struct TclPlatStubs *tclPlatStubs;
@@ -2474,6 +2477,7 @@ typedef struct TclStubs {
     const char * (*tcl_UtfAtIndex) (const char *src, size_t index); /* 671 */
     Tcl_Obj * (*tcl_GetRange) (Tcl_Obj *objPtr, size_t first, size_t last); /* 672 */
     int (*tcl_GetUniChar) (Tcl_Obj *objPtr, size_t index); /* 673 */
+    Tcl_DriverOutputVProc * (*tcl_ChannelOutputVProc) (const Tcl_ChannelType *chanTypePtr); /* 674 */
 } TclStubs;
 
 extern const TclStubs *tclStubsPtr;
@@ -3767,6 +3771,8 @@ extern const TclStubs *tclStubsPtr;
 	(tclStubsPtr->tcl_GetRange) /* 672 */
 #define Tcl_GetUniChar \
 	(tclStubsPtr->tcl_GetUniChar) /* 673 */
+#define Tcl_ChannelOutputVProc \
+	(tclStubsPtr->tcl_ChannelOutputVProc) /* 674 */
 
 #endif /* defined(USE_TCL_STUBS) */
 
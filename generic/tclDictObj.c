@@ -48,13 +48,16 @@ static Tcl_FreeInternalRepProc	FreeDictInternalRep;
 static void			InvalidateDictChain(Tcl_Obj *dictObj);
 static Tcl_SetFromAnyProc	SetDictFromAny;
 static Tcl_UpdateStringProc	UpdateStringOfDict;
-static Tcl_AllocHashEntryProc	AllocChainEntry;
-static inline void		InitChainTable(struct Dict *dict);
-static inline void		DeleteChainTable(struct Dict *dict);
-static inline Tcl_HashEntry *	CreateChainEntry(struct Dict *dict,
-					Tcl_Obj *keyPtr, int *newPtr);
-static inline int		DeleteChainEntry(struct Dict *dict,
+static inline void		InitDict(struct Dict *dict);
+static void			DeleteDictContents(struct Dict *dict);
+static inline Tcl_Obj *	FindValue(struct Dict *dict, Tcl_Obj *keyPtr);
+static Tcl_Obj *		FindValueForUpdate(struct Dict *dict,
 					Tcl_Obj *keyPtr);
+static int			SetPair(struct Dict *dict, Tcl_Obj *keyPtr,
+					Tcl_Obj *valuePtr);
+static int			DeletePair(struct Dict *dict,
+					Tcl_Obj *keyPtr);
+static struct DictPair *	NextPair(struct Dict *dict, size_t *indexPtr);
 static Tcl_NRPostProc		FinalizeDictUpdate;
 static Tcl_NRPostProc		FinalizeDictWith;
 static Tcl_ObjCmdProc		DictForNRCmd;
@@ -93,42 +96,112 @@ static const EnsembleImplMap implementationMap[] = {
     {NULL, NULL, NULL, NULL, NULL, 0}
 };
 
-/*
- * Internal representation of the entries in the hash table that backs a
- * dictionary.
- */
-
-typedef struct ChainEntry {
-    Tcl_HashEntry entry;
-    struct ChainEntry *prevPtr;
-    struct ChainEntry *nextPtr;
-} ChainEntry;
-
 /*
  * Internal representation of a dictionary.
  *
- * The internal representation of a dictionary object is a hash table (with
- * Tcl_Objs for both keys and values), a reference count and epoch number for
- * detecting concurrent modifications of the dictionary, and a pointer to the
- * parent object (used when invalidating string reps of pathed dictionary
- * trees) which is NULL in normal use. The fact that hash tables know (with
- * appropriate initialisation) already about objects makes key management /so/
- * much easier!
+ * The contents of a dictionary are held in two persistent trees whose nodes
+ * are reference counted, so that copies of a dictionary share them:
+ *
+ *  - The order vector holds the key,value pairs in the order that the keys
+ *    were first added. It is a tree of DICT_WIDTH-way nodes, indexed by the
+ *    digits (DICT_BITS bits each) of a pair's position; the pairs are in the
+ *    bottom level. Removing a key only clears its pair, and the vector is
+ *    rebuilt once the cleared pairs outnumber the others.
+ *
+ *  - The key trie maps keys to positions in the order vector. It is a hash
+ *    array mapped trie: each node has room for 64 slots, selected by
+ *    successive KEY_BITS-bit digits of the hash of the key, but only stores
+ *    the slots in use, as flagged in a bitmap. A slot holds either a key or a
+ *    subtree of the keys that share its digits so far. Keys whose hashes are
+ *    entirely equal end up together in a collision node, searched in order.
+ *    The slot of a key also points to the value of its pair, so that lookups
+ *    need not go through the order vector, and the nodes are wider than
+ *    those of the vector, so that lookups in large dictionaries go through
+ *    few levels. Only the pair holds references to the key and the value;
+ *    SetPair keeps the slot in step with it.
+ *
+ * Copying a dictionary takes references to the roots of its trees. Changing
+ * it copies only the nodes on the path to the change that are shared with
+ * other dictionaries, and changes the nodes it holds the only references to
+ * in place. Since the key and value objects are referenced by nodes rather
+ * than by the dictionary, a value with a single reference may still be seen
+ * through another dictionary; see FindValueForUpdate.
+ *
+ * The Dict also holds a reference count and epoch number for detecting
+ * concurrent modifications of the dictionary, and a pointer to the parent
+ * object (used when invalidating string reps of pathed dictionary trees)
+ * which is NULL in normal use.
  *
  * Reference counts are used to enable safe iteration across hashes while
  * allowing the type of the containing object to be modified.
  */
 
+#define DICT_BITS	5
+#define DICT_WIDTH	(1 << DICT_BITS)
+#define DICT_MASK	(DICT_WIDTH - 1)
+#define KEY_BITS	6
+#define KEY_MASK	((1 << KEY_BITS) - 1)
+#define DICT_HASH_BITS	(sizeof(size_t) * CHAR_BIT)
+
+typedef struct DictPair {
+    Tcl_Obj *keyPtr;		/* The key, or NULL if the pair has been
+				 * removed or is not in use yet. */
+    Tcl_Obj *valuePtr;		/* The value mapped to by the key. */
+} DictPair;
+
+typedef struct OrderNode {
+    size_t refCount;		/* Number of parents and dictionaries that
+				 * refer to this node. */
+    size_t numSlots;		/* Room in slots. Always DICT_WIDTH above
+				 * the bottom level. */
+    union {
+	DictPair pair;		/* In the bottom level. */
+	struct OrderNode *child;/* Above it; NULL where not in use yet. */
+    } slots[TCLFLEXARRAY];
+} OrderNode;
+
+typedef struct KeySlot {
+    Tcl_Obj *keyPtr;		/* The key, or NULL if the slot holds a
+				 * subtree. */
+    size_t hash;		/* The hash of the key. */
+    union {
+	struct {
+	    size_t index;	/* The position of the pair for the key in
+				 * the order vector. */
+	    Tcl_Obj *valuePtr;	/* The value in that pair. */
+	} pair;
+	struct {
+	    struct KeyNode *node;	/* The subtree. */
+	    Tcl_WideUInt bitmap;/* Copy of the bitmap of its root, so that
+				 * lookups need not read the node's header. */
+	} child;
+    } u;
+} KeySlot;
+
+typedef struct KeyNode {
+    size_t refCount;		/* Number of parents and dictionaries that
+				 * refer to this node. */
+    Tcl_WideUInt bitmap;	/* Bit i is set when the slot for digit i is
+				 * in use. Zero in a collision node. */
+    size_t numSlots;		/* Number of slots in use. */
+    KeySlot slots[TCLFLEXARRAY];/* The slots in use, in digit order. */
+} KeyNode;
+
+#define ORDER_NODE_SIZE(numSlots) \
+    (offsetof(OrderNode, slots) + (numSlots) * sizeof(((OrderNode *) 0)->slots[0]))
+#define KEY_NODE_SIZE(numSlots) \
+    (offsetof(KeyNode, slots) + (numSlots) * sizeof(KeySlot))
+
 typedef struct Dict {
-    Tcl_HashTable table;	/* Object hash table to store mapping in. */
-    ChainEntry *entryChainHead;	/* Linked list of all entries in the
-				 * dictionary. Used for doing traversal of the
-				 * entries in the order that they are
-				 * created. */
-    ChainEntry *entryChainTail;	/* Other end of linked list of all entries in
-				 * the dictionary. Used for doing traversal of
-				 * the entries in the order that they are
-				 * created. */
+    KeyNode *keys;		/* Root of the key trie, or NULL if the
+				 * dictionary is empty. */
+    OrderNode *order;		/* Root of the order vector, or NULL if no
+				 * slot of it is in use. */
+    size_t orderShift;		/* Bits of a position consumed by the levels
+				 * above the bottom of the order vector. */
+    size_t orderSize;		/* Number of slots of the order vector in
+				 * use, including removed pairs. */
+    size_t numEntries;		/* Number of key,value pairs. */
     size_t epoch;		/* Epoch counter */
     size_t refCount;		/* Reference counter (see above) */
     Tcl_Obj *chain;		/* Linked list used for invalidating the
@@ -164,25 +237,6 @@ const Tcl_ObjType tclDictType = {
         (dictRepPtr) = irPtr ? (Dict *)irPtr->twoPtrValue.ptr1 : NULL;          \
     } while (0)
 
-/*
- * The type of the specially adapted version of the Tcl_Obj*-containing hash
- * table defined in the tclObj.c code. This version differs in that it
- * allocates a bit more space in each hash entry in order to hold the pointers
- * used to keep the hash entries in a linked list.
- *
- * Note that this type of hash table is *only* suitable for direct use in
- * *this* file. Everything else should use the dict iterator API.
- */
-
-static const Tcl_HashKeyType chainHashType = {
-    TCL_HASH_KEY_TYPE_VERSION,
-    0,
-    TclHashObjKey,
-    TclCompareObjKeys,
-    AllocChainEntry,
-    TclFreeObjEntry
-};
-
 /*
  * Structure used in implementation of 'dict map' to hold the state that gets
  * passed between parts of the implementation.
@@ -203,135 +257,714 @@ typedef struct {
 /***** START OF FUNCTIONS IMPLEMENTING DICT CORE API *****/
 
 /*
- *----------------------------------------------------------------------
- *
- * AllocChainEntry --
- *
- *	Allocate space for a Tcl_HashEntry containing the Tcl_Obj * key, and
- *	which has a bit of extra space afterwards for storing pointers to the
- *	rest of the chain of entries (the extra pointers are left NULL).
- *
- * Results:
- *	The return value is a pointer to the created entry.
- *
- * Side effects:
- *	Increments the reference count on the object.
- *
- *----------------------------------------------------------------------
+ * Helper functions that disguise most of the details relating to how the
+ * trees of a dictionary are managed. In particular, these manage the lookup
+ * of keys, the creation and removal of entries, and the copying of shared
+ * nodes that must be done before any change.
  */
 
-static Tcl_HashEntry *
-AllocChainEntry(
-    TCL_UNUSED(Tcl_HashTable *),
-    void *keyPtr)
+static inline unsigned int
+CountBits(
+    Tcl_WideUInt bits)
 {
-    Tcl_Obj *objPtr = (Tcl_Obj *)keyPtr;
-    ChainEntry *cPtr;
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned int) __builtin_popcountll(bits);
+#else
+    bits -= (bits >> 1) & 0x5555555555555555ULL;
+    bits = (bits & 0x3333333333333333ULL)
+	    + ((bits >> 2) & 0x3333333333333333ULL);
+    bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (unsigned int) ((bits * 0x0101010101010101ULL) >> 56);
+#endif
+}
 
-    cPtr = (ChainEntry *)Tcl_Alloc(sizeof(ChainEntry));
-    cPtr->entry.key.objPtr = objPtr;
-    Tcl_IncrRefCount(objPtr);
-    Tcl_SetHashValue(&cPtr->entry, NULL);
-    cPtr->prevPtr = cPtr->nextPtr = NULL;
+/*
+ * The hash of a key. The trie uses every bit of it, which rules out the
+ * string hash used by hash tables: that one gives the same value to many
+ * short keys differing only in their digits (such as "a19" and "a28"), and
+ * each such clash costs a path down to the bottom of the trie. Use FNV-1a,
+ * which is about as cheap.
+ */
+
+#if SIZE_MAX > 0xFFFFFFFF
+#define FNV_OFFSET	((size_t) 0xCBF29CE484222325ULL)
+#define FNV_PRIME	((size_t) 0x100000001B3ULL)
+#else
+#define FNV_OFFSET	((size_t) 0x811C9DC5UL)
+#define FNV_PRIME	((size_t) 0x1000193UL)
+#endif
+
+static inline size_t
+HashKey(
+    Tcl_Obj *keyPtr)
+{
+    size_t length, hash = FNV_OFFSET;
+    const unsigned char *bytes = (const unsigned char *)
+	    Tcl_GetStringFromObj(keyPtr, &length);
 
-    return &cPtr->entry;
+    while (length--) {
+	hash ^= *bytes++;
+	hash *= FNV_PRIME;
+    }
+    return hash;
 }
-
+
+static inline int
+SameKey(
+    Tcl_Obj *keyPtr,
+    Tcl_Obj *otherPtr)
+{
+    size_t length, otherLength;
+    const char *bytes, *otherBytes;
+
+    if (keyPtr == otherPtr) {
+	return 1;
+    }
+    bytes = Tcl_GetStringFromObj(keyPtr, &length);
+    otherBytes = Tcl_GetStringFromObj(otherPtr, &otherLength);
+    return (length == otherLength) && !memcmp(bytes, otherBytes, length);
+}
+
 /*
- * Helper functions that disguise most of the details relating to how the
- * linked list of hash entries is managed. In particular, these manage the
- * creation of the table and initializing of the chain, the deletion of the
- * table and chain, the adding of an entry to the chain, and the removal of an
- * entry from the chain.
+ * Nodes of the key trie.
  */
 
-static inline void
-InitChainTable(
-    Dict *dict)
+static KeyNode *
+NewKeyNode(
+    size_t numSlots)
 {
-    Tcl_InitCustomHashTable(&dict->table, TCL_CUSTOM_PTR_KEYS,
-	    &chainHashType);
-    dict->entryChainHead = dict->entryChainTail = NULL;
+    KeyNode *node = (KeyNode *)Tcl_Alloc(KEY_NODE_SIZE(numSlots));
+
+    node->refCount = 1;
+    node->bitmap = 0;
+    node->numSlots = 0;
+    return node;
 }
 
-static inline void
-DeleteChainTable(
-    Dict *dict)
+static void
+ReleaseKeyNode(
+    KeyNode *node)
 {
-    ChainEntry *cPtr;
+    size_t i;
 
-    for (cPtr=dict->entryChainHead ; cPtr!=NULL ; cPtr=cPtr->nextPtr) {
-	Tcl_Obj *valuePtr = (Tcl_Obj *)Tcl_GetHashValue(&cPtr->entry);
+    if (node->refCount-- > 1) {
+	return;
+    }
+    for (i = 0; i < node->numSlots; i++) {
+	if (node->slots[i].keyPtr == NULL) {
+	    ReleaseKeyNode(node->slots[i].u.child.node);
+	}
+    }
+    Tcl_Free(node);
+}
 
-	TclDecrRefCount(valuePtr);
+/*
+ * Returns a node that may be changed in place of the given one: the node
+ * itself when nothing else refers to it, else a copy, which takes over the
+ * caller's reference.
+ */
+
+static KeyNode *
+UniqueKeyNode(
+    KeyNode *node)
+{
+    KeyNode *copy;
+    size_t i;
+
+    if (node->refCount == 1) {
+	return node;
+    }
+    copy = (KeyNode *)Tcl_Alloc(KEY_NODE_SIZE(node->numSlots));
+    memcpy(copy, node, KEY_NODE_SIZE(node->numSlots));
+    copy->refCount = 1;
+    for (i = 0; i < copy->numSlots; i++) {
+	if (copy->slots[i].keyPtr == NULL) {
+	    copy->slots[i].u.child.node->refCount++;
+	}
     }
-    Tcl_DeleteHashTable(&dict->table);
+    node->refCount--;
+    return copy;
 }
 
-static inline Tcl_HashEntry *
-CreateChainEntry(
-    Dict *dict,
+/*
+ * Returns the slot of a key in the trie at node, which must not be empty, or
+ * NULL if the key is not there. Below the root, the bitmap of each node is
+ * taken from the slot that leads to it, so that only the slot looked at is
+ * read from the node.
+ */
+
+static KeySlot *
+FindKey(
+    KeyNode *node,
     Tcl_Obj *keyPtr,
-    int *newPtr)
+    size_t hash)
 {
-    ChainEntry *cPtr = (ChainEntry *)
-	    Tcl_CreateHashEntry(&dict->table, keyPtr, newPtr);
+    Tcl_WideUInt bit, bitmap = node->bitmap;
+    KeySlot *slotPtr;
+    size_t i, shift;
+
+    for (shift = 0; shift < DICT_HASH_BITS; shift += KEY_BITS) {
+	bit = (Tcl_WideUInt) 1 << ((hash >> shift) & KEY_MASK);
+	if (!(bitmap & bit)) {
+	    return NULL;
+	}
+	slotPtr = &node->slots[CountBits(bitmap & (bit - 1))];
+	if (slotPtr->keyPtr) {
+	    if (slotPtr->hash == hash && SameKey(keyPtr, slotPtr->keyPtr)) {
+		return slotPtr;
+	    }
+	    return NULL;
+	}
+	node = slotPtr->u.child.node;
+	bitmap = slotPtr->u.child.bitmap;
+    }
 
     /*
-     * If this is a new entry in the hash table, stitch it into the chain.
+     * A collision node.
      */
 
-    if (*newPtr) {
-	cPtr->nextPtr = NULL;
-	if (dict->entryChainHead == NULL) {
-	    cPtr->prevPtr = NULL;
-	    dict->entryChainHead = cPtr;
-	    dict->entryChainTail = cPtr;
+    for (i = 0; i < node->numSlots; i++) {
+	if (SameKey(keyPtr, node->slots[i].keyPtr)) {
+	    return &node->slots[i];
+	}
+    }
+    return NULL;
+}
+
+/*
+ * Like FindKey, but makes the nodes on the path to the key the dictionary's
+ * own on the way, so that the slot found may be changed. The root is taken
+ * from and stored back into *nodePtrPtr.
+ */
+
+static KeySlot *
+UpdateKey(
+    KeyNode **nodePtrPtr,
+    Tcl_Obj *keyPtr,
+    size_t hash)
+{
+    size_t i, shift = 0;
+
+    while (*nodePtrPtr != NULL) {
+	KeyNode *node = *nodePtrPtr = UniqueKeyNode(*nodePtrPtr);
+	KeySlot *slotPtr;
+	Tcl_WideUInt bit;
+
+	if (shift >= DICT_HASH_BITS) {
+	    for (i = 0; i < node->numSlots; i++) {
+		if (SameKey(keyPtr, node->slots[i].keyPtr)) {
+		    return &node->slots[i];
+		}
+	    }
+	    return NULL;
+	}
+	bit = (Tcl_WideUInt) 1 << ((hash >> shift) & KEY_MASK);
+	if (!(node->bitmap & bit)) {
+	    return NULL;
+	}
+	slotPtr = &node->slots[CountBits(node->bitmap & (bit - 1))];
+	if (slotPtr->keyPtr) {
+	    if (slotPtr->hash == hash && SameKey(keyPtr, slotPtr->keyPtr)) {
+		return slotPtr;
+	    }
+	    return NULL;
+	}
+	nodePtrPtr = &slotPtr->u.child.node;
+	shift += KEY_BITS;
+    }
+    return NULL;
+}
+
+/*
+ * Adds the key in *newSlotPtr, which must not be present yet, to the subtree
+ * at node (which may be NULL) at the given depth. Returns the new subtree.
+ */
+
+static KeyNode *
+InsertKey(
+    KeyNode *node,
+    size_t shift,
+    const KeySlot *newSlotPtr)
+{
+    KeySlot *slotPtr;
+    Tcl_WideUInt bit = 0;
+    size_t pos;
+
+    if (shift < DICT_HASH_BITS) {
+	bit = (Tcl_WideUInt) 1 << ((newSlotPtr->hash >> shift) & KEY_MASK);
+    }
+    if (node == NULL) {
+	node = NewKeyNode(1);
+	node->bitmap = bit;
+	node->numSlots = 1;
+	node->slots[0] = *newSlotPtr;
+	return node;
+    }
+    node = UniqueKeyNode(node);
+
+    if (bit == 0) {
+	pos = node->numSlots;
+    } else if (node->bitmap & bit) {
+	slotPtr = &node->slots[CountBits(node->bitmap & (bit - 1))];
+	if (slotPtr->keyPtr) {
+	    /*
+	     * Push the key in the slot down into a new subtree, which the
+	     * new key then joins.
+	     */
+
+	    KeyNode *child = InsertKey(NULL, shift + KEY_BITS, slotPtr);
+
+	    slotPtr->u.child.node = InsertKey(child, shift + KEY_BITS,
+		    newSlotPtr);
+	    slotPtr->keyPtr = NULL;
+	    slotPtr->hash = 0;
 	} else {
-	    cPtr->prevPtr = dict->entryChainTail;
-	    dict->entryChainTail->nextPtr = cPtr;
-	    dict->entryChainTail = cPtr;
+	    slotPtr->u.child.node = InsertKey(slotPtr->u.child.node,
+		    shift + KEY_BITS, newSlotPtr);
 	}
+	slotPtr->u.child.bitmap = slotPtr->u.child.node->bitmap;
+	return node;
+    } else {
+	pos = CountBits(node->bitmap & (bit - 1));
     }
 
-    return &cPtr->entry;
+    node = (KeyNode *)Tcl_Realloc(node, KEY_NODE_SIZE(node->numSlots + 1));
+    memmove(&node->slots[pos + 1], &node->slots[pos],
+	    (node->numSlots - pos) * sizeof(KeySlot));
+    node->slots[pos] = *newSlotPtr;
+    node->numSlots++;
+    node->bitmap |= bit;
+    return node;
 }
 
-static inline int
-DeleteChainEntry(
+/*
+ * Removes a key, which must be present, from the subtree at node at the
+ * given depth. Returns the new subtree, or NULL if it is now empty. A subtree
+ * left with a single key is replaced by that key.
+ */
+
+static KeyNode *
+RemoveKey(
+    KeyNode *node,
+    size_t shift,
+    Tcl_Obj *keyPtr,
+    size_t hash)
+{
+    KeySlot *slotPtr;
+    Tcl_WideUInt bit = 0;
+    size_t pos;
+
+    node = UniqueKeyNode(node);
+    if (shift >= DICT_HASH_BITS) {
+	for (pos = 0; !SameKey(keyPtr, node->slots[pos].keyPtr); pos++) {
+	    /* Empty loop body. */
+	}
+    } else {
+	bit = (Tcl_WideUInt) 1 << ((hash >> shift) & KEY_MASK);
+	pos = CountBits(node->bitmap & (bit - 1));
+	slotPtr = &node->slots[pos];
+	if (slotPtr->keyPtr == NULL) {
+	    KeyNode *child = RemoveKey(slotPtr->u.child.node, shift + KEY_BITS,
+		    keyPtr, hash);
+
+	    if (child != NULL) {
+		if (child->numSlots == 1 && child->slots[0].keyPtr) {
+		    *slotPtr = child->slots[0];
+		    Tcl_Free(child);
+		} else {
+		    slotPtr->u.child.node = child;
+		    slotPtr->u.child.bitmap = child->bitmap;
+		}
+		return node;
+	    }
+	}
+    }
+
+    if (node->numSlots == 1) {
+	Tcl_Free(node);
+	return NULL;
+    }
+    node->numSlots--;
+    memmove(&node->slots[pos], &node->slots[pos + 1],
+	    (node->numSlots - pos) * sizeof(KeySlot));
+    node->bitmap &= ~bit;
+    return node;
+}
+
+/*
+ * Counts the nodes below a node of the key trie, and the depth of the
+ * deepest one, for [dict info].
+ */
+
+static void
+KeyNodeStats(
+    KeyNode *node,
+    size_t depth,
+    size_t *numNodesPtr,
+    size_t *maxDepthPtr)
+{
+    size_t i;
+
+    (*numNodesPtr)++;
+    if (depth > *maxDepthPtr) {
+	*maxDepthPtr = depth;
+    }
+    for (i = 0; i < node->numSlots; i++) {
+	if (node->slots[i].keyPtr == NULL) {
+	    KeyNodeStats(node->slots[i].u.child.node, depth + 1, numNodesPtr,
+		    maxDepthPtr);
+	}
+    }
+}
+
+/*
+ * Nodes of the order vector. The shift of a node is the number of bits of a
+ * position consumed by the levels below it; it is zero in the bottom level.
+ */
+
+static OrderNode *
+NewOrderNode(
+    size_t numSlots)
+{
+    OrderNode *node = (OrderNode *)Tcl_Alloc(ORDER_NODE_SIZE(numSlots));
+
+    memset(node, 0, ORDER_NODE_SIZE(numSlots));
+    node->refCount = 1;
+    node->numSlots = numSlots;
+    return node;
+}
+
+static void
+ReleaseOrderNode(
+    OrderNode *node,
+    size_t shift)
+{
+    size_t i;
+
+    if (node->refCount-- > 1) {
+	return;
+    }
+    for (i = 0; i < node->numSlots; i++) {
+	if (shift == 0) {
+	    if (node->slots[i].pair.keyPtr) {
+		TclDecrRefCount(node->slots[i].pair.keyPtr);
+		TclDecrRefCount(node->slots[i].pair.valuePtr);
+	    }
+	} else if (node->slots[i].child) {
+	    ReleaseOrderNode(node->slots[i].child, shift - DICT_BITS);
+	}
+    }
+    Tcl_Free(node);
+}
+
+/*
+ * Returns a node that may be changed in place of the given one; see
+ * UniqueKeyNode.
+ */
+
+static OrderNode *
+UniqueOrderNode(
+    OrderNode *node,
+    size_t shift)
+{
+    OrderNode *copy;
+    size_t i;
+
+    if (node->refCount == 1) {
+	return node;
+    }
+    copy = (OrderNode *)Tcl_Alloc(ORDER_NODE_SIZE(node->numSlots));
+    memcpy(copy, node, ORDER_NODE_SIZE(node->numSlots));
+    copy->refCount = 1;
+    for (i = 0; i < copy->numSlots; i++) {
+	if (shift == 0) {
+	    if (copy->slots[i].pair.keyPtr) {
+		Tcl_IncrRefCount(copy->slots[i].pair.keyPtr);
+		Tcl_IncrRefCount(copy->slots[i].pair.valuePtr);
+	    }
+	} else if (copy->slots[i].child) {
+	    copy->slots[i].child->refCount++;
+	}
+    }
+    node->refCount--;
+    return copy;
+}
+
+/*
+ * Returns the pair at a position of the order vector, for reading.
+ */
+
+static inline DictPair *
+GetPair(
+    Dict *dict,
+    size_t index)
+{
+    OrderNode *node = dict->order;
+    size_t shift;
+
+    for (shift = dict->orderShift; shift > 0; shift -= DICT_BITS) {
+	node = node->slots[(index >> shift) & DICT_MASK].child;
+    }
+    return &node->slots[index & DICT_MASK].pair;
+}
+
+/*
+ * Returns the pair at a position of the order vector, for changing: the
+ * nodes on the path to it are made the dictionary's own. When extending the
+ * vector, missing nodes are created, and the bottom node given room for the
+ * new slot.
+ */
+
+static DictPair *
+UpdatePair(
+    Dict *dict,
+    size_t index)
+{
+    OrderNode **nodePtrPtr = &dict->order;
+    size_t slot, shift = dict->orderShift;
+
+    for (; shift > 0; shift -= DICT_BITS) {
+	*nodePtrPtr = UniqueOrderNode(*nodePtrPtr, shift);
+	nodePtrPtr = &(*nodePtrPtr)->slots[(index >> shift) & DICT_MASK].child;
+	if (*nodePtrPtr == NULL) {
+	    *nodePtrPtr = NewOrderNode(
+		    (shift > DICT_BITS) ? DICT_WIDTH : DICT_WIDTH / 4);
+	}
+    }
+    *nodePtrPtr = UniqueOrderNode(*nodePtrPtr, 0);
+    slot = index & DICT_MASK;
+    if (slot >= (*nodePtrPtr)->numSlots) {
+	size_t numSlots = (*nodePtrPtr)->numSlots, newSlots = 2 * numSlots;
+	OrderNode *node;
+
+	while (slot >= newSlots) {
+	    newSlots *= 2;
+	}
+	node = (OrderNode *)Tcl_Realloc(*nodePtrPtr, ORDER_NODE_SIZE(newSlots));
+	memset(&node->slots[numSlots], 0,
+		ORDER_NODE_SIZE(newSlots) - ORDER_NODE_SIZE(numSlots));
+	node->numSlots = newSlots;
+	*nodePtrPtr = node;
+    }
+    return &(*nodePtrPtr)->slots[slot].pair;
+}
+
+/*
+ * Adds a slot at the end of the order vector, growing the tree by a level
+ * when it is full, and returns its (empty) pair.
+ */
+
+static DictPair *
+AppendPair(
+    Dict *dict)
+{
+    size_t index = dict->orderSize;
+
+    if (dict->order == NULL) {
+	dict->order = NewOrderNode(4);
+	dict->orderShift = 0;
+    } else if ((index >> dict->orderShift) == DICT_WIDTH) {
+	OrderNode *root = NewOrderNode(DICT_WIDTH);
+
+	root->slots[0].child = dict->order;
+	dict->order = root;
+	dict->orderShift += DICT_BITS;
+    }
+    dict->orderSize++;
+    return UpdatePair(dict, index);
+}
+
+/*
+ * Functions for the whole dictionary. These are the counterparts of the
+ * Tcl_HashTable functions that the rest of this file uses.
+ */
+
+static inline void
+InitDict(
+    Dict *dict)
+{
+    dict->keys = NULL;
+    dict->order = NULL;
+    dict->orderShift = 0;
+    dict->orderSize = 0;
+    dict->numEntries = 0;
+}
+
+static void
+DeleteDictContents(
+    Dict *dict)
+{
+    if (dict->keys) {
+	ReleaseKeyNode(dict->keys);
+    }
+    if (dict->order) {
+	ReleaseOrderNode(dict->order, dict->orderShift);
+    }
+    InitDict(dict);
+}
+
+/*
+ * Returns the value for a key, or NULL if the key is not in the dictionary.
+ * Only the key trie is searched.
+ */
+
+static inline Tcl_Obj *
+FindValue(
     Dict *dict,
     Tcl_Obj *keyPtr)
 {
-    ChainEntry *cPtr = (ChainEntry *)
-	    Tcl_FindHashEntry(&dict->table, keyPtr);
+    KeySlot *slotPtr;
+
+    if (dict->keys == NULL) {
+	return NULL;
+    }
+    slotPtr = FindKey(dict->keys, keyPtr, HashKey(keyPtr));
+    return slotPtr ? slotPtr->u.pair.valuePtr : NULL;
+}
 
-    if (cPtr == NULL) {
+/*
+ * Returns the value for a key, or NULL if the key is not in the dictionary.
+ * Besides, the path to its pair is made the dictionary's own, so that the
+ * value is only shared if it really is: the caller may change it in place if
+ * it is not.
+ */
+
+static Tcl_Obj *
+FindValueForUpdate(
+    Dict *dict,
+    Tcl_Obj *keyPtr)
+{
+    KeySlot *slotPtr;
+
+    if (dict->keys == NULL) {
+	return NULL;
+    }
+    slotPtr = FindKey(dict->keys, keyPtr, HashKey(keyPtr));
+    return slotPtr ? UpdatePair(dict, slotPtr->u.pair.index)->valuePtr : NULL;
+}
+
+/*
+ * Maps a key to a value, adding a pair for the key if it is not in the
+ * dictionary yet. Returns whether it was added. The dictionary takes a
+ * reference to the value, and to the key if it is added.
+ */
+
+static int
+SetPair(
+    Dict *dict,
+    Tcl_Obj *keyPtr,
+    Tcl_Obj *valuePtr)
+{
+    KeySlot *slotPtr, newSlot;
+    DictPair *pairPtr;
+    size_t hash = HashKey(keyPtr);
+
+    Tcl_IncrRefCount(valuePtr);
+    slotPtr = UpdateKey(&dict->keys, keyPtr, hash);
+    if (slotPtr) {
+	pairPtr = UpdatePair(dict, slotPtr->u.pair.index);
+	TclDecrRefCount(pairPtr->valuePtr);
+	pairPtr->valuePtr = slotPtr->u.pair.valuePtr = valuePtr;
 	return 0;
-    } else {
-	Tcl_Obj *valuePtr = (Tcl_Obj *)Tcl_GetHashValue(&cPtr->entry);
+    }
+
+    newSlot.keyPtr = keyPtr;
+    newSlot.hash = hash;
+    newSlot.u.pair.index = dict->orderSize;
+    newSlot.u.pair.valuePtr = valuePtr;
+    dict->keys = InsertKey(dict->keys, 0, &newSlot);
+
+    pairPtr = AppendPair(dict);
+    pairPtr->keyPtr = keyPtr;
+    Tcl_IncrRefCount(keyPtr);
+    pairPtr->valuePtr = valuePtr;
+    dict->numEntries++;
+    return 1;
+}
+
+/*
+ * Removes a key and its value from the dictionary. Returns whether the key
+ * was there.
+ */
+
+static int
+DeletePair(
+    Dict *dict,
+    Tcl_Obj *keyPtr)
+{
+    KeySlot *slotPtr;
+    DictPair *pairPtr;
+    size_t hash, index;
 
-	TclDecrRefCount(valuePtr);
+    if (dict->keys == NULL) {
+	return 0;
     }
+    hash = HashKey(keyPtr);
+    slotPtr = FindKey(dict->keys, keyPtr, hash);
+    if (slotPtr == NULL) {
+	return 0;
+    }
+    index = slotPtr->u.pair.index;
+    dict->keys = RemoveKey(dict->keys, 0, keyPtr, hash);
+
+    pairPtr = UpdatePair(dict, index);
+    TclDecrRefCount(pairPtr->keyPtr);
+    TclDecrRefCount(pairPtr->valuePtr);
+    pairPtr->keyPtr = pairPtr->valuePtr = NULL;
+    dict->numEntries--;
 
     /*
-     * Unstitch from the chain.
+     * Once the removed pairs outnumber the others, rebuild the dictionary
+     * without them, so that traversals and the vector stay proportional to
+     * the size.
      */
 
-    if (cPtr->nextPtr) {
-	cPtr->nextPtr->prevPtr = cPtr->prevPtr;
-    } else {
-	dict->entryChainTail = cPtr->prevPtr;
-    }
-    if (cPtr->prevPtr) {
-	cPtr->prevPtr->nextPtr = cPtr->nextPtr;
-    } else {
-	dict->entryChainHead = cPtr->nextPtr;
-    }
+    if (dict->numEntries == 0) {
+	DeleteDictContents(dict);
+    } else if (dict->orderSize > 2 * dict->numEntries + DICT_WIDTH) {
+	Dict compact;
 
-    Tcl_DeleteHashEntry(&cPtr->entry);
+	InitDict(&compact);
+	for (index = 0; index < dict->orderSize; index++) {
+	    pairPtr = GetPair(dict, index);
+	    if (pairPtr->keyPtr) {
+		SetPair(&compact, pairPtr->keyPtr, pairPtr->valuePtr);
+	    }
+	}
+	DeleteDictContents(dict);
+	dict->keys = compact.keys;
+	dict->order = compact.order;
+	dict->orderShift = compact.orderShift;
+	dict->orderSize = compact.orderSize;
+	dict->numEntries = compact.numEntries;
+    }
     return 1;
 }
-
+
+/*
+ * Returns the first pair in the dictionary at or after a position of the
+ * order vector, and sets *indexPtr to its position; or returns NULL if there
+ * is none.
+ */
+
+static DictPair *
+NextPair(
+    Dict *dict,
+    size_t *indexPtr)
+{
+    size_t index;
+
+    for (index = *indexPtr; index < dict->orderSize; index++) {
+	DictPair *pairPtr = GetPair(dict, index);
+
+	if (pairPtr->keyPtr) {
+	    *indexPtr = index;
+	    return pairPtr;
+	}
+    }
+    return NULL;
+}
+
 /*
  *----------------------------------------------------------------------
  *
@@ -346,10 +979,10 @@ DeleteChainEntry(
  * Side effects:
  *	"srcPtr"s dictionary internal rep pointer should not be NULL and we
  *	assume it is not NULL. We set "copyPtr"s internal rep to a pointer to
- *	a newly allocated dictionary rep that, in turn, points to "srcPtr"s
- *	key and value objects. Those objects are not actually copied but are
- *	shared between "srcPtr" and "copyPtr". The ref count of each key and
- *	value object is incremented.
+ *	a newly allocated dictionary rep that, in turn, shares the trees of
+ *	"srcPtr"s dictionary rep, holding the key and value objects. Neither
+ *	those nor the nodes are actually copied; each dictionary copies the
+ *	shared nodes it changes when it changes them.
  *
  *----------------------------------------------------------------------
  */
@@ -360,28 +993,24 @@ DupDictInternalRep(
     Tcl_Obj *copyPtr)
 {
     Dict *oldDict, *newDict = (Dict *)Tcl_Alloc(sizeof(Dict));
-    ChainEntry *cPtr;
 
     DictGetInternalRep(srcPtr, oldDict);
 
     /*
-     * Copy values across from the old hash table.
+     * Share the trees of the old dictionary.
      */
 
-    InitChainTable(newDict);
-    for (cPtr=oldDict->entryChainHead ; cPtr!=NULL ; cPtr=cPtr->nextPtr) {
-	Tcl_Obj *key = (Tcl_Obj *)Tcl_GetHashKey(&oldDict->table, &cPtr->entry);
-	Tcl_Obj *valuePtr = (Tcl_Obj *)Tcl_GetHashValue(&cPtr->entry);
-	int n;
-	Tcl_HashEntry *hPtr = CreateChainEntry(newDict, key, &n);
-
-	/*
-	 * Fill in the contents.
-	 */
-
-	Tcl_SetHashValue(hPtr, valuePtr);
-	Tcl_IncrRefCount(valuePtr);
+    newDict->keys = oldDict->keys;
+    if (newDict->keys) {
+	newDict->keys->refCount++;
     }
+    newDict->order = oldDict->order;
+    if (newDict->order) {
+	newDict->order->refCount++;
+    }
+    newDict->orderShift = oldDict->orderShift;
+    newDict->orderSize = oldDict->orderSize;
+    newDict->numEntries = oldDict->numEntries;
 
     /*
      * Initialise other fields.
@@ -410,7 +1039,7 @@ DupDictInternalRep(
  *	None
  *
  * Side effects:
- *	Frees the memory holding the dictionary's internal hash table unless
+ *	Frees the memory holding the dictionary's internal trees unless
  *	it is locked by an iteration going over it.
  *
  *----------------------------------------------------------------------
@@ -453,7 +1082,7 @@ static void
 DeleteDict(
     Dict *dict)
 {
-    DeleteChainTable(dict);
+    DeleteDictContents(dict);
     Tcl_Free(dict);
 }
 
@@ -486,24 +1115,19 @@ UpdateStringOfDict(
 #define LOCAL_SIZE 64
     char localFlags[LOCAL_SIZE], *flagPtr = NULL;
     Dict *dict;
-    ChainEntry *cPtr;
+    DictPair *pairPtr;
     Tcl_Obj *keyPtr, *valuePtr;
-    size_t i, length, bytesNeeded = 0;
+    size_t i, index, length, bytesNeeded = 0;
     const char *elem;
     char *dst;
 
-    /*
-     * This field is the most useful one in the whole hash structure, and it
-     * is not exposed by any API function...
-     */
-
     size_t numElems;
 
     DictGetInternalRep(dictPtr, dict);
 
     assert (dict != NULL);
 
-    numElems = dict->table.numEntries * 2;
+    numElems = dict->numEntries * 2;
 
     /* Handle empty list case first, simplifies what follows */
     if (numElems == 0) {
@@ -520,18 +1144,19 @@ UpdateStringOfDict(
     } else {
 	flagPtr = (char *)Tcl_Alloc(numElems);
     }
-    for (i=0,cPtr=dict->entryChainHead; i<numElems; i+=2,cPtr=cPtr->nextPtr) {
+    for (i=0,index=0; i<numElems; i+=2,index++) {
 	/*
-	 * Assume that cPtr is never NULL since we know the number of array
+	 * Assume that pairPtr is never NULL since we know the number of array
 	 * elements already.
 	 */
 
+	pairPtr = NextPair(dict, &index);
 	flagPtr[i] = ( i ? TCL_DONT_QUOTE_HASH : 0 );
-	keyPtr = (Tcl_Obj *)Tcl_GetHashKey(&dict->table, &cPtr->entry);
+	keyPtr = pairPtr->keyPtr;
 	elem = Tcl_GetStringFromObj(keyPtr, &length);
 	bytesNeeded += TclScanElement(elem, length, flagPtr+i);
 	flagPtr[i+1] = TCL_DONT_QUOTE_HASH;
-	valuePtr = (Tcl_Obj *)Tcl_GetHashValue(&cPtr->entry);
+	valuePtr = pairPtr->valuePtr;
 	elem = Tcl_GetStringFromObj(valuePtr, &length);
 	bytesNeeded += TclScanElement(elem, length, flagPtr+i+1);
     }
@@ -543,15 +1168,16 @@ UpdateStringOfDict(
 
     dst = Tcl_InitStringRep(dictPtr, NULL, bytesNeeded - 1);
     TclOOM(dst, bytesNeeded);
-    for (i=0,cPtr=dict->entryChainHead; i<numElems; i+=2,cPtr=cPtr->nextPtr) {
+    for (i=0,index=0; i<numElems; i+=2,index++) {
+	pairPtr = NextPair(dict, &index);
 	flagPtr[i] |= ( i ? TCL_DONT_QUOTE_HASH : 0 );
-	keyPtr = (Tcl_Obj *)Tcl_GetHashKey(&dict->table, &cPtr->entry);
+	keyPtr = pairPtr->keyPtr;
 	elem = Tcl_GetStringFromObj(keyPtr, &length);
 	dst += TclConvertElement(elem, length, dst, flagPtr[i]);
 	*dst++ = ' ';
 
 	flagPtr[i+1] |= TCL_DONT_QUOTE_HASH;
-	valuePtr = (Tcl_Obj *)Tcl_GetHashValue(&cPtr->entry);
+	valuePtr = pairPtr->valuePtr;
 	elem = Tcl_GetStringFromObj(valuePtr, &length);
 	dst += TclConvertElement(elem, length, dst, flagPtr[i+1]);
 	*dst++ = ' ';
@@ -589,11 +1215,9 @@ SetDictFromAny(
     Tcl_Interp *interp,
     Tcl_Obj *objPtr)
 {
-    Tcl_HashEntry *hPtr;
-    int isNew;
     Dict *dict = (Dict *)Tcl_Alloc(sizeof(Dict));
 
-    InitChainTable(dict);
+    InitDict(dict);
 
     /*
      * Since lists and dictionaries have very closely-related string
@@ -601,7 +1225,8 @@ SetDictFromAny(
      * the conversion from lists to dictionaries.
      */
 
-    if (TclHasInternalRep(objPtr, &tclListType)) {
+    if (TclHasInternalRep(objPtr, &tclListType)
+	    || TclHasInternalRep(objPtr, &tclListTreeType)) {
 	int objc, i;
 	Tcl_Obj **objv;
 
@@ -613,11 +1238,8 @@ SetDictFromAny(
 
 	for (i=0 ; i<objc ; i+=2) {
 
-	    /* Store key and value in the hash table we're building. */
-	    hPtr = CreateChainEntry(dict, objv[i], &isNew);
-	    if (!isNew) {
-		Tcl_Obj *discardedValue = (Tcl_Obj *)Tcl_GetHashValue(hPtr);
-
+	    /* Store key and value in the dictionary we're building. */
+	    if (!SetPair(dict, objv[i], objv[i+1])) {
 		/*
 		 * Not really a well-formed dictionary as there are duplicate
 		 * keys, so better get the string rep here so that we can
@@ -625,11 +1247,7 @@ SetDictFromAny(
 		 */
 
 		(void) TclGetString(objPtr);
-
-		TclDecrRefCount(discardedValue);
 	    }
-	    Tcl_SetHashValue(hPtr, objv[i+1]);
-	    Tcl_IncrRefCount(objv[i+1]); /* Since hash now holds ref to it */
 	}
     } else {
 	size_t length;
@@ -687,16 +1305,10 @@ SetDictFromAny(
 			TclCopyAndCollapse(elemSize, elemStart, dst));
 	    }
 
-	    /* Store key and value in the hash table we're building. */
-	    hPtr = CreateChainEntry(dict, keyPtr, &isNew);
-	    if (!isNew) {
-		Tcl_Obj *discardedValue = (Tcl_Obj *)Tcl_GetHashValue(hPtr);
-
+	    /* Store key and value in the dictionary we're building. */
+	    if (!SetPair(dict, keyPtr, valuePtr)) {
 		TclDecrRefCount(keyPtr);
-		TclDecrRefCount(discardedValue);
 	    }
-	    Tcl_SetHashValue(hPtr, valuePtr);
-	    Tcl_IncrRefCount(valuePtr); /* since hash now holds ref to it */
 	}
     }
 
@@ -719,7 +1331,7 @@ SetDictFromAny(
 	Tcl_SetErrorCode(interp, "TCL", "VALUE", "DICTIONARY", NULL);
     }
   errorInFindDictElement:
-    DeleteChainTable(dict);
+    DeleteDictContents(dict);
     Tcl_Free(dict);
     return TCL_ERROR;
 }
@@ -796,12 +1408,10 @@ TclTraceDictPath(
     }
 
     for (i=0 ; i<keyc ; i++) {
-	Tcl_HashEntry *hPtr = Tcl_FindHashEntry(&dict->table, keyv[i]);
-	Tcl_Obj *tmpObj;
-
-	if (hPtr == NULL) {
-	    int isNew;			/* Dummy */
+	Tcl_Obj *tmpObj = (flags & DICT_PATH_UPDATE)
+		? FindValueForUpdate(dict, keyv[i]) : FindValue(dict, keyv[i]);
 
+	if (tmpObj == NULL) {
 	    if (flags & DICT_PATH_EXISTS) {
 		return DICT_PATH_NON_EXISTENT;
 	    }
@@ -816,17 +1426,9 @@ TclTraceDictPath(
 		return NULL;
 	    }
 
-	    /*
-	     * The next line should always set isNew to 1.
-	     */
-
-	    hPtr = CreateChainEntry(dict, keyv[i], &isNew);
 	    tmpObj = Tcl_NewDictObj();
-	    Tcl_IncrRefCount(tmpObj);
-	    Tcl_SetHashValue(hPtr, tmpObj);
+	    SetPair(dict, keyv[i], tmpObj);
 	} else {
-	    tmpObj = (Tcl_Obj *)Tcl_GetHashValue(hPtr);
-
 	    DictGetInternalRep(tmpObj, newDict);
 
 	    if (newDict == NULL) {
@@ -839,10 +1441,8 @@ TclTraceDictPath(
 	DictGetInternalRep(tmpObj, newDict);
 	if (flags & DICT_PATH_UPDATE) {
 	    if (Tcl_IsShared(tmpObj)) {
-		TclDecrRefCount(tmpObj);
 		tmpObj = Tcl_DuplicateObj(tmpObj);
-		Tcl_IncrRefCount(tmpObj);
-		Tcl_SetHashValue(hPtr, tmpObj);
+		SetPair(dict, keyv[i], tmpObj);
 		dict->epoch++;
 		DictGetInternalRep(tmpObj, newDict);
 	    }
@@ -927,8 +1527,6 @@ Tcl_DictObjPut(
     Tcl_Obj *valuePtr)
 {
     Dict *dict;
-    Tcl_HashEntry *hPtr;
-    int isNew;
 
     if (Tcl_IsShared(dictPtr)) {
 	Tcl_Panic("%s called with shared object", "Tcl_DictObjPut");
@@ -940,17 +1538,10 @@ Tcl_DictObjPut(
     }
 
     TclInvalidateStringRep(dictPtr);
-    hPtr = CreateChainEntry(dict, keyPtr, &isNew);
+    SetPair(dict, keyPtr, valuePtr);
     dict->refCount++;
     TclFreeInternalRep(dictPtr)
     DictSetInternalRep(dictPtr, dict);
-    Tcl_IncrRefCount(valuePtr);
-    if (!isNew) {
-	Tcl_Obj *oldValuePtr = (Tcl_Obj *)Tcl_GetHashValue(hPtr);
-
-	TclDecrRefCount(oldValuePtr);
-    }
-    Tcl_SetHashValue(hPtr, valuePtr);
     dict->epoch++;
     return TCL_OK;
 }
@@ -983,7 +1574,6 @@ Tcl_DictObjGet(
     Tcl_Obj **valuePtrPtr)
 {
     Dict *dict;
-    Tcl_HashEntry *hPtr;
 
     dict = GetDictFromObj(interp, dictPtr);
     if (dict == NULL) {
@@ -991,12 +1581,14 @@ Tcl_DictObjGet(
 	return TCL_ERROR;
     }
 
-    hPtr = Tcl_FindHashEntry(&dict->table, keyPtr);
-    if (hPtr == NULL) {
-	*valuePtrPtr = NULL;
-    } else {
-	*valuePtrPtr = (Tcl_Obj *)Tcl_GetHashValue(hPtr);
-    }
+    /*
+     * Callers holding the only reference to the dictionary may change the
+     * value in place when it is not otherwise shared, so make sure that it
+     * is not reachable through nodes shared with some other dictionary.
+     */
+
+    *valuePtrPtr = Tcl_IsShared(dictPtr)
+	    ? FindValue(dict, keyPtr) : FindValueForUpdate(dict, keyPtr);
     return TCL_OK;
 }
 
@@ -1036,7 +1628,7 @@ Tcl_DictObjRemove(
 	return TCL_ERROR;
     }
 
-    if (DeleteChainEntry(dict, keyPtr)) {
+    if (DeletePair(dict, keyPtr)) {
 	TclInvalidateStringRep(dictPtr);
 	dict->epoch++;
     }
@@ -1074,7 +1666,7 @@ Tcl_DictObjSize(
 	return TCL_ERROR;
     }
 
-    *sizePtr = dict->table.numEntries;
+    *sizePtr = dict->numEntries;
     return TCL_OK;
 }
 
@@ -1118,28 +1710,35 @@ Tcl_DictObjFirst(
 				 * otherwise. */
 {
     Dict *dict;
-    ChainEntry *cPtr;
+    DictPair *pairPtr;
+    size_t index = 0;
 
     dict = GetDictFromObj(interp, dictPtr);
     if (dict == NULL) {
 	return TCL_ERROR;
     }
 
-    cPtr = dict->entryChainHead;
-    if (cPtr == NULL) {
+    pairPtr = NextPair(dict, &index);
+    if (pairPtr == NULL) {
 	searchPtr->epoch = 0;
 	*donePtr = 1;
     } else {
+	/*
+	 * The search remembers the position in the order vector of the next
+	 * pair to look at, not a pointer to it: the nodes holding the pairs
+	 * may be copied by lookups that do not count as modifications.
+	 */
+
 	*donePtr = 0;
 	searchPtr->dictionaryPtr = (Tcl_Dict) dict;
 	searchPtr->epoch = dict->epoch;
-	searchPtr->next = cPtr->nextPtr;
+	searchPtr->next = INT2PTR(index + 1);
 	dict->refCount++;
 	if (keyPtrPtr != NULL) {
-	    *keyPtrPtr = (Tcl_Obj *)Tcl_GetHashKey(&dict->table, &cPtr->entry);
+	    *keyPtrPtr = pairPtr->keyPtr;
 	}
 	if (valuePtrPtr != NULL) {
-	    *valuePtrPtr = (Tcl_Obj *)Tcl_GetHashValue(&cPtr->entry);
+	    *valuePtrPtr = pairPtr->valuePtr;
 	}
     }
     return TCL_OK;
@@ -1182,7 +1781,8 @@ Tcl_DictObjNext(
 				 * values in the dictionary, or a 0
 				 * otherwise. */
 {
-    ChainEntry *cPtr;
+    DictPair *pairPtr;
+    size_t index;
 
     /*
      * If the searh is done; we do no work.
@@ -1202,21 +1802,21 @@ Tcl_DictObjNext(
 	Tcl_Panic("concurrent dictionary modification and search");
     }
 
-    cPtr = (ChainEntry *)searchPtr->next;
-    if (cPtr == NULL) {
+    index = PTR2UINT(searchPtr->next);
+    pairPtr = NextPair((Dict *)searchPtr->dictionaryPtr, &index);
+    if (pairPtr == NULL) {
 	Tcl_DictObjDone(searchPtr);
 	*donePtr = 1;
 	return;
     }
 
-    searchPtr->next = cPtr->nextPtr;
+    searchPtr->next = INT2PTR(index + 1);
     *donePtr = 0;
     if (keyPtrPtr != NULL) {
-	*keyPtrPtr = (Tcl_Obj *)Tcl_GetHashKey(
-		&((Dict *)searchPtr->dictionaryPtr)->table, &cPtr->entry);
+	*keyPtrPtr = pairPtr->keyPtr;
     }
     if (valuePtrPtr != NULL) {
-	*valuePtrPtr = (Tcl_Obj *)Tcl_GetHashValue(&cPtr->entry);
+	*valuePtrPtr = pairPtr->valuePtr;
     }
 }
 
@@ -1283,8 +1883,6 @@ Tcl_DictObjPutKeyList(
     Tcl_Obj *valuePtr)
 {
     Dict *dict;
-    Tcl_HashEntry *hPtr;
-    int isNew;
 
     if (Tcl_IsShared(dictPtr)) {
 	Tcl_Panic("%s called with shared object", "Tcl_DictObjPutKeyList");
@@ -1300,14 +1898,7 @@ Tcl_DictObjPutKeyList(
 
     DictGetInternalRep(dictPtr, dict);
     assert(dict != NULL);
-    hPtr = CreateChainEntry(dict, keyv[keyc-1], &isNew);
-    Tcl_IncrRefCount(valuePtr);
-    if (!isNew) {
-	Tcl_Obj *oldValuePtr = (Tcl_Obj *)Tcl_GetHashValue(hPtr);
-
-	TclDecrRefCount(oldValuePtr);
-    }
-    Tcl_SetHashValue(hPtr, valuePtr);
+    SetPair(dict, keyv[keyc-1], valuePtr);
     InvalidateDictChain(dictPtr);
 
     return TCL_OK;
@@ -1358,7 +1949,7 @@ Tcl_DictObjRemoveKeyList(
 
     DictGetInternalRep(dictPtr, dict);
     assert(dict != NULL);
-    DeleteChainEntry(dict, keyv[keyc-1]);
+    DeletePair(dict, keyv[keyc-1]);
     InvalidateDictChain(dictPtr);
     return TCL_OK;
 }
@@ -1399,7 +1990,7 @@ Tcl_NewDictObj(void)
     TclNewObj(dictPtr);
     TclInvalidateStringRep(dictPtr);
     dict = (Dict *)Tcl_Alloc(sizeof(Dict));
-    InitChainTable(dict);
+    InitDict(dict);
     dict->epoch = 1;
     dict->chain = NULL;
     dict->refCount = 1;
@@ -1447,7 +2038,7 @@ Tcl_DbNewDictObj(
     TclDbNewObj(dictPtr, file, line);
     TclInvalidateStringRep(dictPtr);
     dict = (Dict *)Tcl_Alloc(sizeof(Dict));
-    InitChainTable(dict);
+    InitDict(dict);
     dict->epoch = 1;
     dict->chain = NULL;
     dict->refCount = 1;
@@ -2102,7 +2693,7 @@ DictInfoCmd(
     Tcl_Obj *const *objv)
 {
     Dict *dict;
-    char *statsStr;
+    size_t numNodes = 0, maxDepth = 0;
 
     if (objc != 2) {
 	Tcl_WrongNumArgs(interp, 1, objv, "dictionary");
@@ -2114,9 +2705,18 @@ DictInfoCmd(
 	return TCL_ERROR;
     }
 
-    statsStr = Tcl_HashStats(&dict->table);
-    Tcl_SetObjResult(interp, Tcl_NewStringObj(statsStr, -1));
-    Tcl_Free(statsStr);
+    if (dict->keys) {
+	KeyNodeStats(dict->keys, 1, &numNodes, &maxDepth);
+    }
+    Tcl_SetObjResult(interp, Tcl_ObjPrintf(
+	    "%" TCL_Z_MODIFIER "u entries\n"
+	    "order vector: %" TCL_Z_MODIFIER "u slots, %" TCL_Z_MODIFIER
+	    "u removed, %" TCL_Z_MODIFIER "u levels\n"
+	    "key trie: %" TCL_Z_MODIFIER "u nodes, depth %" TCL_Z_MODIFIER "u",
+	    dict->numEntries, dict->orderSize,
+	    dict->orderSize - dict->numEntries,
+	    dict->order ? dict->orderShift / DICT_BITS + 1 : 0,
+	    numNodes, maxDepth));
     return TCL_OK;
 }
 
@@ -2178,6 +2778,15 @@ DictIncrCmd(
 	TclNewObj(dictPtr);
 	TclInvalidateStringRep(dictPtr);
 	DupDictInternalRep(oldPtr, dictPtr);
+
+	/*
+	 * The copy shares the value with the original; look it up again so
+	 * that the copy holds its own reference to it.
+	 */
+
+	if (valuePtr != NULL) {
+	    Tcl_DictObjGet(NULL, dictPtr, objv[2], &valuePtr);
+	}
     }
     if (valuePtr == NULL) {
 	/*
@@ -82,8 +82,84 @@ typedef struct {
 				 * is no corresponding character the encoding,
 				 * the value in the matrix is 0x0000.
 				 * malloc'd. */
+    int asciiPlain;		/* Non-zero if the bytes 0x01-0x7F stand for
+				 * themselves and none of them is a lead
+				 * byte, so that runs of them can be copied
+				 * as they are. */
 } TableEncodingData;
 
+/*
+ * Shortest run of ASCII worth handing to the bulk conversions in tclUtf.c.
+ * The procs below only look for one where the source address is a multiple
+ * of ENCODING_BULK_MIN code units, and only try it when the next 16 bytes
+ * are plain ASCII, 0x01-0x7F, so that text with only short runs of ASCII
+ * pays next to nothing for them. Keeping no further state in the loops
+ * matters as much: they are tight on registers already.
+ */
+
+#define ENCODING_BULK_MIN 16
+#define BULK_BOUNDARY(src, unitSize) \
+	(!((size_t) (src) & ((unitSize) * ENCODING_BULK_MIN - 1)))
+#define PLAIN_ONES	((Tcl_WideUInt) 0x0101010101010101)
+#define PLAIN_UNIT_ONES	((Tcl_WideUInt) 0x0001000100010001)
+
+static inline int
+PlainAsciiAhead(
+    const char *src)
+{
+    Tcl_WideUInt w1, w2;
+
+    memcpy(&w1, src, sizeof(w1));
+    memcpy(&w2, src + sizeof(w1), sizeof(w2));
+    return !((w1 | w2 | ((w1 - PLAIN_ONES) & ~w1)
+	    | ((w2 - PLAIN_ONES) & ~w2)) & (PLAIN_ONES << 7));
+}
+
+static inline int
+PlainUtf16Ahead(
+    const char *src,
+    int le)
+{
+    Tcl_WideUInt w[2];
+    int i;
+#ifdef WORDS_BIGENDIAN
+    int swap = le;
+#else
+    int swap = !le;
+#endif
+
+    memcpy(w, src, sizeof(w));
+    for (i = 0; i < 2; i++) {
+	if (swap) {
+	    w[i] = ((w[i] & (PLAIN_UNIT_ONES * 0xFF)) << 8)
+		    | ((w[i] >> 8) & (PLAIN_UNIT_ONES * 0xFF));
+	}
+	if ((w[i] & (PLAIN_UNIT_ONES * 0xFF80))
+		|| ((w[i] - PLAIN_UNIT_ONES) & (PLAIN_UNIT_ONES << 15))) {
+	    return 0;
+	}
+    }
+    return 1;
+}
+
+/*
+ * The number of characters a bulk conversion may handle: the fewest of those
+ * left in the source, those with room in the output and those left under
+ * the character limit.
+ */
+
+static inline size_t
+BulkRoom(
+    size_t srcRoom,
+    size_t dstRoom,
+    size_t charRoom)
+{
+    if (srcRoom > dstRoom) {
+	srcRoom = dstRoom;
+    }
+    return (srcRoom > charRoom) ? charRoom : srcRoom;
+}
+
 /*
  * Each of the following structures is the clientData for a dynamically-loaded
  * escape-driven encoding that is itself comprised of other simpler encodings.
@@ -641,6 +717,7 @@ TclInitEncodingSubsystem(void)
 	dataPtr->toUnicode[0][i] = i;
 	dataPtr->fromUnicode[0][i] = i;
     }
+    dataPtr->asciiPlain = 1;
 
     type.encodingName	= "iso8859-1";
     type.toUtfProc	= Iso88591ToUtfProc;
@@ -2001,6 +2078,14 @@ LoadTableEncoding(
   doneParse:
     Tcl_DStringFree(&lineString);
 
+    dataPtr->asciiPlain = 1;
+    for (lo = 1; lo < 0x80; lo++) {
+	if (dataPtr->prefixBytes[lo] || (dataPtr->toUnicode[0][lo] != lo)) {
+	    dataPtr->asciiPlain = 0;
+	    break;
+	}
+    }
+
     /*
      * Package everything into an encoding structure.
      */
@@ -2283,9 +2368,23 @@ UtfToUtfProc(
 	if (UCHAR(*src) < 0x80 && !((UCHAR(*src) == 0) && (flags & TCL_ENCODING_MODIFIED))) {
 	    /*
 	     * Copy 7bit characters, but skip null-bytes when we are in input
-	     * mode, so that they get converted to 0xC080.
+	     * mode, so that they get converted to 0xC080. Long runs are
+	     * copied in bulk, as far as the output space and character limit
+	     * allow.
 	     */
 
+	    size_t room = srcEnd - src;
+
+	    if (BULK_BOUNDARY(src, 1) && (room >= ENCODING_BULK_MIN)) {
+		if (PlainAsciiAhead(src)) {
+		    room = TclAsciiCopy(src, BulkRoom(room, dstEnd - dst + 1,
+			    (size_t) (charLimit - numChars) + 1), dst);
+		    src += room;
+		    dst += room;
+		    numChars += room - 1;
+		    continue;
+		}
+	    }
 	    *dst++ = *src++;
 	} else if ((UCHAR(*src) == 0xC0) && (src + 1 < srcEnd)
 		&& (UCHAR(src[1]) == 0x80) && !(flags & TCL_ENCODING_MODIFIED)) {
@@ -2295,6 +2394,16 @@ UtfToUtfProc(
 
 	    *dst++ = 0;
 	    src += 2;
+	} else if (((unsigned) (UCHAR(*src) - 0xC2) < 0x1E) && (src + 1 < srcEnd)
+		&& ((src[1] & 0xC0) == 0x80)
+		&& ((flags & TCL_ENCODING_UTF) || (UCHAR(*src) < 0xD0))) {
+	    /*
+	     * Well-formed two byte characters stand for themselves, except
+	     * for those above U+03FF in CESU-8.
+	     */
+
+	    *dst++ = *src++;
+	    *dst++ = *src++;
 	} else if (!Tcl_UtfCharComplete(src, srcEnd - src)) {
 	    /*
 	     * Always check before using TclUtfToUCS4. Not doing can so
@@ -2665,7 +2774,32 @@ Utf16ToUtfProc(
 	 */
 
 	if (ch && ch < 0x80) {
+	    size_t room = (srcEnd - src) / 2;
+
+	    if (BULK_BOUNDARY(src, 2) && (room >= ENCODING_BULK_MIN)) {
+		/*
+		 * A run of ASCII, narrowed in bulk as far as the output space
+		 * and character limit allow.
+		 */
+
+		if (PlainUtf16Ahead(src, flags & TCL_ENCODING_LE)) {
+		    room = TclUtf16ToAscii(src, BulkRoom(room,
+			    dstEnd - dst + 1, (size_t) (charLimit - numChars) + 1),
+			    flags & TCL_ENCODING_LE, dst);
+		    src += 2 * room;
+		    dst += room;
+		    numChars += room - 1;
+		    continue;
+		}
+	    }
 	    *dst++ = (ch & 0xFF);
+	} else if (ch < 0x800) {
+	    /*
+	     * As are the two byte ones, \0 included.
+	     */
+
+	    *dst++ = (char) (0xC0 | (ch >> 6));
+	    *dst++ = (char) (0x80 | (ch & 0x3F));
 	} else {
 	    dst += Tcl_UniCharToUtf(ch, dst);
 	}
@@ -2747,13 +2881,39 @@ UtfToUtf16Proc(
 	    result = TCL_CONVERT_NOSPACE;
 	    break;
 	}
-	len = TclUtfToUCS4(src, &ch);
-	if (!Tcl_UniCharIsUnicode(ch)) {
-	    if (!(flags & TCL_ENCODING_NOCOMPLAIN)) {
-		result = TCL_CONVERT_UNKNOWN;
-		break;
+	if (BULK_BOUNDARY(src, 1) && (srcEnd - src >= ENCODING_BULK_MIN)) {
+	    /*
+	     * A run of ASCII, widened in bulk as far as the output space
+	     * allows.
+	     */
+
+	    if (PlainAsciiAhead(src)) {
+		size_t room = TclAsciiToUtf16(src, BulkRoom(srcEnd - src,
+			(dstEnd - dst) / 2 + 1, srcEnd - src),
+			flags & TCL_ENCODING_LE, dst);
+
+		src += room;
+		dst += 2 * room;
+		numChars += room - 1;
+		continue;
+	    }
+	}
+	if (UCHAR(*src) < 0x80) {
+	    /*
+	     * Special case for 1-byte utf chars for speed.
+	     */
+
+	    ch = UCHAR(*src);
+	    len = 1;
+	} else {
+	    len = TclUtfToUCS4(src, &ch);
+	    if (!Tcl_UniCharIsUnicode(ch)) {
+		if (!(flags & TCL_ENCODING_NOCOMPLAIN)) {
+		    result = TCL_CONVERT_UNKNOWN;
+		    break;
+		}
+		ch = 0xFFFD;
 	    }
-	    ch = 0xFFFD;
 	}
 	src += len;
 	if (flags & TCL_ENCODING_LE) {
@@ -2931,7 +3091,7 @@ TableToUtfProc(
 {
     const char *srcStart, *srcEnd;
     const char *dstEnd, *dstStart, *prefixBytes;
-    int result, byte, numChars, charLimit = INT_MAX;
+    int result, byte, numChars, charLimit = INT_MAX, asciiPlain;
     Tcl_UniChar ch = 0;
     const unsigned short *const *toUnicode;
     const unsigned short *pageZero;
@@ -2949,6 +3109,7 @@ TableToUtfProc(
     toUnicode = (const unsigned short *const *) dataPtr->toUnicode;
     prefixBytes = dataPtr->prefixBytes;
     pageZero = toUnicode[0];
+    asciiPlain = dataPtr->asciiPlain;
 
     result = TCL_OK;
     for (numChars = 0; src < srcEnd && numChars <= charLimit; numChars++) {
@@ -2957,6 +3118,23 @@ TableToUtfProc(
 	    break;
 	}
 	byte = *((unsigned char *) src);
+	if ((byte < 0x80) && asciiPlain && BULK_BOUNDARY(src, 1)
+		&& (srcEnd - src >= ENCODING_BULK_MIN)) {
+	    /*
+	     * A run of ASCII, which this encoding leaves as it is.
+	     */
+
+	    if (PlainAsciiAhead(src)) {
+		size_t room = TclAsciiCopy(src, BulkRoom(srcEnd - src,
+			dstEnd - dst + 1, (size_t) (charLimit - numChars) + 1),
+			dst);
+
+		src += room;
+		dst += room;
+		numChars += room - 1;
+		continue;
+	    }
+	}
 	if (prefixBytes[byte]) {
 	    src++;
 	    if (src >= srcEnd) {
@@ -2980,11 +3158,14 @@ TableToUtfProc(
 	}
 
 	/*
-	 * Special case for 1-byte utf chars for speed.
+	 * Special case for 1- and 2-byte utf chars for speed.
 	 */
 
 	if (ch && ch < 0x80) {
 	    *dst++ = (char) ch;
+	} else if (ch < 0x800) {
+	    *dst++ = (char) (0xC0 | (ch >> 6));
+	    *dst++ = (char) (0x80 | (ch & 0x3F));
 	} else {
 	    dst += Tcl_UniCharToUtf(ch, dst);
 	}
@@ -3179,13 +3360,31 @@ Iso88591ToUtfProc(
 	ch = (Tcl_UniChar) *((unsigned char *) src);
 
 	/*
-	 * Special case for 1-byte utf chars for speed.
+	 * Special case for 1-byte utf chars for speed, and for runs of them
+	 * even more so.
 	 */
 
 	if (ch && ch < 0x80) {
+	    size_t room = srcEnd - src;
+
+	    if (BULK_BOUNDARY(src, 1) && (room >= ENCODING_BULK_MIN)) {
+		if (PlainAsciiAhead(src)) {
+		    room = TclAsciiCopy(src, BulkRoom(room, dstEnd - dst + 1,
+			    (size_t) (charLimit - numChars) + 1), dst);
+		    src += room;
+		    dst += room;
+		    numChars += room - 1;
+		    continue;
+		}
+	    }
 	    *dst++ = (char) ch;
 	} else {
-	    dst += Tcl_UniCharToUtf(ch, dst);
+	    /*
+	     * Everything else, \0 included, takes two bytes.
+	     */
+
+	    *dst++ = (char) (0xC0 | (ch >> 6));
+	    *dst++ = (char) (0x80 | (ch & 0x3F));
 	}
 	src++;
     }
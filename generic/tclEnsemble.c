@@ -3123,6 +3123,7 @@ TclCompileEnsemble(
     oldCmdPtr = cmdPtr;
     Tcl_IncrRefCount(targetCmdObj);
     newCmdPtr = (Command *) Tcl_GetCommandFromObj(interp, targetCmdObj);
+    TclNoteCompiledCommand(envPtr, targetCmdObj, newCmdPtr);
     TclDecrRefCount(targetCmdObj);
     if (newCmdPtr == NULL || Tcl_IsSafe(interp)
 	    || newCmdPtr->nsPtr->flags & NS_SUPPRESS_COMPILATION
@@ -216,7 +216,7 @@ VarHashCreateVar(
 		}						\
 	    }							\
 	    pc += (pcAdjustment);				\
-	    goto cleanup0;					\
+	    NEXT_DISPATCH();					\
 	} else if (resultHandling != 0) {			\
 	    if ((resultHandling) > 0) {				\
 		Tcl_IncrRefCount(objResultPtr);			\
@@ -326,6 +326,84 @@ VarHashCreateVar(
     } while (0)
 #endif
 
+/*
+ * Threaded-code dispatch. With compilers that can take the address of a
+ * label (gcc, clang and compatibles) the code for each opcode gets a label
+ * target_<opcode>, and the most frequent instruction endings jump straight
+ * to the next instruction through a table of those labels, instead of all
+ * funnelling through the single indirect jump of the big switch. Having one
+ * indirect branch per instruction ending gives the CPU's branch predictor
+ * far more context, which pays off in tight loops.
+ *
+ * The switch remains the portable fallback, and is also used when compiling
+ * with TCL_COMPILE_DEBUG, TCL_COMPILE_STATS or DTrace, as those need the
+ * per-instruction bookkeeping done at peepholeStart. Define
+ * TCL_NO_THREADED_DISPATCH to force the switch.
+ *
+ * ARGUMENTS (of TARGET):
+ *    op: the opcode, used in place of "case op" in the switch.
+ */
+
+#if defined(__GNUC__) && !defined(TCL_NO_THREADED_DISPATCH) \
+	&& !defined(TCL_COMPILE_DEBUG) && !defined(TCL_COMPILE_STATS) \
+	&& !defined(USE_DTRACE)
+#define TEBC_THREADED_DISPATCH 1
+#endif
+
+#ifdef TEBC_THREADED_DISPATCH
+#define TARGET(op)	case op: target_ ## op
+#define TARGET_ADDR(op)	[op] = &&target_ ## op
+#define DISPATCH()	goto *dispatchTable[inst]
+#define NEXT_DISPATCH() \
+    do {								\
+	if (interruptCounter > 1) {					\
+	    interruptCounter--;						\
+	    inst = *pc;							\
+	    goto *dispatchTable[inst];					\
+	}								\
+	goto cleanup0;							\
+    } while (0)
+#else /* !TEBC_THREADED_DISPATCH */
+#define TARGET(op)	case op
+#define DISPATCH()	goto peepholeStart
+#define NEXT_DISPATCH()	goto cleanup0
+#endif /* TEBC_THREADED_DISPATCH */
+
+/*
+ * Quickening. The generic numeric instructions (INST_ADD, INST_LT, ...)
+ * that find both operands already holding int or double internal reps
+ * rewrite their own opcode byte in the bytecode to a variant specialized
+ * for that pair of types (INST_ADD_INT, INST_LT_DBL, ...). The specialized
+ * code only checks the internal rep types, skipping GetNumberFromObj and
+ * the dispatch on number types. When the check fails, UNQUICKEN puts the
+ * generic opcode back and dispatches to it again.
+ *
+ * ARGUMENTS:
+ *    op: the opcode to store at pc.
+ */
+
+#define QUICKEN(op) \
+    (*((unsigned char *) pc) = (unsigned char) (op))
+#define UNQUICKEN(op) \
+    do {								\
+	inst = (unsigned char) (op);					\
+	QUICKEN(inst);							\
+	DISPATCH();							\
+    } while (0)
+
+/*
+ * The generic opcode for a possibly quickened one; for code, such as the
+ * superinstructions, that looks at instructions other than the current
+ * one. Relies on the quickened opcodes being the last ones.
+ */
+
+#define UNQUICKENED(op) \
+    (((op) < INST_ADD_INT) ? (op) :					\
+    ((op) < INST_ADD_DBL) ? INST_ADD + ((op) - INST_ADD_INT) :		\
+    ((op) < INST_EQ_INT) ? INST_ADD + ((op) - INST_ADD_DBL) :		\
+    ((op) < INST_EQ_DBL) ? INST_EQ + ((op) - INST_EQ_INT) :		\
+    INST_EQ + ((op) - INST_EQ_DBL))
+
 /*
  * Macros used to cache often-referenced Tcl evaluation stack information
  * in local variables. Note that a DECACHE_STACK_INFO()-CACHE_STACK_INFO()
@@ -2029,6 +2107,119 @@ TEBCresume(
     const unsigned char *pc = (const unsigned char *)data[1];
                                 /* The current program counter. */
     unsigned char inst;         /* The currently running instruction */
+#ifdef TEBC_THREADED_DISPATCH
+    static const void *const dispatchTable[LAST_INST_OPCODE] = {
+	TARGET_ADDR(INST_DONE), TARGET_ADDR(INST_PUSH1),
+	TARGET_ADDR(INST_PUSH4), TARGET_ADDR(INST_POP),
+	TARGET_ADDR(INST_DUP), TARGET_ADDR(INST_STR_CONCAT1),
+	TARGET_ADDR(INST_INVOKE_STK1), TARGET_ADDR(INST_INVOKE_STK4),
+	TARGET_ADDR(INST_EVAL_STK), TARGET_ADDR(INST_EXPR_STK),
+	TARGET_ADDR(INST_LOAD_SCALAR1), TARGET_ADDR(INST_LOAD_SCALAR4),
+	TARGET_ADDR(INST_LOAD_SCALAR_STK), TARGET_ADDR(INST_LOAD_ARRAY1),
+	TARGET_ADDR(INST_LOAD_ARRAY4), TARGET_ADDR(INST_LOAD_ARRAY_STK),
+	TARGET_ADDR(INST_LOAD_STK), TARGET_ADDR(INST_STORE_SCALAR1),
+	TARGET_ADDR(INST_STORE_SCALAR4), TARGET_ADDR(INST_STORE_SCALAR_STK),
+	TARGET_ADDR(INST_STORE_ARRAY1), TARGET_ADDR(INST_STORE_ARRAY4),
+	TARGET_ADDR(INST_STORE_ARRAY_STK), TARGET_ADDR(INST_STORE_STK),
+	TARGET_ADDR(INST_INCR_SCALAR1), TARGET_ADDR(INST_INCR_SCALAR_STK),
+	TARGET_ADDR(INST_INCR_ARRAY1), TARGET_ADDR(INST_INCR_ARRAY_STK),
+	TARGET_ADDR(INST_INCR_STK), TARGET_ADDR(INST_INCR_SCALAR1_IMM),
+	TARGET_ADDR(INST_INCR_SCALAR_STK_IMM),
+	TARGET_ADDR(INST_INCR_ARRAY1_IMM),
+	TARGET_ADDR(INST_INCR_ARRAY_STK_IMM), TARGET_ADDR(INST_INCR_STK_IMM),
+	TARGET_ADDR(INST_JUMP1), TARGET_ADDR(INST_JUMP4),
+	TARGET_ADDR(INST_JUMP_TRUE1), TARGET_ADDR(INST_JUMP_TRUE4),
+	TARGET_ADDR(INST_JUMP_FALSE1), TARGET_ADDR(INST_JUMP_FALSE4),
+	TARGET_ADDR(INST_BITOR), TARGET_ADDR(INST_BITXOR),
+	TARGET_ADDR(INST_BITAND), TARGET_ADDR(INST_EQ),
+	TARGET_ADDR(INST_NEQ), TARGET_ADDR(INST_LT), TARGET_ADDR(INST_GT),
+	TARGET_ADDR(INST_LE), TARGET_ADDR(INST_GE), TARGET_ADDR(INST_LSHIFT),
+	TARGET_ADDR(INST_RSHIFT), TARGET_ADDR(INST_ADD),
+	TARGET_ADDR(INST_SUB), TARGET_ADDR(INST_MULT), TARGET_ADDR(INST_DIV),
+	TARGET_ADDR(INST_MOD), TARGET_ADDR(INST_UPLUS),
+	TARGET_ADDR(INST_UMINUS), TARGET_ADDR(INST_BITNOT),
+	TARGET_ADDR(INST_LNOT), TARGET_ADDR(INST_TRY_CVT_TO_NUMERIC),
+	TARGET_ADDR(INST_BREAK), TARGET_ADDR(INST_CONTINUE),
+	TARGET_ADDR(INST_BEGIN_CATCH4), TARGET_ADDR(INST_END_CATCH),
+	TARGET_ADDR(INST_PUSH_RESULT), TARGET_ADDR(INST_PUSH_RETURN_CODE),
+	TARGET_ADDR(INST_STR_EQ), TARGET_ADDR(INST_STR_NEQ),
+	TARGET_ADDR(INST_STR_CMP), TARGET_ADDR(INST_STR_LEN),
+	TARGET_ADDR(INST_STR_INDEX), TARGET_ADDR(INST_STR_MATCH),
+	TARGET_ADDR(INST_LIST), TARGET_ADDR(INST_LIST_INDEX),
+	TARGET_ADDR(INST_LIST_LENGTH), TARGET_ADDR(INST_APPEND_SCALAR1),
+	TARGET_ADDR(INST_APPEND_SCALAR4), TARGET_ADDR(INST_APPEND_ARRAY1),
+	TARGET_ADDR(INST_APPEND_ARRAY4), TARGET_ADDR(INST_APPEND_ARRAY_STK),
+	TARGET_ADDR(INST_APPEND_STK), TARGET_ADDR(INST_LAPPEND_SCALAR1),
+	TARGET_ADDR(INST_LAPPEND_SCALAR4), TARGET_ADDR(INST_LAPPEND_ARRAY1),
+	TARGET_ADDR(INST_LAPPEND_ARRAY4),
+	TARGET_ADDR(INST_LAPPEND_ARRAY_STK), TARGET_ADDR(INST_LAPPEND_STK),
+	TARGET_ADDR(INST_LIST_INDEX_MULTI), TARGET_ADDR(INST_OVER),
+	TARGET_ADDR(INST_LSET_LIST), TARGET_ADDR(INST_LSET_FLAT),
+	TARGET_ADDR(INST_RETURN_IMM), TARGET_ADDR(INST_EXPON),
+	TARGET_ADDR(INST_EXPAND_START), TARGET_ADDR(INST_EXPAND_STKTOP),
+	TARGET_ADDR(INST_INVOKE_EXPANDED), TARGET_ADDR(INST_LIST_INDEX_IMM),
+	TARGET_ADDR(INST_LIST_RANGE_IMM), TARGET_ADDR(INST_START_CMD),
+	TARGET_ADDR(INST_LIST_IN), TARGET_ADDR(INST_LIST_NOT_IN),
+	TARGET_ADDR(INST_PUSH_RETURN_OPTIONS), TARGET_ADDR(INST_RETURN_STK),
+	TARGET_ADDR(INST_DICT_GET), TARGET_ADDR(INST_DICT_SET),
+	TARGET_ADDR(INST_DICT_UNSET), TARGET_ADDR(INST_DICT_INCR_IMM),
+	TARGET_ADDR(INST_DICT_APPEND), TARGET_ADDR(INST_DICT_LAPPEND),
+	TARGET_ADDR(INST_DICT_FIRST), TARGET_ADDR(INST_DICT_NEXT),
+	TARGET_ADDR(INST_DICT_UPDATE_START),
+	TARGET_ADDR(INST_DICT_UPDATE_END), TARGET_ADDR(INST_JUMP_TABLE),
+	TARGET_ADDR(INST_UPVAR), TARGET_ADDR(INST_NSUPVAR),
+	TARGET_ADDR(INST_VARIABLE), TARGET_ADDR(INST_SYNTAX),
+	TARGET_ADDR(INST_REVERSE), TARGET_ADDR(INST_REGEXP),
+	TARGET_ADDR(INST_EXIST_SCALAR), TARGET_ADDR(INST_EXIST_ARRAY),
+	TARGET_ADDR(INST_EXIST_ARRAY_STK), TARGET_ADDR(INST_EXIST_STK),
+	TARGET_ADDR(INST_NOP), TARGET_ADDR(INST_RETURN_CODE_BRANCH),
+	TARGET_ADDR(INST_UNSET_SCALAR), TARGET_ADDR(INST_UNSET_ARRAY),
+	TARGET_ADDR(INST_UNSET_ARRAY_STK), TARGET_ADDR(INST_UNSET_STK),
+	TARGET_ADDR(INST_DICT_EXPAND), TARGET_ADDR(INST_DICT_RECOMBINE_STK),
+	TARGET_ADDR(INST_DICT_RECOMBINE_IMM), TARGET_ADDR(INST_DICT_EXISTS),
+	TARGET_ADDR(INST_DICT_VERIFY), TARGET_ADDR(INST_STR_MAP),
+	TARGET_ADDR(INST_STR_FIND), TARGET_ADDR(INST_STR_FIND_LAST),
+	TARGET_ADDR(INST_STR_RANGE_IMM), TARGET_ADDR(INST_STR_RANGE),
+	TARGET_ADDR(INST_YIELD), TARGET_ADDR(INST_COROUTINE_NAME),
+	TARGET_ADDR(INST_TAILCALL), TARGET_ADDR(INST_NS_CURRENT),
+	TARGET_ADDR(INST_INFO_LEVEL_NUM), TARGET_ADDR(INST_INFO_LEVEL_ARGS),
+	TARGET_ADDR(INST_RESOLVE_COMMAND), TARGET_ADDR(INST_TCLOO_SELF),
+	TARGET_ADDR(INST_TCLOO_CLASS), TARGET_ADDR(INST_TCLOO_NS),
+	TARGET_ADDR(INST_TCLOO_IS_OBJECT),
+	TARGET_ADDR(INST_ARRAY_EXISTS_STK),
+	TARGET_ADDR(INST_ARRAY_EXISTS_IMM), TARGET_ADDR(INST_ARRAY_MAKE_STK),
+	TARGET_ADDR(INST_ARRAY_MAKE_IMM), TARGET_ADDR(INST_INVOKE_REPLACE),
+	TARGET_ADDR(INST_LIST_CONCAT), TARGET_ADDR(INST_EXPAND_DROP),
+	TARGET_ADDR(INST_FOREACH_START), TARGET_ADDR(INST_FOREACH_STEP),
+	TARGET_ADDR(INST_FOREACH_END), TARGET_ADDR(INST_LMAP_COLLECT),
+	TARGET_ADDR(INST_STR_TRIM), TARGET_ADDR(INST_STR_TRIM_LEFT),
+	TARGET_ADDR(INST_STR_TRIM_RIGHT), TARGET_ADDR(INST_CONCAT_STK),
+	TARGET_ADDR(INST_STR_UPPER), TARGET_ADDR(INST_STR_LOWER),
+	TARGET_ADDR(INST_STR_TITLE), TARGET_ADDR(INST_STR_REPLACE),
+	TARGET_ADDR(INST_ORIGIN_COMMAND), TARGET_ADDR(INST_TCLOO_NEXT),
+	TARGET_ADDR(INST_TCLOO_NEXT_CLASS),
+	TARGET_ADDR(INST_YIELD_TO_INVOKE), TARGET_ADDR(INST_NUM_TYPE),
+	TARGET_ADDR(INST_TRY_CVT_TO_BOOLEAN), TARGET_ADDR(INST_STR_CLASS),
+	TARGET_ADDR(INST_LAPPEND_LIST), TARGET_ADDR(INST_LAPPEND_LIST_ARRAY),
+	TARGET_ADDR(INST_LAPPEND_LIST_ARRAY_STK),
+	TARGET_ADDR(INST_LAPPEND_LIST_STK), TARGET_ADDR(INST_CLOCK_READ),
+	TARGET_ADDR(INST_DICT_GET_DEF), TARGET_ADDR(INST_STR_LT),
+	TARGET_ADDR(INST_STR_GT), TARGET_ADDR(INST_STR_LE),
+	TARGET_ADDR(INST_STR_GE), TARGET_ADDR(INST_LOAD_SCALAR1_ARITH_STORE),
+	TARGET_ADDR(INST_LOAD_SCALAR1_CMP_JUMP),
+	TARGET_ADDR(INST_LOAD_SCALAR1_LIST_INDEX), TARGET_ADDR(INST_ADD_INT),
+	TARGET_ADDR(INST_SUB_INT), TARGET_ADDR(INST_MULT_INT),
+	TARGET_ADDR(INST_ADD_DBL), TARGET_ADDR(INST_SUB_DBL),
+	TARGET_ADDR(INST_MULT_DBL), TARGET_ADDR(INST_EQ_INT),
+	TARGET_ADDR(INST_NEQ_INT), TARGET_ADDR(INST_LT_INT),
+	TARGET_ADDR(INST_GT_INT), TARGET_ADDR(INST_LE_INT),
+	TARGET_ADDR(INST_GE_INT), TARGET_ADDR(INST_EQ_DBL),
+	TARGET_ADDR(INST_NEQ_DBL), TARGET_ADDR(INST_LT_DBL),
+	TARGET_ADDR(INST_GT_DBL), TARGET_ADDR(INST_LE_DBL),
+	TARGET_ADDR(INST_GE_DBL)
+    };				/* Code address for each opcode; indexed by
+				 * opcode, see TEBC_THREADED_DISPATCH. */
+#endif
 
     /*
      * Transfer variables - needed only between opcodes, but not while
@@ -2183,7 +2374,7 @@ TEBCresume(
 	TclDecrRefCount(objPtr);
     }
     OBJ_AT_TOS = objResultPtr;
-    goto cleanup0;
+    NEXT_DISPATCH();
 
   cleanupV:
     switch (cleanup) {
@@ -2257,7 +2448,11 @@ TEBCresume(
 
     inst = *pc;
 
+#ifdef TEBC_THREADED_DISPATCH
+    DISPATCH();
+#else
     peepholeStart:
+#endif
 #ifdef TCL_COMPILE_STATS
     iPtr->stats.instructionCount[*pc]++;
 #endif
@@ -2280,15 +2475,21 @@ TEBCresume(
     if (inst == INST_LOAD_SCALAR1) {
 	goto instLoadScalar1;
     } else if (inst == INST_PUSH1) {
+#ifdef TEBC_THREADED_DISPATCH
+    target_INST_PUSH1:
+#endif
 	PUSH_OBJECT(codePtr->objArrayPtr[TclGetUInt1AtPtr(pc+1)]);
 	TRACE_WITH_OBJ(("%u => ", TclGetUInt1AtPtr(pc+1)), OBJ_AT_TOS);
 	inst = *(pc += 2);
-	goto peepholeStart;
+	DISPATCH();
     } else if (inst == INST_START_CMD) {
 	/*
 	 * Peephole: do not run INST_START_CMD, just skip it
 	 */
 
+#ifdef TEBC_THREADED_DISPATCH
+    target_INST_START_CMD:
+#endif
 	iPtr->cmdCount += TclGetUInt4AtPtr(pc+5);
 	if (checkInterp) {
 	    if (((codePtr->compileEpoch != iPtr->compileEpoch) ||
@@ -2299,20 +2500,23 @@ TEBCresume(
 	    checkInterp = 0;
 	}
 	inst = *(pc += 9);
-	goto peepholeStart;
+	DISPATCH();
     } else if (inst == INST_NOP) {
+#ifdef TEBC_THREADED_DISPATCH
+    target_INST_NOP:
+#endif
 #ifndef TCL_COMPILE_DEBUG
 	while (inst == INST_NOP)
 #endif
 	{
 	    inst = *++pc;
 	}
-	goto peepholeStart;
+	DISPATCH();
     }
 
     switch (inst) {
-    case INST_SYNTAX:
-    case INST_RETURN_IMM: {
+    TARGET(INST_SYNTAX):
+    TARGET(INST_RETURN_IMM): {
 	int code = TclGetInt4AtPtr(pc+1);
 	int level = TclGetUInt4AtPtr(pc+5);
 
@@ -2336,7 +2540,7 @@ TEBCresume(
 	goto processExceptionReturn;
     }
 
-    case INST_RETURN_STK:
+    TARGET(INST_RETURN_STK):
 	TRACE(("=> "));
 	objResultPtr = POP_OBJECT();
 	result = Tcl_SetReturnOptions(interp, OBJ_AT_TOS);
@@ -2370,7 +2574,7 @@ TEBCresume(
 	CoroutineData *corPtr;
 	void *yieldParameter;
 
-    case INST_YIELD:
+    TARGET(INST_YIELD):
 	corPtr = iPtr->execEnvPtr->corPtr;
 	TRACE(("%.30s => ", O2S(OBJ_AT_TOS)));
 	if (!corPtr) {
@@ -2400,7 +2604,7 @@ TEBCresume(
 	Tcl_SetObjResult(interp, OBJ_AT_TOS);
 	goto doYield;
 
-    case INST_YIELD_TO_INVOKE:
+    TARGET(INST_YIELD_TO_INVOKE):
 	corPtr = iPtr->execEnvPtr->corPtr;
 	valuePtr = OBJ_AT_TOS;
 	if (!corPtr) {
@@ -2473,7 +2677,7 @@ TEBCresume(
 	return TCL_OK;
     }
 
-    case INST_TAILCALL: {
+    TARGET(INST_TAILCALL): {
 	Tcl_Obj *listPtr, *nsObjPtr;
 
 	opnd = TclGetUInt1AtPtr(pc+1);
@@ -2522,7 +2726,7 @@ TEBCresume(
 	goto processExceptionReturn;
     }
 
-    case INST_DONE:
+    TARGET(INST_DONE):
 	if (tosPtr > initTosPtr) {
 
 	    if ((curEvalFlags & TCL_EVAL_DISCARD_RESULT) && (result == TCL_OK)) {
@@ -2552,33 +2756,33 @@ TEBCresume(
 	(void) POP_OBJECT();
 	goto abnormalReturn;
 
-    case INST_PUSH4:
+    TARGET(INST_PUSH4):
 	objResultPtr = codePtr->objArrayPtr[TclGetUInt4AtPtr(pc+1)];
 	TRACE_WITH_OBJ(("%u => ", TclGetUInt4AtPtr(pc+1)), objResultPtr);
 	NEXT_INST_F(5, 0, 1);
     break;
 
-    case INST_POP:
+    TARGET(INST_POP):
 	TRACE_WITH_OBJ(("=> discarding "), OBJ_AT_TOS);
 	objPtr = POP_OBJECT();
 	TclDecrRefCount(objPtr);
 	NEXT_INST_F(1, 0, 0);
     break;
 
-    case INST_DUP:
+    TARGET(INST_DUP):
 	objResultPtr = OBJ_AT_TOS;
 	TRACE_WITH_OBJ(("=> "), objResultPtr);
 	NEXT_INST_F(1, 0, 1);
     break;
 
-    case INST_OVER:
+    TARGET(INST_OVER):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	objResultPtr = OBJ_AT_DEPTH(opnd);
 	TRACE_WITH_OBJ(("%u => ", opnd), objResultPtr);
 	NEXT_INST_F(5, 0, 1);
     break;
 
-    case INST_REVERSE: {
+    TARGET(INST_REVERSE): {
 	Tcl_Obj **a, **b;
 
 	opnd = TclGetUInt4AtPtr(pc+1);
@@ -2595,7 +2799,7 @@ TEBCresume(
     }
     break;
 
-    case INST_STR_CONCAT1:
+    TARGET(INST_STR_CONCAT1):
 
 	opnd = TclGetUInt1AtPtr(pc+1);
 	objResultPtr = TclStringCat(interp, opnd, &OBJ_AT_DEPTH(opnd-1),
@@ -2609,7 +2813,7 @@ TEBCresume(
 	NEXT_INST_V(2, opnd, 1);
     break;
 
-    case INST_CONCAT_STK:
+    TARGET(INST_CONCAT_STK):
 	/*
 	 * Pop the opnd (objc) top stack elements, run through Tcl_ConcatObj,
 	 * and then decrement their ref counts.
@@ -2621,7 +2825,7 @@ TEBCresume(
 	NEXT_INST_V(5, opnd, 1);
     break;
 
-    case INST_EXPAND_START:
+    TARGET(INST_EXPAND_START):
 	/*
 	 * Push an element to the auxObjList. This records the current
 	 * stack depth - i.e., the point in the stack where the expanded
@@ -2643,7 +2847,7 @@ TEBCresume(
 	NEXT_INST_F(1, 0, 0);
     break;
 
-    case INST_EXPAND_DROP:
+    TARGET(INST_EXPAND_DROP):
 	/*
 	 * Drops an element of the auxObjList, popping stack elements to
 	 * restore the stack to the state before the point where the aux
@@ -2660,7 +2864,7 @@ TEBCresume(
 	TRACE(("=> drop %d items\n", objc));
 	NEXT_INST_V(1, objc, 0);
 
-    case INST_EXPAND_STKTOP: {
+    TARGET(INST_EXPAND_STKTOP): {
 	int i;
 	ptrdiff_t moved;
 
@@ -2722,7 +2926,7 @@ TEBCresume(
     }
     break;
 
-    case INST_EXPR_STK: {
+    TARGET(INST_EXPR_STK): {
 	ByteCode *newCodePtr;
 
 	bcFramePtr->data.tebc.pc = (char *) pc;
@@ -2740,7 +2944,7 @@ TEBCresume(
 	 * INVOCATION BLOCK
 	 */
 
-    case INST_EVAL_STK:
+    TARGET(INST_EVAL_STK):
     instEvalStk:
 	bcFramePtr->data.tebc.pc = (char *) pc;
 	iPtr->cmdFramePtr = bcFramePtr;
@@ -2753,7 +2957,7 @@ TEBCresume(
 	return TclNRExecuteByteCode(interp,
 		    TclCompileObj(interp, OBJ_AT_TOS, NULL, 0));
 
-    case INST_INVOKE_EXPANDED:
+    TARGET(INST_INVOKE_EXPANDED):
 	CLANG_ASSERT(auxObjList);
 	objc = CURR_DEPTH - PTR2INT(auxObjList->internalRep.twoPtrValue.ptr2);
 	POP_TAUX_OBJ();
@@ -2770,12 +2974,12 @@ TEBCresume(
 	NEXT_INST_F(1, 0, 1);
     break;
 
-    case INST_INVOKE_STK4:
+    TARGET(INST_INVOKE_STK4):
 	objc = TclGetUInt4AtPtr(pc+1);
 	pcAdjustment = 5;
 	goto doInvocation;
 
-    case INST_INVOKE_STK1:
+    TARGET(INST_INVOKE_STK1):
 	objc = TclGetUInt1AtPtr(pc+1);
 	pcAdjustment = 2;
 
@@ -2824,7 +3028,7 @@ TEBCresume(
 	return TclNREvalObjv(interp, objc, objv,
 		TCL_EVAL_NOERR | TCL_EVAL_SOURCE_IN_FRAME, NULL);
 
-    case INST_INVOKE_REPLACE:
+    TARGET(INST_INVOKE_REPLACE):
 	objc = TclGetUInt4AtPtr(pc+1);
 	opnd = TclGetUInt1AtPtr(pc+5);
 	objPtr = POP_OBJECT();
@@ -2895,7 +3099,7 @@ TEBCresume(
      * common execution code.
      */
 
-    case INST_LOAD_SCALAR1:
+    TARGET(INST_LOAD_SCALAR1):
     instLoadScalar1:
 	opnd = TclGetUInt1AtPtr(pc+1);
 	varPtr = LOCAL(opnd);
@@ -2918,7 +3122,7 @@ TEBCresume(
 	part1Ptr = part2Ptr = NULL;
 	goto doCallPtrGetVar;
 
-    case INST_LOAD_SCALAR4:
+    TARGET(INST_LOAD_SCALAR4):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	varPtr = LOCAL(opnd);
 	while (TclIsVarLink(varPtr)) {
@@ -2940,12 +3144,198 @@ TEBCresume(
 	part1Ptr = part2Ptr = NULL;
 	goto doCallPtrGetVar;
 
-    case INST_LOAD_ARRAY4:
+    /*
+     * Superinstructions placed by the optimizer (FuseInstructions in
+     * tclOptimize.c) over the INST_LOAD_SCALAR1 that starts a common
+     * sequence. The rest of the sequence is still in the bytecode after
+     * them, so whenever the fast path does not apply they just do the load
+     * and let the sequence continue one instruction at a time.
+     */
+
+    TARGET(INST_LOAD_SCALAR1_ARITH_STORE): {
+	/*
+	 * loadScalar1 %a; push1 lit; add|sub; storeScalar1 %b
+	 */
+
+	Var *storeVarPtr;
+	Tcl_Obj *litPtr;
+	Tcl_WideInt wLeft, wRight, wSum;
+
+	varPtr = LOCAL(TclGetUInt1AtPtr(pc+1));
+	while (TclIsVarLink(varPtr)) {
+	    varPtr = varPtr->value.linkPtr;
+	}
+	storeVarPtr = LOCAL(TclGetUInt1AtPtr(pc+6));
+	while (TclIsVarLink(storeVarPtr)) {
+	    storeVarPtr = storeVarPtr->value.linkPtr;
+	}
+	if (!TclIsVarDirectReadable(varPtr)
+		|| !TclIsVarDirectWritable(storeVarPtr)) {
+	    goto instLoadScalar1;
+	}
+	valuePtr = varPtr->value.objPtr;
+	litPtr = codePtr->objArrayPtr[TclGetUInt1AtPtr(pc+3)];
+	if (!TclHasInternalRep(valuePtr, &tclIntType)
+		|| !TclHasInternalRep(litPtr, &tclIntType)) {
+	    goto instLoadScalar1;
+	}
+	wLeft = valuePtr->internalRep.wideValue;
+	wRight = litPtr->internalRep.wideValue;
+	if (UNQUICKENED(*(pc+4)) == INST_ADD) {
+	    wSum = (Tcl_WideInt)((Tcl_WideUInt)wLeft + (Tcl_WideUInt)wRight);
+	    if (Overflowing(wLeft, wRight, wSum)) {
+		goto instLoadScalar1;
+	    }
+	} else {
+	    wSum = (Tcl_WideInt)((Tcl_WideUInt)wLeft - (Tcl_WideUInt)wRight);
+	    if (Overflowing(wLeft, ~wRight, wSum)) {
+		goto instLoadScalar1;
+	    }
+	}
+	TRACE(("%u %s %s => ", TclGetUInt1AtPtr(pc+1), O2S(valuePtr),
+		O2S(litPtr)));
+
+	/*
+	 * Storing back into the variable we read from: when nothing else
+	 * holds the value we can update it in place, as the sequence would
+	 * have discarded it anyway.
+	 */
+
+	if ((storeVarPtr == varPtr) && !Tcl_IsShared(valuePtr)) {
+	    TclSetIntObj(valuePtr, wSum);
+	    objResultPtr = valuePtr;
+	} else {
+	    TclNewIntObj(objResultPtr, wSum);
+	    Tcl_IncrRefCount(objResultPtr);
+	    if (storeVarPtr->value.objPtr != NULL) {
+		TclDecrRefCount(storeVarPtr->value.objPtr);
+	    }
+	    storeVarPtr->value.objPtr = objResultPtr;
+	}
+	TRACE_APPEND(("%.30s\n", O2S(objResultPtr)));
+#ifndef TCL_COMPILE_DEBUG
+	if (*(pc+7) == INST_POP) {
+	    NEXT_INST_F(8, 0, 0);
+	}
+#endif
+	NEXT_INST_F(7, 0, 1);
+    }
+    break;
+
+    TARGET(INST_LOAD_SCALAR1_CMP_JUMP): {
+	/*
+	 * loadScalar1 %a; loadScalar1 %b; eq|neq|lt|gt|le|ge; jump*
+	 */
+
+	Var *var2Ptr;
+	Tcl_WideInt wLeft, wRight;
+	const unsigned char *jumpPc = pc+5;
+	int iResult = 0;
+
+	varPtr = LOCAL(TclGetUInt1AtPtr(pc+1));
+	while (TclIsVarLink(varPtr)) {
+	    varPtr = varPtr->value.linkPtr;
+	}
+	var2Ptr = LOCAL(TclGetUInt1AtPtr(pc+3));
+	while (TclIsVarLink(var2Ptr)) {
+	    var2Ptr = var2Ptr->value.linkPtr;
+	}
+	if (!TclIsVarDirectReadable(varPtr)
+		|| !TclIsVarDirectReadable(var2Ptr)) {
+	    goto instLoadScalar1;
+	}
+	valuePtr = varPtr->value.objPtr;
+	value2Ptr = var2Ptr->value.objPtr;
+	if (!TclHasInternalRep(valuePtr, &tclIntType)
+		|| !TclHasInternalRep(value2Ptr, &tclIntType)) {
+	    goto instLoadScalar1;
+	}
+	wLeft = valuePtr->internalRep.wideValue;
+	wRight = value2Ptr->internalRep.wideValue;
+	switch (UNQUICKENED(*(pc+4))) {
+	case INST_EQ:
+	    iResult = (wLeft == wRight);
+	    break;
+	case INST_NEQ:
+	    iResult = (wLeft != wRight);
+	    break;
+	case INST_LT:
+	    iResult = (wLeft < wRight);
+	    break;
+	case INST_GT:
+	    iResult = (wLeft > wRight);
+	    break;
+	case INST_LE:
+	    iResult = (wLeft <= wRight);
+	    break;
+	case INST_GE:
+	    iResult = (wLeft >= wRight);
+	    break;
+	}
+	TRACE(("%u %u => %d\n", TclGetUInt1AtPtr(pc+1),
+		TclGetUInt1AtPtr(pc+3), iResult));
+	switch (*jumpPc) {
+	case INST_JUMP_TRUE1:
+	    pcAdjustment = iResult ? TclGetInt1AtPtr(jumpPc+1) : 2;
+	    break;
+	case INST_JUMP_FALSE1:
+	    pcAdjustment = iResult ? 2 : TclGetInt1AtPtr(jumpPc+1);
+	    break;
+	case INST_JUMP_TRUE4:
+	    pcAdjustment = iResult ? TclGetInt4AtPtr(jumpPc+1) : 5;
+	    break;
+	default:
+	    pcAdjustment = iResult ? 5 : TclGetInt4AtPtr(jumpPc+1);
+	    break;
+	}
+	NEXT_INST_F(5 + pcAdjustment, 0, 0);
+    }
+    break;
+
+    TARGET(INST_LOAD_SCALAR1_LIST_INDEX): {
+	/*
+	 * loadScalar1 %list; loadScalar1 %index; listIndex
+	 */
+
+	Var *var2Ptr;
+	Tcl_WideInt wIndex;
+
+	varPtr = LOCAL(TclGetUInt1AtPtr(pc+1));
+	while (TclIsVarLink(varPtr)) {
+	    varPtr = varPtr->value.linkPtr;
+	}
+	var2Ptr = LOCAL(TclGetUInt1AtPtr(pc+3));
+	while (TclIsVarLink(var2Ptr)) {
+	    var2Ptr = var2Ptr->value.linkPtr;
+	}
+	if (!TclIsVarDirectReadable(varPtr)
+		|| !TclIsVarDirectReadable(var2Ptr)) {
+	    goto instLoadScalar1;
+	}
+	valuePtr = varPtr->value.objPtr;
+	value2Ptr = var2Ptr->value.objPtr;
+	if (!TclHasInternalRep(valuePtr, &tclListType)
+		|| !TclHasInternalRep(value2Ptr, &tclIntType)) {
+	    goto instLoadScalar1;
+	}
+	ListObjGetElements(valuePtr, objc, objv);
+	wIndex = value2Ptr->internalRep.wideValue;
+	if ((wIndex < 0) || (wIndex >= objc)) {
+	    goto instLoadScalar1;
+	}
+	objResultPtr = objv[wIndex];
+	TRACE(("\"%.30s\" %" TCL_LL_MODIFIER "d => %.30s\n", O2S(valuePtr),
+		wIndex, O2S(objResultPtr)));
+	NEXT_INST_F(5, 0, 1);
+    }
+    break;
+
+    TARGET(INST_LOAD_ARRAY4):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	pcAdjustment = 5;
 	goto doLoadArray;
 
-    case INST_LOAD_ARRAY1:
+    TARGET(INST_LOAD_ARRAY1):
 	opnd = TclGetUInt1AtPtr(pc+1);
 	pcAdjustment = 2;
 
@@ -2978,15 +3368,15 @@ TEBCresume(
 	cleanup = 1;
 	goto doCallPtrGetVar;
 
-    case INST_LOAD_ARRAY_STK:
+    TARGET(INST_LOAD_ARRAY_STK):
 	cleanup = 2;
 	part2Ptr = OBJ_AT_TOS;		/* element name */
 	objPtr = OBJ_UNDER_TOS;		/* array name */
 	TRACE(("\"%.30s(%.30s)\" => ", O2S(objPtr), O2S(part2Ptr)));
 	goto doLoadStk;
 
-    case INST_LOAD_STK:
-    case INST_LOAD_SCALAR_STK:
+    TARGET(INST_LOAD_STK):
+    TARGET(INST_LOAD_SCALAR_STK):
 	cleanup = 1;
 	part2Ptr = NULL;
 	objPtr = OBJ_AT_TOS;		/* variable name */
@@ -3044,12 +3434,12 @@ TEBCresume(
     {
 	int storeFlags, len;
 
-    case INST_STORE_ARRAY4:
+    TARGET(INST_STORE_ARRAY4):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	pcAdjustment = 5;
 	goto doStoreArrayDirect;
 
-    case INST_STORE_ARRAY1:
+    TARGET(INST_STORE_ARRAY1):
 	opnd = TclGetUInt1AtPtr(pc+1);
 	pcAdjustment = 2;
 
@@ -3076,12 +3466,12 @@ TEBCresume(
 	part1Ptr = NULL;
 	goto doStoreArrayDirectFailed;
 
-    case INST_STORE_SCALAR4:
+    TARGET(INST_STORE_SCALAR4):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	pcAdjustment = 5;
 	goto doStoreScalarDirect;
 
-    case INST_STORE_SCALAR1:
+    TARGET(INST_STORE_SCALAR1):
 	opnd = TclGetUInt1AtPtr(pc+1);
 	pcAdjustment = 2;
 
@@ -3122,40 +3512,40 @@ TEBCresume(
 	Tcl_IncrRefCount(objResultPtr);
 	NEXT_INST_F(pcAdjustment, 0, 0);
 
-    case INST_LAPPEND_STK:
+    TARGET(INST_LAPPEND_STK):
 	valuePtr = OBJ_AT_TOS; /* value to append */
 	part2Ptr = NULL;
 	storeFlags = (TCL_LEAVE_ERR_MSG | TCL_APPEND_VALUE
 		| TCL_LIST_ELEMENT);
 	goto doStoreStk;
 
-    case INST_LAPPEND_ARRAY_STK:
+    TARGET(INST_LAPPEND_ARRAY_STK):
 	valuePtr = OBJ_AT_TOS; /* value to append */
 	part2Ptr = OBJ_UNDER_TOS;
 	storeFlags = (TCL_LEAVE_ERR_MSG | TCL_APPEND_VALUE
 		| TCL_LIST_ELEMENT);
 	goto doStoreStk;
 
-    case INST_APPEND_STK:
+    TARGET(INST_APPEND_STK):
 	valuePtr = OBJ_AT_TOS; /* value to append */
 	part2Ptr = NULL;
 	storeFlags = (TCL_LEAVE_ERR_MSG | TCL_APPEND_VALUE);
 	goto doStoreStk;
 
-    case INST_APPEND_ARRAY_STK:
+    TARGET(INST_APPEND_ARRAY_STK):
 	valuePtr = OBJ_AT_TOS; /* value to append */
 	part2Ptr = OBJ_UNDER_TOS;
 	storeFlags = (TCL_LEAVE_ERR_MSG | TCL_APPEND_VALUE);
 	goto doStoreStk;
 
-    case INST_STORE_ARRAY_STK:
+    TARGET(INST_STORE_ARRAY_STK):
 	valuePtr = OBJ_AT_TOS;
 	part2Ptr = OBJ_UNDER_TOS;
 	storeFlags = TCL_LEAVE_ERR_MSG;
 	goto doStoreStk;
 
-    case INST_STORE_STK:
-    case INST_STORE_SCALAR_STK:
+    TARGET(INST_STORE_STK):
+    TARGET(INST_STORE_SCALAR_STK):
 	valuePtr = OBJ_AT_TOS;
 	part2Ptr = NULL;
 	storeFlags = TCL_LEAVE_ERR_MSG;
@@ -3182,27 +3572,27 @@ TEBCresume(
 	opnd = -1;
 	goto doCallPtrSetVar;
 
-    case INST_LAPPEND_ARRAY4:
+    TARGET(INST_LAPPEND_ARRAY4):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	pcAdjustment = 5;
 	storeFlags = (TCL_LEAVE_ERR_MSG | TCL_APPEND_VALUE
 		| TCL_LIST_ELEMENT);
 	goto doStoreArray;
 
-    case INST_LAPPEND_ARRAY1:
+    TARGET(INST_LAPPEND_ARRAY1):
 	opnd = TclGetUInt1AtPtr(pc+1);
 	pcAdjustment = 2;
 	storeFlags = (TCL_LEAVE_ERR_MSG | TCL_APPEND_VALUE
 		| TCL_LIST_ELEMENT);
 	goto doStoreArray;
 
-    case INST_APPEND_ARRAY4:
+    TARGET(INST_APPEND_ARRAY4):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	pcAdjustment = 5;
 	storeFlags = (TCL_LEAVE_ERR_MSG | TCL_APPEND_VALUE);
 	goto doStoreArray;
 
-    case INST_APPEND_ARRAY1:
+    TARGET(INST_APPEND_ARRAY1):
 	opnd = TclGetUInt1AtPtr(pc+1);
 	pcAdjustment = 2;
 	storeFlags = (TCL_LEAVE_ERR_MSG | TCL_APPEND_VALUE);
@@ -3229,27 +3619,27 @@ TEBCresume(
 	}
 	goto doCallPtrSetVar;
 
-    case INST_LAPPEND_SCALAR4:
+    TARGET(INST_LAPPEND_SCALAR4):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	pcAdjustment = 5;
 	storeFlags = (TCL_LEAVE_ERR_MSG | TCL_APPEND_VALUE
 		| TCL_LIST_ELEMENT);
 	goto doStoreScalar;
 
-    case INST_LAPPEND_SCALAR1:
+    TARGET(INST_LAPPEND_SCALAR1):
 	opnd = TclGetUInt1AtPtr(pc+1);
 	pcAdjustment = 2;
 	storeFlags = (TCL_LEAVE_ERR_MSG | TCL_APPEND_VALUE
 		| TCL_LIST_ELEMENT);
 	goto doStoreScalar;
 
-    case INST_APPEND_SCALAR4:
+    TARGET(INST_APPEND_SCALAR4):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	pcAdjustment = 5;
 	storeFlags = (TCL_LEAVE_ERR_MSG | TCL_APPEND_VALUE);
 	goto doStoreScalar;
 
-    case INST_APPEND_SCALAR1:
+    TARGET(INST_APPEND_SCALAR1):
 	opnd = TclGetUInt1AtPtr(pc+1);
 	pcAdjustment = 2;
 	storeFlags = (TCL_LEAVE_ERR_MSG | TCL_APPEND_VALUE);
@@ -3283,7 +3673,7 @@ TEBCresume(
 	TRACE_APPEND(("%.30s\n", O2S(objResultPtr)));
 	NEXT_INST_V(pcAdjustment, cleanup, 1);
 
-    case INST_LAPPEND_LIST:
+    TARGET(INST_LAPPEND_LIST):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	valuePtr = OBJ_AT_TOS;
 	varPtr = LOCAL(opnd);
@@ -3306,7 +3696,7 @@ TEBCresume(
 	part1Ptr = part2Ptr = NULL;
 	goto lappendListPtr;
 
-    case INST_LAPPEND_LIST_ARRAY:
+    TARGET(INST_LAPPEND_LIST_ARRAY):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	valuePtr = OBJ_AT_TOS;
 	part1Ptr = NULL;
@@ -3340,7 +3730,7 @@ TEBCresume(
 	}
 	goto lappendListPtr;
 
-    case INST_LAPPEND_LIST_ARRAY_STK:
+    TARGET(INST_LAPPEND_LIST_ARRAY_STK):
 	pcAdjustment = 1;
 	cleanup = 3;
 	valuePtr = OBJ_AT_TOS;
@@ -3350,7 +3740,7 @@ TEBCresume(
 		O2S(part1Ptr), O2S(part2Ptr), O2S(valuePtr)));
 	goto lappendList;
 
-    case INST_LAPPEND_LIST_STK:
+    TARGET(INST_LAPPEND_LIST_STK):
 	pcAdjustment = 1;
 	cleanup = 2;
 	valuePtr = OBJ_AT_TOS;
@@ -3471,11 +3861,11 @@ TEBCresume(
 	Tcl_WideInt w;
 	long increment;
 
-    case INST_INCR_SCALAR1:
-    case INST_INCR_ARRAY1:
-    case INST_INCR_ARRAY_STK:
-    case INST_INCR_SCALAR_STK:
-    case INST_INCR_STK:
+    TARGET(INST_INCR_SCALAR1):
+    TARGET(INST_INCR_ARRAY1):
+    TARGET(INST_INCR_ARRAY_STK):
+    TARGET(INST_INCR_SCALAR_STK):
+    TARGET(INST_INCR_STK):
 	opnd = TclGetUInt1AtPtr(pc+1);
 	incrPtr = POP_OBJECT();
 	switch (*pc) {
@@ -3490,9 +3880,9 @@ TEBCresume(
 	    goto doIncrStk;
 	}
 
-    case INST_INCR_ARRAY_STK_IMM:
-    case INST_INCR_SCALAR_STK_IMM:
-    case INST_INCR_STK_IMM:
+    TARGET(INST_INCR_ARRAY_STK_IMM):
+    TARGET(INST_INCR_SCALAR_STK_IMM):
+    TARGET(INST_INCR_STK_IMM):
 	increment = TclGetInt1AtPtr(pc+1);
 	TclNewIntObj(incrPtr, increment);
 	Tcl_IncrRefCount(incrPtr);
@@ -3526,7 +3916,7 @@ TEBCresume(
 	cleanup = ((part2Ptr == NULL)? 1 : 2);
 	goto doIncrVar;
 
-    case INST_INCR_ARRAY1_IMM:
+    TARGET(INST_INCR_ARRAY1_IMM):
 	opnd = TclGetUInt1AtPtr(pc+1);
 	increment = TclGetInt1AtPtr(pc+2);
 	TclNewIntObj(incrPtr, increment);
@@ -3551,7 +3941,7 @@ TEBCresume(
 	}
 	goto doIncrVar;
 
-    case INST_INCR_SCALAR1_IMM:
+    TARGET(INST_INCR_SCALAR1_IMM):
 	opnd = TclGetUInt1AtPtr(pc+1);
 	increment = TclGetInt1AtPtr(pc+2);
 	pcAdjustment = 3;
@@ -3690,7 +4080,7 @@ TEBCresume(
      *	   Start of INST_EXIST instructions.
      */
 
-    case INST_EXIST_SCALAR:
+    TARGET(INST_EXIST_SCALAR):
 	cleanup = 0;
 	pcAdjustment = 5;
 	opnd = TclGetUInt4AtPtr(pc+1);
@@ -3711,7 +4101,7 @@ TEBCresume(
 	}
 	goto afterExistsPeephole;
 
-    case INST_EXIST_ARRAY:
+    TARGET(INST_EXIST_ARRAY):
 	cleanup = 1;
 	pcAdjustment = 5;
 	opnd = TclGetUInt4AtPtr(pc+1);
@@ -3743,7 +4133,7 @@ TEBCresume(
 	}
 	goto afterExistsPeephole;
 
-    case INST_EXIST_ARRAY_STK:
+    TARGET(INST_EXIST_ARRAY_STK):
 	cleanup = 2;
 	pcAdjustment = 1;
 	part2Ptr = OBJ_AT_TOS;		/* element name */
@@ -3751,7 +4141,7 @@ TEBCresume(
 	TRACE(("\"%.30s(%.30s)\" => ", O2S(part1Ptr), O2S(part2Ptr)));
 	goto doExistStk;
 
-    case INST_EXIST_STK:
+    TARGET(INST_EXIST_STK):
 	cleanup = 1;
 	pcAdjustment = 1;
 	part2Ptr = NULL;
@@ -3794,7 +4184,7 @@ TEBCresume(
     {
 	int flags;
 
-    case INST_UNSET_SCALAR:
+    TARGET(INST_UNSET_SCALAR):
 	flags = TclGetUInt1AtPtr(pc+1) ? TCL_LEAVE_ERR_MSG : 0;
 	opnd = TclGetUInt4AtPtr(pc+2);
 	varPtr = LOCAL(opnd);
@@ -3827,7 +4217,7 @@ TEBCresume(
 	CACHE_STACK_INFO();
 	NEXT_INST_F(6, 0, 0);
 
-    case INST_UNSET_ARRAY:
+    TARGET(INST_UNSET_ARRAY):
 	flags = TclGetUInt1AtPtr(pc+1) ? TCL_LEAVE_ERR_MSG : 0;
 	opnd = TclGetUInt4AtPtr(pc+2);
 	part2Ptr = OBJ_AT_TOS;
@@ -3880,7 +4270,7 @@ TEBCresume(
 	CACHE_STACK_INFO();
 	NEXT_INST_F(6, 1, 0);
 
-    case INST_UNSET_ARRAY_STK:
+    TARGET(INST_UNSET_ARRAY_STK):
 	flags = TclGetUInt1AtPtr(pc+1) ? TCL_LEAVE_ERR_MSG : 0;
 	cleanup = 2;
 	part2Ptr = OBJ_AT_TOS;		/* element name */
@@ -3889,7 +4279,7 @@ TEBCresume(
 		O2S(part1Ptr), O2S(part2Ptr)));
 	goto doUnsetStk;
 
-    case INST_UNSET_STK:
+    TARGET(INST_UNSET_STK):
 	flags = TclGetUInt1AtPtr(pc+1) ? TCL_LEAVE_ERR_MSG : 0;
 	cleanup = 1;
 	part2Ptr = NULL;
@@ -3920,7 +4310,7 @@ TEBCresume(
      *	   Start of INST_ARRAY instructions.
      */
 
-    case INST_ARRAY_EXISTS_IMM:
+    TARGET(INST_ARRAY_EXISTS_IMM):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	pcAdjustment = 5;
 	cleanup = 0;
@@ -3932,7 +4322,7 @@ TEBCresume(
 	    varPtr = varPtr->value.linkPtr;
 	}
 	goto doArrayExists;
-    case INST_ARRAY_EXISTS_STK:
+    TARGET(INST_ARRAY_EXISTS_STK):
 	opnd = -1;
 	pcAdjustment = 1;
 	cleanup = 1;
@@ -3956,7 +4346,7 @@ TEBCresume(
 	TRACE_APPEND(("%.30s\n", O2S(objResultPtr)));
 	NEXT_INST_V(pcAdjustment, cleanup, 1);
 
-    case INST_ARRAY_MAKE_IMM:
+    TARGET(INST_ARRAY_MAKE_IMM):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	pcAdjustment = 5;
 	cleanup = 0;
@@ -3968,7 +4358,7 @@ TEBCresume(
 	    varPtr = varPtr->value.linkPtr;
 	}
 	goto doArrayMake;
-    case INST_ARRAY_MAKE_STK:
+    TARGET(INST_ARRAY_MAKE_STK):
 	opnd = -1;
 	pcAdjustment = 1;
 	cleanup = 1;
@@ -4016,7 +4406,7 @@ TEBCresume(
 	Tcl_Namespace *nsPtr;
 	Namespace *savedNsPtr;
 
-    case INST_UPVAR:
+    TARGET(INST_UPVAR):
 	TRACE(("%d %.30s %.30s => ", TclGetInt4AtPtr(pc+1),
 		O2S(OBJ_UNDER_TOS), O2S(OBJ_AT_TOS)));
 
@@ -4041,7 +4431,7 @@ TEBCresume(
 	}
 	goto doLinkVars;
 
-    case INST_NSUPVAR:
+    TARGET(INST_NSUPVAR):
 	TRACE(("%d %.30s %.30s => ", TclGetInt4AtPtr(pc+1),
 		O2S(OBJ_UNDER_TOS), O2S(OBJ_AT_TOS)));
 	if (TclGetNamespaceFromObj(interp, OBJ_UNDER_TOS, &nsPtr) != TCL_OK) {
@@ -4065,7 +4455,7 @@ TEBCresume(
 	}
 	goto doLinkVars;
 
-    case INST_VARIABLE:
+    TARGET(INST_VARIABLE):
 	TRACE(("%d, %.30s => ", TclGetInt4AtPtr(pc+1), O2S(OBJ_AT_TOS)));
 	otherPtr = TclObjLookupVarEx(interp, OBJ_AT_TOS, NULL,
 		(TCL_NAMESPACE_ONLY | TCL_LEAVE_ERR_MSG), "access",
@@ -4137,14 +4527,14 @@ TEBCresume(
      * -----------------------------------------------------------------
      */
 
-    case INST_JUMP1:
+    TARGET(INST_JUMP1):
 	opnd = TclGetInt1AtPtr(pc+1);
 	TRACE(("%d => new pc %" TCL_Z_MODIFIER "u\n", opnd,
 		(size_t)(pc + opnd - codePtr->codeStart)));
 	NEXT_INST_F(opnd, 0, 0);
     break;
 
-    case INST_JUMP4:
+    TARGET(INST_JUMP4):
 	opnd = TclGetInt4AtPtr(pc+1);
 	TRACE(("%d => new pc %" TCL_Z_MODIFIER "u\n", opnd,
 		(size_t)(pc + opnd - codePtr->codeStart)));
@@ -4155,22 +4545,22 @@ TEBCresume(
 
 	/* TODO: consider rewrite so we don't compute the offset we're not
 	 * going to take. */
-    case INST_JUMP_FALSE4:
+    TARGET(INST_JUMP_FALSE4):
 	jmpOffset[0] = TclGetInt4AtPtr(pc+1);	/* FALSE offset */
 	jmpOffset[1] = 5;			/* TRUE offset */
 	goto doCondJump;
 
-    case INST_JUMP_TRUE4:
+    TARGET(INST_JUMP_TRUE4):
 	jmpOffset[0] = 5;
 	jmpOffset[1] = TclGetInt4AtPtr(pc+1);
 	goto doCondJump;
 
-    case INST_JUMP_FALSE1:
+    TARGET(INST_JUMP_FALSE1):
 	jmpOffset[0] = TclGetInt1AtPtr(pc+1);
 	jmpOffset[1] = 2;
 	goto doCondJump;
 
-    case INST_JUMP_TRUE1:
+    TARGET(INST_JUMP_TRUE1):
 	jmpOffset[0] = 2;
 	jmpOffset[1] = TclGetInt1AtPtr(pc+1);
 
@@ -4207,7 +4597,7 @@ TEBCresume(
     }
     break;
 
-    case INST_JUMP_TABLE: {
+    TARGET(INST_JUMP_TABLE): {
 	Tcl_HashEntry *hPtr;
 	JumptableInfo *jtPtr;
 
@@ -4238,7 +4628,7 @@ TEBCresume(
      *	   Start of general introspector instructions.
      */
 
-    case INST_NS_CURRENT: {
+    TARGET(INST_NS_CURRENT): {
 	Namespace *currNsPtr = (Namespace *) TclGetCurrentNamespace(interp);
 
 	if (currNsPtr == (Namespace *) TclGetGlobalNamespace(interp)) {
@@ -4251,7 +4641,7 @@ TEBCresume(
 	NEXT_INST_F(1, 0, 1);
     }
     break;
-    case INST_COROUTINE_NAME: {
+    TARGET(INST_COROUTINE_NAME): {
 	CoroutineData *corPtr = iPtr->execEnvPtr->corPtr;
 
 	TclNewObj(objResultPtr);
@@ -4263,12 +4653,12 @@ TEBCresume(
 	NEXT_INST_F(1, 0, 1);
     }
     break;
-    case INST_INFO_LEVEL_NUM:
+    TARGET(INST_INFO_LEVEL_NUM):
 	TclNewIntObj(objResultPtr, iPtr->varFramePtr->level);
 	TRACE_WITH_OBJ(("=> "), objResultPtr);
 	NEXT_INST_F(1, 0, 1);
     break;
-    case INST_INFO_LEVEL_ARGS: {
+    TARGET(INST_INFO_LEVEL_ARGS): {
 	int level;
 	CallFrame *framePtr = iPtr->varFramePtr;
 	CallFrame *rootFramePtr = iPtr->rootFramePtr;
@@ -4302,7 +4692,7 @@ TEBCresume(
     {
 	Tcl_Command cmd, origCmd;
 
-    case INST_RESOLVE_COMMAND:
+    TARGET(INST_RESOLVE_COMMAND):
 	cmd = Tcl_GetCommandFromObj(interp, OBJ_AT_TOS);
 	TclNewObj(objResultPtr);
 	if (cmd != NULL) {
@@ -4311,7 +4701,7 @@ TEBCresume(
 	TRACE_WITH_OBJ(("\"%.20s\" => ", O2S(OBJ_AT_TOS)), objResultPtr);
 	NEXT_INST_F(1, 1, 1);
 
-    case INST_ORIGIN_COMMAND:
+    TARGET(INST_ORIGIN_COMMAND):
 	TRACE(("\"%.30s\" => ", O2S(OBJ_AT_TOS)));
 	cmd = Tcl_GetCommandFromObj(interp, OBJ_AT_TOS);
 	if (cmd == NULL) {
@@ -4351,7 +4741,7 @@ TEBCresume(
 	CallContext *contextPtr;
 	size_t skip, newDepth;
 
-    case INST_TCLOO_SELF:
+    TARGET(INST_TCLOO_SELF):
 	framePtr = iPtr->varFramePtr;
 	if (framePtr == NULL ||
 		!(framePtr->isProcCallFrame & FRAME_IS_METHOD)) {
@@ -4374,7 +4764,7 @@ TEBCresume(
 	TRACE_WITH_OBJ(("=> "), objResultPtr);
 	NEXT_INST_F(1, 0, 1);
 
-    case INST_TCLOO_NEXT_CLASS:
+    TARGET(INST_TCLOO_NEXT_CLASS):
 	opnd = TclGetUInt1AtPtr(pc+1);
 	framePtr = iPtr->varFramePtr;
 	valuePtr = OBJ_AT_DEPTH(opnd - 2);
@@ -4474,7 +4864,7 @@ TEBCresume(
 	    goto gotError;
 	}
 
-    case INST_TCLOO_NEXT:
+    TARGET(INST_TCLOO_NEXT):
 	opnd = TclGetUInt1AtPtr(pc+1);
 	objv = &OBJ_AT_DEPTH(opnd - 1);
 	framePtr = iPtr->varFramePtr;
@@ -4581,12 +4971,12 @@ TEBCresume(
 		    (Tcl_ObjectContext) contextPtr, opnd, objv);
 	}
 
-    case INST_TCLOO_IS_OBJECT:
+    TARGET(INST_TCLOO_IS_OBJECT):
 	oPtr = (Object *) Tcl_GetObjectFromObj(interp, OBJ_AT_TOS);
 	objResultPtr = TCONST(oPtr != NULL ? 1 : 0);
 	TRACE_WITH_OBJ(("%.30s => ", O2S(OBJ_AT_TOS)), objResultPtr);
 	NEXT_INST_F(1, 1, 1);
-    case INST_TCLOO_CLASS:
+    TARGET(INST_TCLOO_CLASS):
 	oPtr = (Object *) Tcl_GetObjectFromObj(interp, OBJ_AT_TOS);
 	if (oPtr == NULL) {
 	    TRACE(("%.30s => ERROR: not object\n", O2S(OBJ_AT_TOS)));
@@ -4595,7 +4985,7 @@ TEBCresume(
 	objResultPtr = TclOOObjectName(interp, oPtr->selfCls->thisPtr);
 	TRACE_WITH_OBJ(("%.30s => ", O2S(OBJ_AT_TOS)), objResultPtr);
 	NEXT_INST_F(1, 1, 1);
-    case INST_TCLOO_NS:
+    TARGET(INST_TCLOO_NS):
 	oPtr = (Object *) Tcl_GetObjectFromObj(interp, OBJ_AT_TOS);
 	if (oPtr == NULL) {
 	    TRACE(("%.30s => ERROR: not object\n", O2S(OBJ_AT_TOS)));
@@ -4623,7 +5013,7 @@ TEBCresume(
 	size_t slength, length2, fromIdx, toIdx, index, s1len, s2len;
 	const char *s1, *s2;
 
-    case INST_LIST:
+    TARGET(INST_LIST):
 	/*
 	 * Pop the opnd (objc) top stack elements into a new list obj and then
 	 * decrement their ref counts.
@@ -4634,7 +5024,7 @@ TEBCresume(
 	TRACE_WITH_OBJ(("%u => ", opnd), objResultPtr);
 	NEXT_INST_V(5, opnd, 1);
 
-    case INST_LIST_LENGTH:
+    TARGET(INST_LIST_LENGTH):
 	TRACE(("\"%.30s\" => ", O2S(OBJ_AT_TOS)));
 	if (TclListObjLengthM(interp, OBJ_AT_TOS, &length) != TCL_OK) {
 	    TRACE_ERROR(interp);
@@ -4644,7 +5034,7 @@ TEBCresume(
 	TRACE_APPEND(("%d\n", length));
 	NEXT_INST_F(1, 1, 1);
 
-    case INST_LIST_INDEX:	/* lindex with objc == 3 */
+    TARGET(INST_LIST_INDEX):	/* lindex with objc == 3 */
 	value2Ptr = OBJ_AT_TOS;
 	valuePtr = OBJ_UNDER_TOS;
 	TRACE(("\"%.30s\" \"%.30s\" => ", O2S(valuePtr), O2S(value2Ptr)));
@@ -4653,7 +5043,32 @@ TEBCresume(
 	 * Extract the desired list element.
 	 */
 
-	if ((TclListObjGetElementsM(interp, valuePtr, &objc, &objv) == TCL_OK)
+	if (TclHasInternalRep(valuePtr, &tclListTreeType)
+		&& !TclHasInternalRep(value2Ptr, &tclListType)) {
+	    int code;
+
+	    /*
+	     * Index a long list held as a tree without flattening it. The
+	     * index is converted first, in case it is the list itself.
+	     */
+
+	    TclListObjLengthM(NULL, valuePtr, &objc);
+	    DECACHE_STACK_INFO();
+	    code = TclGetIntForIndexM(interp, value2Ptr, objc-1, &index);
+	    CACHE_STACK_INFO();
+	    if (code == TCL_OK) {
+		objResultPtr = NULL;
+		if (index < (size_t)objc) {
+		    Tcl_ListObjIndex(NULL, valuePtr, (int)index, &objResultPtr);
+		}
+		if (objResultPtr == NULL) {
+		    TclNewObj(objResultPtr);
+		}
+		TRACE_APPEND(("\"%.30s\"\n", O2S(objResultPtr)));
+		NEXT_INST_F(1, 2, 1);
+	    }
+	    Tcl_ResetResult(interp);
+	} else if ((TclListObjGetElementsM(interp, valuePtr, &objc, &objv) == TCL_OK)
 		&& !TclHasInternalRep(value2Ptr, &tclListType)) {
 	    int code;
 
@@ -4682,7 +5097,7 @@ TEBCresume(
 	TRACE_APPEND(("\"%.30s\"\n", O2S(objResultPtr)));
 	NEXT_INST_F(1, 2, -1);	/* Already has the correct refCount */
 
-    case INST_LIST_INDEX_IMM:	/* lindex with objc==3 and index in bytecode
+    TARGET(INST_LIST_INDEX_IMM):	/* lindex with objc==3 and index in bytecode
 				 * stream */
 
 	/*
@@ -4693,6 +5108,23 @@ TEBCresume(
 	opnd = TclGetInt4AtPtr(pc+1);
 	TRACE(("\"%.30s\" %d => ", O2S(valuePtr), opnd));
 
+	/*
+	 * Long lists held as trees are indexed without flattening them.
+	 */
+
+	if (TclHasInternalRep(valuePtr, &tclListTreeType)) {
+	    TclListObjLengthM(NULL, valuePtr, &objc);
+	    index = TclIndexDecode(opnd, objc - 1);
+	    objResultPtr = NULL;
+	    if (index < (size_t)objc) {
+		Tcl_ListObjIndex(NULL, valuePtr, (int)index, &objResultPtr);
+	    } else {
+		TclNewObj(objResultPtr);
+	    }
+	    TRACE_APPEND(("\"%.30s\"\n", O2S(objResultPtr)));
+	    NEXT_INST_F(5, 1, 1);
+	}
+
 	/*
 	 * Get the contents of the list, making sure that it really is a list
 	 * in the process.
@@ -4718,7 +5150,7 @@ TEBCresume(
 	TRACE_APPEND(("\"%.30s\"\n", O2S(objResultPtr)));
 	NEXT_INST_F(pcAdjustment, 1, 1);
 
-    case INST_LIST_INDEX_MULTI:	/* 'lindex' with multiple index args */
+    TARGET(INST_LIST_INDEX_MULTI):	/* 'lindex' with multiple index args */
 	/*
 	 * Determine the count of index args.
 	 */
@@ -4745,7 +5177,7 @@ TEBCresume(
 	TRACE_APPEND(("\"%.30s\"\n", O2S(objResultPtr)));
 	NEXT_INST_V(5, opnd, -1);
 
-    case INST_LSET_FLAT:
+    TARGET(INST_LSET_FLAT):
 	/*
 	 * Lset with 3, 5, or more args. Get the number of index args.
 	 */
@@ -4782,7 +5214,7 @@ TEBCresume(
 	TRACE_APPEND(("\"%.30s\"\n", O2S(objResultPtr)));
 	NEXT_INST_V(5, numIndices+1, -1);
 
-    case INST_LSET_LIST:	/* 'lset' with 4 args */
+    TARGET(INST_LSET_LIST):	/* 'lset' with 4 args */
 	/*
 	 * Get the old value of variable, and remove the stack ref. This is
 	 * safe because the variable still references the object; the ref
@@ -4819,7 +5251,7 @@ TEBCresume(
 	TRACE_APPEND(("\"%.30s\"\n", O2S(objResultPtr)));
 	NEXT_INST_F(1, 2, -1);
 
-    case INST_LIST_RANGE_IMM:	/* lrange with objc==4 and both indices in
+    TARGET(INST_LIST_RANGE_IMM):	/* lrange with objc==4 and both indices in
 				 * bytecode stream */
 
 	/*
@@ -4895,8 +5327,8 @@ TEBCresume(
 	TRACE_APPEND(("\"%.30s\"", O2S(objResultPtr)));
 	NEXT_INST_F(9, 1, 1);
 
-    case INST_LIST_IN:
-    case INST_LIST_NOT_IN:	/* Basic list containment operators. */
+    TARGET(INST_LIST_IN):
+    TARGET(INST_LIST_NOT_IN):	/* Basic list containment operators. */
 	value2Ptr = OBJ_AT_TOS;
 	valuePtr = OBJ_UNDER_TOS;
 
@@ -4907,7 +5339,9 @@ TEBCresume(
 	    goto gotError;
 	}
 	match = 0;
-	if (length > 0) {
+	if (length > 0 && TclListObjFind(value2Ptr, valuePtr, &match)) {
+	    match = (match >= 0);
+	} else if (length > 0) {
 	    int i = 0;
 	    Tcl_Obj *o;
 
@@ -4915,6 +5349,7 @@ TEBCresume(
 	     * An empty list doesn't match anything.
 	     */
 
+	    match = 0;
 	    do {
 		Tcl_ListObjIndex(NULL, value2Ptr, i, &o);
 		if (o != NULL) {
@@ -4944,7 +5379,7 @@ TEBCresume(
 
 	JUMP_PEEPHOLE_F(match, 1, 2);
 
-    case INST_LIST_CONCAT:
+    TARGET(INST_LIST_CONCAT):
 	value2Ptr = OBJ_AT_TOS;
 	valuePtr = OBJ_UNDER_TOS;
 	TRACE(("\"%.30s\" \"%.30s\" => ", O2S(valuePtr), O2S(value2Ptr)));
@@ -4973,13 +5408,13 @@ TEBCresume(
      *	   Start of string-related instructions.
      */
 
-    case INST_STR_EQ:
-    case INST_STR_NEQ:		/* String (in)equality check */
-    case INST_STR_CMP:		/* String compare. */
-    case INST_STR_LT:
-    case INST_STR_GT:
-    case INST_STR_LE:
-    case INST_STR_GE:
+    TARGET(INST_STR_EQ):
+    TARGET(INST_STR_NEQ):		/* String (in)equality check */
+    TARGET(INST_STR_CMP):		/* String compare. */
+    TARGET(INST_STR_LT):
+    TARGET(INST_STR_GT):
+    TARGET(INST_STR_LE):
+    TARGET(INST_STR_GE):
     stringCompare:
 	value2Ptr = OBJ_AT_TOS;
 	valuePtr = OBJ_UNDER_TOS;
@@ -5032,14 +5467,14 @@ TEBCresume(
 		(match < 0 ? -1 : match > 0 ? 1 : 0)));
 	JUMP_PEEPHOLE_F(match, 1, 2);
 
-    case INST_STR_LEN:
+    TARGET(INST_STR_LEN):
 	valuePtr = OBJ_AT_TOS;
 	slength = Tcl_GetCharLength(valuePtr);
 	TclNewIntObj(objResultPtr, slength);
 	TRACE(("\"%.20s\" => %" TCL_Z_MODIFIER "u\n", O2S(valuePtr), slength));
 	NEXT_INST_F(1, 1, 1);
 
-    case INST_STR_UPPER:
+    TARGET(INST_STR_UPPER):
 	valuePtr = OBJ_AT_TOS;
 	TRACE(("\"%.20s\" => ", O2S(valuePtr)));
 	if (Tcl_IsShared(valuePtr)) {
@@ -5056,7 +5491,7 @@ TEBCresume(
 	    TRACE_APPEND(("\"%.20s\"\n", O2S(valuePtr)));
 	    NEXT_INST_F(1, 0, 0);
 	}
-    case INST_STR_LOWER:
+    TARGET(INST_STR_LOWER):
 	valuePtr = OBJ_AT_TOS;
 	TRACE(("\"%.20s\" => ", O2S(valuePtr)));
 	if (Tcl_IsShared(valuePtr)) {
@@ -5073,7 +5508,7 @@ TEBCresume(
 	    TRACE_APPEND(("\"%.20s\"\n", O2S(valuePtr)));
 	    NEXT_INST_F(1, 0, 0);
 	}
-    case INST_STR_TITLE:
+    TARGET(INST_STR_TITLE):
 	valuePtr = OBJ_AT_TOS;
 	TRACE(("\"%.20s\" => ", O2S(valuePtr)));
 	if (Tcl_IsShared(valuePtr)) {
@@ -5091,7 +5526,7 @@ TEBCresume(
 	    NEXT_INST_F(1, 0, 0);
 	}
 
-    case INST_STR_INDEX:
+    TARGET(INST_STR_INDEX):
 	value2Ptr = OBJ_AT_TOS;
 	valuePtr = OBJ_UNDER_TOS;
 	TRACE(("\"%.20s\" %.20s => ", O2S(valuePtr), O2S(value2Ptr)));
@@ -5140,7 +5575,7 @@ TEBCresume(
 	TRACE_APPEND(("\"%s\"\n", O2S(objResultPtr)));
 	NEXT_INST_F(1, 2, 1);
 
-    case INST_STR_RANGE:
+    TARGET(INST_STR_RANGE):
 	TRACE(("\"%.20s\" %.20s %.20s =>",
 		O2S(OBJ_AT_DEPTH(2)), O2S(OBJ_UNDER_TOS), O2S(OBJ_AT_TOS)));
 	slength = Tcl_GetCharLength(OBJ_AT_DEPTH(2)) - 1;
@@ -5168,7 +5603,7 @@ TEBCresume(
 	TRACE_APPEND(("\"%.30s\"\n", O2S(objResultPtr)));
 	NEXT_INST_V(1, 3, 1);
 
-    case INST_STR_RANGE_IMM:
+    TARGET(INST_STR_RANGE_IMM):
 	valuePtr = OBJ_AT_TOS;
 	fromIdx = TclGetInt4AtPtr(pc+1);
 	toIdx = TclGetInt4AtPtr(pc+5);
@@ -5198,7 +5633,7 @@ TEBCresume(
 	size_t length3;
 	Tcl_Obj *value3Ptr;
 
-    case INST_STR_REPLACE:
+    TARGET(INST_STR_REPLACE):
 	value3Ptr = POP_OBJECT();
 	valuePtr = OBJ_AT_DEPTH(2);
 	slength = Tcl_GetCharLength(valuePtr) - 1;
@@ -5257,7 +5692,7 @@ TEBCresume(
 	TRACE_APPEND(("\"%.30s\"\n", O2S(objResultPtr)));
 	NEXT_INST_F(1, 1, 1);
 
-    case INST_STR_MAP:
+    TARGET(INST_STR_MAP):
 	valuePtr = OBJ_AT_TOS;		/* "Main" string. */
 	value3Ptr = OBJ_UNDER_TOS;	/* "Target" string. */
 	value2Ptr = OBJ_AT_DEPTH(2);	/* "Source" string. */
@@ -5319,21 +5754,21 @@ TEBCresume(
 		O2S(value2Ptr), O2S(value3Ptr), O2S(valuePtr)), objResultPtr);
 	NEXT_INST_V(1, 3, 1);
 
-    case INST_STR_FIND:
+    TARGET(INST_STR_FIND):
 	objResultPtr = TclStringFirst(OBJ_UNDER_TOS, OBJ_AT_TOS, 0);
 
 	TRACE(("%.20s %.20s => %s\n",
 		O2S(OBJ_UNDER_TOS), O2S(OBJ_AT_TOS), O2S(objResultPtr)));
 	NEXT_INST_F(1, 2, 1);
 
-    case INST_STR_FIND_LAST:
+    TARGET(INST_STR_FIND_LAST):
 	objResultPtr = TclStringLast(OBJ_UNDER_TOS, OBJ_AT_TOS, INT_MAX - 1);
 
 	TRACE(("%.20s %.20s => %s\n",
 		O2S(OBJ_UNDER_TOS), O2S(OBJ_AT_TOS), O2S(objResultPtr)));
 	NEXT_INST_F(1, 2, 1);
 
-    case INST_STR_CLASS:
+    TARGET(INST_STR_CLASS):
 	opnd = TclGetInt1AtPtr(pc+1);
 	valuePtr = OBJ_AT_TOS;
 	TRACE(("%s \"%.30s\" => ", tclStringClassTable[opnd].name,
@@ -5355,7 +5790,7 @@ TEBCresume(
 	JUMP_PEEPHOLE_F(match, 2, 1);
     }
 
-    case INST_STR_MATCH:
+    TARGET(INST_STR_MATCH):
 	nocase = TclGetInt1AtPtr(pc+1);
 	valuePtr = OBJ_AT_TOS;		/* String */
 	value2Ptr = OBJ_UNDER_TOS;	/* Pattern */
@@ -5402,7 +5837,7 @@ TEBCresume(
 	const char *string1, *string2;
 	size_t trim1, trim2;
 
-    case INST_STR_TRIM_LEFT:
+    TARGET(INST_STR_TRIM_LEFT):
 	valuePtr = OBJ_UNDER_TOS;	/* String */
 	value2Ptr = OBJ_AT_TOS;		/* TrimSet */
 	string2 = Tcl_GetStringFromObj(value2Ptr, &length2);
@@ -5410,7 +5845,7 @@ TEBCresume(
 	trim1 = TclTrimLeft(string1, slength, string2, length2);
 	trim2 = 0;
 	goto createTrimmedString;
-    case INST_STR_TRIM_RIGHT:
+    TARGET(INST_STR_TRIM_RIGHT):
 	valuePtr = OBJ_UNDER_TOS;	/* String */
 	value2Ptr = OBJ_AT_TOS;		/* TrimSet */
 	string2 = Tcl_GetStringFromObj(value2Ptr, &length2);
@@ -5418,7 +5853,7 @@ TEBCresume(
 	trim2 = TclTrimRight(string1, slength, string2, length2);
 	trim1 = 0;
 	goto createTrimmedString;
-    case INST_STR_TRIM:
+    TARGET(INST_STR_TRIM):
 	valuePtr = OBJ_UNDER_TOS;	/* String */
 	value2Ptr = OBJ_AT_TOS;		/* TrimSet */
 	string2 = Tcl_GetStringFromObj(value2Ptr, &length2);
@@ -5457,7 +5892,7 @@ TEBCresume(
 	}
     }
 
-    case INST_REGEXP:
+    TARGET(INST_REGEXP):
 	cflags = TclGetInt1AtPtr(pc+1); /* RE compile flages like NOCASE */
 	valuePtr = OBJ_AT_TOS;		/* String */
 	value2Ptr = OBJ_UNDER_TOS;	/* Pattern */
@@ -5503,7 +5938,7 @@ TEBCresume(
 	int type1, type2;
 	Tcl_WideInt w1, w2, wResult;
 
-    case INST_NUM_TYPE:
+    TARGET(INST_NUM_TYPE):
 	if (GetNumberFromObj(NULL, OBJ_AT_TOS, &ptr1, &type1) != TCL_OK) {
 	    type1 = 0;
 	} else if (type1 == TCL_NUMBER_BIG) {
@@ -5519,17 +5954,128 @@ TEBCresume(
 	TRACE(("\"%.20s\" => %d\n", O2S(OBJ_AT_TOS), type1));
 	NEXT_INST_F(1, 1, 1);
 
-    case INST_EQ:
-    case INST_NEQ:
-    case INST_LT:
-    case INST_GT:
-    case INST_LE:
-    case INST_GE: {
+    TARGET(INST_EQ_INT):
+    TARGET(INST_NEQ_INT):
+    TARGET(INST_LT_INT):
+    TARGET(INST_GT_INT):
+    TARGET(INST_LE_INT):
+    TARGET(INST_GE_INT): {
+	int iResult;
+
+	value2Ptr = OBJ_AT_TOS;
+	valuePtr = OBJ_UNDER_TOS;
+	if (!TclHasInternalRep(valuePtr, &tclIntType)
+		|| !TclHasInternalRep(value2Ptr, &tclIntType)) {
+	    TRACE(("\"%.20s\" \"%.20s\" => NOT INT, UNQUICKEN\n",
+		    O2S(valuePtr), O2S(value2Ptr)));
+	    UNQUICKEN(INST_EQ + (*pc - INST_EQ_INT));
+	}
+
+    quickCompareInt:
+	w1 = valuePtr->internalRep.wideValue;
+	w2 = value2Ptr->internalRep.wideValue;
+	switch (*pc) {
+	case INST_EQ_INT:
+	    iResult = (w1 == w2);
+	    break;
+	case INST_NEQ_INT:
+	    iResult = (w1 != w2);
+	    break;
+	case INST_LT_INT:
+	    iResult = (w1 < w2);
+	    break;
+	case INST_GT_INT:
+	    iResult = (w1 > w2);
+	    break;
+	case INST_LE_INT:
+	    iResult = (w1 <= w2);
+	    break;
+	default:		/* INST_GE_INT */
+	    iResult = (w1 >= w2);
+	    break;
+	}
+	TRACE(("\"%.20s\" \"%.20s\" => %d\n", O2S(valuePtr), O2S(value2Ptr),
+		iResult));
+	JUMP_PEEPHOLE_F(iResult, 1, 2);
+    }
+
+    TARGET(INST_EQ_DBL):
+    TARGET(INST_NEQ_DBL):
+    TARGET(INST_LT_DBL):
+    TARGET(INST_GT_DBL):
+    TARGET(INST_LE_DBL):
+    TARGET(INST_GE_DBL): {
+	int iResult;
+	double d1, d2;
+
+	value2Ptr = OBJ_AT_TOS;
+	valuePtr = OBJ_UNDER_TOS;
+	if (!TclHasInternalRep(valuePtr, &tclDoubleType)
+		|| !TclHasInternalRep(value2Ptr, &tclDoubleType)
+		|| isnan(valuePtr->internalRep.doubleValue)
+		|| isnan(value2Ptr->internalRep.doubleValue)) {
+	    TRACE(("\"%.20s\" \"%.20s\" => NOT DOUBLE, UNQUICKEN\n",
+		    O2S(valuePtr), O2S(value2Ptr)));
+	    UNQUICKEN(INST_EQ + (*pc - INST_EQ_DBL));
+	}
+
+    quickCompareDbl:
+	d1 = valuePtr->internalRep.doubleValue;
+	d2 = value2Ptr->internalRep.doubleValue;
+	switch (*pc) {
+	case INST_EQ_DBL:
+	    iResult = (d1 == d2);
+	    break;
+	case INST_NEQ_DBL:
+	    iResult = (d1 != d2);
+	    break;
+	case INST_LT_DBL:
+	    iResult = (d1 < d2);
+	    break;
+	case INST_GT_DBL:
+	    iResult = (d1 > d2);
+	    break;
+	case INST_LE_DBL:
+	    iResult = (d1 <= d2);
+	    break;
+	default:		/* INST_GE_DBL */
+	    iResult = (d1 >= d2);
+	    break;
+	}
+	TRACE(("\"%.20s\" \"%.20s\" => %d\n", O2S(valuePtr), O2S(value2Ptr),
+		iResult));
+	JUMP_PEEPHOLE_F(iResult, 1, 2);
+    }
+
+    TARGET(INST_EQ):
+    TARGET(INST_NEQ):
+    TARGET(INST_LT):
+    TARGET(INST_GT):
+    TARGET(INST_LE):
+    TARGET(INST_GE): {
 	int iResult = 0, compare = 0;
 
 	value2Ptr = OBJ_AT_TOS;
 	valuePtr = OBJ_UNDER_TOS;
 
+	/*
+	 * Quicken when both values are ints, or both are doubles and neither
+	 * is a NaN. These are exactly the conditions the specialized
+	 * instructions check, so we never bounce between the two forms.
+	 */
+
+	if (TclHasInternalRep(valuePtr, &tclIntType)
+		&& TclHasInternalRep(value2Ptr, &tclIntType)) {
+	    QUICKEN(INST_EQ_INT + (*pc - INST_EQ));
+	    goto quickCompareInt;
+	} else if (TclHasInternalRep(valuePtr, &tclDoubleType)
+		&& TclHasInternalRep(value2Ptr, &tclDoubleType)
+		&& !isnan(valuePtr->internalRep.doubleValue)
+		&& !isnan(value2Ptr->internalRep.doubleValue)) {
+	    QUICKEN(INST_EQ_DBL + (*pc - INST_EQ));
+	    goto quickCompareDbl;
+	}
+
 	/*
 	    Try to determine, without triggering generation of a string
 	    representation, whether one value is not a number.
@@ -5602,12 +6148,12 @@ TEBCresume(
 	JUMP_PEEPHOLE_F(iResult, 1, 2);
     }
 
-    case INST_MOD:
-    case INST_LSHIFT:
-    case INST_RSHIFT:
-    case INST_BITOR:
-    case INST_BITXOR:
-    case INST_BITAND:
+    TARGET(INST_MOD):
+    TARGET(INST_LSHIFT):
+    TARGET(INST_RSHIFT):
+    TARGET(INST_BITOR):
+    TARGET(INST_BITXOR):
+    TARGET(INST_BITAND):
 	value2Ptr = OBJ_AT_TOS;
 	valuePtr = OBJ_UNDER_TOS;
 
@@ -5824,13 +6370,138 @@ TEBCresume(
 	    NEXT_INST_F(1, 2, 1);
 	}
 
-    case INST_EXPON:
-    case INST_ADD:
-    case INST_SUB:
-    case INST_DIV:
-    case INST_MULT:
+    TARGET(INST_ADD_INT):
+    TARGET(INST_SUB_INT):
+    TARGET(INST_MULT_INT):
 	value2Ptr = OBJ_AT_TOS;
 	valuePtr = OBJ_UNDER_TOS;
+	if (!TclHasInternalRep(valuePtr, &tclIntType)
+		|| !TclHasInternalRep(value2Ptr, &tclIntType)) {
+	    TRACE(("%.20s %.20s => NOT INT, UNQUICKEN\n",
+		    O2S(valuePtr), O2S(value2Ptr)));
+	    UNQUICKEN(INST_ADD + (*pc - INST_ADD_INT));
+	}
+
+    quickArithInt:
+	w1 = valuePtr->internalRep.wideValue;
+	w2 = value2Ptr->internalRep.wideValue;
+	switch (*pc) {
+	case INST_ADD_INT:
+	    wResult = (Tcl_WideInt)((Tcl_WideUInt)w1 + (Tcl_WideUInt)w2);
+	    if (Overflowing(w1, w2, wResult)) {
+		goto quickArithOverflow;
+	    }
+	    break;
+	case INST_SUB_INT:
+	    wResult = (Tcl_WideInt)((Tcl_WideUInt)w1 - (Tcl_WideUInt)w2);
+	    if (Overflowing(w1, ~w2, wResult)) {
+		goto quickArithOverflow;
+	    }
+	    break;
+	default:		/* INST_MULT_INT */
+	    if ((w1 > INT_MAX) || (w1 < INT_MIN)
+		    || (w2 > INT_MAX) || (w2 < INT_MIN)) {
+		goto quickArithOverflow;
+	    }
+	    wResult = w1 * w2;
+	    break;
+	}
+	TRACE(("%s %s => ", O2S(valuePtr), O2S(value2Ptr)));
+	if (Tcl_IsShared(valuePtr)) {
+	    TclNewIntObj(objResultPtr, wResult);
+	    TRACE(("%s\n", O2S(objResultPtr)));
+	    NEXT_INST_F(1, 2, 1);
+	}
+	TclSetIntObj(valuePtr, wResult);
+	TRACE(("%s\n", O2S(valuePtr)));
+	NEXT_INST_F(1, 1, 0);
+
+    quickArithOverflow:
+	/*
+	 * The result does not fit (or, for doubles, is a NaN such as Inf-Inf;
+	 * the operands are never NaNs here). Let the general code deal with
+	 * it; it needs the generic opcode at pc.
+	 */
+
+	if (*pc >= INST_ADD_DBL) {
+	    QUICKEN(INST_ADD + (*pc - INST_ADD_DBL));
+	} else {
+	    QUICKEN(INST_ADD + (*pc - INST_ADD_INT));
+	}
+	goto overflow;
+
+    TARGET(INST_ADD_DBL):
+    TARGET(INST_SUB_DBL):
+    TARGET(INST_MULT_DBL): {
+	double dResult;
+
+	value2Ptr = OBJ_AT_TOS;
+	valuePtr = OBJ_UNDER_TOS;
+	if (!TclHasInternalRep(valuePtr, &tclDoubleType)
+		|| !TclHasInternalRep(value2Ptr, &tclDoubleType)
+		|| isnan(valuePtr->internalRep.doubleValue)
+		|| isnan(value2Ptr->internalRep.doubleValue)) {
+	    TRACE(("%.20s %.20s => NOT DOUBLE, UNQUICKEN\n",
+		    O2S(valuePtr), O2S(value2Ptr)));
+	    UNQUICKEN(INST_ADD + (*pc - INST_ADD_DBL));
+	}
+
+    quickArithDbl:
+	switch (*pc) {
+	case INST_ADD_DBL:
+	    dResult = valuePtr->internalRep.doubleValue
+		    + value2Ptr->internalRep.doubleValue;
+	    break;
+	case INST_SUB_DBL:
+	    dResult = valuePtr->internalRep.doubleValue
+		    - value2Ptr->internalRep.doubleValue;
+	    break;
+	default:		/* INST_MULT_DBL */
+	    dResult = valuePtr->internalRep.doubleValue
+		    * value2Ptr->internalRep.doubleValue;
+	    break;
+	}
+	if (isnan(dResult)) {
+	    goto quickArithOverflow;
+	}
+	TRACE(("%s %s => ", O2S(valuePtr), O2S(value2Ptr)));
+	if (Tcl_IsShared(valuePtr)) {
+	    TclNewDoubleObj(objResultPtr, dResult);
+	    TRACE(("%s\n", O2S(objResultPtr)));
+	    NEXT_INST_F(1, 2, 1);
+	}
+	TclSetDoubleObj(valuePtr, dResult);
+	TRACE(("%s\n", O2S(valuePtr)));
+	NEXT_INST_F(1, 1, 0);
+    }
+    break;
+
+    TARGET(INST_EXPON):
+    TARGET(INST_ADD):
+    TARGET(INST_SUB):
+    TARGET(INST_DIV):
+    TARGET(INST_MULT):
+	value2Ptr = OBJ_AT_TOS;
+	valuePtr = OBJ_UNDER_TOS;
+
+	/*
+	 * Quicken add, sub and mult over two ints, or two doubles neither of
+	 * which is a NaN. A NaN operand is an error, which is reported below.
+	 */
+
+	if ((*pc >= INST_ADD) && (*pc <= INST_MULT)) {
+	    if (TclHasInternalRep(valuePtr, &tclIntType)
+		    && TclHasInternalRep(value2Ptr, &tclIntType)) {
+		QUICKEN(INST_ADD_INT + (*pc - INST_ADD));
+		goto quickArithInt;
+	    } else if (TclHasInternalRep(valuePtr, &tclDoubleType)
+		    && TclHasInternalRep(value2Ptr, &tclDoubleType)
+		    && !isnan(valuePtr->internalRep.doubleValue)
+		    && !isnan(value2Ptr->internalRep.doubleValue)) {
+		QUICKEN(INST_ADD_DBL + (*pc - INST_ADD));
+		goto quickArithDbl;
+	    }
+	}
 
 	if ((GetNumberFromObj(NULL, valuePtr, &ptr1, &type1) != TCL_OK)
 		|| IsErroringNaNType(type1)) {
@@ -5990,7 +6661,7 @@ TEBCresume(
 	    NEXT_INST_F(1, 2, 1);
 	}
 
-    case INST_LNOT: {
+    TARGET(INST_LNOT): {
 	int b;
 
 	valuePtr = OBJ_AT_TOS;
@@ -6011,7 +6682,7 @@ TEBCresume(
 	NEXT_INST_F(1, 1, 1);
     }
 
-    case INST_BITNOT:
+    TARGET(INST_BITNOT):
 	valuePtr = OBJ_AT_TOS;
 	TRACE(("\"%.20s\" => ", O2S(valuePtr)));
 	if ((GetNumberFromObj(NULL, valuePtr, &ptr1, &type1) != TCL_OK)
@@ -6047,7 +6718,7 @@ TEBCresume(
 	    NEXT_INST_F(1, 0, 0);
 	}
 
-    case INST_UMINUS:
+    TARGET(INST_UMINUS):
 	valuePtr = OBJ_AT_TOS;
 	TRACE(("\"%.20s\" => ", O2S(valuePtr)));
 	if ((GetNumberFromObj(NULL, valuePtr, &ptr1, &type1) != TCL_OK)
@@ -6088,8 +6759,8 @@ TEBCresume(
 	    NEXT_INST_F(1, 0, 0);
 	}
 
-    case INST_UPLUS:
-    case INST_TRY_CVT_TO_NUMERIC:
+    TARGET(INST_UPLUS):
+    TARGET(INST_TRY_CVT_TO_NUMERIC):
 	/*
 	 * Try to convert the topmost stack object to numeric object. This is
 	 * done in order to support [expr]'s policy of interpreting operands
@@ -6180,7 +6851,7 @@ TEBCresume(
      * -----------------------------------------------------------------
      */
 
-    case INST_TRY_CVT_TO_BOOLEAN:
+    TARGET(INST_TRY_CVT_TO_BOOLEAN):
 	valuePtr = OBJ_AT_TOS;
 	if (TclHasInternalRep(valuePtr,  &tclBooleanType)) {
 	    objResultPtr = TCONST(1);
@@ -6192,7 +6863,7 @@ TEBCresume(
 	NEXT_INST_F(1, 0, 1);
     break;
 
-    case INST_BREAK:
+    TARGET(INST_BREAK):
 	/*
 	DECACHE_STACK_INFO();
 	Tcl_ResetResult(interp);
@@ -6203,7 +6874,7 @@ TEBCresume(
 	TRACE(("=> BREAK!\n"));
 	goto processExceptionReturn;
 
-    case INST_CONTINUE:
+    TARGET(INST_CONTINUE):
 	/*
 	DECACHE_STACK_INFO();
 	Tcl_ResetResult(interp);
@@ -6224,7 +6895,7 @@ TEBCresume(
 	int varIndex, valIndex, j;
 	long i;
 
-    case INST_FOREACH_START:
+    TARGET(INST_FOREACH_START):
 	/*
 	 * Initialize the data for the looping construct, pushing the
 	 * corresponding Tcl_Objs to the stack.
@@ -6292,7 +6963,7 @@ TEBCresume(
 
 	pc += 5 - infoPtr->loopCtTemp;
 
-    case INST_FOREACH_STEP:
+    TARGET(INST_FOREACH_STEP):
 	/*
 	 * "Step" a foreach loop (i.e., begin its next iteration) by assigning
 	 * the next value list element to each loop var.
@@ -6380,7 +7051,7 @@ TEBCresume(
 	pc++;
 #endif
 
-    case INST_FOREACH_END:
+    TARGET(INST_FOREACH_END):
 	/* THIS INSTRUCTION IS ONLY CALLED AS A BREAK TARGET */
 	tmpPtr = OBJ_AT_TOS;
 	infoPtr = (ForeachInfo *)tmpPtr->internalRep.twoPtrValue.ptr1;
@@ -6388,7 +7059,7 @@ TEBCresume(
 	TRACE(("=> loop terminated\n"));
 	NEXT_INST_V(1, numLists+2, 0);
 
-    case INST_LMAP_COLLECT:
+    TARGET(INST_LMAP_COLLECT):
 	/*
 	 * This instruction is only issued by lmap. The stack is:
 	 *   - result
@@ -6410,7 +7081,7 @@ TEBCresume(
     }
     break;
 
-    case INST_BEGIN_CATCH4:
+    TARGET(INST_BEGIN_CATCH4):
 	/*
 	 * Record start of the catch command with exception range index equal
 	 * to the operand. Push the current stack depth onto the special catch
@@ -6424,7 +7095,7 @@ TEBCresume(
 	NEXT_INST_F(5, 0, 0);
     break;
 
-    case INST_END_CATCH:
+    TARGET(INST_END_CATCH):
 	catchTop--;
 	DECACHE_STACK_INFO();
 	Tcl_ResetResult(interp);
@@ -6434,7 +7105,7 @@ TEBCresume(
 	NEXT_INST_F(1, 0, 0);
     break;
 
-    case INST_PUSH_RESULT:
+    TARGET(INST_PUSH_RESULT):
 	objResultPtr = Tcl_GetObjResult(interp);
 	TRACE_WITH_OBJ(("=> "), objResultPtr);
 
@@ -6448,13 +7119,13 @@ TEBCresume(
 	NEXT_INST_F(1, 0, -1);
     break;
 
-    case INST_PUSH_RETURN_CODE:
+    TARGET(INST_PUSH_RETURN_CODE):
 	TclNewIntObj(objResultPtr, result);
 	TRACE(("=> %u\n", result));
 	NEXT_INST_F(1, 0, 1);
     break;
 
-    case INST_PUSH_RETURN_OPTIONS:
+    TARGET(INST_PUSH_RETURN_OPTIONS):
 	DECACHE_STACK_INFO();
 	objResultPtr = Tcl_GetReturnOptions(interp, result);
 	CACHE_STACK_INFO();
@@ -6462,7 +7133,7 @@ TEBCresume(
 	NEXT_INST_F(1, 0, 1);
     break;
 
-    case INST_RETURN_CODE_BRANCH: {
+    TARGET(INST_RETURN_CODE_BRANCH): {
 	int code;
 
 	if (TclGetIntFromObj(NULL, OBJ_AT_TOS, &code) != TCL_OK) {
@@ -6490,7 +7161,7 @@ TEBCresume(
 	Tcl_DictSearch *searchPtr;
 	DictUpdateInfo *duiPtr;
 
-    case INST_DICT_VERIFY:
+    TARGET(INST_DICT_VERIFY):
 	dictPtr = OBJ_AT_TOS;
 	TRACE(("\"%.30s\" => ", O2S(dictPtr)));
 	if (Tcl_DictObjSize(interp, dictPtr, &done) != TCL_OK) {
@@ -6502,7 +7173,7 @@ TEBCresume(
 	NEXT_INST_F(1, 1, 0);
     break;
 
-    case INST_DICT_EXISTS: {
+    TARGET(INST_DICT_EXISTS): {
 	int found;
 
 	opnd = TclGetUInt4AtPtr(pc+1);
@@ -6534,7 +7205,7 @@ TEBCresume(
 
 	JUMP_PEEPHOLE_V(found, 5, opnd+1);
     }
-    case INST_DICT_GET:
+    TARGET(INST_DICT_GET):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	TRACE(("%u => ", opnd));
 	dictPtr = OBJ_AT_DEPTH(opnd);
@@ -6568,7 +7239,7 @@ TEBCresume(
 	}
 	TRACE_APPEND(("%.30s\n", O2S(objResultPtr)));
 	NEXT_INST_V(5, opnd+1, 1);
-    case INST_DICT_GET_DEF:
+    TARGET(INST_DICT_GET_DEF):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	TRACE(("%u => ", opnd));
 	dictPtr = OBJ_AT_DEPTH(opnd+1);
@@ -6597,9 +7268,9 @@ TEBCresume(
 	TRACE_APPEND(("%.30s\n", O2S(objResultPtr)));
 	NEXT_INST_V(5, opnd+2, 1);
 
-    case INST_DICT_SET:
-    case INST_DICT_UNSET:
-    case INST_DICT_INCR_IMM:
+    TARGET(INST_DICT_SET):
+    TARGET(INST_DICT_UNSET):
+    TARGET(INST_DICT_INCR_IMM):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	opnd2 = TclGetUInt4AtPtr(pc+5);
 
@@ -6704,8 +7375,8 @@ TEBCresume(
 	TRACE_APPEND(("\"%.30s\"\n", O2S(objResultPtr)));
 	NEXT_INST_V(9, cleanup, 1);
 
-    case INST_DICT_APPEND:
-    case INST_DICT_LAPPEND:
+    TARGET(INST_DICT_APPEND):
+    TARGET(INST_DICT_LAPPEND):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	varPtr = LOCAL(opnd);
 	while (TclIsVarLink(varPtr)) {
@@ -6843,7 +7514,7 @@ TEBCresume(
 	TRACE_APPEND(("%.30s\n", O2S(objResultPtr)));
 	NEXT_INST_F(5, 2, 1);
 
-    case INST_DICT_FIRST:
+    TARGET(INST_DICT_FIRST):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	TRACE(("%u => ", opnd));
 	dictPtr = POP_OBJECT();
@@ -6880,7 +7551,7 @@ TEBCresume(
 	Tcl_IncrRefCount(statePtr);
 	goto pushDictIteratorResult;
 
-    case INST_DICT_NEXT:
+    TARGET(INST_DICT_NEXT):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	TRACE(("%u => ", opnd));
 	statePtr = (*LOCAL(opnd)).value.objPtr;
@@ -6916,7 +7587,7 @@ TEBCresume(
 
 	JUMP_PEEPHOLE_F(done, 5, 0);
 
-    case INST_DICT_UPDATE_START:
+    TARGET(INST_DICT_UPDATE_START):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	opnd2 = TclGetUInt4AtPtr(pc+5);
 	TRACE(("%u => ", opnd));
@@ -6976,7 +7647,7 @@ TEBCresume(
 	TRACE_APPEND(("OK\n"));
 	NEXT_INST_F(9, 0, 0);
 
-    case INST_DICT_UPDATE_END:
+    TARGET(INST_DICT_UPDATE_END):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	opnd2 = TclGetUInt4AtPtr(pc+5);
 	TRACE(("%u => ", opnd));
@@ -7053,7 +7724,7 @@ TEBCresume(
 	TRACE_APPEND(("written back\n"));
 	NEXT_INST_F(9, 1, 0);
 
-    case INST_DICT_EXPAND:
+    TARGET(INST_DICT_EXPAND):
 	dictPtr = OBJ_UNDER_TOS;
 	listPtr = OBJ_AT_TOS;
 	TRACE(("\"%.30s\" \"%.30s\" =>", O2S(dictPtr), O2S(listPtr)));
@@ -7069,7 +7740,7 @@ TEBCresume(
 	TRACE_APPEND(("\"%.30s\"\n", O2S(objResultPtr)));
 	NEXT_INST_F(1, 2, 1);
 
-    case INST_DICT_RECOMBINE_STK:
+    TARGET(INST_DICT_RECOMBINE_STK):
 	keysPtr = POP_OBJECT();
 	varNamePtr = OBJ_UNDER_TOS;
 	listPtr = OBJ_AT_TOS;
@@ -7099,7 +7770,7 @@ TEBCresume(
 	TRACE_APPEND(("OK\n"));
 	NEXT_INST_F(1, 2, 0);
 
-    case INST_DICT_RECOMBINE_IMM:
+    TARGET(INST_DICT_RECOMBINE_IMM):
 	opnd = TclGetUInt4AtPtr(pc+1);
 	listPtr = OBJ_UNDER_TOS;
 	keysPtr = OBJ_AT_TOS;
@@ -7131,7 +7802,7 @@ TEBCresume(
      * -----------------------------------------------------------------
      */
 
-    case INST_CLOCK_READ:
+    TARGET(INST_CLOCK_READ):
 	{			/* Read the wall clock */
 	    Tcl_WideInt wval;
 	    Tcl_Time now;
@@ -102,6 +102,9 @@ typedef struct CopyState {
     Tcl_WideInt total;		/* Total bytes transferred (written). */
     Tcl_Interp *interp;		/* Interp that started the copy. */
     Tcl_Obj *cmdPtr;		/* Command to be invoked at completion. */
+    TclDirectCopy *directPtr;	/* State of the OS-level copy done by
+				 * MBDirect, or NULL. */
+    int directMask;		/* Event MBDirectEvent is waiting for. */
     int bufSize;		/* Size of appended buffer. */
     char buffer[TCLFLEXARRAY];		/* Copy buffer, this must be the last
                                  * field. */
@@ -179,6 +182,9 @@ static void		MBError(CopyState *csPtr, int mask, int errorCode);
 static int		MBRead(CopyState *csPtr);
 static int		MBWrite(CopyState *csPtr);
 static void		MBEvent(ClientData clientData, int mask);
+static int		MBDirect(CopyState *csPtr, int *maskPtr);
+static void		MBDirectEvent(ClientData clientData, int mask);
+static int		CloseDirectCopy(CopyState *csPtr);
 
 static void		CopyEventProc(ClientData clientData, int mask);
 static void		CreateScriptRecord(Tcl_Interp *interp,
@@ -221,6 +227,7 @@ static void		TranslateInputEOL(ChannelState *statePtr, char *dst,
 static void		UpdateInterest(Channel *chanPtr);
 static int		Write(Channel *chanPtr, const char *src,
 			    int srcLen, Tcl_Encoding encoding);
+static size_t		WriteRope(Channel *chanPtr, Tcl_Obj *objPtr);
 static Tcl_Obj *	FixLevelCode(Tcl_Obj *msg);
 static void		SpliceChannel(Tcl_Channel chan);
 static void		CutChannel(Tcl_Channel chan);
@@ -356,11 +363,19 @@ static const Tcl_ObjType chanObjType = {
       (((st)->csPtrW) && ((fl) & TCL_WRITABLE)))
 
 #define MAX_CHANNEL_BUFFER_SIZE (1024*1024)
+
+/*
+ * Most queued output buffers FlushChannel hands to a driver outputVProc in
+ * one call.
+ */
+
+#define MAX_FLUSH_VECS 64
 
 /*
  *---------------------------------------------------------------------------
  *
- * ChanClose, ChanRead, ChanSeek, ChanThreadAction, ChanWatch, ChanWrite --
+ * ChanClose, ChanRead, ChanSeek, ChanThreadAction, ChanWatch, ChanWrite,
+ * ChanWriteV --
  *
  *	Simplify the access to selected channel driver "methods" that are used
  *	in multiple places in a stereotypical fashion. These are just thin
@@ -517,6 +532,17 @@ ChanWrite(
     return chanPtr->typePtr->outputProc(chanPtr->instanceData, src, srcLen,
 	    errnoPtr);
 }
+
+static inline int
+ChanWriteV(
+    Channel *chanPtr,
+    const Tcl_ChannelOutputVec *vecs,
+    int numVecs,
+    int *errnoPtr)
+{
+    return Tcl_ChannelOutputVProc(chanPtr->typePtr)(chanPtr->instanceData,
+	    vecs, numVecs, errnoPtr);
+}
 
 /*
  *---------------------------------------------------------------------------
@@ -1606,8 +1632,9 @@ Tcl_CreateChannel(
 
     assert(sizeof(Tcl_ChannelTypeVersion) == sizeof(Tcl_DriverBlockModeProc *));
     assert(typePtr->typeName != NULL);
-    if (Tcl_ChannelVersion(typePtr) != TCL_CHANNEL_VERSION_5) {
-	Tcl_Panic("channel type %s must be version TCL_CHANNEL_VERSION_5", typePtr->typeName);
+    if (Tcl_ChannelVersion(typePtr) != TCL_CHANNEL_VERSION_5
+	    && Tcl_ChannelVersion(typePtr) != TCL_CHANNEL_VERSION_6) {
+	Tcl_Panic("channel type %s must be version TCL_CHANNEL_VERSION_5 or TCL_CHANNEL_VERSION_6", typePtr->typeName);
     }
     if (typePtr->close2Proc == NULL) {
 	Tcl_Panic("channel type %s must define close2Proc", typePtr->typeName);
@@ -2684,6 +2711,15 @@ FlushChannel(
 				 * driver operations. */
     int wroteSome = 0;		/* Set to one if any data was written to the
 				 * driver. */
+    Tcl_DriverOutputVProc *outputVProc;
+				/* Scatter/gather output proc of the driver,
+				 * if it has one. */
+    ChannelBuffer *bufs[MAX_FLUSH_VECS];
+				/* Queued buffers handed to the driver in the
+				 * current round. */
+    Tcl_ChannelOutputVec vecs[MAX_FLUSH_VECS];
+				/* The bytes left in each of them. */
+    int numBufs, i;
 
     int bufExists;
     /*
@@ -2747,16 +2783,34 @@ FlushChannel(
      */
 
     TclChannelPreserve((Tcl_Channel)chanPtr);
+    outputVProc = Tcl_ChannelOutputVProc(chanPtr->typePtr);
     while (statePtr->outQueueHead) {
 	bufPtr = statePtr->outQueueHead;
 
 	/*
-	 * Produce the output on the channel.
+	 * Produce the output on the channel. A driver that can write several
+	 * runs of bytes at once gets as much of the queue as fits in one
+	 * call, so that a flush is a single system call instead of one per
+	 * buffer.
 	 */
 
-	PreserveChannelBuffer(bufPtr);
-	written = ChanWrite(chanPtr, RemovePoint(bufPtr), BytesLeft(bufPtr),
-		&errorCode);
+	numBufs = 0;
+	do {
+	    PreserveChannelBuffer(bufPtr);
+	    bufs[numBufs] = bufPtr;
+	    vecs[numBufs].buf = RemovePoint(bufPtr);
+	    vecs[numBufs].toWrite = BytesLeft(bufPtr);
+	    numBufs++;
+	    bufPtr = bufPtr->nextPtr;
+	} while (outputVProc && bufPtr && numBufs < MAX_FLUSH_VECS);
+	bufPtr = bufs[0];
+
+	if (numBufs > 1) {
+	    written = ChanWriteV(chanPtr, vecs, numBufs, &errorCode);
+	} else {
+	    written = ChanWrite(chanPtr, RemovePoint(bufPtr),
+		    BytesLeft(bufPtr), &errorCode);
+	}
 
 	/*
 	 * If the write failed completely attempt to start the asynchronous
@@ -2765,6 +2819,10 @@ FlushChannel(
 	 */
 
 	if (written < 0) {
+	    for (i = 1; i < numBufs; i++) {
+		ReleaseChannelBuffer(bufs[i]);
+	    }
+
 	    /*
 	     * If the last attempt to write was interrupted, simply retry.
 	     */
@@ -2866,29 +2924,42 @@ FlushChannel(
 	    wroteSome = 1;
 	}
 
-	bufExists = bufPtr->refCount > 1;
-	ReleaseChannelBuffer(bufPtr);
-	if (bufExists) {
-	    /* There is still a reference to this buffer other than the one
-	     * this routine just released, meaning that final cleanup of the
-	     * buffer hasn't been ordered by, e.g. by a reflected channel
-	     * closing the channel from within one of its handler scripts (not
-	     * something one would expecte, but it must be considered).  Normal
-	     * operations on the buffer can proceed.
-	     */
+	bufExists = 1;
+	for (i = 0; i < numBufs; i++) {
+	    if (bufs[i]->refCount <= 1) {
+		bufExists = 0;
+	    }
+	}
+	for (i = 0; i < numBufs; i++) {
+	    bufPtr = bufs[i];
+	    ReleaseChannelBuffer(bufPtr);
+	    if (bufExists) {
+		/* There is still a reference to this buffer other than the one
+		 * this routine just released, meaning that final cleanup of the
+		 * buffer hasn't been ordered by, e.g. by a reflected channel
+		 * closing the channel from within one of its handler scripts (not
+		 * something one would expecte, but it must be considered).  Normal
+		 * operations on the buffer can proceed.
+		 */
 
-	    bufPtr->nextRemoved += written;
+		int consumed = ((size_t) written < BytesLeft(bufPtr))
+			? written : (int) BytesLeft(bufPtr);
 
-	    /*
-	     * If this buffer is now empty, recycle it.
-	     */
+		bufPtr->nextRemoved += consumed;
+		written -= consumed;
 
-	    if (IsBufferEmpty(bufPtr)) {
-		statePtr->outQueueHead = bufPtr->nextPtr;
-		if (statePtr->outQueueHead == NULL) {
-		    statePtr->outQueueTail = NULL;
+		/*
+		 * If this buffer is now empty, recycle it. Buffers are emptied
+		 * in queue order, so it is the head of the queue.
+		 */
+
+		if (IsBufferEmpty(bufPtr)) {
+		    statePtr->outQueueHead = bufPtr->nextPtr;
+		    if (statePtr->outQueueHead == NULL) {
+			statePtr->outQueueTail = NULL;
+		    }
+		    RecycleBuffer(statePtr, bufPtr, 0);
 		}
-		RecycleBuffer(statePtr, bufPtr, 0);
 	    }
 	}
 
@@ -4207,6 +4278,9 @@ Tcl_WriteObj(
     if (CheckChannelErrors(statePtr, TCL_WRITABLE) != 0) {
 	return TCL_IO_FAILURE;
     }
+    if (TclHasInternalRep(objPtr, &tclRopeType)) {
+	return WriteRope(chanPtr, objPtr);
+    }
     if (statePtr->encoding == NULL) {
 	int result;
 	Tcl_Obj *copy = TclNarrowToBytes(objPtr);
@@ -4221,6 +4295,65 @@ Tcl_WriteObj(
     }
 }
 
+/*
+ *---------------------------------------------------------------------------
+ *
+ * WriteRope --
+ *
+ *	Helper for Tcl_WriteObj. Writes a rope piece by piece, so that it
+ *	need not be flattened into one buffer first.
+ *
+ * Results:
+ *	The number of bytes written or -1 in case of error.
+ *
+ * Side effects:
+ *	Same as Tcl_WriteObj.
+ *
+ *---------------------------------------------------------------------------
+ */
+
+static size_t
+WriteRope(
+    Channel *chanPtr,		/* The channel to buffer output for. */
+    Tcl_Obj *objPtr)		/* The rope to write. */
+{
+    ChannelState *statePtr = chanPtr->state;
+    Tcl_Obj *copyPtr, *const *pieces;
+    size_t i, numPieces = 0, total = 0;
+
+    /*
+     * Write from a private copy of the rope. Channel handlers may run
+     * scripts that change or flatten objPtr; the copy and its pieces stay
+     * put.
+     */
+
+    copyPtr = Tcl_DuplicateObj(objPtr);
+    Tcl_IncrRefCount(copyPtr);
+    pieces = TclGetRopePieces(copyPtr, &numPieces);
+    for (i = 0; i < numPieces; i++) {
+	int written;
+
+	if (statePtr->encoding == NULL) {
+	    Tcl_Obj *bytesPtr = TclNarrowToBytes(pieces[i]);
+	    size_t srcLen = 0;
+	    const char *src = (char *) Tcl_GetByteArrayFromObj(bytesPtr,
+		    &srcLen);
+
+	    written = WriteBytes(chanPtr, src, srcLen);
+	    Tcl_DecrRefCount(bytesPtr);
+	} else {
+	    written = WriteChars(chanPtr, pieces[i]->bytes, pieces[i]->length);
+	}
+	if (written == -1) {
+	    total = TCL_IO_FAILURE;
+	    break;
+	}
+	total += written;
+    }
+    Tcl_DecrRefCount(copyPtr);
+    return total;
+}
+
 static void
 WillWrite(
     Channel *chanPtr)
@@ -9215,6 +9348,8 @@ TclCopyChannel(
     csPtr->writeFlags = writeFlags;
     csPtr->toRead = toRead;
     csPtr->total = (Tcl_WideInt) 0;
+    csPtr->directPtr = NULL;
+    csPtr->directMask = 0;
     csPtr->interp = interp;
     if (cmdPtr) {
 	Tcl_IncrRefCount(cmdPtr);
@@ -9447,10 +9582,217 @@ MBWrite(
     return TCL_CONTINUE;
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * CloseDirectCopy --
+ *
+ *	Ends the copy by the OS of a MoveBytes copy. Bytes the OS has already
+ *	taken from the input but not written yet (see TclpDirectCopyPending)
+ *	are put back at the head of the input queue: the buffered copy writes
+ *	them out first if it takes over, and they stay readable from the
+ *	input channel if the copy is stopped.
+ *
+ * Results:
+ *	0, or a POSIX error code if the pending bytes could not be recovered.
+ *
+ * Side effects:
+ *	Frees csPtr->directPtr and sets it to NULL.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+CloseDirectCopy(
+    CopyState *csPtr)		/* State of copy operation. */
+{
+    ChannelState *inStatePtr = csPtr->readPtr->state;
+    size_t pending = TclpDirectCopyPending(csPtr->directPtr);
+    int errorCode = 0;
+
+    if (pending > 0) {
+	ChannelBuffer *bufPtr = AllocChannelBuffer((int) pending);
+
+	errorCode = TclpReadDirectCopyPending(csPtr->directPtr,
+		InsertPoint(bufPtr));
+	if (errorCode == 0) {
+	    bufPtr->nextAdded += (int) pending;
+	    bufPtr->nextPtr = inStatePtr->inQueueHead;
+	    inStatePtr->inQueueHead = bufPtr;
+	    if (inStatePtr->inQueueTail == NULL) {
+		inStatePtr->inQueueTail = bufPtr;
+	    }
+	} else {
+	    ReleaseChannelBuffer(bufPtr);
+	}
+    }
+    TclpCloseDirectCopy(csPtr->directPtr);
+    csPtr->directPtr = NULL;
+    return errorCode;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * MBDirect --
+ *
+ *	Performs one step of a MoveBytes copy by letting the OS move the bytes
+ *	from the input to the output channel (TclpDirectCopy), so they never
+ *	pass through the channel buffers. Bytes buffered in the channels
+ *	before the copy started are moved through the buffers first.
+ *
+ * Results:
+ *	TCL_OK when the copy is complete, TCL_ERROR if it failed (MBError has
+ *	been called), TCL_CONTINUE otherwise. In the latter case *maskPtr is
+ *	set to the channel event to wait for before the next step, or to 0.
+ *	If the OS cannot do the copy after all, csPtr->directPtr is reset to
+ *	NULL and the copy has to continue with MBRead and MBWrite.
+ *
+ * Side effects:
+ *	Moves data between the channels.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+MBDirect(
+    CopyState *csPtr,		/* State of copy operation. */
+    int *maskPtr)		/* Where to store the event to wait for. */
+{
+    ChannelState *inStatePtr = csPtr->readPtr->state;
+    ChannelState *outStatePtr = csPtr->writePtr->state;
+    Tcl_WideInt copied;
+    int code;
+
+    *maskPtr = 0;
+    if (csPtr->toRead == 0) {
+	return TCL_OK;
+    }
+    if (outStatePtr->outQueueHead) {
+	*maskPtr = TCL_WRITABLE;	/* Background flush in progress. */
+	return TCL_CONTINUE;
+    }
+    if (inStatePtr->inQueueHead || csPtr->readPtr->inQueueHead) {
+	if (MBRead(csPtr) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	code = MBWrite(csPtr);
+	if (code == TCL_CONTINUE && outStatePtr->outQueueHead) {
+	    *maskPtr = TCL_WRITABLE;
+	}
+	return code;
+    }
+
+    /*
+     * Same bookkeeping as ChanRead() and WillWrite() do for buffered I/O.
+     */
+
+    if (WillRead(csPtr->readPtr) == -1) {
+	MBError(csPtr, TCL_READABLE, Tcl_GetErrno());
+	return TCL_ERROR;
+    }
+    WillWrite(csPtr->writePtr);
+    if (GotFlag(inStatePtr, CHANNEL_EOF)) {
+	inStatePtr->inputEncodingFlags |= TCL_ENCODING_START;
+    }
+    ResetFlag(inStatePtr, CHANNEL_BLOCKED | CHANNEL_EOF);
+    inStatePtr->inputEncodingFlags &= ~TCL_ENCODING_END;
+
+    code = TclpDirectCopy(csPtr->directPtr, csPtr->toRead, &copied);
+    if (csPtr->toRead != -1) {
+	csPtr->toRead -= copied;
+    }
+    csPtr->total += copied;
+
+    switch (code) {
+    case TCL_DIRECT_EOF:
+	SetFlag(inStatePtr, CHANNEL_EOF);
+	inStatePtr->inputEncodingFlags |= TCL_ENCODING_END;
+	return TCL_OK;
+    case TCL_DIRECT_READ_BLOCKED:
+	SetFlag(inStatePtr, CHANNEL_BLOCKED);
+	*maskPtr = TCL_READABLE;
+	break;
+    case TCL_DIRECT_WRITE_BLOCKED:
+	*maskPtr = TCL_WRITABLE;
+	break;
+    case TCL_DIRECT_READ_ERROR:
+	MBError(csPtr, TCL_READABLE, Tcl_GetErrno());
+	return TCL_ERROR;
+    case TCL_DIRECT_WRITE_ERROR:
+	MBError(csPtr, TCL_WRITABLE, Tcl_GetErrno());
+	return TCL_ERROR;
+    case TCL_DIRECT_UNSUPPORTED:
+	TclpCloseDirectCopy(csPtr->directPtr);
+	csPtr->directPtr = NULL;
+	break;
+    }
+    return (csPtr->toRead == 0) ? TCL_OK : TCL_CONTINUE;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * MBDirectEvent --
+ *
+ *	Channel handler driving a background MoveBytes copy done by MBDirect.
+ *	Like MBEvent, it does one step per event, waiting for the input to
+ *	become readable or the output to become writable as needed.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	Moves data between the channels, may invoke the -command callback or
+ *	hand the copy over to MBEvent.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+MBDirectEvent(
+    ClientData clientData,
+    TCL_UNUSED(int) /*mask*/)
+{
+    CopyState *csPtr = (CopyState *) clientData;
+    Tcl_Channel inChan = (Tcl_Channel) csPtr->readPtr;
+    Tcl_Channel outChan = (Tcl_Channel) csPtr->writePtr;
+    int code, mask;
+
+    code = MBDirect(csPtr, &mask);
+    if (code == TCL_OK) {
+	MBCallback(csPtr, NULL);
+	return;
+    }
+    if (code == TCL_ERROR) {
+	return;
+    }
+    if (csPtr->directPtr == NULL) {
+	Tcl_DeleteChannelHandler(inChan, MBDirectEvent, csPtr);
+	Tcl_DeleteChannelHandler(outChan, MBDirectEvent, csPtr);
+	Tcl_CreateChannelHandler(inChan, TCL_READABLE, MBEvent, csPtr);
+	return;
+    }
+
+    /*
+     * Without a reason to wait for something else, stay with the current
+     * handler; the notifier calls it again as long as its channel is ready.
+     */
+
+    if (mask != 0 && mask != csPtr->directMask) {
+	Tcl_DeleteChannelHandler((csPtr->directMask == TCL_READABLE)
+		? inChan : outChan, MBDirectEvent, csPtr);
+	Tcl_CreateChannelHandler((mask == TCL_READABLE) ? inChan : outChan,
+		mask, MBDirectEvent, csPtr);
+	csPtr->directMask = mask;
+    }
+}
+
 static int
 MoveBytes(
     CopyState *csPtr)		/* State of copy operation. */
 {
+    ChannelState *inStatePtr = csPtr->readPtr->state;
     ChannelState *outStatePtr = csPtr->writePtr->state;
     ChannelBuffer *bufPtr = outStatePtr->curOutPtr;
     int errorCode;
@@ -9466,12 +9808,57 @@ MoveBytes(
 	}
     }
 
+    /*
+     * Between unstacked channels, the OS may be able to move the bytes
+     * without copying them through user space.
+     */
+
+    if (inStatePtr->topChanPtr == inStatePtr->bottomChanPtr
+	    && outStatePtr->topChanPtr == outStatePtr->bottomChanPtr) {
+	csPtr->directPtr = TclpOpenDirectCopy((Tcl_Channel) csPtr->readPtr,
+		(Tcl_Channel) csPtr->writePtr);
+    }
+
     if (csPtr->cmdPtr) {
 	Tcl_Channel inChan = (Tcl_Channel) csPtr->readPtr;
-	Tcl_CreateChannelHandler(inChan, TCL_READABLE, MBEvent, csPtr);
+
+	if (csPtr->directPtr) {
+	    csPtr->directMask = TCL_READABLE;
+	    Tcl_CreateChannelHandler(inChan, TCL_READABLE, MBDirectEvent,
+		    csPtr);
+	} else {
+	    Tcl_CreateChannelHandler(inChan, TCL_READABLE, MBEvent, csPtr);
+	}
 	return TCL_OK;
     }
 
+    while (csPtr->directPtr) {
+	int code, mask;
+
+	code = MBDirect(csPtr, &mask);
+	if (code == TCL_OK) {
+	    Tcl_SetObjResult(csPtr->interp, Tcl_NewWideIntObj(csPtr->total));
+	    StopCopy(csPtr);
+	    return TCL_OK;
+	}
+	if (code == TCL_ERROR) {
+	    return TCL_ERROR;
+	}
+	if (mask && csPtr->directPtr) {
+	    /*
+	     * Blocking channels should not report to be blocked (think of a
+	     * receive or send timeout); leave such cases to the buffered copy,
+	     * which starts with the bytes the OS has taken from the input.
+	     */
+
+	    errorCode = CloseDirectCopy(csPtr);
+	    if (errorCode != 0) {
+		MBError(csPtr, TCL_WRITABLE, errorCode);
+		return TCL_ERROR;
+	    }
+	}
+    }
+
     while (1) {
 	int code;
 
@@ -10129,8 +10516,18 @@ StopCopy(
 	}
 	Tcl_DeleteChannelHandler(inChan, MBEvent, csPtr);
 	Tcl_DeleteChannelHandler(outChan, MBEvent, csPtr);
+	Tcl_DeleteChannelHandler(inChan, MBDirectEvent, csPtr);
+	Tcl_DeleteChannelHandler(outChan, MBDirectEvent, csPtr);
 	TclDecrRefCount(csPtr->cmdPtr);
     }
+    if (csPtr->directPtr) {
+	/*
+	 * There is no one left to report a failure to; the bytes in transit
+	 * are lost then, as they would be in a failed write.
+	 */
+
+	(void) CloseDirectCopy(csPtr);
+    }
     inStatePtr->csPtrR = NULL;
     outStatePtr->csPtrW = NULL;
     Tcl_Free(csPtr);
@@ -11137,6 +11534,34 @@ Tcl_ChannelTruncateProc(
 {
     return chanTypePtr->truncateProc;
 }
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * Tcl_ChannelOutputVProc --
+ *
+ *	Return the Tcl_DriverOutputVProc of the channel type, or NULL for
+ *	channel types older than TCL_CHANNEL_VERSION_6, which lack the field.
+ *
+ * Results:
+ *	A pointer to the proc.
+ *
+ * Side effects:
+ *	None.
+ *
+ *----------------------------------------------------------------------
+ */
+
+Tcl_DriverOutputVProc *
+Tcl_ChannelOutputVProc(
+    const Tcl_ChannelType *chanTypePtr)
+				/* Pointer to channel type. */
+{
+    if (Tcl_ChannelVersion(chanTypePtr) != TCL_CHANNEL_VERSION_6) {
+	return NULL;
+    }
+    return chanTypePtr->outputVProc;
+}
 
 /*
  *----------------------------------------------------------------------
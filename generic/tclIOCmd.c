@@ -20,6 +20,60 @@ typedef struct {
     Tcl_Interp *interp;		/* Interpreter in which to run it. */
 } AcceptCallback;
 
+/*
+ * Structures describing the threads started by [socket -server -threads],
+ * each of which listens on the port of the server socket with a socket of
+ * its own and accepts connections in an interpreter of its own. The threads
+ * run until the server socket they were started for is closed. Closing it
+ * only tells them to stop: they are not joined, and the last one of the
+ * server socket and its threads to let go of the AcceptThreads frees it.
+ * The fields that change while the threads run are guarded by
+ * acceptThreadMutex.
+ */
+
+typedef struct AcceptThread {
+    Tcl_ThreadId id;		/* The thread. */
+    int state;			/* One of the ACCEPT_THREAD_* values below. */
+    char *errorMsg;		/* If the thread failed to start, why, else
+				 * NULL. */
+    struct AcceptThread *nextPtr;
+				/* Next thread of the same server socket. */
+} AcceptThread;
+
+enum AcceptThreadStates {
+    ACCEPT_THREAD_STARTING,	/* Setting up its interpreter and socket. */
+    ACCEPT_THREAD_RUNNING,	/* Accepting connections. */
+    ACCEPT_THREAD_FAILED	/* Failed to start; it has ended or is about
+				 * to. */
+};
+
+typedef struct {
+    char *command;		/* The accept callback. */
+    char *initScript;		/* Script run in each thread before it starts
+				 * listening, or NULL. */
+    char *host;			/* Address to listen on, or NULL for all. */
+    char *port;			/* The port of the server socket. */
+    unsigned flags;		/* Flags for Tcl_OpenTcpServerEx. */
+    int stop;			/* Set when the threads are to stop. */
+    size_t refCount;		/* One for the server socket and one for each
+				 * thread that has not ended yet. */
+    Tcl_Condition started;	/* Notified when a thread has started, or
+				 * failed to. */
+    AcceptThread *firstPtr;	/* The threads. */
+} AcceptThreads;
+
+TCL_DECLARE_MUTEX(acceptThreadMutex)
+
+/*
+ * The number of accepting threads of all server sockets that have not ended
+ * yet, and a condition notified when it drops to 0. Tcl_Finalize waits for
+ * it, see FinalizeAcceptThreads.
+ */
+
+static size_t numAcceptThreads = 0;
+static Tcl_Condition acceptThreadsEnded;
+static int acceptThreadsExitHandler = 0;
+
 /*
  * Thread local storage used to maintain a per-thread stdout channel obj.
  * It must be per-thread because of std channel limitations.
@@ -38,6 +92,10 @@ static Tcl_ThreadDataKey dataKey;
 
 static Tcl_ExitProc		FinalizeIOCmdTSD;
 static Tcl_TcpAcceptProc 	AcceptCallbackProc;
+static Tcl_ThreadCreateType	AcceptThreadProc(void *clientData);
+static Tcl_CloseProc		AcceptThreadsCloseProc;
+static Tcl_EventProc		AcceptThreadWakeProc;
+static Tcl_ExitProc		FinalizeAcceptThreads;
 static Tcl_ObjCmdProc		ChanPendingObjCmd;
 static Tcl_ObjCmdProc		ChanTruncateObjCmd;
 static void			RegisterTcpServerInterpCleanup(
@@ -48,6 +106,13 @@ static void		TcpServerCloseProc(ClientData callbackData);
 static void		UnregisterTcpServerInterpCleanupProc(
 			    Tcl_Interp *interp,
 			    AcceptCallback *acceptCallbackPtr);
+static char *		CopyString(const char *string);
+static int		StartAcceptThreads(Tcl_Interp *interp,
+			    Tcl_Channel chan, Tcl_Obj *script,
+			    Tcl_Obj *initScript, const char *host,
+			    unsigned flags, int count);
+static void		StopAcceptThreads(AcceptThreads *threadsPtr);
+static void		ReleaseAcceptThreads(AcceptThreads *threadsPtr);
 
 /*
  *----------------------------------------------------------------------
@@ -1414,6 +1479,397 @@ TcpServerCloseProc(
     Tcl_DecrRefCount(acceptCallbackPtr->script);
     Tcl_Free(acceptCallbackPtr);
 }
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * StartAcceptThreads --
+ *
+ *	Starts the threads that accept connections on the port of a new
+ *	server socket for [socket -server -threads], and arranges for them to
+ *	be stopped when the server socket is closed.
+ *
+ * Results:
+ *	A standard Tcl result. If any thread fails to start, the others are
+ *	stopped and an error message is left in the interpreter.
+ *
+ * Side effects:
+ *	Creates threads, each with an interpreter and a server socket.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+StartAcceptThreads(
+    Tcl_Interp *interp,		/* For error reporting. */
+    Tcl_Channel chan,		/* The server socket. */
+    Tcl_Obj *script,		/* The accept callback. */
+    Tcl_Obj *initScript,	/* Script to prepare the interpreter of each
+				 * thread, or NULL. */
+    const char *host,		/* Address to listen on, or NULL. */
+    unsigned flags,		/* Flags for Tcl_OpenTcpServerEx. */
+    int count)			/* The number of threads to start. */
+{
+    AcceptThreads *threadsPtr;
+    AcceptThread *threadPtr;
+    Tcl_DString ds;
+    int numElements;
+    const char **elements;
+    int i;
+
+    /*
+     * The server socket may have been opened on port 0, in which case the
+     * system chose the port that the threads must listen on too.
+     */
+
+    Tcl_DStringInit(&ds);
+    if (Tcl_GetChannelOption(interp, chan, "-sockname", &ds) != TCL_OK
+	    || Tcl_SplitList(interp, Tcl_DStringValue(&ds), &numElements,
+		    &elements) != TCL_OK) {
+	Tcl_DStringFree(&ds);
+	return TCL_ERROR;
+    }
+    Tcl_DStringFree(&ds);
+    if (numElements < 3) {
+	Tcl_Free((void *)elements);
+	Tcl_SetObjResult(interp, Tcl_NewStringObj(
+		"couldn't get the port of the server socket", -1));
+	return TCL_ERROR;
+    }
+
+    threadsPtr = (AcceptThreads *)Tcl_Alloc(sizeof(AcceptThreads));
+    threadsPtr->command = CopyString(TclGetString(script));
+    threadsPtr->initScript = initScript ?
+	    CopyString(TclGetString(initScript)) : NULL;
+    threadsPtr->host = host ? CopyString(host) : NULL;
+    threadsPtr->port = CopyString(elements[2]);
+    threadsPtr->flags = flags;
+    threadsPtr->stop = 0;
+    threadsPtr->refCount = 1;
+    threadsPtr->started = NULL;
+    threadsPtr->firstPtr = NULL;
+    Tcl_Free((void *)elements);
+
+    /*
+     * Start the threads one at a time, so that an error in the first one
+     * is reported before the others are started.
+     */
+
+    for (i = 0; i < count; i++) {
+	threadPtr = (AcceptThread *)Tcl_Alloc(sizeof(AcceptThread));
+	threadPtr->state = ACCEPT_THREAD_STARTING;
+	threadPtr->errorMsg = NULL;
+
+	Tcl_MutexLock(&acceptThreadMutex);
+	if (!acceptThreadsExitHandler) {
+	    TclCreateLateExitHandler(FinalizeAcceptThreads, NULL);
+	    acceptThreadsExitHandler = 1;
+	}
+	threadPtr->nextPtr = threadsPtr->firstPtr;
+	threadsPtr->firstPtr = threadPtr;
+	threadsPtr->refCount++;
+	numAcceptThreads++;
+	if (Tcl_CreateThread(&threadPtr->id, AcceptThreadProc, threadsPtr,
+		TCL_THREAD_STACK_DEFAULT, TCL_THREAD_NOFLAGS) != TCL_OK) {
+	    threadsPtr->firstPtr = threadPtr->nextPtr;
+	    threadsPtr->refCount--;
+	    numAcceptThreads--;
+	    Tcl_MutexUnlock(&acceptThreadMutex);
+	    Tcl_Free(threadPtr);
+	    Tcl_SetObjResult(interp, Tcl_NewStringObj(
+		    "can't create a new thread", -1));
+	    goto error;
+	}
+	while (threadPtr->state == ACCEPT_THREAD_STARTING) {
+	    Tcl_ConditionWait(&threadsPtr->started, &acceptThreadMutex, NULL);
+	}
+	Tcl_MutexUnlock(&acceptThreadMutex);
+
+	if (threadPtr->state == ACCEPT_THREAD_FAILED) {
+	    Tcl_SetObjResult(interp, Tcl_ObjPrintf(
+		    "couldn't start accepting thread: %s",
+		    threadPtr->errorMsg));
+	    goto error;
+	}
+    }
+
+    Tcl_CreateCloseHandler(chan, AcceptThreadsCloseProc, threadsPtr);
+    return TCL_OK;
+
+  error:
+    StopAcceptThreads(threadsPtr);
+    return TCL_ERROR;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * AcceptThreadProc --
+ *
+ *	The body of a thread started by StartAcceptThreads. It creates an
+ *	interpreter, runs the -threadinit script in it, opens a server socket
+ *	on the port of the original one and services events until told to
+ *	stop.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	Whatever the scripts do. May free the AcceptThreads structure.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static Tcl_ThreadCreateType
+AcceptThreadProc(
+    void *clientData)		/* The AcceptThreads structure. */
+{
+    AcceptThreads *threadsPtr = (AcceptThreads *)clientData;
+    AcceptThread *threadPtr;
+    Tcl_Interp *interp = Tcl_CreateInterp();
+    Tcl_Channel chan = NULL;
+    int code, stop;
+
+    code = Tcl_Init(interp);
+    if (code == TCL_OK && threadsPtr->initScript != NULL) {
+	code = Tcl_EvalEx(interp, threadsPtr->initScript, TCL_INDEX_NONE,
+		TCL_EVAL_GLOBAL);
+    }
+    if (code == TCL_OK) {
+	AcceptCallback *acceptCallbackPtr = (AcceptCallback *)
+		Tcl_Alloc(sizeof(AcceptCallback));
+
+	acceptCallbackPtr->script = Tcl_NewStringObj(threadsPtr->command, -1);
+	Tcl_IncrRefCount(acceptCallbackPtr->script);
+	acceptCallbackPtr->interp = interp;
+	chan = Tcl_OpenTcpServerEx(interp, threadsPtr->port, threadsPtr->host,
+		threadsPtr->flags, AcceptCallbackProc, acceptCallbackPtr);
+	if (chan == NULL) {
+	    Tcl_DecrRefCount(acceptCallbackPtr->script);
+	    Tcl_Free(acceptCallbackPtr);
+	    code = TCL_ERROR;
+	} else {
+	    RegisterTcpServerInterpCleanup(interp, acceptCallbackPtr);
+	    Tcl_CreateCloseHandler(chan, TcpServerCloseProc,
+		    acceptCallbackPtr);
+	    Tcl_RegisterChannel(interp, chan);
+	}
+    }
+
+    /*
+     * The thread that started this one is waiting to hear how it went. It
+     * starts one thread at a time, so this one is the first in the list.
+     */
+
+    Tcl_MutexLock(&acceptThreadMutex);
+    threadPtr = threadsPtr->firstPtr;
+    if (code == TCL_OK) {
+	threadPtr->state = ACCEPT_THREAD_RUNNING;
+    } else {
+	threadPtr->state = ACCEPT_THREAD_FAILED;
+	threadPtr->errorMsg = CopyString(Tcl_GetStringResult(interp));
+    }
+    Tcl_ConditionNotify(&threadsPtr->started);
+    stop = (code != TCL_OK) || threadsPtr->stop;
+    Tcl_MutexUnlock(&acceptThreadMutex);
+
+    while (!stop) {
+	Tcl_DoOneEvent(TCL_ALL_EVENTS);
+	Tcl_MutexLock(&acceptThreadMutex);
+	stop = threadsPtr->stop;
+	Tcl_MutexUnlock(&acceptThreadMutex);
+    }
+
+    /*
+     * Deleting the interpreter closes the server socket and any connection
+     * the scripts left open. Tell FinalizeAcceptThreads only once this
+     * thread is done with Tcl.
+     */
+
+    Tcl_DeleteInterp(interp);
+    Tcl_MutexLock(&acceptThreadMutex);
+    ReleaseAcceptThreads(threadsPtr);
+    Tcl_MutexUnlock(&acceptThreadMutex);
+    Tcl_FinalizeThread();
+
+    Tcl_MutexLock(&acceptThreadMutex);
+    if (--numAcceptThreads == 0) {
+	Tcl_ConditionNotify(&acceptThreadsEnded);
+    }
+    Tcl_MutexUnlock(&acceptThreadMutex);
+    TCL_THREAD_CREATE_RETURN;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * AcceptThreadWakeProc --
+ *
+ *	Event queued to an accepting thread to make it notice that it is to
+ *	stop.
+ *
+ * Results:
+ *	Always 1, the event is done.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+AcceptThreadWakeProc(
+    TCL_UNUSED(Tcl_Event *),
+    TCL_UNUSED(int) /*flags*/)
+{
+    return 1;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * AcceptThreadsCloseProc, StopAcceptThreads --
+ *
+ *	Tell the threads started for a server socket to stop, when it is
+ *	closed or when one of them failed to start. This does not wait for
+ *	them: a thread may be running a script, and the server socket may be
+ *	closed while its interpreter is being deleted.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	Drops the reference of the server socket to the AcceptThreads
+ *	structure.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+AcceptThreadsCloseProc(
+    void *clientData)		/* The AcceptThreads structure. */
+{
+    StopAcceptThreads((AcceptThreads *)clientData);
+}
+
+static void
+StopAcceptThreads(
+    AcceptThreads *threadsPtr)
+{
+    AcceptThread *threadPtr;
+
+    Tcl_MutexLock(&acceptThreadMutex);
+    threadsPtr->stop = 1;
+    for (threadPtr = threadsPtr->firstPtr; threadPtr != NULL;
+	    threadPtr = threadPtr->nextPtr) {
+	if (threadPtr->state == ACCEPT_THREAD_RUNNING) {
+	    Tcl_Event *evPtr = (Tcl_Event *)Tcl_Alloc(sizeof(Tcl_Event));
+
+	    evPtr->proc = AcceptThreadWakeProc;
+	    Tcl_ThreadQueueEvent(threadPtr->id, evPtr, TCL_QUEUE_TAIL);
+	    Tcl_ThreadAlert(threadPtr->id);
+	}
+    }
+    ReleaseAcceptThreads(threadsPtr);
+    Tcl_MutexUnlock(&acceptThreadMutex);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * ReleaseAcceptThreads --
+ *
+ *	Drops a reference to an AcceptThreads structure. Must be called with
+ *	acceptThreadMutex held.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	Frees the structure and its threads' records with the last reference.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+ReleaseAcceptThreads(
+    AcceptThreads *threadsPtr)
+{
+    AcceptThread *threadPtr, *nextPtr;
+
+    if (--threadsPtr->refCount > 0) {
+	return;
+    }
+    for (threadPtr = threadsPtr->firstPtr; threadPtr != NULL;
+	    threadPtr = nextPtr) {
+	nextPtr = threadPtr->nextPtr;
+	if (threadPtr->errorMsg != NULL) {
+	    Tcl_Free(threadPtr->errorMsg);
+	}
+	Tcl_Free(threadPtr);
+    }
+    Tcl_ConditionFinalize(&threadsPtr->started);
+    Tcl_Free(threadsPtr->command);
+    if (threadsPtr->initScript != NULL) {
+	Tcl_Free(threadsPtr->initScript);
+    }
+    if (threadsPtr->host != NULL) {
+	Tcl_Free(threadsPtr->host);
+    }
+    Tcl_Free(threadsPtr->port);
+    Tcl_Free(threadsPtr);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * FinalizeAcceptThreads --
+ *
+ *	Late exit handler that waits for the accepting threads to end. By the
+ *	time it runs, Tcl_FinalizeThread has closed the server sockets of the
+ *	finalizing thread, which told their threads to stop; those still
+ *	running a script must be done with Tcl before it is finalized.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	May block until the threads have finished their scripts.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+FinalizeAcceptThreads(
+    TCL_UNUSED(void *))
+{
+    Tcl_MutexLock(&acceptThreadMutex);
+    while (numAcceptThreads > 0) {
+	Tcl_ConditionWait(&acceptThreadsEnded, &acceptThreadMutex, NULL);
+    }
+    acceptThreadsExitHandler = 0;
+    Tcl_MutexUnlock(&acceptThreadMutex);
+    Tcl_ConditionFinalize(&acceptThreadsEnded);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * CopyString --
+ *
+ *	Returns a copy of a string in memory obtained with Tcl_Alloc, to be
+ *	handed to another thread.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static char *
+CopyString(
+    const char *string)
+{
+    size_t length = strlen(string) + 1;
+    char *copy = (char *)Tcl_Alloc(length);
+
+    memcpy(copy, string, length);
+    return copy;
+}
 
 /*
  *----------------------------------------------------------------------
@@ -1441,17 +1897,17 @@ Tcl_SocketObjCmd(
 {
     static const char *const socketOptions[] = {
 	"-async", "-myaddr", "-myport", "-reuseaddr", "-reuseport", "-server",
-	NULL
+	"-threadinit", "-threads", NULL
     };
     enum socketOptionsEnum {
 	SKT_ASYNC, SKT_MYADDR, SKT_MYPORT, SKT_REUSEADDR, SKT_REUSEPORT,
-	SKT_SERVER
+	SKT_SERVER, SKT_THREADINIT, SKT_THREADS
     } optionIndex;
     int a, server = 0, myport = 0, async = 0, reusep = -1,
-	reusea = -1;
+	reusea = -1, threads = -1;
     unsigned int flags = 0;
     const char *host, *port, *myaddr = NULL;
-    Tcl_Obj *script = NULL;
+    Tcl_Obj *script = NULL, *threadInit = NULL;
     Tcl_Channel chan;
 
     if (TclpHasSockets(interp) != TCL_OK) {
@@ -1538,6 +1994,33 @@ Tcl_SocketObjCmd(
 		return TCL_ERROR;
 	    }
 	    break;
+	case SKT_THREADINIT:
+	    a++;
+	    if (a >= objc) {
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(
+			"no argument given for -threadinit option", -1));
+		return TCL_ERROR;
+	    }
+	    threadInit = objv[a];
+	    break;
+	case SKT_THREADS:
+	    a++;
+	    if (a >= objc) {
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(
+			"no argument given for -threads option", -1));
+		return TCL_ERROR;
+	    }
+	    if (Tcl_GetIntFromObj(interp, objv[a], &threads) != TCL_OK) {
+		return TCL_ERROR;
+	    }
+	    if (threads < 0) {
+		Tcl_SetObjResult(interp, Tcl_ObjPrintf(
+			"expected non-negative integer but got \"%s\"",
+			TclGetString(objv[a])));
+		Tcl_SetErrorCode(interp, "TCL", "VALUE", "NUMBER", NULL);
+		return TCL_ERROR;
+	    }
+	    break;
 	default:
 	    Tcl_Panic("Tcl_SocketObjCmd: bad option index to SocketOptions");
 	}
@@ -1562,7 +2045,7 @@ Tcl_SocketObjCmd(
 	iPtr->flags |= INTERP_ALTERNATE_WRONG_ARGS;
 	Tcl_WrongNumArgs(interp, 1, objv,
 		"-server command ?-reuseaddr boolean? ?-reuseport boolean? "
-		"?-myaddr addr? port");
+		"?-threads count? ?-threadinit script? ?-myaddr addr? port");
 	return TCL_ERROR;
     }
 
@@ -1572,6 +2055,12 @@ Tcl_SocketObjCmd(
 		-1));
 	return TCL_ERROR;
     }
+    if (!server && (threads != -1 || threadInit != NULL)) {
+	Tcl_SetObjResult(interp, Tcl_NewStringObj(
+		"options -threads and -threadinit are only valid for servers",
+		-1));
+	return TCL_ERROR;
+    }
 
     /*
      * Set the options to their default value if the user didn't override
@@ -1584,6 +2073,25 @@ Tcl_SocketObjCmd(
     if (reusea == -1) {
 	reusea = 1;
     }
+    if (threads == -1) {
+	threads = 0;
+    }
+
+    /*
+     * The sockets of the accepting threads all listen on the same port,
+     * which takes SO_REUSEPORT. On Windows, -reuseport maps to SO_REUSEADDR,
+     * which does not spread the connections over the sockets.
+     */
+
+    if (threads > 0) {
+#if defined(_WIN32) || !defined(SO_REUSEPORT)
+	Tcl_SetObjResult(interp, Tcl_NewStringObj(
+		"option -threads isn't supported by this platform", -1));
+	return TCL_ERROR;
+#else
+	reusep = 1;
+#endif
+    }
 
     /*
      * Build the bitset with the flags values.
@@ -1638,6 +2146,12 @@ Tcl_SocketObjCmd(
 	 */
 
 	Tcl_CreateCloseHandler(chan, TcpServerCloseProc, acceptCallbackPtr);
+
+	if (threads > 0 && StartAcceptThreads(interp, chan, script,
+		threadInit, host, flags, threads) != TCL_OK) {
+	    Tcl_CloseEx(NULL, chan, 0);
+	    return TCL_ERROR;
+	}
     } else {
 	int portNum;
 
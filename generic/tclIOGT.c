@@ -116,7 +116,7 @@ static inline void	ResultAdd(ResultBuffer *r, unsigned char *buf,
 
 static const Tcl_ChannelType transformChannelType = {
     "transform",		/* Type name. */
-    TCL_CHANNEL_VERSION_5,	/* v5 channel */
+    TCL_CHANNEL_VERSION_6,	/* v6 channel */
     NULL,		/* Close proc. */
     TransformInputProc,		/* Input proc. */
     TransformOutputProc,	/* Output proc. */
@@ -131,7 +131,8 @@ static const Tcl_ChannelType transformChannelType = {
     TransformNotifyProc,	/* Handling of events bubbling up. */
     TransformWideSeekProc,	/* Wide seek proc. */
     NULL,			/* Thread action. */
-    NULL			/* Truncate. */
+    NULL,			/* Truncate. */
+    NULL			/* Scatter/gather output proc. */
 };
 
 /*
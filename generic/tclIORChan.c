@@ -63,7 +63,7 @@ static void     TimerRunWrite(void *clientData);
 
 static const Tcl_ChannelType tclRChannelType = {
     "tclrchannel",	   /* Type name.				  */
-    TCL_CHANNEL_VERSION_5, /* v5 channel */
+    TCL_CHANNEL_VERSION_6, /* v6 channel */
     NULL,	   /* Close channel, clean instance data	  */
     ReflectInput,	   /* Handle read request			  */
     ReflectOutput,	   /* Handle write request			  */
@@ -82,7 +82,8 @@ static const Tcl_ChannelType tclRChannelType = {
 #else
 	NULL,		   /* thread action */
 #endif
-    ReflectTruncate	   /* Truncate.				NULL'able */
+    ReflectTruncate,	   /* Truncate.				NULL'able */
+    NULL			/* Scatter/gather output proc. */
 };
 
 /*
@@ -57,7 +57,7 @@ static int		ReflectNotify(void *clientData, int mask);
 
 static const Tcl_ChannelType tclRTransformType = {
     "tclrtransform",		/* Type name. */
-    TCL_CHANNEL_VERSION_5,	/* v5 channel. */
+    TCL_CHANNEL_VERSION_6,	/* v6 channel. */
     NULL,		/* Close channel, clean instance data. */
     ReflectInput,		/* Handle read request. */
     ReflectOutput,		/* Handle write request. */
@@ -73,7 +73,8 @@ static const Tcl_ChannelType tclRTransformType = {
     ReflectNotify,		/* Handle events. */
     ReflectSeekWide,		/* Move access point (64 bit). */
     NULL,			/* thread action */
-    NULL			/* truncate */
+    NULL,			/* truncate */
+    NULL			/* scatter/gather output proc. */
 };
 
 /*
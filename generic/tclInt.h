@@ -2133,6 +2133,9 @@ typedef struct Interp {
     Tcl_Obj *innerLiteral;	/* "INNER" literal for [info errorstack] */
     Tcl_Obj *innerContext;	/* cached list for fast reallocation */
     int resetErrorStack;        /* controls cleaning up of ::errorStack */
+    void *byteCodeCache;	/* State of the persistent bytecode cache, or
+				 * NULL when it is not in use. See
+				 * tclByteCodeCache.c. */
 
 #ifdef TCL_COMPILE_STATS
     /*
@@ -2376,6 +2379,13 @@ typedef struct List {
 				 * derived from the list representation. May
 				 * be ignored if there is no string rep at
 				 * all.*/
+    int searchCount;		/* Number of exact searches of the list since
+				 * it was last modified. */
+    Tcl_HashTable *indexPtr;	/* If not NULL, maps the string of each
+				 * element to the index of its first
+				 * occurrence. Built by TclListObjFind once
+				 * the list has been searched often enough,
+				 * and discarded when the list changes. */
     Tcl_Obj *elements;		/* First list element; the struct is grown to
 				 * accommodate all elements. */
 } List;
@@ -2412,8 +2422,27 @@ typedef struct List {
 	    ? ((ListObjLength((listPtr), *(lenPtr))), TCL_OK)\
 	    : Tcl_ListObjLength((interp), (listPtr), (lenPtr)))
 
+/*
+ * A list held as a tree keeps the string rep of the value it was made from
+ * until it is changed, so it is only canonical without one.
+ */
+
 #define TclListObjIsCanonical(listPtr) \
-    (((listPtr)->typePtr == &tclListType) ? ListObjIsCanonical((listPtr)) : 0)
+    (((listPtr)->typePtr == &tclListType) ? ListObjIsCanonical((listPtr)) \
+	    : ((listPtr)->typePtr == &tclListTreeType && (listPtr)->bytes == NULL))
+
+/*
+ * Macro used to forget the searches of a List, and any index built from them,
+ * before its elements are changed in place.
+ */
+
+#define TclListDiscardIndex(listRepPtr) \
+    do {								\
+	if ((listRepPtr)->indexPtr) {					\
+	    TclListFreeIndex(listRepPtr);				\
+	}								\
+	(listRepPtr)->searchCount = 0;					\
+    } while (0)
 
 /*
  * Modes for collecting (or not) in the implementations of TclNRForeachCmd,
@@ -2547,6 +2576,22 @@ typedef struct TclFileAttrProcs {
 
 typedef struct TclFile_ *TclFile;
 
+/*
+ * Opaque handle used by [chan copy] to let the OS move bytes between two
+ * channels without passing them through user space, see TclpOpenDirectCopy.
+ * The following values are returned by TclpDirectCopy:
+ */
+
+typedef struct TclDirectCopy TclDirectCopy;
+
+#define TCL_DIRECT_OK		0	/* Bytes were copied. */
+#define TCL_DIRECT_EOF		1	/* End of input, nothing left to copy. */
+#define TCL_DIRECT_READ_BLOCKED	2	/* Reading would block. */
+#define TCL_DIRECT_WRITE_BLOCKED 3	/* Writing would block. */
+#define TCL_DIRECT_READ_ERROR	4	/* Reading failed, see Tcl_GetErrno. */
+#define TCL_DIRECT_WRITE_ERROR	5	/* Writing failed, see Tcl_GetErrno. */
+#define TCL_DIRECT_UNSUPPORTED	6	/* The OS refused, no data was lost. */
+
 /*
  * The "globParameters" argument of the function TclGlob is an or'ed
  * combination of the following values:
@@ -2686,9 +2731,11 @@ MODULE_SCOPE const Tcl_ObjType tclByteCodeType;
 MODULE_SCOPE const Tcl_ObjType tclDoubleType;
 MODULE_SCOPE const Tcl_ObjType tclIntType;
 MODULE_SCOPE const Tcl_ObjType tclListType;
+MODULE_SCOPE const Tcl_ObjType tclListTreeType;
 MODULE_SCOPE const Tcl_ObjType tclDictType;
 MODULE_SCOPE const Tcl_ObjType tclProcBodyType;
 MODULE_SCOPE const Tcl_ObjType tclStringType;
+MODULE_SCOPE const Tcl_ObjType tclRopeType;
 MODULE_SCOPE const Tcl_ObjType tclEnsembleCmdType;
 MODULE_SCOPE const Tcl_ObjType tclRegexpType;
 MODULE_SCOPE Tcl_ObjType tclCmdNameType;
@@ -2917,6 +2964,7 @@ MODULE_SCOPE Tcl_Namespace *TclEnsureNamespace(Tcl_Interp *interp,
 			    Tcl_Namespace *namespacePtr);
 MODULE_SCOPE void	TclFinalizeAllocSubsystem(void);
 MODULE_SCOPE void	TclFinalizeAsync(void);
+MODULE_SCOPE void	TclFinalizeByteCodeCache(Tcl_Interp *interp);
 MODULE_SCOPE void	TclFinalizeDoubleConversion(void);
 MODULE_SCOPE void	TclFinalizeEncodingSubsystem(void);
 MODULE_SCOPE void	TclFinalizeEnvironment(void);
@@ -2968,6 +3016,8 @@ MODULE_SCOPE int	TclGetOpenModeEx(Tcl_Interp *interp,
 MODULE_SCOPE Tcl_Obj *	TclGetProcessGlobalValue(ProcessGlobalValue *pgvPtr);
 MODULE_SCOPE Tcl_Obj *	TclGetSourceFromFrame(CmdFrame *cfPtr, int objc,
 			    Tcl_Obj *const objv[]);
+MODULE_SCOPE Tcl_Obj *const *TclGetRopePieces(Tcl_Obj *objPtr,
+			    size_t *numPiecesPtr);
 MODULE_SCOPE char *	TclGetStringStorage(Tcl_Obj *objPtr,
 			    size_t *sizePtr);
 MODULE_SCOPE int	TclGetLoadedLibraries(Tcl_Interp *interp,
@@ -2994,6 +3044,7 @@ MODULE_SCOPE int	TclInfoLocalsCmd(void *dummy, Tcl_Interp *interp,
 MODULE_SCOPE int	TclInfoVarsCmd(void *dummy, Tcl_Interp *interp,
 			    int objc, Tcl_Obj *const objv[]);
 MODULE_SCOPE void	TclInitAlloc(void);
+MODULE_SCOPE void	TclInitByteCodeCache(Tcl_Interp *interp);
 MODULE_SCOPE void	TclInitDbCkalloc(void);
 MODULE_SCOPE void	TclInitDoubleConversion(void);
 MODULE_SCOPE void	TclInitEmbeddedConfigurationInformation(
@@ -3019,6 +3070,9 @@ MODULE_SCOPE Tcl_Obj *	TclLindexFlat(Tcl_Interp *interp, Tcl_Obj *listPtr,
 MODULE_SCOPE void	TclListLines(Tcl_Obj *listObj, int line, int n,
 			    int *lines, Tcl_Obj *const *elems);
 MODULE_SCOPE Tcl_Obj *	TclListObjCopy(Tcl_Interp *interp, Tcl_Obj *listPtr);
+MODULE_SCOPE int	TclListObjFind(Tcl_Obj *listPtr, Tcl_Obj *valuePtr,
+			    int *indexPtr);
+MODULE_SCOPE void	TclListFreeIndex(List *listRepPtr);
 MODULE_SCOPE Tcl_Obj *	TclListObjRange(Tcl_Obj *listPtr, size_t fromIdx,
 			    size_t toIdx);
 MODULE_SCOPE Tcl_Obj *	TclLsetList(Tcl_Interp *interp, Tcl_Obj *listPtr,
@@ -3065,6 +3119,12 @@ MODULE_SCOPE Tcl_Obj *  TclpTempFileNameForLibrary(Tcl_Interp *interp,
 MODULE_SCOPE Tcl_Obj *	TclNewFSPathObj(Tcl_Obj *dirPtr, const char *addStrRep,
 			    size_t len);
 MODULE_SCOPE void	TclpAlertNotifier(ClientData clientData);
+MODULE_SCOPE void	TclpCloseDirectCopy(TclDirectCopy *dcPtr);
+MODULE_SCOPE int	TclpDirectCopy(TclDirectCopy *dcPtr,
+			    Tcl_WideInt toCopy, Tcl_WideInt *copiedPtr);
+MODULE_SCOPE size_t	TclpDirectCopyPending(TclDirectCopy *dcPtr);
+MODULE_SCOPE int	TclpReadDirectCopyPending(TclDirectCopy *dcPtr,
+			    char *buf);
 MODULE_SCOPE ClientData	TclpNotifierData(void);
 MODULE_SCOPE void	TclpServiceModeHook(int mode);
 MODULE_SCOPE void	TclpSetTimer(const Tcl_Time *timePtr);
@@ -3085,6 +3145,7 @@ MODULE_SCOPE int	TclCreateSocketAddress(Tcl_Interp *interp,
 MODULE_SCOPE int	TclpThreadCreate(Tcl_ThreadId *idPtr,
 			    Tcl_ThreadCreateProc *proc, void *clientData,
 			    size_t stackSize, int flags);
+MODULE_SCOPE int	TclpGetCpuCount(void);
 MODULE_SCOPE size_t	TclpFindVariable(const char *name, size_t *lengthPtr);
 MODULE_SCOPE void	TclpInitLibraryPath(char **valuePtr,
 			    size_t *lengthPtr, Tcl_Encoding *encodingPtr);
@@ -3113,6 +3174,8 @@ MODULE_SCOPE Tcl_FSDupInternalRepProc TclNativeDupInternalRep;
 MODULE_SCOPE Tcl_Obj *	TclpObjLink(Tcl_Obj *pathPtr, Tcl_Obj *toPtr,
 			    int linkType);
 MODULE_SCOPE int	TclpObjChdir(Tcl_Obj *pathPtr);
+MODULE_SCOPE TclDirectCopy *TclpOpenDirectCopy(Tcl_Channel inChan,
+			    Tcl_Channel outChan);
 MODULE_SCOPE Tcl_Channel TclpOpenTemporaryFile(Tcl_Obj *dirObj,
 			    Tcl_Obj *basenameObj, Tcl_Obj *extensionObj,
 			    Tcl_Obj *resultingNameObj);
@@ -3188,6 +3251,14 @@ MODULE_SCOPE void	TclRegisterCommandTypeName(
 MODULE_SCOPE int	TclUtfCmp(const char *cs, const char *ct);
 MODULE_SCOPE int	TclUtfCasecmp(const char *cs, const char *ct);
 MODULE_SCOPE size_t	TclUtfCount(int ch);
+MODULE_SCOPE size_t	TclUtfAsciiToUCS4(const char *src, size_t length,
+			    int *dst);
+MODULE_SCOPE size_t	TclAsciiCopy(const char *src, size_t length,
+			    char *dst);
+MODULE_SCOPE size_t	TclUtf16ToAscii(const char *src, size_t numUnits,
+			    int le, char *dst);
+MODULE_SCOPE size_t	TclAsciiToUtf16(const char *src, size_t length,
+			    int le, char *dst);
 #if TCL_UTF_MAX > 3
 #   define TclUtfToUCS4 Tcl_UtfToUniChar
 #   define TclUniCharToUCS4(src, ptr) (*ptr = *(src),1)
@@ -3333,6 +3404,9 @@ MODULE_SCOPE int	Tcl_ErrorObjCmd(void *clientData,
 MODULE_SCOPE int	Tcl_EvalObjCmd(void *clientData,
 			    Tcl_Interp *interp, int objc,
 			    Tcl_Obj *const objv[]);
+MODULE_SCOPE int	TclEventBatchObjCmd(void *clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const objv[]);
 MODULE_SCOPE int	Tcl_ExecObjCmd(void *clientData,
 			    Tcl_Interp *interp, int objc,
 			    Tcl_Obj *const objv[]);
@@ -3454,6 +3528,9 @@ MODULE_SCOPE int	Tcl_PidObjCmd(void *clientData,
 			    Tcl_Interp *interp, int objc,
 			    Tcl_Obj *const objv[]);
 MODULE_SCOPE Tcl_Command TclInitPrefixCmd(Tcl_Interp *interp);
+MODULE_SCOPE int	TclPrecompileObjCmd(void *clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const objv[]);
 MODULE_SCOPE int	Tcl_PutsObjCmd(void *clientData,
 			    Tcl_Interp *interp, int objc,
 			    Tcl_Obj *const objv[]);
@@ -4086,6 +4163,13 @@ MODULE_SCOPE int	TclCompareObjKeys(void *keyPtr, Tcl_HashEntry *hPtr);
 MODULE_SCOPE void	TclFreeObjEntry(Tcl_HashEntry *hPtr);
 MODULE_SCOPE TCL_HASH_TYPE TclHashObjKey(Tcl_HashTable *tablePtr, void *keyPtr);
 
+/*
+ * Creation and release of many Tcl_Obj's at once, e.g. for list elements.
+ */
+
+MODULE_SCOPE void	TclNewObjs(size_t objc, Tcl_Obj **objv);
+MODULE_SCOPE void	TclDecrRefCounts(size_t objc, Tcl_Obj *const *objv);
+
 MODULE_SCOPE int	TclFullFinalizationRequested(void);
 
 /*
@@ -4303,7 +4387,10 @@ TclScaleTime(
  */
 
 MODULE_SCOPE Tcl_Obj *	TclThreadAllocObj(void);
+MODULE_SCOPE void	TclThreadAllocObjs(size_t objc, Tcl_Obj **objv);
 MODULE_SCOPE void	TclThreadFreeObj(Tcl_Obj *);
+MODULE_SCOPE void	TclThreadFreeObjs(Tcl_Obj *firstPtr, Tcl_Obj *lastPtr,
+			    size_t numObjs);
 MODULE_SCOPE Tcl_Mutex *TclpNewAllocMutex(void);
 MODULE_SCOPE void	TclFreeAllocCache(void *);
 MODULE_SCOPE void *	TclpGetAllocCache(void);
@@ -4649,7 +4736,8 @@ MODULE_SCOPE const TclFileAttrProcs	tclpFileAttrProcs[];
  *----------------------------------------------------------------
  * Macro counterpart of the Tcl_NumUtfChars() function. To be used in speed-
  * -sensitive points where it pays to avoid a function call in the common case
- * of counting along a string of all one-byte characters.  The ANSI C
+ * of counting along a short string of all one-byte characters. Long strings
+ * go straight to Tcl_NumUtfChars(), which counts them in bulk.  The ANSI C
  * "prototype" for this macro is:
  *
  * MODULE_SCOPE void	TclNumUtfCharsM(int numChars, const char *bytes,
@@ -4661,7 +4749,9 @@ MODULE_SCOPE const TclFileAttrProcs	tclpFileAttrProcs[];
     do { \
 	size_t _count, _i = (numBytes); \
 	unsigned char *_str = (unsigned char *) (bytes); \
-	while (_i && (*_str < 0xC0)) { _i--; _str++; } \
+	if (_i < 64) { \
+	    while (_i && (*_str < 0xC0)) { _i--; _str++; } \
+	} \
 	_count = (numBytes) - _i; \
 	if (_i) { \
 	    _count += Tcl_NumUtfChars((bytes) + _count, _i); \
@@ -25,6 +25,13 @@ static void		DupListInternalRep(Tcl_Obj *srcPtr, Tcl_Obj *copyPtr);
 static void		FreeListInternalRep(Tcl_Obj *listPtr);
 static int		SetListFromAny(Tcl_Interp *interp, Tcl_Obj *objPtr);
 static void		UpdateStringOfList(Tcl_Obj *listPtr);
+static void		ListElementsToString(Tcl_Obj *listPtr, int numElems,
+			    Tcl_Obj *const elemPtrs[]);
+static void		DupListTreeInternalRep(Tcl_Obj *srcPtr,
+			    Tcl_Obj *copyPtr);
+static void		FreeListTreeInternalRep(Tcl_Obj *listPtr);
+static void		UpdateStringOfListTree(Tcl_Obj *listPtr);
+static void		ListIndexAdd(List *listRepPtr, int index);
 
 /*
  * The structure below defines the list Tcl object type by means of functions
@@ -71,6 +78,798 @@ const Tcl_ObjType tclListType = {
 #ifndef TCL_MIN_ELEMENT_GROWTH
 #define TCL_MIN_ELEMENT_GROWTH TCL_MIN_GROWTH/sizeof(Tcl_Obj *)
 #endif
+
+/*
+ * SetListFromAny creates the objects for the elements it parses this many at
+ * a time.
+ */
+
+#ifndef LIST_NEW_OBJS_CHUNK
+#define LIST_NEW_OBJS_CHUNK	64
+#endif
+
+/*
+ * A list that is modified while its List is shared must have all of its
+ * element pointers copied first. Once a list is long enough for that copy to
+ * dominate, it is converted instead to a persistent tree: a B-tree whose
+ * branches record how many elements are held under each child. Copies of the
+ * list share the tree, and a modification copies only the nodes on the paths
+ * it changes, so that replacing, inserting, slicing and concatenating all
+ * take O(log n). Anything that needs the element array (including
+ * Tcl_ListObjGetElements) flattens the tree back into a List.
+ *
+ * A leaf may also be a span: a view of a run of the elements of a List,
+ * which it keeps alive. A list becomes a tree by wrapping its List in a single
+ * span, and long slices and concatenations of lists are made of spans, so
+ * none of these copy the elements. A tree whose root is a span can hand out
+ * the element array of the List it views without being flattened.
+ *
+ * The internal representation of such a list holds the root of the tree in
+ * ptr1. As for lists, ptr2 is NULL except while TclLsetFlat uses it.
+ */
+
+const Tcl_ObjType tclListTreeType = {
+    "listtree",			/* name */
+    FreeListTreeInternalRep,	/* freeIntRepProc */
+    DupListTreeInternalRep,	/* dupIntRepProc */
+    UpdateStringOfListTree,	/* updateStringProc */
+    NULL			/* setFromAnyProc */
+};
+
+#ifndef LIST_TREE_MIN
+#define LIST_TREE_MIN	1024	/* Shared lists of at least this many elements
+				 * become trees when they are modified. */
+#endif
+#define LIST_TREE_FLAT	(LIST_TREE_MIN / 4)
+				/* Trees that shrink below this many elements
+				 * are flattened again. */
+#define LIST_NODE_WIDTH	32	/* Most items held by a node. */
+#define LIST_NODE_MIN	(LIST_NODE_WIDTH / 2)
+				/* Fewest items held by a node other than the
+				 * root. */
+
+typedef union ListItem {
+    Tcl_Obj *objPtr;		/* An element, in a leaf. */
+    struct ListNode *child;	/* A subtree, in a branch. */
+} ListItem;
+
+typedef struct ListNode {
+    size_t refCount;		/* Number of trees and branches holding this
+				 * node. */
+    unsigned int height;	/* Zero for leaves. */
+    unsigned int numItems;	/* Number of items in use. */
+    ListItem items[LIST_NODE_WIDTH];
+    size_t sizes[TCLFLEXARRAY];	/* Branches only: number of elements held
+				 * under items 0..i. */
+} ListNode;
+
+#define LIST_NODE_SIZE(height) \
+    (offsetof(ListNode, sizes) + ((height) ? LIST_NODE_WIDTH * sizeof(size_t) : 0))
+
+/*
+ * A span begins as a ListNode does, and is told apart as a leaf with no
+ * items. Nothing else ever has no items.
+ */
+
+typedef struct ListSpan {
+    size_t refCount;		/* As for ListNode. */
+    unsigned int height;	/* Always zero. */
+    unsigned int numItems;	/* Always zero. */
+    List *listRepPtr;		/* List holding the elements. */
+    size_t first;		/* Index in it of the first element. */
+    size_t count;		/* Number of elements. */
+} ListSpan;
+
+#define IsSpan(nodePtr) \
+    ((nodePtr)->height == 0 && (nodePtr)->numItems == 0)
+#define NodeSpan(nodePtr) \
+    ((ListSpan *) (nodePtr))
+#define SpanElements(nodePtr) \
+    (&NodeSpan(nodePtr)->listRepPtr->elements + NodeSpan(nodePtr)->first)
+
+#define ListIsTree(objPtr) \
+    TclHasInternalRep((objPtr), &tclListTreeType)
+#define ListTreeRoot(objPtr) \
+    ((ListNode *) (objPtr)->internalRep.twoPtrValue.ptr1)
+
+static inline size_t
+NodeLength(
+    const ListNode *nodePtr)
+{
+    if (nodePtr == NULL) {
+	return 0;
+    }
+    if (nodePtr->height) {
+	return nodePtr->sizes[nodePtr->numItems - 1];
+    }
+    return nodePtr->numItems ? nodePtr->numItems : NodeSpan(nodePtr)->count;
+}
+
+static ListNode *
+NewListNode(
+    unsigned int height)
+{
+    ListNode *nodePtr = (ListNode *)Tcl_Alloc(LIST_NODE_SIZE(height));
+
+    nodePtr->refCount = 1;
+    nodePtr->height = height;
+    nodePtr->numItems = 0;
+    return nodePtr;
+}
+
+static void
+FixNodeSizes(
+    ListNode *nodePtr)
+{
+    unsigned int i;
+    size_t total = 0;
+
+    for (i = 0; i < nodePtr->numItems; i++) {
+	total += NodeLength(nodePtr->items[i].child);
+	nodePtr->sizes[i] = total;
+    }
+}
+
+static void
+HoldItems(
+    unsigned int height,
+    ListItem *items,
+    unsigned int numItems)
+{
+    while (numItems--) {
+	if (height) {
+	    items->child->refCount++;
+	} else {
+	    Tcl_IncrRefCount(items->objPtr);
+	}
+	items++;
+    }
+}
+
+static void
+ReleaseList(
+    List *listRepPtr)
+{
+    if (listRepPtr->refCount-- <= 1) {
+	if (listRepPtr->indexPtr) {
+	    TclListFreeIndex(listRepPtr);
+	}
+	TclDecrRefCounts(listRepPtr->elemCount, &listRepPtr->elements);
+	Tcl_Free(listRepPtr);
+    }
+}
+
+static void
+ReleaseListNode(
+    ListNode *nodePtr)
+{
+    unsigned int i;
+
+    if (nodePtr == NULL || nodePtr->refCount-- > 1) {
+	return;
+    }
+    if (IsSpan(nodePtr)) {
+	ReleaseList(NodeSpan(nodePtr)->listRepPtr);
+    }
+    for (i = 0; i < nodePtr->numItems; i++) {
+	if (nodePtr->height) {
+	    ReleaseListNode(nodePtr->items[i].child);
+	} else {
+	    Tcl_DecrRefCount(nodePtr->items[i].objPtr);
+	}
+    }
+    Tcl_Free(nodePtr);
+}
+
+/*
+ * Returns a leaf holding 'count' elements of a List from 'first' on: a span
+ * viewing them, or for a few elements a plain leaf holding them, so that
+ * long lists do not end up as many small spans.
+ */
+
+static ListNode *
+NewSpan(
+    List *listRepPtr,
+    size_t first,
+    size_t count)
+{
+    Tcl_Obj **elemPtrs = &listRepPtr->elements + first;
+    ListNode *nodePtr;
+
+    if (count == 0) {
+	return NULL;
+    }
+    if (count <= LIST_NODE_WIDTH) {
+	nodePtr = NewListNode(0);
+	memcpy(nodePtr->items, elemPtrs, count * sizeof(ListItem));
+	nodePtr->numItems = count;
+	HoldItems(0, nodePtr->items, count);
+    } else {
+	ListSpan *spanPtr = (ListSpan *)Tcl_Alloc(sizeof(ListSpan));
+
+	spanPtr->refCount = 1;
+	spanPtr->height = 0;
+	spanPtr->numItems = 0;
+	spanPtr->listRepPtr = listRepPtr;
+	spanPtr->first = first;
+	spanPtr->count = count;
+	listRepPtr->refCount++;
+	nodePtr = (ListNode *) spanPtr;
+    }
+    return nodePtr;
+}
+
+/*
+ * Returns a copy of the node that the caller may modify, consuming the
+ * caller's reference to the original.
+ */
+
+static ListNode *
+UniqueListNode(
+    ListNode *nodePtr)
+{
+    ListNode *copyPtr;
+
+    if (nodePtr->refCount == 1) {
+	return nodePtr;
+    }
+    copyPtr = (ListNode *)Tcl_Alloc(LIST_NODE_SIZE(nodePtr->height));
+    memcpy(copyPtr, nodePtr, LIST_NODE_SIZE(nodePtr->height));
+    copyPtr->refCount = 1;
+    HoldItems(copyPtr->height, copyPtr->items, copyPtr->numItems);
+    nodePtr->refCount--;
+    return copyPtr;
+}
+
+/*
+ * Moves the items of a node to 'dst', consuming the caller's reference to
+ * the node. When that was the only reference, the emptied node is handed
+ * back through 'sparePtr' for NodesFromItems to reuse.
+ */
+
+static unsigned int
+TakeItems(
+    ListNode *nodePtr,
+    ListItem *dst,
+    ListNode **sparePtr)
+{
+    unsigned int numItems = nodePtr->numItems;
+
+    memcpy(dst, nodePtr->items, numItems * sizeof(ListItem));
+    if (nodePtr->refCount == 1) {
+	nodePtr->numItems = 0;
+	*sparePtr = nodePtr;
+    } else {
+	HoldItems(nodePtr->height, dst, numItems);
+	nodePtr->refCount--;
+	*sparePtr = NULL;
+    }
+    return numItems;
+}
+
+/*
+ * Makes a tree of the given height, or one level taller, holding up to
+ * twice LIST_NODE_WIDTH items. A single child is returned on its own rather
+ * than wrapped in a branch. The references held by the items are taken over.
+ */
+
+static ListNode *
+NodesFromItems(
+    unsigned int height,
+    ListItem *items,
+    unsigned int numItems,
+    ListNode *sparePtr)
+{
+    ListNode *nodePtr;
+
+    if (numItems == 0 || (numItems == 1 && height)) {
+	if (sparePtr != NULL) {
+	    Tcl_Free(sparePtr);
+	}
+	return numItems ? items[0].child : NULL;
+    }
+    if (numItems > LIST_NODE_WIDTH) {
+	unsigned int half = numItems / 2;
+	ListItem pair[2];
+
+	assert(numItems <= 2 * LIST_NODE_WIDTH);
+	pair[0].child = NodesFromItems(height, items, half, sparePtr);
+	pair[1].child = NodesFromItems(height, items + half, numItems - half,
+		NULL);
+	return NodesFromItems(height + 1, pair, 2, NULL);
+    }
+    nodePtr = sparePtr ? sparePtr : NewListNode(height);
+    memcpy(nodePtr->items, items, numItems * sizeof(ListItem));
+    nodePtr->numItems = numItems;
+    if (height) {
+	FixNodeSizes(nodePtr);
+    }
+    return nodePtr;
+}
+
+/*
+ * Returns the tree holding the elements of 'leftPtr' followed by those of
+ * 'rightPtr', consuming the caller's references to both. The shorter tree is
+ * joined to the edge of the taller one at its own height, so only the nodes
+ * along that edge are rebuilt.
+ */
+
+static ListNode *
+JoinTrees(
+    ListNode *leftPtr,
+    ListNode *rightPtr)
+{
+    ListItem items[2 * LIST_NODE_WIDTH + 1];
+    ListNode *sparePtr, *subPtr;
+    unsigned int height, numItems;
+
+    if (leftPtr == NULL) {
+	return rightPtr;
+    }
+    if (rightPtr == NULL) {
+	return leftPtr;
+    }
+
+    if (leftPtr->height > rightPtr->height) {
+	height = leftPtr->height;
+	numItems = TakeItems(leftPtr, items, &sparePtr);
+	subPtr = JoinTrees(items[numItems - 1].child, rightPtr);
+	if (subPtr->height == height) {
+	    items[numItems - 1] = subPtr->items[0];
+	    items[numItems++] = subPtr->items[1];
+	    Tcl_Free(subPtr);
+	} else {
+	    items[numItems - 1].child = subPtr;
+	}
+	return NodesFromItems(height, items, numItems, sparePtr);
+    }
+
+    if (leftPtr->height < rightPtr->height) {
+	ListItem *first = items + 1;
+
+	height = rightPtr->height;
+	numItems = TakeItems(rightPtr, first, &sparePtr);
+	subPtr = JoinTrees(leftPtr, first[0].child);
+	if (subPtr->height == height) {
+	    first--;
+	    first[0] = subPtr->items[0];
+	    first[1] = subPtr->items[1];
+	    numItems++;
+	    Tcl_Free(subPtr);
+	} else {
+	    first[0].child = subPtr;
+	}
+	return NodesFromItems(height, first, numItems, sparePtr);
+    }
+
+    /*
+     * Equal heights: two well-filled nodes, or leaves either of which is a
+     * span, simply become siblings. Otherwise their items are merged, or
+     * shared out evenly between two nodes.
+     */
+
+    height = leftPtr->height;
+    if (IsSpan(leftPtr) || IsSpan(rightPtr)) {
+	items[0].child = leftPtr;
+	items[1].child = rightPtr;
+	return NodesFromItems(1, items, 2, NULL);
+    }
+    if (leftPtr->numItems >= LIST_NODE_MIN
+	    && rightPtr->numItems >= LIST_NODE_MIN
+	    && leftPtr->numItems + rightPtr->numItems > LIST_NODE_WIDTH) {
+	items[0].child = leftPtr;
+	items[1].child = rightPtr;
+	return NodesFromItems(height + 1, items, 2, NULL);
+    }
+    numItems = TakeItems(leftPtr, items, &sparePtr);
+    numItems += TakeItems(rightPtr, items + numItems, &subPtr);
+    if (subPtr != NULL) {
+	Tcl_Free(subPtr);
+    }
+    return NodesFromItems(height, items, numItems, sparePtr);
+}
+
+/*
+ * Finds the child of a branch holding element '*indexPtr', and makes the
+ * index relative to that child.
+ */
+
+static inline unsigned int
+ChildIndex(
+    const ListNode *nodePtr,
+    size_t *indexPtr)
+{
+    unsigned int lo = 0, hi = nodePtr->numItems - 1;
+
+    while (lo < hi) {
+	unsigned int mid = (lo + hi) / 2;
+
+	if (nodePtr->sizes[mid] <= *indexPtr) {
+	    lo = mid + 1;
+	} else {
+	    hi = mid;
+	}
+    }
+    if (lo) {
+	*indexPtr -= nodePtr->sizes[lo - 1];
+    }
+    return lo;
+}
+
+/*
+ * Splits a tree into the elements before 'index' and the rest, consuming the
+ * caller's reference to it. Either part may come back NULL when empty.
+ */
+
+static void
+SplitTree(
+    ListNode *nodePtr,
+    size_t index,
+    ListNode **leftPtrPtr,
+    ListNode **rightPtrPtr)
+{
+    ListItem items[LIST_NODE_WIDTH];
+    ListNode *sparePtr, *leftPtr, *rightPtr;
+    unsigned int i, height, numItems;
+
+    if (index == 0 || index >= NodeLength(nodePtr)) {
+	*leftPtrPtr = index ? nodePtr : NULL;
+	*rightPtrPtr = index ? NULL : nodePtr;
+	return;
+    }
+
+    height = nodePtr->height;
+    if (IsSpan(nodePtr)) {
+	ListSpan *spanPtr = NodeSpan(nodePtr);
+
+	*leftPtrPtr = NewSpan(spanPtr->listRepPtr, spanPtr->first, index);
+	*rightPtrPtr = NewSpan(spanPtr->listRepPtr, spanPtr->first + index,
+		spanPtr->count - index);
+	ReleaseListNode(nodePtr);
+	return;
+    }
+    if (height == 0) {
+	numItems = TakeItems(nodePtr, items, &sparePtr);
+	*leftPtrPtr = NodesFromItems(0, items, index, sparePtr);
+	*rightPtrPtr = NodesFromItems(0, items + index, numItems - index,
+		NULL);
+	return;
+    }
+
+    i = ChildIndex(nodePtr, &index);
+    numItems = TakeItems(nodePtr, items, &sparePtr);
+    if (index == 0) {
+	*leftPtrPtr = NodesFromItems(height, items, i, sparePtr);
+	*rightPtrPtr = NodesFromItems(height, items + i, numItems - i, NULL);
+	return;
+    }
+    SplitTree(items[i].child, index, &leftPtr, &rightPtr);
+    *leftPtrPtr = JoinTrees(NodesFromItems(height, items, i, sparePtr),
+	    leftPtr);
+    *rightPtrPtr = JoinTrees(rightPtr,
+	    NodesFromItems(height, items + i + 1, numItems - i - 1, NULL));
+}
+
+/*
+ * Builds a tree holding the given elements, with the nodes of each level
+ * filled evenly. The elements' reference counts are incremented.
+ */
+
+static ListNode *
+BuildTree(
+    size_t objc,
+    Tcl_Obj *const objv[])
+{
+    ListNode **nodes, *nodePtr;
+    size_t count, numNodes, i, j, k;
+    unsigned int height = 0;
+
+    if (objc == 0) {
+	return NULL;
+    }
+    numNodes = (objc + LIST_NODE_WIDTH - 1) / LIST_NODE_WIDTH;
+    nodes = (ListNode **)Tcl_Alloc(numNodes * sizeof(ListNode *));
+    for (i = 0, j = 0; i < numNodes; i++) {
+	nodePtr = NewListNode(0);
+	nodePtr->numItems = objc / numNodes + (i < objc % numNodes);
+	for (k = 0; k < nodePtr->numItems; k++, j++) {
+	    nodePtr->items[k].objPtr = objv[j];
+	    Tcl_IncrRefCount(objv[j]);
+	}
+	nodes[i] = nodePtr;
+    }
+
+    /*
+     * Group the nodes of each level under the next one. The new nodes are
+     * stored in place; node i never takes any child before child i.
+     */
+
+    for (count = numNodes; count > 1; count = numNodes) {
+	height++;
+	numNodes = (count + LIST_NODE_WIDTH - 1) / LIST_NODE_WIDTH;
+	for (i = 0, j = 0; i < numNodes; i++) {
+	    nodePtr = NewListNode(height);
+	    nodePtr->numItems = count / numNodes + (i < count % numNodes);
+	    for (k = 0; k < nodePtr->numItems; k++, j++) {
+		nodePtr->items[k].child = nodes[j];
+	    }
+	    FixNodeSizes(nodePtr);
+	    nodes[i] = nodePtr;
+	}
+    }
+    nodePtr = nodes[0];
+    Tcl_Free(nodes);
+    return nodePtr;
+}
+
+static Tcl_Obj *
+TreeIndex(
+    const ListNode *nodePtr,
+    size_t index)
+{
+    while (nodePtr->height) {
+	nodePtr = nodePtr->items[ChildIndex(nodePtr, &index)].child;
+    }
+    if (IsSpan(nodePtr)) {
+	return SpanElements(nodePtr)[index];
+    }
+    return nodePtr->items[index].objPtr;
+}
+
+/*
+ * Copies the element pointers of a tree to 'dst', without taking references
+ * to them, and returns the first slot after them.
+ */
+
+static Tcl_Obj **
+TreeFlatten(
+    const ListNode *nodePtr,
+    Tcl_Obj **dst)
+{
+    unsigned int i;
+
+    if (IsSpan(nodePtr)) {
+	memcpy(dst, SpanElements(nodePtr),
+		NodeSpan(nodePtr)->count * sizeof(Tcl_Obj *));
+	return dst + NodeSpan(nodePtr)->count;
+    }
+    for (i = 0; i < nodePtr->numItems; i++) {
+	if (nodePtr->height) {
+	    dst = TreeFlatten(nodePtr->items[i].child, dst);
+	} else {
+	    *dst++ = nodePtr->items[i].objPtr;
+	}
+    }
+    return dst;
+}
+
+/*
+ * Returns a new List (with refCount 0) holding the elements of a tree.
+ */
+
+static List *
+TreeToList(
+    Tcl_Interp *interp,
+    const ListNode *rootPtr)
+{
+    int numElems = (int) NodeLength(rootPtr);
+    List *listRepPtr = AttemptNewList(interp, numElems ? numElems : 1, NULL);
+    Tcl_Obj **elemPtrs;
+
+    if (listRepPtr == NULL) {
+	return NULL;
+    }
+    if (numElems) {
+	elemPtrs = &listRepPtr->elements;
+	TreeFlatten(rootPtr, elemPtrs);
+	while (listRepPtr->elemCount < numElems) {
+	    Tcl_IncrRefCount(elemPtrs[listRepPtr->elemCount++]);
+	}
+    }
+    return listRepPtr;
+}
+
+static void
+ListTreeSetIntRep(
+    Tcl_Obj *objPtr,
+    ListNode *rootPtr)
+{
+    Tcl_ObjInternalRep ir;
+
+    ir.twoPtrValue.ptr1 = rootPtr;
+    ir.twoPtrValue.ptr2 = NULL;
+    Tcl_StoreInternalRep(objPtr, &tclListTreeType, &ir);
+}
+
+/*
+ * Converts a list whose List is shared to a tree, a single span over the
+ * List, in place of copying the List to modify it. The value, and so the
+ * string rep, is unchanged.
+ */
+
+static void
+ListConvertToTree(
+    Tcl_Obj *listPtr,
+    List *listRepPtr)
+{
+    ListTreeSetIntRep(listPtr, NewSpan(listRepPtr, 0, listRepPtr->elemCount));
+}
+
+/*
+ * Makes 'rootPtr' the new value of the unshared list 'listPtr', taking over
+ * the caller's reference. If 'listPtr' is a tree already, the caller must
+ * have released its old root or taken it over. Short results go back to
+ * being a List.
+ */
+
+static void
+ListTreeSetRoot(
+    Tcl_Obj *listPtr,
+    ListNode *rootPtr)
+{
+    List *listRepPtr = NULL;
+
+    /*
+     * A span left viewing less than half of its List is copied too, so that
+     * slicing a list down bit by bit does not hold on to all of it.
+     */
+
+    if (NodeLength(rootPtr) < LIST_TREE_FLAT || (IsSpan(rootPtr)
+	    && NodeSpan(rootPtr)->count
+	    < (size_t) NodeSpan(rootPtr)->listRepPtr->elemCount / 2)) {
+	listRepPtr = TreeToList(NULL, rootPtr);
+    }
+    if (listRepPtr != NULL) {
+	if (ListIsTree(listPtr)) {
+	    listPtr->internalRep.twoPtrValue.ptr1 = NULL;
+	}
+	ListSetIntRep(listPtr, listRepPtr);
+	ReleaseListNode(rootPtr);
+    } else if (ListIsTree(listPtr)) {
+	listPtr->internalRep.twoPtrValue.ptr1 = rootPtr;
+    } else {
+	ListTreeSetIntRep(listPtr, rootPtr);
+    }
+    TclInvalidateStringRep(listPtr);
+}
+
+/*
+ * The tree counterparts of Tcl_ListObjReplace, TclListObjSetElement and
+ * TclListObjRange, called by them.
+ */
+
+static int
+ListTreeReplace(
+    Tcl_Interp *interp,
+    Tcl_Obj *listPtr,
+    int first,
+    int count,
+    int objc,
+    Tcl_Obj *const objv[])
+{
+    ListNode *rootPtr = ListTreeRoot(listPtr), *newPtr, *leftPtr, *midPtr;
+    int numElems = (int) NodeLength(rootPtr);
+
+    if (first < 0) {
+	first = 0;
+    }
+    if (first >= numElems) {
+	first = numElems;
+    }
+    if (count < 0) {
+	count = 0;
+    } else if (first > INT_MAX - count || numElems < first + count) {
+	count = numElems - first;
+    }
+    if (objc > LIST_MAX - (numElems - count)) {
+	if (interp != NULL) {
+	    Tcl_SetObjResult(interp, Tcl_ObjPrintf(
+		    "max length of a Tcl list (%d elements) exceeded",
+		    LIST_MAX));
+	}
+	return TCL_ERROR;
+    }
+
+    /*
+     * Take hold of the new elements before releasing the old ones, as they
+     * may be the same.
+     */
+
+    newPtr = BuildTree(objc, objv);
+    listPtr->internalRep.twoPtrValue.ptr1 = NULL;
+    SplitTree(rootPtr, first, &leftPtr, &rootPtr);
+    SplitTree(rootPtr, count, &midPtr, &rootPtr);
+    ReleaseListNode(midPtr);
+    ListTreeSetRoot(listPtr, JoinTrees(JoinTrees(leftPtr, newPtr), rootPtr));
+    return TCL_OK;
+}
+
+static int
+ListTreeSetElement(
+    Tcl_Interp *interp,
+    Tcl_Obj *listPtr,
+    int index,
+    Tcl_Obj *valuePtr)
+{
+    ListNode *nodePtr, **nodePtrPtr;
+    size_t rest = index;
+
+    if (index < 0 || rest >= NodeLength(ListTreeRoot(listPtr))) {
+	if (interp != NULL) {
+	    Tcl_SetObjResult(interp, Tcl_ObjPrintf(
+		    "index \"%d\" out of range", index));
+	    Tcl_SetErrorCode(interp, "TCL", "VALUE", "INDEX",
+		    "OUTOFRANGE", NULL);
+	}
+	return TCL_ERROR;
+    }
+
+    /*
+     * An element viewed by a span is replaced by splitting the span around
+     * it. Otherwise copy whichever nodes on the path to it are shared.
+     */
+
+    for (nodePtr = ListTreeRoot(listPtr); nodePtr->height; ) {
+	nodePtr = nodePtr->items[ChildIndex(nodePtr, &rest)].child;
+    }
+    if (IsSpan(nodePtr)) {
+	return ListTreeReplace(interp, listPtr, index, 1, 1, &valuePtr);
+    }
+    rest = index;
+    nodePtrPtr = (ListNode **) &listPtr->internalRep.twoPtrValue.ptr1;
+    while (1) {
+	nodePtr = UniqueListNode(*nodePtrPtr);
+	*nodePtrPtr = nodePtr;
+	if (nodePtr->height == 0) {
+	    break;
+	}
+	nodePtrPtr = &nodePtr->items[ChildIndex(nodePtr, &rest)].child;
+    }
+    Tcl_IncrRefCount(valuePtr);
+    Tcl_DecrRefCount(nodePtr->items[rest].objPtr);
+    nodePtr->items[rest].objPtr = valuePtr;
+
+    TclInvalidateStringRep(listPtr);
+    return TCL_OK;
+}
+
+static Tcl_Obj *
+ListTreeRange(
+    Tcl_Obj *listPtr,
+    size_t fromIdx,
+    size_t toIdx)
+{
+    ListNode *rootPtr = ListTreeRoot(listPtr), *restPtr;
+    size_t listLen = NodeLength(rootPtr);
+    Tcl_Obj *newPtr;
+
+    if (fromIdx == TCL_INDEX_NONE) {
+	fromIdx = 0;
+    }
+    if (toIdx + 1 >= listLen + 1) {
+	toIdx = listLen - 1;
+    }
+    if (fromIdx + 1 > toIdx + 1) {
+	TclNewObj(newPtr);
+	return newPtr;
+    }
+
+    rootPtr->refCount++;
+    SplitTree(rootPtr, toIdx + 1, &rootPtr, &restPtr);
+    ReleaseListNode(restPtr);
+    SplitTree(rootPtr, fromIdx, &restPtr, &rootPtr);
+    ReleaseListNode(restPtr);
+
+    if (Tcl_IsShared(listPtr)) {
+	TclNewObj(newPtr);
+	ListTreeSetRoot(newPtr, rootPtr);
+	return newPtr;
+    }
+    ReleaseListNode(ListTreeRoot(listPtr));
+    listPtr->internalRep.twoPtrValue.ptr1 = NULL;
+    ListTreeSetRoot(listPtr, rootPtr);
+    return listPtr;
+}
 
 /*
  *----------------------------------------------------------------------
@@ -136,6 +935,8 @@ NewListIntRep(
     listRepPtr->canonicalFlag = 0;
     listRepPtr->refCount = 0;
     listRepPtr->maxElemCount = objc;
+    listRepPtr->searchCount = 0;
+    listRepPtr->indexPtr = NULL;
 
     if (objv) {
 	Tcl_Obj **elemPtrs;
@@ -392,6 +1193,13 @@ TclListObjCopy(
     Tcl_Obj *copyPtr;
     List *listRepPtr;
 
+    if (ListIsTree(listPtr)) {
+	TclNewObj(copyPtr);
+	TclInvalidateStringRep(copyPtr);
+	DupListTreeInternalRep(listPtr, copyPtr);
+	return copyPtr;
+    }
+
     ListGetIntRep(listPtr, listRepPtr);
     if (NULL == listRepPtr) {
 	if (SetListFromAny(interp, listPtr) != TCL_OK) {
@@ -404,6 +1212,114 @@ TclListObjCopy(
     DupListInternalRep(listPtr, copyPtr);
     return copyPtr;
 }
+
+/*
+ * A list that is searched for exact matches again and again without being
+ * changed is given an index: a hash table from the string of each element to
+ * the index of its first occurrence. Building it costs about as much as a
+ * handful of linear searches, and it is kept only until the elements are
+ * next changed in place, so only a list that has been searched often enough
+ * since it was last changed gets one. Appending to a list keeps its index.
+ *
+ * The keys of the index are the elements themselves, hashed and compared by
+ * their strings, without extra references; the List holds those.
+ */
+
+#ifndef LIST_INDEX_MIN
+#define LIST_INDEX_MIN		64	/* Shorter lists are always searched
+					 * linearly. */
+#endif
+#ifndef LIST_INDEX_SEARCHES
+#define LIST_INDEX_SEARCHES	16	/* Number of searches of an unchanged
+					 * list after which it is indexed. */
+#endif
+
+static const Tcl_HashKeyType listIndexKeyType = {
+    TCL_HASH_KEY_TYPE_VERSION,	/* version */
+    0,				/* flags */
+    TclHashObjKey,		/* hashKeyProc */
+    TclCompareObjKeys,		/* compareKeysProc */
+    NULL,			/* allocEntryProc */
+    NULL			/* freeEntryProc */
+};
+
+static void
+ListIndexAdd(
+    List *listRepPtr,
+    int index)
+{
+    int isNew;
+    Tcl_HashEntry *hPtr = Tcl_CreateHashEntry(listRepPtr->indexPtr,
+	    (&listRepPtr->elements)[index], &isNew);
+
+    if (isNew) {
+	Tcl_SetHashValue(hPtr, INT2PTR(index));
+    }
+}
+
+void
+TclListFreeIndex(
+    List *listRepPtr)
+{
+    Tcl_DeleteHashTable(listRepPtr->indexPtr);
+    Tcl_Free(listRepPtr->indexPtr);
+    listRepPtr->indexPtr = NULL;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclListObjFind --
+ *
+ *	Looks up the first element of a list whose string is the same as that
+ *	of 'valuePtr', using the index of the list if it has one (or is due
+ *	one). Used by [lsearch -exact] and the [expr] operators "in" and "ni".
+ *
+ * Value
+ *
+ *	1 if the lookup was made, in which case the index of the element, or
+ *	-1 if there is none, is stored at 'indexPtr'.  0 if the caller must
+ *	search the list itself.
+ *
+ * Effect
+ *
+ *	The search is counted, and an index may be built for the list.
+ *
+ *----------------------------------------------------------------------
+ */
+
+int
+TclListObjFind(
+    Tcl_Obj *listPtr,		/* List object to search. */
+    Tcl_Obj *valuePtr,		/* Value to look for. */
+    int *indexPtr)		/* Where to store the index found. */
+{
+    List *listRepPtr;
+    Tcl_HashEntry *hPtr;
+
+    ListGetIntRep(listPtr, listRepPtr);
+    if (listRepPtr == NULL || listRepPtr->elemCount < LIST_INDEX_MIN) {
+	return 0;
+    }
+    if (listRepPtr->indexPtr == NULL) {
+	int i;
+
+	if (++listRepPtr->searchCount < LIST_INDEX_SEARCHES) {
+	    return 0;
+	}
+	listRepPtr->indexPtr = (Tcl_HashTable *)
+		Tcl_Alloc(sizeof(Tcl_HashTable));
+	Tcl_InitCustomHashTable(listRepPtr->indexPtr, TCL_CUSTOM_PTR_KEYS,
+		&listIndexKeyType);
+	for (i = 0; i < listRepPtr->elemCount; i++) {
+	    ListIndexAdd(listRepPtr, i);
+	}
+    }
+
+    hPtr = Tcl_FindHashEntry(listRepPtr->indexPtr, valuePtr);
+    *indexPtr = hPtr ? PTR2INT(Tcl_GetHashValue(hPtr)) : -1;
+    return 1;
+}
 
 /*
  *----------------------------------------------------------------------
@@ -435,6 +1351,9 @@ TclListObjRange(
     size_t i, newLen;
     List *listRepPtr;
 
+    if (ListIsTree(listPtr)) {
+	return ListTreeRange(listPtr, fromIdx, toIdx);
+    }
     TclListObjGetElementsM(NULL, listPtr, &listLen, &elemPtrs);
 
     if (fromIdx == TCL_INDEX_NONE) {
@@ -453,7 +1372,21 @@ TclListObjRange(
 
     if (Tcl_IsShared(listPtr) ||
 	    ((ListRepPtr(listPtr)->refCount > 1))) {
-	return Tcl_NewListObj(newLen, &elemPtrs[fromIdx]);
+	Tcl_Obj *newPtr;
+
+	/*
+	 * A long slice covering at least half of the list views its elements
+	 * through a span instead of copying them.
+	 */
+
+	if (newLen < LIST_TREE_MIN || newLen < (size_t) listLen / 2) {
+	    return Tcl_NewListObj(newLen, &elemPtrs[fromIdx]);
+	}
+	TclNewObj(newPtr);
+	TclInvalidateStringRep(newPtr);
+	ListTreeSetIntRep(newPtr,
+		NewSpan(ListRepPtr(listPtr), fromIdx, newLen));
+	return newPtr;
     }
 
     /*
@@ -466,6 +1399,7 @@ TclListObjRange(
      */
 
     TclInvalidateStringRep(listPtr);
+    TclListDiscardIndex(ListRepPtr(listPtr));
 
     /*
      * Delete elements that should not be included.
@@ -534,6 +1468,18 @@ Tcl_ListObjGetElements(
 {
     List *listRepPtr;
 
+    if (ListIsTree(listPtr)) {
+	ListNode *rootPtr = ListTreeRoot(listPtr);
+
+	if (IsSpan(rootPtr)) {
+	    *objcPtr = (int) NodeSpan(rootPtr)->count;
+	    *objvPtr = SpanElements(rootPtr);
+	    return TCL_OK;
+	}
+	if (SetListFromAny(interp, listPtr) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+    }
     ListGetIntRep(listPtr, listRepPtr);
 
     if (listRepPtr == NULL) {
@@ -600,6 +1546,51 @@ Tcl_ListObjAppendList(
 	Tcl_Panic("%s called with shared object", "Tcl_ListObjAppendList");
     }
 
+    /*
+     * A tree, or a long list, is appended by sharing it (the list through a
+     * span), with 'listPtr' made a tree too.
+     */
+
+    if (ListIsTree(elemListPtr) || (TclHasInternalRep(elemListPtr, &tclListType)
+	    && ListRepPtr(elemListPtr)->elemCount >= LIST_TREE_MIN)) {
+	ListNode *rootPtr, *leftPtr;
+
+	if (ListIsTree(elemListPtr)) {
+	    rootPtr = ListTreeRoot(elemListPtr);
+	    rootPtr->refCount++;
+	} else {
+	    List *listRepPtr = ListRepPtr(elemListPtr);
+
+	    rootPtr = NewSpan(listRepPtr, 0, listRepPtr->elemCount);
+	}
+	if (ListIsTree(listPtr)) {
+	    objc = (int) NodeLength(ListTreeRoot(listPtr));
+	} else if (TclListObjGetElementsM(interp, listPtr, &objc, &objv)
+		!= TCL_OK) {
+	    ReleaseListNode(rootPtr);
+	    return TCL_ERROR;
+	}
+	if (NodeLength(rootPtr) > (size_t) (LIST_MAX - objc)) {
+	    if (interp != NULL) {
+		Tcl_SetObjResult(interp, Tcl_ObjPrintf(
+			"max length of a Tcl list (%d elements) exceeded",
+			LIST_MAX));
+	    }
+	    ReleaseListNode(rootPtr);
+	    return TCL_ERROR;
+	}
+	if (ListIsTree(listPtr)) {
+	    leftPtr = ListTreeRoot(listPtr);
+	    listPtr->internalRep.twoPtrValue.ptr1 = NULL;
+	} else if (objc >= LIST_TREE_MIN) {
+	    leftPtr = NewSpan(ListRepPtr(listPtr), 0, objc);
+	} else {
+	    leftPtr = BuildTree(objc, objv);
+	}
+	ListTreeSetRoot(listPtr, JoinTrees(leftPtr, rootPtr));
+	return TCL_OK;
+    }
+
     /*
      * Pull the elements to append from elemListPtr.
      */
@@ -658,6 +1649,9 @@ Tcl_ListObjAppendElement(
     if (Tcl_IsShared(listPtr)) {
 	Tcl_Panic("%s called with shared object", "Tcl_ListObjAppendElement");
     }
+    if (ListIsTree(listPtr)) {
+	return ListTreeReplace(interp, listPtr, LIST_MAX, 0, 1, &objPtr);
+    }
 
     ListGetIntRep(listPtr, listRepPtr);
     if (listRepPtr == NULL) {
@@ -681,6 +1675,11 @@ Tcl_ListObjAppendElement(
     needGrow = (numRequired > listRepPtr->maxElemCount);
     isShared = (listRepPtr->refCount > 1);
 
+    if (isShared && numElems >= LIST_TREE_MIN) {
+	ListConvertToTree(listPtr, listRepPtr);
+	return ListTreeReplace(interp, listPtr, LIST_MAX, 0, 1, &objPtr);
+    }
+
     if (numRequired > LIST_MAX) {
 	if (interp != NULL) {
 	    Tcl_SetObjResult(interp, Tcl_ObjPrintf(
@@ -767,6 +1766,8 @@ Tcl_ListObjAppendElement(
 	     */
 
 	    memcpy(dst, src, numElems * sizeof(Tcl_Obj *));
+	    newPtr->searchCount = listRepPtr->searchCount;
+	    newPtr->indexPtr = listRepPtr->indexPtr;
 	    Tcl_Free(listRepPtr);
 	}
 	listRepPtr = newPtr;
@@ -786,6 +1787,16 @@ Tcl_ListObjAppendElement(
     Tcl_IncrRefCount(objPtr);
     listRepPtr->elemCount++;
 
+    /*
+     * Appending leaves the first occurrence of every other element where it
+     * was, so an index of the list can be kept up to date instead of being
+     * discarded. This keeps [if {$x ni $l} {lappend l $x}] fast.
+     */
+
+    if (listRepPtr->indexPtr) {
+	ListIndexAdd(listRepPtr, listRepPtr->elemCount - 1);
+    }
+
     /*
      * Invalidate any old string representation since the list's internal
      * representation has changed.
@@ -834,6 +1845,17 @@ Tcl_ListObjIndex(
 {
     List *listRepPtr;
 
+    if (ListIsTree(listPtr)) {
+	ListNode *rootPtr = ListTreeRoot(listPtr);
+
+	if ((index < 0) || ((size_t) index >= NodeLength(rootPtr))) {
+	    *objPtrPtr = NULL;
+	} else {
+	    *objPtrPtr = TreeIndex(rootPtr, index);
+	}
+	return TCL_OK;
+    }
+
     ListGetIntRep(listPtr, listRepPtr);
     if (listRepPtr == NULL) {
 	int result;
@@ -891,6 +1913,11 @@ Tcl_ListObjLength(
 {
     List *listRepPtr;
 
+    if (ListIsTree(listPtr)) {
+	*intPtr = (int) NodeLength(ListTreeRoot(listPtr));
+	return TCL_OK;
+    }
+
     ListGetIntRep(listPtr, listRepPtr);
     if (listRepPtr == NULL) {
 	int result;
@@ -968,6 +1995,9 @@ Tcl_ListObjReplace(
     if (Tcl_IsShared(listPtr)) {
 	Tcl_Panic("%s called with shared object", "Tcl_ListObjReplace");
     }
+    if (ListIsTree(listPtr)) {
+	return ListTreeReplace(interp, listPtr, first, count, objc, objv);
+    }
 
     ListGetIntRep(listPtr, listRepPtr);
     if (listRepPtr == NULL) {
@@ -1023,9 +2053,25 @@ Tcl_ListObjReplace(
 	return TCL_ERROR;
     }
     isShared = (listRepPtr->refCount > 1);
+    if (isShared && numElems >= LIST_TREE_MIN) {
+	/*
+	 * Change a tree rather than copy a long list.
+	 */
+
+	ListConvertToTree(listPtr, listRepPtr);
+	return ListTreeReplace(interp, listPtr, first, count, objc, objv);
+    }
     numRequired = numElems - count + objc; /* Known <= LIST_MAX */
     needGrow = numRequired > listRepPtr->maxElemCount;
 
+    /*
+     * Only appending leaves an index of the list valid.
+     */
+
+    if (!isShared && (count > 0 || first < numElems)) {
+	TclListDiscardIndex(listRepPtr);
+    }
+
     for (i = 0;  i < objc;  i++) {
 	Tcl_IncrRefCount(objv[i]);
     }
@@ -1173,6 +2219,8 @@ Tcl_ListObjReplace(
 			(size_t) numAfterLast * sizeof(Tcl_Obj *));
 	    }
 
+	    listRepPtr->searchCount = oldListRepPtr->searchCount;
+	    listRepPtr->indexPtr = oldListRepPtr->indexPtr;
 	    Tcl_Free(oldListRepPtr);
 	}
     }
@@ -1190,6 +2238,11 @@ Tcl_ListObjReplace(
      */
 
     listRepPtr->elemCount = numRequired;
+    if (listRepPtr->indexPtr) {
+	for (j=first ; j<numRequired ; j++) {
+	    ListIndexAdd(listRepPtr, j);
+	}
+    }
 
     /*
      * Invalidate and free any old representations that may not agree
@@ -1235,8 +2288,9 @@ TclLindexList(
 {
 
     size_t index;			/* Index into the list. */
-    Tcl_Obj *indexListCopy;
+    Tcl_Obj *indexListCopy, **indices;
     List *listRepPtr;
+    int indexCount;
 
     /*
      * Determine whether argPtr designates a list or a single index. We have
@@ -1276,12 +2330,8 @@ TclLindexList(
 	return TclLindexFlat(interp, listPtr, 1, &argPtr);
     }
 
-    ListGetIntRep(indexListCopy, listRepPtr);
-
-    assert(listRepPtr != NULL);
-
-    listPtr = TclLindexFlat(interp, listPtr, listRepPtr->elemCount,
-		&listRepPtr->elements);
+    TclListObjGetElementsM(NULL, indexListCopy, &indexCount, &indices);
+    listPtr = TclLindexFlat(interp, listPtr, indexCount, indices);
     Tcl_DecrRefCount(indexListCopy);
     return listPtr;
 }
@@ -1341,7 +2391,11 @@ TclLindexFlat(
 
 	    break;
 	}
-	TclListObjGetElementsM(NULL, sublistCopy, &listLen, &elemPtrs);
+	if (ListIsTree(sublistCopy)) {
+	    listLen = (int) NodeLength(ListTreeRoot(sublistCopy));
+	} else {
+	    TclListObjGetElementsM(NULL, sublistCopy, &listLen, &elemPtrs);
+	}
 
 	if (TclGetIntForIndexM(interp, indexArray[i], /*endValue*/ listLen-1,
 		&index) == TCL_OK) {
@@ -1364,7 +2418,8 @@ TclLindexFlat(
 		 * Extract the pointer to the appropriate element.
 		 */
 
-		listPtr = elemPtrs[index];
+		listPtr = elemPtrs ? elemPtrs[index]
+			: TreeIndex(ListTreeRoot(sublistCopy), index);
 	    }
 	    Tcl_IncrRefCount(listPtr);
 	}
@@ -1528,10 +2583,15 @@ TclLsetFlat(
      * the delayed invalidation of string reps of modified Tcl_Obj's
      * implemented below, the outcome is that any error condition that causes
      * this routine to return NULL, will leave the string rep of listPtr and
-     * all elements to be unchanged.
+     * all elements to be unchanged. The copy shares the List of a long list,
+     * and so becomes a tree when it is changed below.
      */
 
-    subListPtr = Tcl_IsShared(listPtr) ? Tcl_DuplicateObj(listPtr) : listPtr;
+    if (Tcl_IsShared(listPtr)) {
+	subListPtr = Tcl_DuplicateObj(listPtr);
+    } else {
+	subListPtr = listPtr;
+    }
 
     /*
      * Anchor the linked list of Tcl_Obj's whose string reps must be
@@ -1549,14 +2609,13 @@ TclLsetFlat(
 
     do {
 	int elemCount;
-	Tcl_Obj *parentList, **elemPtrs;
+	Tcl_Obj *parentList;
 
 	/*
 	 * Check for the possible error conditions...
 	 */
 
-	if (TclListObjGetElementsM(interp, subListPtr, &elemCount, &elemPtrs)
-		!= TCL_OK) {
+	if (TclListObjLengthM(interp, subListPtr, &elemCount) != TCL_OK) {
 	    /* ...the sublist we're indexing into isn't a list at all. */
 	    result = TCL_ERROR;
 	    break;
@@ -1601,7 +2660,7 @@ TclLsetFlat(
 	    if (index == (size_t)elemCount) {
 		TclNewObj(subListPtr);
 	    } else {
-		subListPtr = elemPtrs[index];
+		Tcl_ListObjIndex(NULL, parentList, index, &subListPtr);
 	    }
 	    if (Tcl_IsShared(subListPtr)) {
 		subListPtr = Tcl_DuplicateObj(subListPtr);
@@ -1641,6 +2700,9 @@ TclLsetFlat(
 	     */
 
 	    irPtr = TclFetchInternalRep(parentList, &tclListType);
+	    if (irPtr == NULL) {
+		irPtr = TclFetchInternalRep(parentList, &tclListTreeType);
+	    }
 	    irPtr->twoPtrValue.ptr2 = chainPtr;
 	    chainPtr = parentList;
 	}
@@ -1662,6 +2724,15 @@ TclLsetFlat(
 	 */
 
 	irPtr = TclFetchInternalRep(objPtr, &tclListType);
+	if (irPtr == NULL) {
+	    irPtr = TclFetchInternalRep(objPtr, &tclListTreeType);
+	    chainPtr = (Tcl_Obj *)irPtr->twoPtrValue.ptr2;
+	    irPtr->twoPtrValue.ptr2 = NULL;
+	    if (result == TCL_OK) {
+		TclInvalidateStringRep(objPtr);
+	    }
+	    continue;
+	}
 	listRepPtr = (List *)irPtr->twoPtrValue.ptr1;
 	chainPtr = (Tcl_Obj *)irPtr->twoPtrValue.ptr2;
 
@@ -1778,6 +2849,9 @@ TclListObjSetElement(
     if (Tcl_IsShared(listPtr)) {
 	Tcl_Panic("%s called with shared object", "TclListObjSetElement");
     }
+    if (ListIsTree(listPtr)) {
+	return ListTreeSetElement(interp, listPtr, index, valuePtr);
+    }
 
     ListGetIntRep(listPtr, listRepPtr);
     if (listRepPtr == NULL) {
@@ -1818,9 +2892,14 @@ TclListObjSetElement(
     }
 
     /*
-     * If the internal rep is shared, replace it with an unshared copy.
+     * If the internal rep is shared, replace it with an unshared copy, or
+     * with a tree when it is long.
      */
 
+    if (listRepPtr->refCount > 1 && elemCount >= LIST_TREE_MIN) {
+	ListConvertToTree(listPtr, listRepPtr);
+	return ListTreeSetElement(interp, listPtr, index, valuePtr);
+    }
     if (listRepPtr->refCount > 1) {
 	Tcl_Obj **dst, **src = &listRepPtr->elements;
 	List *newPtr = AttemptNewList(NULL, listRepPtr->maxElemCount, NULL);
@@ -1847,6 +2926,7 @@ TclListObjSetElement(
 	ListResetIntRep(listPtr, listRepPtr);
     }
     elemPtrs = &listRepPtr->elements;
+    TclListDiscardIndex(listRepPtr);
 
     /*
      * Add a reference to the new list element.
@@ -1906,15 +2986,7 @@ FreeListInternalRep(
     ListGetIntRep(listPtr, listRepPtr);
     assert(listRepPtr != NULL);
 
-    if (listRepPtr->refCount-- <= 1) {
-	Tcl_Obj **elemPtrs = &listRepPtr->elements;
-	int i, numElems = listRepPtr->elemCount;
-
-	for (i = 0;  i < numElems;  i++) {
-	    Tcl_DecrRefCount(elemPtrs[i]);
-	}
-	Tcl_Free(listRepPtr);
-    }
+    ReleaseList(listRepPtr);
 }
 
 /*
@@ -1975,6 +3047,20 @@ SetListFromAny(
     List *listRepPtr;
     Tcl_Obj **elemPtrs;
 
+    /*
+     * Trees are flattened. A string rep they have may still be the one of the
+     * value they were made from, so it is not taken to be canonical.
+     */
+
+    if (ListIsTree(objPtr)) {
+	listRepPtr = TreeToList(interp, ListTreeRoot(objPtr));
+	if (listRepPtr == NULL) {
+	    return TCL_ERROR;
+	}
+	ListSetIntRep(objPtr, listRepPtr);
+	return TCL_OK;
+    }
+
     /*
      * Dictionaries are a special case; they have a string representation such
      * that *all* valid dictionaries are valid lists. Hence we can convert
@@ -2021,6 +3107,8 @@ SetListFromAny(
 	int estCount;
 	size_t length;
 	const char *limit, *nextElem = Tcl_GetStringFromObj(objPtr, &length);
+	Tcl_Obj **newEnd;		/* End of the element objects created so
+					 * far. */
 
 	/*
 	 * Allocate enough space to hold a (Tcl_Obj *) for each
@@ -2034,7 +3122,7 @@ SetListFromAny(
 	if (listRepPtr == NULL) {
 	    return TCL_ERROR;
 	}
-	elemPtrs = &listRepPtr->elements;
+	elemPtrs = newEnd = &listRepPtr->elements;
 
 	/*
 	 * Each iteration, parse and store a list element.
@@ -2049,9 +3137,8 @@ SetListFromAny(
 	    if (TCL_OK != TclFindElement(interp, nextElem, limit - nextElem,
 		    &elemStart, &nextElem, &elemSize, &literal)) {
 	    fail:
-		while (--elemPtrs >= &listRepPtr->elements) {
-		    Tcl_DecrRefCount(*elemPtrs);
-		}
+		TclDecrRefCounts(newEnd - &listRepPtr->elements,
+			&listRepPtr->elements);
 		Tcl_Free(listRepPtr);
 		return TCL_ERROR;
 	    }
@@ -2059,7 +3146,24 @@ SetListFromAny(
 		break;
 	    }
 
-	    TclNewObj(*elemPtrs);
+	    /*
+	     * Create the element objects a chunk at a time. The estimate
+	     * counts every run of white space as an element boundary, which
+	     * can be many times the real count when elements are braced
+	     * lists themselves, so creating them all up front would waste
+	     * more than it saves.
+	     */
+
+	    if (elemPtrs == newEnd) {
+		int numNew = estCount - (newEnd - &listRepPtr->elements);
+
+		if (numNew > LIST_NEW_OBJS_CHUNK) {
+		    numNew = LIST_NEW_OBJS_CHUNK;
+		}
+		TclNewObjs(numNew, newEnd);
+		newEnd += numNew;
+	    }
+
 	    TclInvalidateStringRep(*elemPtrs);
 	    check = Tcl_InitStringRep(*elemPtrs, literal ? elemStart : NULL,
 		    elemSize);
@@ -2080,6 +3184,7 @@ SetListFromAny(
 	}
 
  	listRepPtr->elemCount = elemPtrs - &listRepPtr->elements;
+	TclDecrRefCounts(newEnd - elemPtrs, elemPtrs);
     }
 
     /*
@@ -2115,21 +3220,12 @@ static void
 UpdateStringOfList(
     Tcl_Obj *listPtr)		/* List object with string rep to update. */
 {
-#   define LOCAL_SIZE 64
-    char localFlags[LOCAL_SIZE], *flagPtr = NULL;
-    int numElems, i;
-    size_t length, bytesNeeded = 0;
-    const char *elem, *start;
-    char *dst;
-    Tcl_Obj **elemPtrs;
     List *listRepPtr;
 
     ListGetIntRep(listPtr, listRepPtr);
 
     assert(listRepPtr != NULL);
 
-    numElems = listRepPtr->elemCount;
-
     /*
      * Mark the list as being canonical; although it will now have a string
      * rep, it is one we derived through proper "canonical" quoting and so
@@ -2138,6 +3234,34 @@ UpdateStringOfList(
 
     listRepPtr->canonicalFlag = 1;
 
+    ListElementsToString(listPtr, listRepPtr->elemCount,
+	    &listRepPtr->elements);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * ListElementsToString --
+ *
+ *	Sets the string representation of a list object from its elements,
+ *	quoting them as needed.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+ListElementsToString(
+    Tcl_Obj *listPtr,		/* List object with string rep to update. */
+    int numElems,		/* Number of elements. */
+    Tcl_Obj *const elemPtrs[])	/* The elements. */
+{
+#   define LOCAL_SIZE 64
+    char localFlags[LOCAL_SIZE], *flagPtr = NULL;
+    int i;
+    size_t length, bytesNeeded = 0;
+    const char *elem, *start;
+    char *dst;
+
     /*
      * Handle empty list case first, so rest of the routine is simpler.
      */
@@ -2160,7 +3284,6 @@ UpdateStringOfList(
 
 	flagPtr = (char *)Tcl_Alloc(numElems);
     }
-    elemPtrs = &listRepPtr->elements;
     for (i = 0; i < numElems; i++) {
 	flagPtr[i] = (i ? TCL_DONT_QUOTE_HASH : 0);
 	elem = Tcl_GetStringFromObj(elemPtrs[i], &length);
@@ -2189,6 +3312,57 @@ UpdateStringOfList(
     }
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * FreeListTreeInternalRep, DupListTreeInternalRep --
+ *
+ *	Release and share the tree of a list held as one.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+FreeListTreeInternalRep(
+    Tcl_Obj *listPtr)		/* List object with internal rep to free. */
+{
+    ReleaseListNode(ListTreeRoot(listPtr));
+}
+
+static void
+DupListTreeInternalRep(
+    Tcl_Obj *srcPtr,		/* Object with internal rep to copy. */
+    Tcl_Obj *copyPtr)		/* Object with internal rep to set. */
+{
+    ListNode *rootPtr = ListTreeRoot(srcPtr);
+
+    rootPtr->refCount++;
+    ListTreeSetIntRep(copyPtr, rootPtr);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * UpdateStringOfListTree --
+ *
+ *	Update the string representation for a list object held as a tree.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+UpdateStringOfListTree(
+    Tcl_Obj *listPtr)		/* List object with string rep to update. */
+{
+    ListNode *rootPtr = ListTreeRoot(listPtr);
+    int numElems = (int) NodeLength(rootPtr);
+    Tcl_Obj **elemPtrs = (Tcl_Obj **)Tcl_Alloc(numElems * sizeof(Tcl_Obj *));
+
+    TreeFlatten(rootPtr, elemPtrs);
+    ListElementsToString(listPtr, numElems, elemPtrs);
+    Tcl_Free(elemPtrs);
+}
+
 /*
  * Local Variables:
  * mode: c
@@ -586,6 +586,46 @@ TclHideLiteral(
     }
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclGetLiteralFlags --
+ *
+ *	Finds out how a literal object is shared through the interpreter's
+ *	global literal table, so that it can be registered again in the same
+ *	way by TclRegisterLiteral.
+ *
+ * Results:
+ *	-1 if the object is not in the global literal table (it is unshared
+ *	or hidden), LITERAL_CMD_NAME if it is shared as a command name, and 0
+ *	if it is shared as any other literal.
+ *
+ * Side effects:
+ *	None.
+ *
+ *----------------------------------------------------------------------
+ */
+
+int
+TclGetLiteralFlags(
+    Interp *iPtr,		/* Interpreter owning the literal table. */
+    Tcl_Obj *objPtr)		/* A literal of a CompileEnv or ByteCode. */
+{
+    LiteralTable *globalTablePtr = &iPtr->literalTable;
+    LiteralEntry *entryPtr;
+    size_t length;
+    const char *bytes = Tcl_GetStringFromObj(objPtr, &length);
+
+    for (entryPtr = globalTablePtr->buckets[
+	    HashString(bytes, length) & globalTablePtr->mask];
+	    entryPtr != NULL; entryPtr = entryPtr->nextPtr) {
+	if (entryPtr->objPtr == objPtr) {
+	    return (entryPtr->nsPtr != NULL) ? LITERAL_CMD_NAME : 0;
+	}
+    }
+    return -1;
+}
+
 /*
  *----------------------------------------------------------------------
  *
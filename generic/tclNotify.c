@@ -48,10 +48,14 @@ typedef struct EventSource {
  * behind all other high-priority events already in the queue (this is used
  * for things like a sequence of Enter and Leave events generated during a
  * grab in Tk). These elements are protected by the queueMutex so that any
- * thread can queue an event on any notifier. Note that all of the values in
- * this structure will be initialized to 0.
+ * thread can queue an event on any notifier. Events that other threads add
+ * at the tail are first pushed on the incomingPtr list without taking the
+ * queueMutex, and are moved to the queue in batches by the owning thread.
+ * Note that all of the values in this structure will be initialized to 0.
  */
 
+#define BATCH_BUCKETS	16
+
 typedef struct ThreadSpecificData {
     Tcl_Event *firstEventPtr;	/* First pending event, or NULL if none. */
     Tcl_Event *lastEventPtr;	/* Last pending event, or NULL if none. */
@@ -59,6 +63,12 @@ typedef struct ThreadSpecificData {
 				 * if none. */
     Tcl_Mutex queueMutex;	/* Mutex to protect access to the previous
 				 * three fields. */
+    Tcl_Event *incomingPtr;	/* Events queued at the tail by other threads
+				 * and not yet moved to the queue, most recent
+				 * first. Only accessed atomically. */
+    int alertPending;		/* 1 if the notifier has been alerted since
+				 * the owning thread last looked for events.
+				 * Only accessed atomically. */
     int serviceMode;		/* One of TCL_SERVICE_NONE or
 				 * TCL_SERVICE_ALL. */
     int blockTimeSet;		/* 0 means there is no maximum block time:
@@ -74,6 +84,22 @@ typedef struct ThreadSpecificData {
     ClientData clientData;	/* Opaque handle for platform specific
 				 * notifier. */
     int initialized;		/* 1 if notifier has been initialized. */
+    int batchEvents;		/* Maximum number of queued events serviced
+				 * by one call of Tcl_DoOneEvent. Values below
+				 * 2 service one event per call. */
+    long long batchTime;	/* If > 0, maximum time in microseconds spent
+				 * servicing a batch of events. */
+    int batchCut;		/* 1 if the last batch was cut short by one of
+				 * the limits above, so that event sources are
+				 * polled before servicing the next. */
+    Tcl_WideInt numBatches;	/* Number of calls of Tcl_DoOneEvent that
+				 * serviced queued events. */
+    Tcl_WideInt numBatchEvents;	/* Number of queued events they serviced. */
+    int maxBatch;		/* Largest number of events serviced by one of
+				 * them. */
+    Tcl_WideInt batchSizes[BATCH_BUCKETS];
+				/* Number of those calls by count of events
+				 * serviced: 1, 2-3, 4-7 and so on. */
     struct ThreadSpecificData *nextPtr;
 				/* Next notifier in global list of notifiers.
 				 * Access is controlled by the listLock global
@@ -95,8 +121,17 @@ TCL_DECLARE_MUTEX(listLock)
  * Declarations for routines used only in this file.
  */
 
+static void		ClearAlertPending(ThreadSpecificData *tsdPtr);
+static void		MoveIncomingEvents(ThreadSpecificData *tsdPtr);
+static void		PollEventSources(ThreadSpecificData *tsdPtr,
+			    int flags);
+static void		PushIncomingEvent(ThreadSpecificData *tsdPtr,
+			    Tcl_Event *evPtr);
 static void		QueueEvent(ThreadSpecificData *tsdPtr,
 			    Tcl_Event *evPtr, Tcl_QueuePosition position);
+static void		ServiceBatch(ThreadSpecificData *tsdPtr, int flags);
+static int		SetAlertPending(ThreadSpecificData *tsdPtr);
+static Tcl_Event *	TakeIncomingEvents(ThreadSpecificData *tsdPtr);
 
 /*
  *----------------------------------------------------------------------
@@ -191,8 +226,6 @@ TclFinalizeNotifier(void)
 
     Tcl_MutexLock(&listLock);
 
-    Tcl_FinalizeNotifier(tsdPtr->clientData);
-    Tcl_MutexFinalize(&(tsdPtr->queueMutex));
     for (prevPtrPtr = &firstNotifierPtr; *prevPtrPtr != NULL;
 	    prevPtrPtr = &((*prevPtrPtr)->nextPtr)) {
 	if (*prevPtrPtr == tsdPtr) {
@@ -200,6 +233,19 @@ TclFinalizeNotifier(void)
 	    break;
 	}
     }
+
+    /*
+     * Other threads push events only while holding the listLock, so once
+     * the notifier is unlinked nothing can be added to the incoming list.
+     */
+
+    for (evPtr = TakeIncomingEvents(tsdPtr); evPtr != NULL; ) {
+	hold = evPtr;
+	evPtr = evPtr->nextPtr;
+	Tcl_Free(hold);
+    }
+    Tcl_FinalizeNotifier(tsdPtr->clientData);
+    Tcl_MutexFinalize(&(tsdPtr->queueMutex));
     tsdPtr->initialized = 0;
 
     Tcl_MutexUnlock(&listLock);
@@ -397,6 +443,9 @@ Tcl_QueueEvent(
 {
     ThreadSpecificData *tsdPtr = TCL_TSD_INIT(&dataKey);
 
+    if (position == TCL_QUEUE_TAIL) {
+	MoveIncomingEvents(tsdPtr);
+    }
     QueueEvent(tsdPtr, evPtr, position);
 }
 
@@ -441,10 +490,20 @@ Tcl_ThreadQueueEvent(
 
     /*
      * Queue the event if there was a notifier associated with the thread.
+     * Events for the tail of another thread's queue are pushed on its
+     * incoming list, so that posting threads do not contend for the queue
+     * with each other or with the owner servicing it.
      */
 
     if (tsdPtr) {
-	QueueEvent(tsdPtr, evPtr, position);
+	if (position != TCL_QUEUE_TAIL) {
+	    QueueEvent(tsdPtr, evPtr, position);
+	} else if (threadId != Tcl_GetCurrentThread()) {
+	    PushIncomingEvent(tsdPtr, evPtr);
+	} else {
+	    MoveIncomingEvents(tsdPtr);
+	    QueueEvent(tsdPtr, evPtr, position);
+	}
     } else {
 	Tcl_Free(evPtr);
     }
@@ -528,6 +587,201 @@ QueueEvent(
     Tcl_MutexUnlock(&(tsdPtr->queueMutex));
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * PushIncomingEvent, TakeIncomingEvents --
+ *
+ *	Push an event queued at the tail by another thread on the incoming
+ *	list of a notifier, and take the whole list on behalf of the owner.
+ *	The list is only ever pushed to or taken as a whole, so compare-and-
+ *	swap needs no protection against reuse of the head; without atomic
+ *	operations the queueMutex is used instead.
+ *
+ * Results:
+ *	TakeIncomingEvents returns the events taken, most recent first.
+ *
+ * Side effects:
+ *	None.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+PushIncomingEvent(
+    ThreadSpecificData *tsdPtr,
+    Tcl_Event *evPtr)
+{
+#if defined(__GNUC__)
+    Tcl_Event *firstPtr = __atomic_load_n(&tsdPtr->incomingPtr,
+	    __ATOMIC_RELAXED);
+
+    do {
+	evPtr->nextPtr = firstPtr;
+    } while (!__atomic_compare_exchange_n(&tsdPtr->incomingPtr, &firstPtr,
+	    evPtr, 1, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+#elif defined(_WIN32)
+    Tcl_Event *firstPtr;
+
+    do {
+	firstPtr = *(Tcl_Event *volatile *) &tsdPtr->incomingPtr;
+	evPtr->nextPtr = firstPtr;
+    } while (InterlockedCompareExchangePointer(
+	    (PVOID volatile *) &tsdPtr->incomingPtr, evPtr, firstPtr)
+	    != firstPtr);
+#else
+    Tcl_MutexLock(&(tsdPtr->queueMutex));
+    evPtr->nextPtr = tsdPtr->incomingPtr;
+    tsdPtr->incomingPtr = evPtr;
+    Tcl_MutexUnlock(&(tsdPtr->queueMutex));
+#endif
+}
+
+static Tcl_Event *
+TakeIncomingEvents(
+    ThreadSpecificData *tsdPtr)
+{
+    Tcl_Event *firstPtr;
+
+#if defined(__GNUC__)
+    if (__atomic_load_n(&tsdPtr->incomingPtr, __ATOMIC_SEQ_CST) == NULL) {
+	return NULL;
+    }
+    firstPtr = __atomic_exchange_n(&tsdPtr->incomingPtr, NULL,
+	    __ATOMIC_SEQ_CST);
+#elif defined(_WIN32)
+    if (*(Tcl_Event *volatile *) &tsdPtr->incomingPtr == NULL) {
+	return NULL;
+    }
+    firstPtr = (Tcl_Event *) InterlockedExchangePointer(
+	    (PVOID volatile *) &tsdPtr->incomingPtr, NULL);
+#else
+    Tcl_MutexLock(&(tsdPtr->queueMutex));
+    firstPtr = tsdPtr->incomingPtr;
+    tsdPtr->incomingPtr = NULL;
+    Tcl_MutexUnlock(&(tsdPtr->queueMutex));
+#endif
+    return firstPtr;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * MoveIncomingEvents --
+ *
+ *	Move the events other threads have queued at the tail since the last
+ *	call to the end of the queue of the current thread, in the order they
+ *	were queued. Must only be called by the thread owning the notifier.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	Clears the pending alert of the notifier, so that the next thread
+ *	queueing an event wakes the notifier up again.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+MoveIncomingEvents(
+    ThreadSpecificData *tsdPtr)
+{
+    Tcl_Event *evPtr, *firstPtr, *lastPtr;
+
+    /*
+     * The alert must be cleared before looking at the list: an event pushed
+     * after the list has been taken then always comes with a new alert.
+     */
+
+    ClearAlertPending(tsdPtr);
+    evPtr = TakeIncomingEvents(tsdPtr);
+    if (evPtr == NULL) {
+	return;
+    }
+
+    /*
+     * Reverse the list into first-in-first-out order and append it to the
+     * queue as a whole.
+     */
+
+    firstPtr = NULL;
+    lastPtr = evPtr;
+    while (evPtr != NULL) {
+	Tcl_Event *nextPtr = evPtr->nextPtr;
+
+	evPtr->nextPtr = firstPtr;
+	firstPtr = evPtr;
+	evPtr = nextPtr;
+    }
+
+    Tcl_MutexLock(&(tsdPtr->queueMutex));
+    if (tsdPtr->firstEventPtr == NULL) {
+	tsdPtr->firstEventPtr = firstPtr;
+    } else {
+	tsdPtr->lastEventPtr->nextPtr = firstPtr;
+    }
+    tsdPtr->lastEventPtr = lastPtr;
+    Tcl_MutexUnlock(&(tsdPtr->queueMutex));
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * SetAlertPending, ClearAlertPending --
+ *
+ *	Mark the notifier of a thread as alerted, and clear that mark on
+ *	behalf of its owner when it is about to look for events again.
+ *
+ * Results:
+ *	SetAlertPending returns 1 if the notifier was already marked, in which
+ *	case it need not be alerted again.
+ *
+ * Side effects:
+ *	None.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+SetAlertPending(
+    ThreadSpecificData *tsdPtr)
+{
+#if defined(__GNUC__)
+    return __atomic_exchange_n(&tsdPtr->alertPending, 1, __ATOMIC_SEQ_CST);
+#elif defined(_WIN32)
+    return (int) InterlockedExchange(
+	    (LONG volatile *) &tsdPtr->alertPending, 1);
+#else
+    int pending;
+
+    Tcl_MutexLock(&(tsdPtr->queueMutex));
+    pending = tsdPtr->alertPending;
+    tsdPtr->alertPending = 1;
+    Tcl_MutexUnlock(&(tsdPtr->queueMutex));
+    return pending;
+#endif
+}
+
+static void
+ClearAlertPending(
+    ThreadSpecificData *tsdPtr)
+{
+#if defined(__GNUC__)
+    if (__atomic_load_n(&tsdPtr->alertPending, __ATOMIC_RELAXED)) {
+	__atomic_store_n(&tsdPtr->alertPending, 0, __ATOMIC_SEQ_CST);
+    }
+#elif defined(_WIN32)
+    if (*(int volatile *) &tsdPtr->alertPending) {
+	InterlockedExchange((LONG volatile *) &tsdPtr->alertPending, 0);
+    }
+#else
+    Tcl_MutexLock(&(tsdPtr->queueMutex));
+    tsdPtr->alertPending = 0;
+    Tcl_MutexUnlock(&(tsdPtr->queueMutex));
+#endif
+}
+
 /*
  *----------------------------------------------------------------------
  *
@@ -559,6 +813,7 @@ Tcl_DeleteEvents(
     Tcl_Event *hold;
     ThreadSpecificData *tsdPtr = TCL_TSD_INIT(&dataKey);
 
+    MoveIncomingEvents(tsdPtr);
     Tcl_MutexLock(&(tsdPtr->queueMutex));
 
     /*
@@ -665,9 +920,11 @@ Tcl_ServiceEvent(
 
     /*
      * Loop through all the events in the queue until we find one that can
-     * actually be handled.
+     * actually be handled, after adding those other threads queued since
+     * the last time.
      */
 
+    MoveIncomingEvents(tsdPtr);
     Tcl_MutexLock(&(tsdPtr->queueMutex));
     for (evPtr = tsdPtr->firstEventPtr; evPtr != NULL;
 	    evPtr = evPtr->nextPtr) {
@@ -930,12 +1187,24 @@ Tcl_DoOneEvent(
 	    goto idleEvents;
 	}
 
+	/*
+	 * If the previous batch left events in the queue, give the event
+	 * sources a chance to queue theirs behind them, so that a busy
+	 * source cannot keep timers or other sources waiting.
+	 */
+
+	if (tsdPtr->batchCut) {
+	    tsdPtr->batchCut = 0;
+	    PollEventSources(tsdPtr, flags);
+	}
+
 	/*
 	 * Ask Tcl to service a queued event, if there are any.
 	 */
 
 	if (Tcl_ServiceEvent(flags)) {
 	    result = 1;
+	    ServiceBatch(tsdPtr, flags);
 	    break;
 	}
 
@@ -1000,6 +1269,7 @@ Tcl_DoOneEvent(
 
 	if (Tcl_ServiceEvent(flags)) {
 	    result = 1;
+	    ServiceBatch(tsdPtr, flags);
 	    break;
 	}
 
@@ -1042,6 +1312,240 @@ Tcl_DoOneEvent(
     return result;
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * ServiceBatch --
+ *
+ *	Called by Tcl_DoOneEvent once it has serviced a queued event, to
+ *	service further queued events up to the limits set with the
+ *	"::tcl::unsupported::eventbatch" command, and to record the number of
+ *	events serviced.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	Invokes the handlers of queued events. If the batch is cut short by a
+ *	limit, idle handlers are invoked too (if requested by flags), as they
+ *	would otherwise not run until the queue empties.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+ServiceBatch(
+    ThreadSpecificData *tsdPtr,	/* Notifier of the current thread. */
+    int flags)			/* Flags passed to Tcl_DoOneEvent. */
+{
+    int numEvents = 1, bucket;
+    long long deadline = 0;
+
+    if (tsdPtr->batchEvents > 1) {
+	if (tsdPtr->batchTime > 0) {
+	    deadline = TclpGetMicroseconds() + tsdPtr->batchTime;
+	}
+	while (1) {
+	    if (numEvents >= tsdPtr->batchEvents
+		    || (deadline && TclpGetMicroseconds() >= deadline)) {
+		tsdPtr->batchCut = 1;
+		if (flags & TCL_IDLE_EVENTS) {
+		    TclServiceIdle();
+		}
+		break;
+	    }
+	    if (!Tcl_ServiceEvent(flags)) {
+		break;
+	    }
+	    numEvents++;
+	}
+    }
+
+    tsdPtr->numBatches++;
+    tsdPtr->numBatchEvents += numEvents;
+    if (numEvents > tsdPtr->maxBatch) {
+	tsdPtr->maxBatch = numEvents;
+    }
+    for (bucket = 0; bucket < BATCH_BUCKETS - 1 && (numEvents >> (bucket + 1));
+	    bucket++) {
+	/* Empty loop body. */
+    }
+    tsdPtr->batchSizes[bucket]++;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * PollEventSources --
+ *
+ *	Run the setup and check procedures of all event sources and poll the
+ *	notifier without blocking, as Tcl_DoOneEvent does when the queue is
+ *	empty.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	Events that are ready are added to the queue.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+PollEventSources(
+    ThreadSpecificData *tsdPtr,	/* Notifier of the current thread. */
+    int flags)			/* Flags passed to Tcl_DoOneEvent. */
+{
+    EventSource *sourcePtr;
+
+    tsdPtr->blockTime.sec = 0;
+    tsdPtr->blockTime.usec = 0;
+    tsdPtr->blockTimeSet = 1;
+
+    tsdPtr->inTraversal = 1;
+    for (sourcePtr = tsdPtr->firstEventSourcePtr; sourcePtr != NULL;
+	    sourcePtr = sourcePtr->nextPtr) {
+	if (sourcePtr->setupProc) {
+	    sourcePtr->setupProc(sourcePtr->clientData, flags);
+	}
+    }
+    tsdPtr->inTraversal = 0;
+
+    (void) Tcl_WaitForEvent(&tsdPtr->blockTime);
+
+    for (sourcePtr = tsdPtr->firstEventSourcePtr; sourcePtr != NULL;
+	    sourcePtr = sourcePtr->nextPtr) {
+	if (sourcePtr->checkProc) {
+	    sourcePtr->checkProc(sourcePtr->clientData, flags);
+	}
+    }
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclEventBatchObjCmd --
+ *
+ *	Implementation of the "::tcl::unsupported::eventbatch" command, which
+ *	controls how many queued events one call of Tcl_DoOneEvent services
+ *	in the current thread, and reports how many it did:
+ *
+ *	    eventbatch limit ?events? ?microseconds?
+ *		Returns the maximum number of events serviced per call and the
+ *		maximum time spent on them (0 for none), or sets them. With a
+ *		limit of 1, the default, events are serviced one at a time.
+ *	    eventbatch stats
+ *		Returns a dictionary with the number of calls that serviced
+ *		queued events, the events serviced, the most serviced by one
+ *		call, and a histogram of calls by events serviced (1, 2-3,
+ *		4-7 and so on).
+ *	    eventbatch reset
+ *		Resets the statistics.
+ *
+ *	Servicing several events per call means that [vwait] and similar
+ *	loops only look at their condition after a whole batch.
+ *
+ *----------------------------------------------------------------------
+ */
+
+int
+TclEventBatchObjCmd(
+    TCL_UNUSED(void *),
+    Tcl_Interp *interp,		/* Current interpreter. */
+    int objc,			/* Number of arguments. */
+    Tcl_Obj *const objv[])	/* Argument objects. */
+{
+    static const char *const options[] = {
+	"limit", "reset", "stats", NULL
+    };
+    enum Options {
+	BATCH_LIMIT, BATCH_RESET, BATCH_STATS
+    } idx;
+    ThreadSpecificData *tsdPtr = TCL_TSD_INIT(&dataKey);
+    Tcl_Obj *resultPtr, *sizesPtr;
+    Tcl_WideInt events, usec;
+    int i, last;
+
+    if (objc < 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "option ?arg ...?");
+	return TCL_ERROR;
+    }
+    if (Tcl_GetIndexFromObj(interp, objv[1], options, "option", 0,
+	    &idx) != TCL_OK) {
+	return TCL_ERROR;
+    }
+
+    switch (idx) {
+    case BATCH_LIMIT:
+	if (objc > 4) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "?events? ?microseconds?");
+	    return TCL_ERROR;
+	}
+	if (objc > 2) {
+	    if (TclGetWideIntFromObj(interp, objv[2], &events) != TCL_OK) {
+		return TCL_ERROR;
+	    }
+	    usec = tsdPtr->batchTime;
+	    if (objc > 3 && TclGetWideIntFromObj(interp, objv[3],
+		    &usec) != TCL_OK) {
+		return TCL_ERROR;
+	    }
+	    if (events < 1 || events > INT_MAX || usec < 0) {
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(
+			"expected a positive number of events and a "
+			"non-negative time", -1));
+		Tcl_SetErrorCode(interp, "TCL", "VALUE", "EVENTBATCH", NULL);
+		return TCL_ERROR;
+	    }
+	    tsdPtr->batchEvents = (int) events;
+	    tsdPtr->batchTime = usec;
+	}
+	resultPtr = Tcl_NewListObj(0, NULL);
+	Tcl_ListObjAppendElement(NULL, resultPtr, Tcl_NewWideIntObj(
+		tsdPtr->batchEvents > 1 ? tsdPtr->batchEvents : 1));
+	Tcl_ListObjAppendElement(NULL, resultPtr,
+		Tcl_NewWideIntObj(tsdPtr->batchTime));
+	Tcl_SetObjResult(interp, resultPtr);
+	return TCL_OK;
+    case BATCH_RESET:
+	if (objc != 2) {
+	    Tcl_WrongNumArgs(interp, 2, objv, NULL);
+	    return TCL_ERROR;
+	}
+	tsdPtr->numBatches = 0;
+	tsdPtr->numBatchEvents = 0;
+	tsdPtr->maxBatch = 0;
+	memset(tsdPtr->batchSizes, 0, sizeof(tsdPtr->batchSizes));
+	return TCL_OK;
+    case BATCH_STATS:
+	if (objc != 2) {
+	    Tcl_WrongNumArgs(interp, 2, objv, NULL);
+	    return TCL_ERROR;
+	}
+	for (last = BATCH_BUCKETS; last > 0 && !tsdPtr->batchSizes[last - 1];
+		last--) {
+	    /* Empty loop body. */
+	}
+	sizesPtr = Tcl_NewListObj(0, NULL);
+	for (i = 0; i < last; i++) {
+	    Tcl_ListObjAppendElement(NULL, sizesPtr,
+		    Tcl_NewWideIntObj(tsdPtr->batchSizes[i]));
+	}
+	TclNewObj(resultPtr);
+	Tcl_DictObjPut(NULL, resultPtr, Tcl_NewStringObj("iterations", -1),
+		Tcl_NewWideIntObj(tsdPtr->numBatches));
+	Tcl_DictObjPut(NULL, resultPtr, Tcl_NewStringObj("events", -1),
+		Tcl_NewWideIntObj(tsdPtr->numBatchEvents));
+	Tcl_DictObjPut(NULL, resultPtr, Tcl_NewStringObj("max", -1),
+		Tcl_NewWideIntObj(tsdPtr->maxBatch));
+	Tcl_DictObjPut(NULL, resultPtr, Tcl_NewStringObj("histogram", -1),
+		sizesPtr);
+	Tcl_SetObjResult(interp, resultPtr);
+	return TCL_OK;
+    }
+    return TCL_OK;
+}
+
 /*
  *----------------------------------------------------------------------
  *
@@ -1069,6 +1573,12 @@ Tcl_ServiceAll(void)
     EventSource *sourcePtr;
     ThreadSpecificData *tsdPtr = TCL_TSD_INIT(&dataKey);
 
+    /*
+     * This is typically called because the notifier was alerted from a
+     * foreign event loop; accept further alerts even if nothing is serviced.
+     */
+
+    ClearAlertPending(tsdPtr);
     if (tsdPtr->serviceMode == TCL_SERVICE_NONE) {
 	return result;
     }
@@ -1154,12 +1664,17 @@ Tcl_ThreadAlert(
      * Find the notifier associated with the specified thread. Note that we
      * need to hold the listLock while calling Tcl_AlertNotifier to avoid a
      * race condition where the specified thread might destroy its notifier.
+     * A notifier that was already alerted and has not yet looked for events
+     * since is not alerted again, so that a burst of events queued from
+     * other threads costs a single wakeup.
      */
 
     Tcl_MutexLock(&listLock);
     for (tsdPtr = firstNotifierPtr; tsdPtr; tsdPtr = tsdPtr->nextPtr) {
 	if (tsdPtr->threadId == threadId) {
-	    Tcl_AlertNotifier(tsdPtr->clientData);
+	    if (!SetAlertPending(tsdPtr)) {
+		Tcl_AlertNotifier(tsdPtr->clientData);
+	    }
 	    break;
 	}
     }
@@ -1337,6 +1852,14 @@ int
 Tcl_WaitForEvent(
     const Tcl_Time *timePtr)		/* Maximum block time, or NULL. */
 {
+    ThreadSpecificData *tsdPtr = TCL_TSD_INIT(&dataKey);
+
+    /*
+     * Any alert from now on must wake us up, or an event queued by another
+     * thread while we block could go unnoticed.
+     */
+
+    ClearAlertPending(tsdPtr);
     if (tclNotifierHooks.waitForEventProc) {
 	return tclNotifierHooks.waitForEventProc(timePtr);
     } else {
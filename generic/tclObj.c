@@ -1171,6 +1171,52 @@ Tcl_DbNewObj(
 }
 #endif /* TCL_MEM_DEBUG */
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclNewObjs --
+ *
+ *	Create a number of new objects at once, as TclNewObj does for one.
+ *	With the threaded allocator, the storage for all of them is taken
+ *	from the thread's cache in one operation.
+ *
+ * Results:
+ *	The new objects, with zero reference counts and empty string
+ *	representations, are stored in objv.
+ *
+ * Side effects:
+ *	If compiling with TCL_COMPILE_STATS, this function increments the
+ *	global count of allocated objects (tclObjsAlloced).
+ *
+ *----------------------------------------------------------------------
+ */
+
+void
+TclNewObjs(
+    size_t objc,		/* Number of objects to create. */
+    Tcl_Obj **objv)		/* Where to store the new objects. */
+{
+    size_t i;
+
+#if defined(USE_THREAD_ALLOC)
+    TclThreadAllocObjs(objc, objv);
+    for (i = 0; i < objc; i++) {
+	Tcl_Obj *objPtr = objv[i];
+
+	TclIncrObjsAllocated();
+	objPtr->refCount = 0;
+	objPtr->bytes = &tclEmptyString;
+	objPtr->length = 0;
+	objPtr->typePtr = NULL;
+	TCL_DTRACE_OBJ_CREATE(objPtr);
+    }
+#else
+    for (i = 0; i < objc; i++) {
+	TclNewObj(objv[i]);
+    }
+#endif
+}
+
 /*
  *----------------------------------------------------------------------
  *
@@ -1465,6 +1511,74 @@ TclFreeObj(
 }
 #endif /* TCL_MEM_DEBUG */
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclDecrRefCounts --
+ *
+ *	Decrement the reference count of a number of objects at once, as
+ *	Tcl_DecrRefCount does for one. With the threaded allocator, the
+ *	storage of the objects that need no internal representation freed is
+ *	given back to the thread's cache in one operation.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	Objects whose reference count drops to zero are freed.
+ *
+ *----------------------------------------------------------------------
+ */
+
+void
+TclDecrRefCounts(
+    size_t objc,		/* Number of objects. */
+    Tcl_Obj *const *objv)	/* The objects to release. */
+{
+    size_t i;
+#if defined(USE_THREAD_ALLOC)
+    Tcl_Obj *firstPtr = NULL, *lastPtr = NULL;
+    size_t numFree = 0;
+
+    for (i = 0; i < objc; i++) {
+	Tcl_Obj *objPtr = objv[i];
+
+	if (objPtr->refCount-- > 1) {
+	    continue;
+	}
+	if (objPtr->typePtr && objPtr->typePtr->freeIntRepProc) {
+	    TclFreeObj(objPtr);
+	    continue;
+	}
+
+	/*
+	 * Same as the fast path of TclDecrRefCount, but chain the storage
+	 * instead of freeing it.
+	 */
+
+	TCL_DTRACE_OBJ_FREE(objPtr);
+	if (objPtr->bytes && (objPtr->bytes != &tclEmptyString)) {
+	    Tcl_Free(objPtr->bytes);
+	}
+	objPtr->length = TCL_INDEX_NONE;
+	objPtr->internalRep.twoPtrValue.ptr1 = firstPtr;
+	if (firstPtr == NULL) {
+	    lastPtr = objPtr;
+	}
+	firstPtr = objPtr;
+	numFree++;
+	TclIncrObjsFreed();
+    }
+    if (numFree > 0) {
+	TclThreadFreeObjs(firstPtr, lastPtr, numFree);
+    }
+#else
+    for (i = 0; i < objc; i++) {
+	Tcl_DecrRefCount(objv[i]);
+    }
+#endif
+}
+
 /*
  *----------------------------------------------------------------------
  *
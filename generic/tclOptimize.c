@@ -19,6 +19,7 @@
 
 static void		AdvanceJumps(CompileEnv *envPtr);
 static void		ConvertZeroEffectToNOP(CompileEnv *envPtr);
+static void		FuseInstructions(CompileEnv *envPtr);
 static void		LocateTargetAddresses(CompileEnv *envPtr,
 			    Tcl_HashTable *tablePtr);
 static void		TrimUnreachable(CompileEnv *envPtr);
@@ -413,6 +414,83 @@ AdvanceJumps(
     }
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * FuseInstructions --
+ *
+ *	Mark the start of common instruction sequences with superinstructions
+ *	that can run the whole sequence in one dispatch. Only the opcode of
+ *	the leading INST_LOAD_SCALAR1 is replaced; its operand and the rest of
+ *	the sequence stay as they are, so the engine can always fall back to
+ *	executing the sequence instruction by instruction, and jumps into the
+ *	middle of the sequence remain valid.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static void
+FuseInstructions(
+    CompileEnv *envPtr)
+{
+    unsigned char *currentInstPtr, *nextInstPtr;
+
+    for (currentInstPtr = envPtr->codeStart ;
+	    currentInstPtr < envPtr->codeNext ;
+	    currentInstPtr += AddrLength(currentInstPtr)) {
+	if (*currentInstPtr != INST_LOAD_SCALAR1) {
+	    continue;
+	}
+	nextInstPtr = currentInstPtr + InstLength(INST_LOAD_SCALAR1);
+	if (nextInstPtr + 4 > envPtr->codeNext) {
+	    continue;
+	}
+
+	switch (*nextInstPtr) {
+	case INST_PUSH1:
+	    /*
+	     * loadScalar1 %a; push1 lit; add|sub; storeScalar1 %b
+	     */
+
+	    if ((nextInstPtr[2] == INST_ADD || nextInstPtr[2] == INST_SUB)
+		    && nextInstPtr[3] == INST_STORE_SCALAR1) {
+		*currentInstPtr = INST_LOAD_SCALAR1_ARITH_STORE;
+	    }
+	    break;
+	case INST_LOAD_SCALAR1:
+	    switch (nextInstPtr[2]) {
+	    case INST_EQ:
+	    case INST_NEQ:
+	    case INST_LT:
+	    case INST_GT:
+	    case INST_LE:
+	    case INST_GE:
+		/*
+		 * loadScalar1 %a; loadScalar1 %b; <compare>; jump*
+		 */
+
+		switch (nextInstPtr[3]) {
+		case INST_JUMP_TRUE1:
+		case INST_JUMP_FALSE1:
+		case INST_JUMP_TRUE4:
+		case INST_JUMP_FALSE4:
+		    *currentInstPtr = INST_LOAD_SCALAR1_CMP_JUMP;
+		    break;
+		}
+		break;
+	    case INST_LIST_INDEX:
+		/*
+		 * loadScalar1 %list; loadScalar1 %index; listIndex
+		 */
+
+		*currentInstPtr = INST_LOAD_SCALAR1_LIST_INDEX;
+		break;
+	    }
+	    break;
+	}
+    }
+}
+
 /*
  * ----------------------------------------------------------------------
  *
@@ -430,6 +508,7 @@ TclOptimizeBytecode(
     ConvertZeroEffectToNOP((CompileEnv *)envPtr);
     AdvanceJumps((CompileEnv *)envPtr);
     TrimUnreachable((CompileEnv *)envPtr);
+    FuseInstructions((CompileEnv *)envPtr);
 }
 
 /*
@@ -27,6 +27,23 @@ typedef struct {
     ExtraFrameInfo efi;
 } ApplyExtraData;
 
+/*
+ * Queue of procedures waiting to be compiled when the interpreter is idle,
+ * kept as assoc data of the interpreter while precompilation is enabled.
+ * Each queued Proc holds a reference so that it can't go away while queued.
+ */
+
+typedef struct {
+    Tcl_Interp *interp;		/* Interpreter the procedures belong to. */
+    Proc **procs;		/* Array of queued procedures. */
+    size_t first;		/* Index of the next procedure to compile. */
+    size_t last;		/* Index after the last queued procedure. */
+    size_t size;		/* Allocated size of procs. */
+    int scheduled;		/* Whether PrecompileIdleProc is scheduled. */
+} PrecompileQueue;
+
+#define PRECOMPILE_KEY "tclPrecompile"
+
 /*
  * Prototypes for static functions in this file
  */
@@ -39,6 +56,10 @@ static void		InitResolvedLocals(Tcl_Interp *interp,
 			    ByteCode *codePtr, Var *defPtr,
 			    Namespace *nsPtr);
 static void		InitLocalCache(Proc *procPtr);
+static void		PrecompileDeleteProc(void *clientData,
+			    Tcl_Interp *interp);
+static void		PrecompileIdleProc(void *clientData);
+static void		PrecompileProc(Tcl_Interp *interp, Proc *procPtr);
 static void		ProcBodyDup(Tcl_Obj *srcPtr, Tcl_Obj *dupPtr);
 static void		ProcBodyFree(Tcl_Obj *objPtr);
 static int		ProcWrongNumArgs(Tcl_Interp *interp, int skip);
@@ -216,6 +237,15 @@ Tcl_ProcObjCmd(
 
     procPtr->cmdPtr = (Command *) cmd;
 
+    /*
+     * When precompilation is enabled, compile the body when the interpreter
+     * next has nothing better to do, rather than on the first call.
+     */
+
+    if (objv[3]->typePtr != &tclProcBodyType) {
+	PrecompileProc(interp, procPtr);
+    }
+
     /*
      * TIP #280: Remember the line the procedure body is starting on. In a
      * bytecode context we ask the engine to provide us with the necessary
@@ -1834,6 +1864,228 @@ InterpProcNR2(
     goto done;
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * PrecompileProc --
+ *
+ *	Queues a newly created procedure for compilation when the interpreter
+ *	is idle, if precompilation is enabled in the interpreter.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	May schedule PrecompileIdleProc.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+PrecompileProc(
+    Tcl_Interp *interp,
+    Proc *procPtr)
+{
+    PrecompileQueue *queuePtr = (PrecompileQueue *)
+	    Tcl_GetAssocData(interp, PRECOMPILE_KEY, NULL);
+
+    if (queuePtr == NULL) {
+	return;
+    }
+    if (queuePtr->last == queuePtr->size) {
+	if (queuePtr->first > queuePtr->size / 2) {
+	    memmove(queuePtr->procs, queuePtr->procs + queuePtr->first,
+		    (queuePtr->last - queuePtr->first) * sizeof(Proc *));
+	    queuePtr->last -= queuePtr->first;
+	    queuePtr->first = 0;
+	} else {
+	    queuePtr->size = queuePtr->size ? 2 * queuePtr->size : 16;
+	    queuePtr->procs = (Proc **)Tcl_Realloc(queuePtr->procs,
+		    queuePtr->size * sizeof(Proc *));
+	}
+    }
+    procPtr->refCount++;
+    queuePtr->procs[queuePtr->last++] = procPtr;
+    if (!queuePtr->scheduled) {
+	queuePtr->scheduled = 1;
+	Tcl_DoWhenIdle(PrecompileIdleProc, queuePtr);
+    }
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * PrecompileIdleProc --
+ *
+ *	Idle handler that compiles the body of the next queued procedure,
+ *	exactly as its first call would have done, and reschedules itself
+ *	while more procedures are queued. Only one body is compiled per idle
+ *	period so that events arriving meanwhile are not held up for long.
+ *
+ *	Procedures deleted or already compiled since they were queued are
+ *	skipped. The bytecode is stamped with the compile epoch current at
+ *	the time of compilation, so if the epoch moves on before the procedure
+ *	is called, TclProcCompileProc recompiles it as usual.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	Compiles a procedure body.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+PrecompileIdleProc(
+    void *clientData)
+{
+    PrecompileQueue *queuePtr = (PrecompileQueue *)clientData;
+    Tcl_Interp *interp = queuePtr->interp;
+    Proc *procPtr;
+
+    queuePtr->scheduled = 0;
+    if (queuePtr->first == queuePtr->last) {
+	return;
+    }
+    procPtr = queuePtr->procs[queuePtr->first++];
+    if (queuePtr->first == queuePtr->last) {
+	queuePtr->first = queuePtr->last = 0;
+    } else {
+	queuePtr->scheduled = 1;
+	Tcl_DoWhenIdle(PrecompileIdleProc, queuePtr);
+    }
+
+    /*
+     * A procedure that is executing has been compiled already, so if its
+     * body has no bytecode and the queue's reference is not the last one,
+     * its command is still there.
+     */
+
+    if ((procPtr->refCount > 1)
+	    && !TclHasInternalRep(procPtr->bodyPtr, &tclByteCodeType)
+	    && !Tcl_InterpDeleted(interp)) {
+	Tcl_InterpState state = Tcl_SaveInterpState(interp, TCL_OK);
+	Tcl_Obj *nameObj;
+
+	TclNewObj(nameObj);
+	Tcl_IncrRefCount(nameObj);
+	Tcl_GetCommandFullName(interp, (Tcl_Command) procPtr->cmdPtr,
+		nameObj);
+	(void) TclProcCompileProc(interp, procPtr, procPtr->bodyPtr,
+		procPtr->cmdPtr->nsPtr, "body of proc", TclGetString(nameObj));
+	Tcl_DecrRefCount(nameObj);
+	(void) Tcl_RestoreInterpState(interp, state);
+    }
+    if (procPtr->refCount-- <= 1) {
+	TclProcCleanupProc(procPtr);
+    }
+}
+
+static void
+PrecompileDeleteProc(
+    void *clientData,
+    TCL_UNUSED(Tcl_Interp *))
+{
+    PrecompileQueue *queuePtr = (PrecompileQueue *)clientData;
+
+    if (queuePtr->scheduled) {
+	Tcl_CancelIdleCall(PrecompileIdleProc, queuePtr);
+    }
+    while (queuePtr->first < queuePtr->last) {
+	Proc *procPtr = queuePtr->procs[queuePtr->first++];
+
+	if (procPtr->refCount-- <= 1) {
+	    TclProcCleanupProc(procPtr);
+	}
+    }
+    if (queuePtr->procs != NULL) {
+	Tcl_Free(queuePtr->procs);
+    }
+    Tcl_Free(queuePtr);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclPrecompileObjCmd --
+ *
+ *	Implementation of the "::tcl::unsupported::precompile" command, which
+ *	controls the compilation of procedure bodies when the interpreter is
+ *	idle, instead of on their first call:
+ *
+ *	    precompile enabled ?boolean?
+ *		Returns whether procedures defined from now on are queued for
+ *		precompilation, or sets it. Disabling drops the queue.
+ *	    precompile pending
+ *		Returns the number of procedures waiting in the queue.
+ *
+ *----------------------------------------------------------------------
+ */
+
+int
+TclPrecompileObjCmd(
+    TCL_UNUSED(void *),
+    Tcl_Interp *interp,		/* Current interpreter. */
+    int objc,			/* Number of arguments. */
+    Tcl_Obj *const objv[])	/* Argument objects. */
+{
+    static const char *const options[] = {
+	"enabled", "pending", NULL
+    };
+    enum Options {
+	PRECOMPILE_ENABLED, PRECOMPILE_PENDING
+    } idx;
+    PrecompileQueue *queuePtr = (PrecompileQueue *)
+	    Tcl_GetAssocData(interp, PRECOMPILE_KEY, NULL);
+    int enable;
+
+    if (objc < 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "option ?arg?");
+	return TCL_ERROR;
+    }
+    if (Tcl_GetIndexFromObj(interp, objv[1], options, "option", 0,
+	    &idx) != TCL_OK) {
+	return TCL_ERROR;
+    }
+
+    switch (idx) {
+    case PRECOMPILE_ENABLED:
+	if (objc > 3) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "?boolean?");
+	    return TCL_ERROR;
+	}
+	if (objc == 3) {
+	    if (Tcl_GetBooleanFromObj(interp, objv[2], &enable) != TCL_OK) {
+		return TCL_ERROR;
+	    }
+	    if (enable && queuePtr == NULL) {
+		queuePtr = (PrecompileQueue *)Tcl_Alloc(sizeof(PrecompileQueue));
+		queuePtr->interp = interp;
+		queuePtr->procs = NULL;
+		queuePtr->first = queuePtr->last = queuePtr->size = 0;
+		queuePtr->scheduled = 0;
+		Tcl_SetAssocData(interp, PRECOMPILE_KEY, PrecompileDeleteProc,
+			queuePtr);
+	    } else if (!enable && queuePtr != NULL) {
+		Tcl_DeleteAssocData(interp, PRECOMPILE_KEY);
+		queuePtr = NULL;
+	    }
+	}
+	Tcl_SetObjResult(interp, Tcl_NewBooleanObj(queuePtr != NULL));
+	return TCL_OK;
+    case PRECOMPILE_PENDING:
+	if (objc != 2) {
+	    Tcl_WrongNumArgs(interp, 2, objv, NULL);
+	    return TCL_ERROR;
+	}
+	Tcl_SetObjResult(interp, Tcl_NewWideIntObj(queuePtr
+		? (Tcl_WideInt) (queuePtr->last - queuePtr->first) : 0));
+	return TCL_OK;
+    }
+    return TCL_OK;
+}
+
 /*
  *----------------------------------------------------------------------
  *
@@ -1993,7 +2245,17 @@ TclProcCompileProc(
 
 	iPtr->invokeWord = 0;
 	iPtr->invokeCmdFramePtr = hePtr ? (CmdFrame *)Tcl_GetHashValue(hePtr) : NULL;
-	TclSetByteCodeFromAny(interp, bodyPtr, NULL, NULL);
+
+	/*
+	 * Take the bytecode from the persistent bytecode cache if it has
+	 * it, and otherwise compile it and offer it to the cache.
+	 */
+
+	if ((iPtr->byteCodeCache == NULL)
+		|| (TclLoadCachedByteCode(interp, bodyPtr) != TCL_OK)) {
+	    TclSetByteCodeFromAny(interp, bodyPtr, (iPtr->byteCodeCache
+		    ? TclStoreCachedByteCode : NULL), bodyPtr);
+	}
 	iPtr->invokeCmdFramePtr = NULL;
 	TclPopStackFrame(interp);
     } else if (codePtr->nsEpoch != nsPtr->resolverEpoch) {
@@ -555,7 +555,8 @@ TclParseNumber(
 		/* A dict can never be a (single) number */
 		return TCL_ERROR;
 	    }
-	    if (TclHasInternalRep(objPtr, &tclListType)) {
+	    if (TclHasInternalRep(objPtr, &tclListType)
+		    || TclHasInternalRep(objPtr, &tclListTreeType)) {
 		int length;
 		/* A list can only be a (single) number if its length == 1 */
 		TclListObjLengthM(NULL, objPtr, &length);
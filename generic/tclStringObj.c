@@ -53,6 +53,10 @@ static void		AppendUtfToUnicodeRep(Tcl_Obj *objPtr,
 			    const char *bytes, size_t numBytes);
 static void		AppendUtfToUtfRep(Tcl_Obj *objPtr,
 			    const char *bytes, size_t numBytes);
+static Tcl_Obj *	CatToRope(int objc, Tcl_Obj *const objv[],
+			    int inPlace);
+static void		DupRopeInternalRep(Tcl_Obj *objPtr,
+			    Tcl_Obj *copyPtr);
 static void		DupStringInternalRep(Tcl_Obj *objPtr,
 			    Tcl_Obj *copyPtr);
 static size_t		ExtendStringRepWithUnicode(Tcl_Obj *objPtr,
@@ -61,13 +65,25 @@ static void		ExtendUnicodeRepWithString(Tcl_Obj *objPtr,
 			    const char *bytes, size_t numBytes,
 			    size_t numAppendChars);
 static void		FillUnicodeRep(Tcl_Obj *objPtr);
+static void		FreeRopeInternalRep(Tcl_Obj *objPtr);
+static void		FreeStringIndex(String *stringPtr);
 static void		FreeStringInternalRep(Tcl_Obj *objPtr);
 static void		GrowStringBuffer(Tcl_Obj *objPtr, size_t needed, int flag);
 static void		GrowUnicodeBuffer(Tcl_Obj *objPtr, size_t needed);
+static void		InitRope(Tcl_Obj *objPtr);
+static int		MakeRope(Tcl_Obj *objPtr, size_t numBytes);
+static const char *	PeekString(Tcl_Obj *objPtr, size_t *lengthPtr);
+static void		RopeAppendBytes(Tcl_Obj *objPtr, const char *bytes,
+			    size_t numBytes);
+static void		RopeAppendObj(Tcl_Obj *objPtr, Tcl_Obj *appendObjPtr);
+static void		RopeAppendPiece(Tcl_Obj *objPtr, Tcl_Obj *piecePtr);
 static int		SetStringFromAny(Tcl_Interp *interp, Tcl_Obj *objPtr);
 static void		SetUnicodeObj(Tcl_Obj *objPtr,
 			    const Tcl_UniChar *unicode, size_t numChars);
+static const char *	StringIndexAt(Tcl_Obj *objPtr, size_t index);
+static void		TruncateStringIndex(String *stringPtr, size_t length);
 static size_t		UnicodeLength(const Tcl_UniChar *unicode);
+static void		UpdateStringOfRope(Tcl_Obj *objPtr);
 static void		UpdateStringOfString(Tcl_Obj *objPtr);
 
 #define ISCONTINUATION(bytes) (\
@@ -87,6 +103,43 @@ const Tcl_ObjType tclStringType = {
     UpdateStringOfString,	/* updateStringProc */
     SetStringFromAny		/* setFromAnyProc */
 };
+
+/*
+ * The rope type holds long strings made by appends and concatenations as a
+ * sequence of pieces; see tclStringRep.h. A rope is flattened into a String
+ * the first time its string rep is needed. There is no setFromAnyProc: values
+ * only become ropes as a side effect of being appended to.
+ */
+
+const Tcl_ObjType tclRopeType = {
+    "rope",			/* name */
+    FreeRopeInternalRep,	/* freeIntRepPro */
+    DupRopeInternalRep,		/* dupIntRepProc */
+    UpdateStringOfRope,		/* updateStringProc */
+    NULL			/* setFromAnyProc */
+};
+
+/*
+ * The rope tuning parameters:
+ *
+ * ROPE_MIN_LENGTH		A String at least this many bytes long that
+ *				must grow its buffer for a long append becomes
+ *				a rope instead, as does the result of [string
+ *				cat] when it is this long.
+ * ROPE_PIECE_MIN		Appended values at least this long become
+ *				pieces of the rope by reference; shorter ones
+ *				are copied into the last piece. Only appends
+ *				this long turn a String into a rope: short
+ *				ones are as cheap to copy into a String.
+ * ROPE_TAIL_LENGTH		Room allocated in a new last piece for the
+ *				copies of short values.
+ * ROPE_MIN_PIECES		Initial room for pieces in a rope.
+ */
+
+#define ROPE_MIN_LENGTH		65536
+#define ROPE_PIECE_MIN		1024
+#define ROPE_TAIL_LENGTH	65536
+#define ROPE_MIN_PIECES		8
 
 /*
  * TCL STRING GROWTH ALGORITHM
@@ -436,11 +489,20 @@ Tcl_GetCharLength(
     numChars = stringPtr->numChars;
 
     /*
-     * If numChars is unknown, compute it.
+     * If numChars is unknown, compute it. Characters the index has already
+     * checked need not be counted again.
      */
 
     if (numChars == TCL_INDEX_NONE) {
-	TclNumUtfCharsM(numChars, objPtr->bytes, objPtr->length);
+	StringIndex *indexPtr = stringPtr->indexPtr;
+
+	if (indexPtr != NULL) {
+	    TclNumUtfCharsM(numChars, objPtr->bytes + indexPtr->numBytes,
+		    objPtr->length - indexPtr->numBytes);
+	    numChars += indexPtr->numChars;
+	} else {
+	    TclNumUtfCharsM(numChars, objPtr->bytes, objPtr->length);
+	}
 	stringPtr->numChars = numChars;
     }
     return numChars;
@@ -586,6 +648,25 @@ Tcl_GetUniChar(
 	if (stringPtr->numChars == objPtr->length) {
 	    return (unsigned char) objPtr->bytes[index];
 	}
+	if (index >= stringPtr->numChars) {
+	    return -1;
+	}
+
+	/*
+	 * Find the character through the sparse index, unless the string is
+	 * not fit for one.
+	 */
+
+	{
+	    const char *src = StringIndexAt(objPtr, index);
+
+	    if (src != NULL) {
+		Tcl_UniChar unichar = 0;
+
+		TclUtfToUniChar(src, &unichar);
+		return unichar;
+	    }
+	}
 	FillUnicodeRep(objPtr);
 	stringPtr = GET_STRING(objPtr);
     }
@@ -781,26 +862,42 @@ Tcl_GetRange(
 	 * If numChars is unknown, compute it.
 	 */
 
+	const char *begin, *end;
+
 	if (stringPtr->numChars == TCL_INDEX_NONE) {
 	    TclNumUtfCharsM(stringPtr->numChars, objPtr->bytes, objPtr->length);
 	}
+	if (last >= stringPtr->numChars) {
+	    last = stringPtr->numChars - 1;
+	}
+	if (last + 1 < first + 1) {
+	    TclNewObj(newObjPtr);
+	    return newObjPtr;
+	}
 	if (stringPtr->numChars == objPtr->length) {
-	    if (last >= stringPtr->numChars) {
-		last = stringPtr->numChars - 1;
-	    }
-	    if (last + 1 < first + 1) {
-		TclNewObj(newObjPtr);
-		return newObjPtr;
+	    begin = objPtr->bytes + first;
+	    end = objPtr->bytes + last + 1;
+	} else {
+	    /*
+	     * Find the ends of the range through the sparse index, unless the
+	     * string is not fit for one.
+	     */
+
+	    begin = StringIndexAt(objPtr, first);
+	    end = objPtr->bytes + objPtr->length;
+	    if (begin && (last + 1 < stringPtr->numChars)) {
+		end = StringIndexAt(objPtr, last + 1);
 	    }
-	    newObjPtr = Tcl_NewStringObj(objPtr->bytes + first, last - first + 1);
+	}
+	if (begin && end) {
+	    newObjPtr = Tcl_NewStringObj(begin, end - begin);
 
 	    /*
 	     * Since we know the char length of the result, store it.
 	     */
 
 	    SetStringFromAny(NULL, newObjPtr);
-	    stringPtr = GET_STRING(newObjPtr);
-	    stringPtr->numChars = newObjPtr->length;
+	    GET_STRING(newObjPtr)->numChars = last - first + 1;
 	    return newObjPtr;
 	}
 	FillUnicodeRep(objPtr);
@@ -989,9 +1086,11 @@ Tcl_SetObjLength(
 	objPtr->bytes[length] = 0;
 
 	/*
-	 * Invalidate the unicode data.
+	 * Invalidate the unicode data. The character index stays good for
+	 * the part of the string that is left.
 	 */
 
+	TruncateStringIndex(stringPtr, length);
 	stringPtr->numChars = TCL_INDEX_NONE;
 	stringPtr->hasUnicode = 0;
     } else {
@@ -1086,9 +1185,11 @@ Tcl_AttemptSetObjLength(
 	objPtr->bytes[length] = 0;
 
 	/*
-	 * Invalidate the unicode data.
+	 * Invalidate the unicode data. The character index stays good for
+	 * the part of the string that is left.
 	 */
 
+	TruncateStringIndex(stringPtr, length);
 	stringPtr->numChars = TCL_INDEX_NONE;
 	stringPtr->hasUnicode = 0;
     } else {
@@ -1193,6 +1294,7 @@ SetUnicodeObj(
     stringPtr->unicode[numChars] = 0;
     stringPtr->numChars = numChars;
     stringPtr->hasUnicode = 1;
+    stringPtr->indexPtr = NULL;
 
     TclInvalidateStringRep(objPtr);
     stringPtr->allocated = 0;
@@ -1268,6 +1370,12 @@ Tcl_AppendLimitedToObj(
 	Tcl_Panic("%s called with shared object", "Tcl_AppendLimitedToObj");
     }
 
+    if (TclHasInternalRep(objPtr, &tclRopeType) && (length <= limit)
+	    && bytes && !ISCONTINUATION(bytes)) {
+	RopeAppendBytes(objPtr, bytes, toCopy);
+	return;
+    }
+
     SetStringFromAny(NULL, objPtr);
     stringPtr = GET_STRING(objPtr);
 
@@ -1469,9 +1577,16 @@ Tcl_AppendObjToObj(
     }
 
     /*
-     * Must append as strings.
+     * Must append as strings. Long strings grow as ropes, which take long
+     * values by reference instead of copying them.
      */
 
+    bytes = PeekString(appendObjPtr, &length);
+    if ((length == 0 || !ISCONTINUATION(bytes)) && MakeRope(objPtr, length)) {
+	RopeAppendObj(objPtr, appendObjPtr);
+	return;
+    }
+
     SetStringFromAny(NULL, objPtr);
     stringPtr = GET_STRING(objPtr);
 
@@ -3082,6 +3197,11 @@ TclStringCat(
 
     /* assert ( objc >= 2 ) */
 
+    objResultPtr = CatToRope(objc, objv, inPlace);
+    if (objResultPtr) {
+	return objResultPtr;
+    }
+
     /*
      * Analyze to determine what representation result should be.
      * GOALS:	Avoid shimmering & string rep generation.
@@ -3359,6 +3479,29 @@ TclStringCat(
     } else {
 	/* Efficiently concatenate string reps */
 	char *dst;
+	size_t numChars = 0;
+	int i;
+
+	/*
+	 * When every value knows its character count, so does the result. No
+	 * value past the first starts with a continuation byte here, but that
+	 * is only checked until some value rules out a Unicode result.
+	 */
+
+	for (i = 0; (i < objc) && (numChars != TCL_INDEX_NONE); i++) {
+	    Tcl_Obj *objPtr = objv[i];
+
+	    if (objPtr->bytes && (objPtr->length == 0)) {
+		continue;
+	    }
+	    if (!TclHasInternalRep(objPtr, &tclStringType)
+		    || (GET_STRING(objPtr)->numChars == TCL_INDEX_NONE)
+		    || (i && ISCONTINUATION(TclGetString(objPtr)))) {
+		numChars = TCL_INDEX_NONE;
+	    } else {
+		numChars += GET_STRING(objPtr)->numChars;
+	    }
+	}
 
 	if (inPlace && !Tcl_IsShared(*objv)) {
 	    size_t start;
@@ -3377,8 +3520,11 @@ TclStringCat(
 	    }
 	    dst = TclGetString(objResultPtr) + start;
 
-	    /* assert ( length > start ) */
-	    TclFreeInternalRep(objResultPtr);
+	    /*
+	     * assert ( length > start )
+	     * The String internal rep is kept: any character index it has
+	     * still holds for the first value.
+	     */
 	} else {
 	    TclNewObj(objResultPtr);	/* PANIC? */
 	    if (0 == Tcl_AttemptSetObjLength(objResultPtr, length)) {
@@ -3406,6 +3552,7 @@ TclStringCat(
 	}
 	/* Must NUL-terminate! */
 	*dst = '\0';
+	GET_STRING(objResultPtr)->numChars = numChars;
     }
     return objResultPtr;
 
@@ -3938,6 +4085,8 @@ TclStringReverse(
 	if (!inPlace || Tcl_IsShared(objPtr)) {
 	    TclNewObj(objPtr);
 	    Tcl_SetObjLength(objPtr, numBytes);
+	} else {
+	    FreeStringIndex(stringPtr);
 	}
 	to = objPtr->bytes;
 
@@ -4172,6 +4321,11 @@ ExtendUnicodeRepWithString(
 	stringPtr = GET_STRING(objPtr);
     }
 
+    /*
+     * The Unicode array makes the character index redundant.
+     */
+
+    FreeStringIndex(stringPtr);
     stringPtr->hasUnicode = 1;
     if (bytes) {
 	stringPtr->numChars = needed;
@@ -4190,14 +4344,184 @@ ExtendUnicodeRepWithString(
 	}
 #endif
 	*dst++ = unichar;
-	while (numAppendChars-- > 0) {
+	while (numAppendChars > 0) {
+#if TCL_UTF_MAX > 3
+	    if ((numAppendChars >= 32) && (UCHAR(bytes[0]) < 0x80)
+		    && (UCHAR(bytes[1]) < 0x80)) {
+		size_t n = TclUtfAsciiToUCS4(bytes, numAppendChars, dst);
+
+		bytes += n;
+		dst += n;
+		numAppendChars -= n;
+		continue;
+	    }
+#endif
 	    bytes += TclUtfToUniChar(bytes, &unichar);
 	    *dst++ = unichar;
+	    numAppendChars--;
 	}
     }
     *dst = 0;
 }
 
+/*
+ *---------------------------------------------------------------------------
+ *
+ * StringIndexAt --
+ *
+ *	Find a character of a String object that has no Unicode rep through
+ *	the sparse character index of its UTF string, creating or extending
+ *	the index as needed. The index must be less than the number of
+ *	characters in the string.
+ *
+ *	Characters are checked before they are indexed. Any that would not
+ *	come out the same way from a Tcl_UniChar array (invalid or overlong
+ *	sequences, raw NUL bytes, surrogates) mean the string is not fit for
+ *	the index, and callers fall back on FillUnicodeRep.
+ *
+ * Results:
+ *	A pointer to the index'th character in objPtr->bytes, or NULL when the
+ *	string is not fit for the index.
+ *
+ * Side effects:
+ *	The index is created or extended, or freed when NULL is returned.
+ *
+ *---------------------------------------------------------------------------
+ */
+
+#define UTF_LEAD_LENGTH(byte) \
+    ((UCHAR(byte) < 0xC0) ? 1 : (UCHAR(byte) < 0xE0) ? 2 : \
+	    (UCHAR(byte) < 0xF0) ? 3 : 4)
+
+static const char *
+StringIndexAt(
+    Tcl_Obj *objPtr,		/* String object with no Unicode rep. */
+    size_t index)		/* Index of the character to find. */
+{
+    String *stringPtr = GET_STRING(objPtr);
+    StringIndex *indexPtr = stringPtr->indexPtr;
+    const char *bytes = objPtr->bytes;
+    size_t numChars, numBytes, block = index / STRING_INDEX_STEP;
+
+    if (indexPtr == NULL) {
+	indexPtr = (StringIndex *)Tcl_Alloc(STRING_INDEX_SIZE(8));
+	indexPtr->numChars = indexPtr->numBytes = 0;
+	indexPtr->lastChar = indexPtr->lastByte = 0;
+	indexPtr->numOffsets = 1;
+	indexPtr->maxOffsets = 8;
+	indexPtr->offsets[0] = 0;
+	stringPtr->indexPtr = indexPtr;
+    }
+
+    /*
+     * Check the characters up to the end of the block holding the one
+     * wanted, recording a checkpoint at the start of each block.
+     */
+
+    numChars = indexPtr->numChars;
+    numBytes = indexPtr->numBytes;
+    if (numChars <= index) {
+	size_t end = (block + 1) * STRING_INDEX_STEP;
+
+	while ((numChars < end) && (numBytes < objPtr->length)) {
+	    if ((numChars % STRING_INDEX_STEP == 0)
+		    && (numChars / STRING_INDEX_STEP == indexPtr->numOffsets)) {
+		if (indexPtr->numOffsets == indexPtr->maxOffsets) {
+		    indexPtr->maxOffsets *= 2;
+		    indexPtr = (StringIndex *)Tcl_Realloc(indexPtr,
+			    STRING_INDEX_SIZE(indexPtr->maxOffsets));
+		    stringPtr->indexPtr = indexPtr;
+		}
+		indexPtr->offsets[indexPtr->numOffsets++] = numBytes;
+	    }
+	    if ((unsigned) (UCHAR(bytes[numBytes]) - 1) < 0x7F) {
+		numBytes++;
+	    } else {
+		Tcl_UniChar ch = 0;
+		size_t len = TclUtfToUniChar(bytes + numBytes, &ch);
+
+		if (((unsigned) (ch - 0xD800) < 0x800)
+			|| (len != TclUtfCount(ch))) {
+		    FreeStringIndex(stringPtr);
+		    return NULL;
+		}
+		numBytes += len;
+	    }
+	    numChars++;
+	}
+	indexPtr->numChars = numChars;
+	indexPtr->numBytes = numBytes;
+    }
+
+    /*
+     * Walk to the character from the start of its block, or from where the
+     * latest lookup ended when that is on the way.
+     */
+
+    if ((indexPtr->lastChar <= index)
+	    && (indexPtr->lastChar >= block * STRING_INDEX_STEP)) {
+	numChars = indexPtr->lastChar;
+	numBytes = indexPtr->lastByte;
+    } else {
+	numChars = block * STRING_INDEX_STEP;
+	numBytes = indexPtr->offsets[block];
+    }
+    while (numChars < index) {
+	numBytes += UTF_LEAD_LENGTH(bytes[numBytes]);
+	numChars++;
+    }
+    indexPtr->lastChar = index;
+    indexPtr->lastByte = numBytes;
+    return bytes + numBytes;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *
+ * TruncateStringIndex, FreeStringIndex --
+ *
+ *	Keep the character index of a String object in step with its UTF
+ *	string: TruncateStringIndex forgets what the index knows past the
+ *	first length bytes, and FreeStringIndex drops the index altogether.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	May free memory.
+ *
+ *---------------------------------------------------------------------------
+ */
+
+static void
+TruncateStringIndex(
+    String *stringPtr,
+    size_t length)		/* Number of bytes still the same. */
+{
+    StringIndex *indexPtr = stringPtr->indexPtr;
+
+    if ((indexPtr == NULL) || (indexPtr->numBytes <= length)) {
+	return;
+    }
+    while ((indexPtr->numOffsets > 1)
+	    && (indexPtr->offsets[indexPtr->numOffsets - 1] >= length)) {
+	indexPtr->numOffsets--;
+    }
+    indexPtr->numChars = (indexPtr->numOffsets - 1) * STRING_INDEX_STEP;
+    indexPtr->numBytes = indexPtr->offsets[indexPtr->numOffsets - 1];
+    indexPtr->lastChar = indexPtr->lastByte = 0;
+}
+
+static void
+FreeStringIndex(
+    String *stringPtr)
+{
+    if (stringPtr->indexPtr != NULL) {
+	Tcl_Free(stringPtr->indexPtr);
+	stringPtr->indexPtr = NULL;
+    }
+}
+
 /*
  *----------------------------------------------------------------------
  *
@@ -4260,6 +4584,7 @@ DupStringInternalRep(
     }
     copyStringPtr->hasUnicode = srcStringPtr->hasUnicode;
     copyStringPtr->numChars = srcStringPtr->numChars;
+    copyStringPtr->indexPtr = NULL;
 
     /*
      * Tricky point: the string value was copied by generic object management
@@ -4296,14 +4621,20 @@ SetStringFromAny(
     Tcl_Obj *objPtr)		/* The object to convert. */
 {
     if (!TclHasInternalRep(objPtr, &tclStringType)) {
-	String *stringPtr = stringAlloc(0);
+	String *stringPtr;
 
 	/*
-	 * Convert whatever we have into an untyped value. Just A String.
+	 * Convert whatever we have into an untyped value. Just A String. A
+	 * rope becomes a String by generating its string rep; keep that one,
+	 * which knows the room left in the buffer.
 	 */
 
 	(void) TclGetString(objPtr);
+	if (TclHasInternalRep(objPtr, &tclStringType)) {
+	    return TCL_OK;
+	}
 	TclFreeInternalRep(objPtr);
+	stringPtr = stringAlloc(0);
 
 	/*
 	 * Create a basic String internalrep that just points to the UTF-8 string
@@ -4314,6 +4645,7 @@ SetStringFromAny(
 	stringPtr->allocated = objPtr->length;
 	stringPtr->maxChars = 0;
 	stringPtr->hasUnicode = 0;
+	stringPtr->indexPtr = NULL;
 	SET_STRING(objPtr, stringPtr);
 	objPtr->typePtr = &tclStringType;
     }
@@ -4353,6 +4685,7 @@ UpdateStringOfString(
      */
 
     stringPtr->allocated = 0;
+    FreeStringIndex(stringPtr);
 
     if (stringPtr->numChars == 0) {
 	TclInitStringRep(objPtr, NULL, 0);
@@ -4441,9 +4774,511 @@ static void
 FreeStringInternalRep(
     Tcl_Obj *objPtr)		/* Object with internal rep to free. */
 {
+    FreeStringIndex(GET_STRING(objPtr));
     Tcl_Free(GET_STRING(objPtr));
     objPtr->typePtr = NULL;
 }
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * PeekString --
+ *
+ *	Looks at the string of a value without flattening it when it is a
+ *	rope.
+ *
+ * Results:
+ *	The length of the value in bytes is written to *lengthPtr. The return
+ *	value points to its bytes; for a rope, only as far as the end of the
+ *	first piece, which is enough to see how the value starts.
+ *
+ * Side effects:
+ *	A value that is not a rope may get a string rep.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static const char *
+PeekString(
+    Tcl_Obj *objPtr,		/* The value to look at. */
+    size_t *lengthPtr)		/* Where to store its length. */
+{
+    if (TclHasInternalRep(objPtr, &tclRopeType)) {
+	Rope *ropePtr = GET_ROPE(objPtr);
+
+	*lengthPtr = ropePtr->numBytes;
+	return ropePtr->numPieces ? ropePtr->pieces[0]->bytes : "";
+    }
+    return Tcl_GetStringFromObj(objPtr, lengthPtr);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * MakeRope --
+ *
+ *	Decides whether an append of numBytes to objPtr should be done to a
+ *	rope, and if so makes objPtr one. That is the case when objPtr is a
+ *	rope already, or a String at least ROPE_MIN_LENGTH bytes long without
+ *	the room in its buffer for an append of at least ROPE_PIECE_MIN
+ *	bytes.
+ *
+ * Results:
+ *	1 when objPtr is a rope on return, 0 otherwise.
+ *
+ * Side effects:
+ *	The string rep and String internal rep of objPtr may move into a new
+ *	value that becomes the first piece of the rope.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+MakeRope(
+    Tcl_Obj *objPtr,		/* The unshared value to be appended to. */
+    size_t numBytes)		/* The number of bytes to be appended. */
+{
+    String *stringPtr;
+    Tcl_Obj *piecePtr;
+
+    if (TclHasInternalRep(objPtr, &tclRopeType)) {
+	return 1;
+    }
+    if (!TclHasInternalRep(objPtr, &tclStringType) || objPtr->bytes == NULL
+	    || objPtr->length == 0) {
+	return 0;
+    }
+    stringPtr = GET_STRING(objPtr);
+    if (stringPtr->hasUnicode || numBytes < ROPE_PIECE_MIN
+	    || numBytes <= stringPtr->allocated - objPtr->length
+	    || objPtr->length + numBytes < ROPE_MIN_LENGTH) {
+	return 0;
+    }
+
+    /*
+     * Hand the buffer over to the first piece as it is, rather than copy it.
+     */
+
+    TclNewObj(piecePtr);
+    piecePtr->bytes = objPtr->bytes;
+    piecePtr->length = objPtr->length;
+    piecePtr->internalRep = objPtr->internalRep;
+    piecePtr->typePtr = &tclStringType;
+
+    objPtr->typePtr = NULL;
+    objPtr->bytes = NULL;
+    objPtr->length = 0;
+    InitRope(objPtr);
+    RopeAppendPiece(objPtr, piecePtr);
+    return 1;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * InitRope --
+ *
+ *	Makes objPtr an empty rope. The value must have neither a string rep
+ *	nor an internal rep.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	Allocates the Rope internal rep.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+InitRope(
+    Tcl_Obj *objPtr)		/* The value to make a rope. */
+{
+    Rope *ropePtr = (Rope *)Tcl_Alloc(ROPE_SIZE(ROPE_MIN_PIECES));
+
+    ropePtr->numBytes = 0;
+    ropePtr->numPieces = 0;
+    ropePtr->maxPieces = ROPE_MIN_PIECES;
+    SET_ROPE(objPtr, ropePtr);
+    objPtr->typePtr = &tclRopeType;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * RopeAppendPiece --
+ *
+ *	Adds a piece at the end of a rope. The piece must be a non-empty value
+ *	with a string rep that does not start inside a character.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	The rope takes a reference to piecePtr, and may be reallocated.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+RopeAppendPiece(
+    Tcl_Obj *objPtr,		/* The rope to append to. */
+    Tcl_Obj *piecePtr)		/* The piece to add. */
+{
+    Rope *ropePtr = GET_ROPE(objPtr);
+
+    if (ropePtr->numPieces == ropePtr->maxPieces) {
+	ropePtr->maxPieces *= 2;
+	ropePtr = (Rope *)Tcl_Realloc(ropePtr, ROPE_SIZE(ropePtr->maxPieces));
+	SET_ROPE(objPtr, ropePtr);
+    }
+    Tcl_IncrRefCount(piecePtr);
+    ropePtr->pieces[ropePtr->numPieces++] = piecePtr;
+    ropePtr->numBytes += piecePtr->length;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * RopeAppendBytes --
+ *
+ *	Appends a copy of some bytes to a rope. They go at the end of the last
+ *	piece when the rope holds the only reference to it and it has the
+ *	room; otherwise into a new last piece.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	The last piece of the rope may be changed or added.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+RopeAppendBytes(
+    Tcl_Obj *objPtr,		/* The rope to append to. */
+    const char *bytes,		/* The bytes to append. */
+    size_t numBytes)		/* Number of bytes to append. */
+{
+    Rope *ropePtr = GET_ROPE(objPtr);
+    Tcl_Obj *tailPtr;
+
+    if (numBytes == 0) {
+	return;
+    }
+    if (ropePtr->numPieces) {
+	tailPtr = ropePtr->pieces[ropePtr->numPieces - 1];
+	if (tailPtr->refCount == 1 && tailPtr->bytes
+		&& TclHasInternalRep(tailPtr, &tclStringType)
+		&& !GET_STRING(tailPtr)->hasUnicode && numBytes
+		<= GET_STRING(tailPtr)->allocated - tailPtr->length) {
+	    AppendUtfToUtfRep(tailPtr, bytes, numBytes);
+	    ropePtr->numBytes += numBytes;
+	    return;
+	}
+    }
+
+    TclNewObj(tailPtr);
+    SetStringFromAny(NULL, tailPtr);
+    GrowStringBuffer(tailPtr,
+	    (numBytes > ROPE_TAIL_LENGTH) ? numBytes : ROPE_TAIL_LENGTH, 1);
+    AppendUtfToUtfRep(tailPtr, bytes, numBytes);
+    RopeAppendPiece(objPtr, tailPtr);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * RopeAppendObj --
+ *
+ *	Appends the string of a value to a rope. Long values become pieces of
+ *	the rope as they are, and the pieces of a rope are spliced in, so
+ *	ropes never nest. Short values are copied.
+ *
+ *	A value nobody holds a reference to is copied whatever its length: its
+ *	owner could still change it, since the single reference the rope would
+ *	take does not make it shared.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	A value that is not a rope may get a string rep.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+RopeAppendObj(
+    Tcl_Obj *objPtr,		/* The rope to append to. */
+    Tcl_Obj *appendObjPtr)	/* The value to append. */
+{
+    size_t i, numPieces = 1;
+    int isRope = TclHasInternalRep(appendObjPtr, &tclRopeType);
+
+    /*
+     * Take the number of pieces first, and fetch each piece afresh: when
+     * appending a rope to itself, its pieces array grows in the loop.
+     */
+
+    if (isRope) {
+	numPieces = GET_ROPE(appendObjPtr)->numPieces;
+    } else {
+	(void) TclGetString(appendObjPtr);
+    }
+    for (i = 0; i < numPieces; i++) {
+	Tcl_Obj *piecePtr =
+		isRope ? GET_ROPE(appendObjPtr)->pieces[i] : appendObjPtr;
+
+	if (piecePtr->length >= ROPE_PIECE_MIN && piecePtr->refCount > 0) {
+	    RopeAppendPiece(objPtr, piecePtr);
+	} else {
+	    RopeAppendBytes(objPtr, piecePtr->bytes, piecePtr->length);
+	}
+    }
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * CatToRope --
+ *
+ *	Performs [string cat] by making a rope, when that can be done without
+ *	generating string reps or flattening ropes, and is worth it: some of
+ *	the values are ropes, or the result is at least ROPE_MIN_LENGTH bytes.
+ *
+ * Results:
+ *	The result value, or NULL when TclStringCat should join the values
+ *	itself.
+ *
+ * Side effects:
+ *	With inPlace set, an unshared first value may be appended to.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static Tcl_Obj *
+CatToRope(
+    int objc,			/* Number of values, at least 2. */
+    Tcl_Obj *const objv[],	/* The values to join. */
+    int inPlace)		/* Whether objv[0] may be the result. */
+{
+    Tcl_Obj *objResultPtr = objv[0];
+    size_t numBytes = 0, firstBytes = 0;
+    int i, numValues = 0, haveRope = 0;
+
+    for (i = 0; i < objc; i++) {
+	const char *bytes;
+	size_t length;
+
+	if (TclHasInternalRep(objv[i], &tclRopeType)) {
+	    haveRope = 1;
+	} else if (objv[i]->bytes == NULL) {
+	    return NULL;
+	}
+	bytes = PeekString(objv[i], &length);
+	if (length == 0) {
+	    continue;
+	}
+	if (i > 0 && ISCONTINUATION(bytes)) {
+	    return NULL;
+	}
+	if (i == 0) {
+	    firstBytes = length;
+	}
+	numValues++;
+	numBytes += length;
+    }
+    if (numValues < 2 || (!haveRope && numBytes < ROPE_MIN_LENGTH)) {
+	return NULL;
+    }
+
+    if (inPlace && !Tcl_IsShared(objResultPtr)) {
+	if (MakeRope(objResultPtr, numBytes - firstBytes)) {
+	    for (i = 1; i < objc; i++) {
+		RopeAppendObj(objResultPtr, objv[i]);
+	    }
+	    return objResultPtr;
+	}
+	if (TclHasInternalRep(objResultPtr, &tclStringType)
+		&& (numBytes - firstBytes
+		<= GET_STRING(objResultPtr)->allocated - firstBytes)) {
+	    /*
+	     * The first value has the room to take the rest in place.
+	     */
+
+	    return NULL;
+	}
+    }
+
+    TclNewObj(objResultPtr);
+    TclInvalidateStringRep(objResultPtr);
+    InitRope(objResultPtr);
+    for (i = 0; i < objc; i++) {
+	RopeAppendObj(objResultPtr, objv[i]);
+    }
+    return objResultPtr;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclGetRopePieces --
+ *
+ *	Gives access to the pieces of a rope, for callers such as
+ *	Tcl_WriteObj that can use a value piece by piece.
+ *
+ * Results:
+ *	The array of pieces, with their number in *numPiecesPtr, or NULL if
+ *	objPtr is not a rope. The array is only valid until the value is next
+ *	changed or its string rep is generated.
+ *
+ * Side effects:
+ *	None.
+ *
+ *----------------------------------------------------------------------
+ */
+
+Tcl_Obj *const *
+TclGetRopePieces(
+    Tcl_Obj *objPtr,		/* The value to look at. */
+    size_t *numPiecesPtr)	/* Where to store the number of pieces. */
+{
+    Rope *ropePtr;
+
+    if (!TclHasInternalRep(objPtr, &tclRopeType)) {
+	return NULL;
+    }
+    ropePtr = GET_ROPE(objPtr);
+    *numPiecesPtr = ropePtr->numPieces;
+    return ropePtr->pieces;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * DupRopeInternalRep --
+ *
+ *	Initialize the internal representation of a new Tcl_Obj to a copy of
+ *	the internal representation of an existing rope object.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	copyPtr's internal rep is set to a new Rope sharing the pieces of the
+ *	rope of srcPtr.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+DupRopeInternalRep(
+    Tcl_Obj *srcPtr,		/* Object with internal rep to copy. */
+    Tcl_Obj *copyPtr)		/* Object with internal rep to set. */
+{
+    Rope *srcRopePtr = GET_ROPE(srcPtr);
+    Rope *copyRopePtr;
+    size_t i, maxPieces = srcRopePtr->numPieces;
+
+    if (maxPieces < ROPE_MIN_PIECES) {
+	maxPieces = ROPE_MIN_PIECES;
+    }
+    copyRopePtr = (Rope *)Tcl_Alloc(ROPE_SIZE(maxPieces));
+    copyRopePtr->numBytes = srcRopePtr->numBytes;
+    copyRopePtr->numPieces = srcRopePtr->numPieces;
+    copyRopePtr->maxPieces = maxPieces;
+    for (i = 0; i < srcRopePtr->numPieces; i++) {
+	copyRopePtr->pieces[i] = srcRopePtr->pieces[i];
+	Tcl_IncrRefCount(copyRopePtr->pieces[i]);
+    }
+    SET_ROPE(copyPtr, copyRopePtr);
+    copyPtr->typePtr = &tclRopeType;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * UpdateStringOfRope --
+ *
+ *	Flattens a rope: generates its string rep from the pieces, and makes
+ *	it an ordinary String object.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	The pieces are released. The buffer gets room to grow, as
+ *	GrowStringBuffer would give it, so that a loop that both appends to a
+ *	value and reads it still copies in amortized linear time.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+UpdateStringOfRope(
+    Tcl_Obj *objPtr)		/* Object with string rep to update. */
+{
+    Rope *ropePtr = GET_ROPE(objPtr);
+    String *stringPtr = stringAlloc(0);
+    size_t i, numBytes = ropePtr->numBytes, allocated = 2 * numBytes;
+    char *dst = (char *)Tcl_AttemptAlloc(allocated + 1U);
+
+    if (dst == NULL) {
+	allocated = numBytes;
+	dst = (char *)Tcl_Alloc(allocated + 1U);
+    }
+    objPtr->bytes = dst;
+    objPtr->length = numBytes;
+    for (i = 0; i < ropePtr->numPieces; i++) {
+	Tcl_Obj *piecePtr = ropePtr->pieces[i];
+
+	memcpy(dst, piecePtr->bytes, piecePtr->length);
+	dst += piecePtr->length;
+    }
+    *dst = '\0';
+    FreeRopeInternalRep(objPtr);
+
+    stringPtr->numChars = TCL_INDEX_NONE;
+    stringPtr->allocated = allocated;
+    stringPtr->maxChars = 0;
+    stringPtr->hasUnicode = 0;
+    stringPtr->indexPtr = NULL;
+    SET_STRING(objPtr, stringPtr);
+    objPtr->typePtr = &tclStringType;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * FreeRopeInternalRep --
+ *
+ *	Deallocate the storage associated with a rope object's internal
+ *	representation.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	Releases the pieces and frees the Rope.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+FreeRopeInternalRep(
+    Tcl_Obj *objPtr)		/* Object with internal rep to free. */
+{
+    Rope *ropePtr = GET_ROPE(objPtr);
+    size_t i;
+
+    for (i = 0; i < ropePtr->numPieces; i++) {
+	Tcl_DecrRefCount(ropePtr->pieces[i]);
+    }
+    Tcl_Free(ropePtr);
+    objPtr->typePtr = NULL;
+}
 
 /*
  * Local Variables:
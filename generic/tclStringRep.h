@@ -50,6 +50,39 @@
  * tcl.h, but do not do that unless you are sure what you're doing!
  */
 
+/*
+ * The following structure is a sparse index of the characters of a String
+ * object that has no Unicode representation: the byte offset of every
+ * STRING_INDEX_STEP'th character of objPtr->bytes. It lets indexing
+ * operations find a character by walking at most STRING_INDEX_STEP-1
+ * characters, without the Tcl_UniChar array that would take 4 bytes per
+ * character. It is only built for strings in canonical form, where the
+ * characters and their UTF-8 encodings map one to one.
+ *
+ * Characters are checked, and checkpoints recorded, only as far as some
+ * lookup has needed them. Appending to the string leaves that prefix intact,
+ * so the index survives appends and is extended on the next lookup.
+ */
+
+#define STRING_INDEX_STEP 64
+
+typedef struct {
+    size_t numChars;		/* Number of characters checked so far. */
+    size_t numBytes;		/* Number of bytes they take. */
+    size_t lastChar;		/* A character found by the latest lookup, */
+    size_t lastByte;		/* and its offset, for sequential access. */
+    size_t numOffsets;		/* Number of checkpoints in offsets. */
+    size_t maxOffsets;		/* Room for checkpoints in offsets. */
+    size_t offsets[TCLFLEXARRAY];
+				/* offsets[i] is the byte offset of character
+				 * i*STRING_INDEX_STEP. The actual size of this
+				 * field depends on the 'maxOffsets' field
+				 * above. */
+} StringIndex;
+
+#define STRING_INDEX_SIZE(maxOffsets) \
+    (offsetof(StringIndex, offsets) + ((maxOffsets) * sizeof(size_t)))
+
 typedef struct {
     size_t numChars;		/* The number of chars in the string. -1 means
 				 * this value has not been calculated. Any other
@@ -63,6 +96,9 @@ typedef struct {
 				 * space allocated for the unicode array. */
     int hasUnicode;		/* Boolean determining whether the string has
 				 * a Unicode representation. */
+    StringIndex *indexPtr;	/* Sparse character index of the UTF string,
+				 * or NULL. Never present together with a
+				 * Unicode representation. */
     Tcl_UniChar unicode[TCLFLEXARRAY];	/* The array of Unicode chars. The actual size
 				 * of this field depends on the 'maxChars'
 				 * field above. */
@@ -83,6 +119,39 @@ typedef struct {
 #define SET_STRING(objPtr, stringPtr) \
     ((objPtr)->internalRep.twoPtrValue.ptr2 = NULL),			\
     ((objPtr)->internalRep.twoPtrValue.ptr1 = (void *) (stringPtr))
+
+/*
+ * The following structure is the internal rep for a rope: a long string
+ * value built by appending or concatenating other long values, kept as the
+ * sequence of values it was made of rather than as one buffer. The value has
+ * no string rep until something asks for it; the pieces are then copied out
+ * once and the value becomes an ordinary String object. Until then, appends
+ * only add pieces, and writing the value to a channel writes the pieces one
+ * by one.
+ *
+ * Every piece is a non-empty value with a string rep, and never a rope
+ * itself. No piece but the first starts with a UTF-8 continuation byte, so
+ * the joints between pieces fall between characters. Short appends are
+ * copied into the last piece when the rope holds the only reference to it.
+ */
+
+typedef struct {
+    size_t numBytes;		/* Total length of the pieces, in bytes. */
+    size_t numPieces;		/* Number of pieces in use. */
+    size_t maxPieces;		/* Room for pieces in the pieces array. */
+    Tcl_Obj *pieces[TCLFLEXARRAY];
+				/* The pieces, each holding a reference. The
+				 * actual size of this field depends on the
+				 * 'maxPieces' field above. */
+} Rope;
+
+#define ROPE_SIZE(maxPieces) \
+    (offsetof(Rope, pieces) + ((maxPieces) * sizeof(Tcl_Obj *)))
+#define GET_ROPE(objPtr) \
+    ((Rope *) (objPtr)->internalRep.twoPtrValue.ptr1)
+#define SET_ROPE(objPtr, ropePtr) \
+    ((objPtr)->internalRep.twoPtrValue.ptr2 = NULL),			\
+    ((objPtr)->internalRep.twoPtrValue.ptr1 = (void *) (ropePtr))
 
 #endif /*  _TCLSTRINGREP */
 /*
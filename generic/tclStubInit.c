@@ -551,6 +551,7 @@ static const TclIntStubs tclIntStubs = {
     TclPtrUnsetVar, /* 256 */
     TclStaticLibrary, /* 257 */
     TclpCreateTemporaryDirectory, /* 258 */
+    TclSetLsortThreadsForTest, /* 259 */
 };
 
 static const TclIntPlatStubs tclIntPlatStubs = {
@@ -1367,6 +1368,7 @@ const TclStubs tclStubs = {
     Tcl_UtfAtIndex, /* 671 */
     Tcl_GetRange, /* 672 */
     Tcl_GetUniChar, /* 673 */
+    Tcl_ChannelOutputVProc, /* 674 */
 };
 
 /* !END!: Do not edit above this line. */
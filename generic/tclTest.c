@@ -252,6 +252,7 @@ static Tcl_CmdProc	TestinterpdeleteCmd;
 static Tcl_CmdProc	TestlinkCmd;
 static Tcl_ObjCmdProc	TestlinkarrayCmd;
 static Tcl_ObjCmdProc	TestlocaleCmd;
+static Tcl_ObjCmdProc	TestlsortthreadsCmd;
 static Tcl_CmdProc	TestmainthreadCmd;
 static Tcl_CmdProc	TestsetmainloopCmd;
 static Tcl_CmdProc	TestexitmainloopCmd;
@@ -636,6 +637,8 @@ Tcltest_Init(
     Tcl_CreateObjCommand(interp, "testlinkarray", TestlinkarrayCmd, NULL, NULL);
     Tcl_CreateObjCommand(interp, "testlocale", TestlocaleCmd, NULL,
 	    NULL);
+    Tcl_CreateObjCommand(interp, "testlsortthreads", TestlsortthreadsCmd,
+	    NULL, NULL);
     Tcl_CreateCommand(interp, "testpanic", TestpanicCmd, NULL, NULL);
     Tcl_CreateObjCommand(interp, "testparseargs", TestparseargsCmd,NULL,NULL);
     Tcl_CreateObjCommand(interp, "testparser", TestparserObjCmd,
@@ -3441,6 +3444,52 @@ TestlocaleCmd(
     }
     return TCL_OK;
 }
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TestlsortthreadsCmd --
+ *
+ *	This procedure implements the "testlsortthreads" command. It sets the
+ *	number of threads that long lists are sorted on by lsort, whatever the
+ *	number of processors; 0 restores the default of one per processor.
+ *
+ * Results:
+ *	A standard Tcl result: the previous setting.
+ *
+ * Side effects:
+ *	Changes how lsort shares out sorts.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+TestlsortthreadsCmd(
+    TCL_UNUSED(void *),
+    Tcl_Interp *interp,		/* Current interpreter. */
+    int objc,			/* Number of arguments. */
+    Tcl_Obj *const objv[])	/* The argument objects. */
+{
+    int count = -1;
+
+    if (objc > 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "?count?");
+	return TCL_ERROR;
+    }
+    if (objc == 2) {
+	if (Tcl_GetIntFromObj(interp, objv[1], &count) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	if (count < 0) {
+	    Tcl_SetObjResult(interp, Tcl_NewStringObj(
+		    "thread count must be at least 0", -1));
+	    return TCL_ERROR;
+	}
+    }
+    Tcl_SetObjResult(interp, Tcl_NewWideIntObj(
+	    TclSetLsortThreadsForTest(count)));
+    return TCL_OK;
+}
 
 /*
  *----------------------------------------------------------------------
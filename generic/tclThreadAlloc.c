@@ -5,6 +5,12 @@
  *	avoid lock contention). The basic strategy is to allocate memory in
  *	fixed size blocks from block caches.
  *
+ *	When built with USE_SLAB_ALLOC, a second backend is used instead of
+ *	the bucket caches: blocks of finer grained size classes are carved out
+ *	of aligned slabs owned by a single thread, frees from other threads
+ *	are handed back to the owner without locking, and the pages of empty
+ *	slabs are returned to the system.
+ *
  * The Initial Developer of the Original Code is America Online, Inc.
  * Portions created by AOL are Copyright © 1999 America Online, Inc.
  *
@@ -28,6 +34,13 @@
 #endif
 #endif
 
+#if defined(USE_SLAB_ALLOC) && !defined(_WIN32)
+#include <sys/mman.h>
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
 /*
  * The following define the number of Tcl_Obj's to allocate/move at a time and
  * the high water mark to prune a per-thread cache. On a 32 bit system,
@@ -77,6 +90,76 @@ typedef union Block {
 #define NBUCKETS	(11 - (MINALLOC >> 5))
 #define MAXALLOC	(MINALLOC << (NBUCKETS - 1))
 
+#ifdef USE_SLAB_ALLOC
+/*
+ * The slab backend carves the blocks of one size class out of SLAB_SIZE
+ * aligned slabs, so that the slab of a block is found by masking its address.
+ * Slabs are obtained from the system SLAB_CHUNK at a time, and never given
+ * back; instead, the pages of empty slabs in excess of SLAB_KEEP_EMPTY per
+ * thread are released with madvise() and the slabs are parked in a global
+ * pool. Requests larger than SLAB_MAXALLOC go to the system allocator.
+ * SLAB_SWEEP is the number of full slabs looked at for blocks freed by other
+ * threads each time the current slab of a size class is exhausted.
+ */
+
+#define SLAB_SIZE	((size_t)1 << 16)
+#define SLAB_CHUNK	16
+#define SLAB_MAXALLOC	(SLAB_SIZE / 4)
+#define SLAB_KEEP_EMPTY	4
+#define SLAB_SWEEP	4
+#define NCLASSES	48
+
+/*
+ * The following structure is the header of each slab. All fields except
+ * remotePtr are only accessed by the thread owning the slab, or with the pool
+ * lock held when the slab is not owned.
+ */
+
+typedef struct Slab {
+    struct Slab *nextPtr;	/* Next slab in list. */
+    struct Slab *prevPtr;	/* Previous slab in owner's class list. */
+    struct Cache *ownerPtr;	/* Cache allocating from this slab, NULL if
+				 * it is empty or orphaned by its thread. */
+    Block *freePtr;		/* Blocks freed by the owner. */
+    Block *remotePtr;		/* Blocks freed by other threads, pushed and
+				 * taken with atomic operations. */
+    char *unusedPtr;		/* Start of the never allocated tail, NULL
+				 * when the slab has been carved entirely. */
+    size_t blockSize;		/* Size of each block, including Block. */
+    size_t numBlocks;		/* Number of blocks in the slab. */
+    size_t numUsed;		/* Blocks not on the owner's free list. */
+    int sizeClass;		/* Size class of the blocks. */
+    int isFull;			/* Slab is on the full list of its class. */
+} Slab;
+
+#define SLAB_HDRSIZE \
+	((sizeof(Slab) + (TCL_ALLOCALIGN-1)) & ~(TCL_ALLOCALIGN-1))
+#define Ptr2Slab(ptr) \
+	((Slab *)((size_t)(ptr) & ~(SLAB_SIZE - 1)))
+
+/*
+ * The following structure defines the slabs of one size class owned by a
+ * thread, with various accounting and statistics information.
+ */
+
+typedef struct {
+    Slab *partialPtr;		/* Slabs with blocks available; the first one
+				 * is allocated from. */
+    Slab *fullPtr;		/* Slabs without blocks known available. */
+    Slab *sweepPtr;		/* Next full slab to look at for blocks freed
+				 * by other threads. */
+    size_t numFree;		/* Number of blocks available */
+
+    /* All fields below for accounting only */
+
+    size_t numRemoves;		/* Number of blocks allocated */
+    size_t numInserts;		/* Number of blocks freed by owner */
+    size_t numRemote;		/* Number of remote frees reclaimed */
+    size_t numSlabs;		/* Number of slabs owned */
+    size_t totalAssigned;	/* Total space assigned to class */
+} SizeClass;
+#endif /* USE_SLAB_ALLOC */
+
 /*
  * The following structure defines a bucket of blocks with various accounting
  * and statistics information.
@@ -109,9 +192,39 @@ typedef struct Cache {
     size_t numObjects;		/* Number of objects for thread */
     Tcl_Obj *lastPtr;		/* Last object in this cache */
     size_t totalAssigned;	/* Total space assigned to thread */
+#ifdef USE_SLAB_ALLOC
+    Slab *emptyPtr;		/* Empty slabs kept for reuse */
+    size_t numEmpty;		/* Number of empty slabs kept */
+    SizeClass classes[NCLASSES];/* The size classes for this thread */
+#else
     Bucket buckets[NBUCKETS];	/* The buckets for this thread */
+#endif
 } Cache;
 
+#ifdef USE_SLAB_ALLOC
+/*
+ * The following arrays specify the size classes and map rounded request
+ * sizes to them. They are initialized in TclInitThreadAlloc().
+ */
+
+static struct {
+    size_t blockSize;		/* Class blocksize. */
+    size_t numBlocks;		/* Blocks per slab. */
+} classInfo[NCLASSES];
+static int numClasses;
+static unsigned char sizeClasses[SLAB_MAXALLOC / TCL_ALLOCALIGN + 1];
+
+/*
+ * Slabs not owned by any thread. The orphans of each class still have blocks
+ * in use and are adopted by the next thread running out of that class.
+ */
+
+static Tcl_Mutex *poolLockPtr;
+static Slab *poolPtr;
+static Slab *orphanPtrs[NCLASSES];
+static size_t pageSize;
+#else /* !USE_SLAB_ALLOC */
+
 /*
  * The following array specifies various per-bucket limits and locks. The
  * values are statically initialized to avoid calculating them repeatedly.
@@ -123,18 +236,32 @@ static struct {
     size_t numMove;			/* Num blocks to move to share. */
     Tcl_Mutex *lockPtr;		/* Share bucket lock. */
 } bucketInfo[NBUCKETS];
+#endif /* USE_SLAB_ALLOC */
 
 /*
  * Static functions defined in this file.
  */
 
 static Cache *	GetCache(void);
+#ifdef USE_SLAB_ALLOC
+static Block *	GetSlabBlock(Cache *cachePtr, int sizeClass);
+static Slab *	NewSlab(Cache *cachePtr, int sizeClass);
+static Slab *	AdoptSlab(Cache *cachePtr, int sizeClass);
+static Slab *	SysAllocSlabs(void);
+static void	EmptySlab(Cache *cachePtr, Slab *slabPtr);
+static void	TrimEmptySlabs(Cache *cachePtr, size_t keep);
+static void	ReleaseSlabs(Cache *cachePtr);
+static size_t	ReclaimRemote(Slab *slabPtr);
+static void	RemoteFree(Slab *slabPtr, Block *blockPtr);
+#else
 static void	LockBucket(Cache *cachePtr, int bucket);
 static void	UnlockBucket(Cache *cachePtr, int bucket);
 static void	PutBlocks(Cache *cachePtr, int bucket, size_t numMove);
 static int	GetBlocks(Cache *cachePtr, int bucket);
+#endif
 static Block *	Ptr2Block(void *ptr);
 static void *	Block2Ptr(Block *blockPtr, int bucket, size_t reqSize);
+static void	GetObjs(Cache *cachePtr, size_t numNeeded);
 static void	MoveObjs(Cache *fromPtr, Cache *toPtr, size_t numMove);
 static void	PutObjs(Cache *fromPtr, size_t numMove);
 
@@ -247,17 +374,23 @@ TclFreeAllocCache(
 {
     Cache *cachePtr = (Cache*)arg;
     Cache **nextPtrPtr;
+#ifndef USE_SLAB_ALLOC
     unsigned int bucket;
+#endif
 
     /*
      * Flush blocks.
      */
 
+#ifdef USE_SLAB_ALLOC
+    ReleaseSlabs(cachePtr);
+#else
     for (bucket = 0; bucket < NBUCKETS; ++bucket) {
 	if (cachePtr->buckets[bucket].numFree > 0) {
 	    PutBlocks(cachePtr, bucket, cachePtr->buckets[bucket].numFree);
 	}
     }
+#endif
 
     /*
      * Flush objs.
@@ -282,6 +415,307 @@ TclFreeAllocCache(
     TclpSysFree(cachePtr);
 }
 
+#ifdef USE_SLAB_ALLOC
+/*
+ *----------------------------------------------------------------------
+ *
+ * SlabLink, SlabUnlink, SlabPop --
+ *
+ *	Insert a slab at the head of, or remove it from, a list of slabs of
+ *	a size class, and pop a block from a slab owned by this thread.
+ *
+ * Results:
+ *	SlabPop returns the block or NULL if the slab has no blocks left
+ *	besides those freed by other threads.
+ *
+ * Side effects:
+ *	None.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static inline void
+SlabLink(
+    Slab **headPtrPtr,
+    Slab *slabPtr)
+{
+    slabPtr->prevPtr = NULL;
+    slabPtr->nextPtr = *headPtrPtr;
+    if (*headPtrPtr != NULL) {
+	(*headPtrPtr)->prevPtr = slabPtr;
+    }
+    *headPtrPtr = slabPtr;
+}
+
+static inline void
+SlabUnlink(
+    Slab **headPtrPtr,
+    Slab *slabPtr)
+{
+    if (slabPtr->prevPtr != NULL) {
+	slabPtr->prevPtr->nextPtr = slabPtr->nextPtr;
+    } else {
+	*headPtrPtr = slabPtr->nextPtr;
+    }
+    if (slabPtr->nextPtr != NULL) {
+	slabPtr->nextPtr->prevPtr = slabPtr->prevPtr;
+    }
+}
+
+static inline Block *
+SlabPop(
+    Slab *slabPtr)
+{
+    Block *blockPtr = slabPtr->freePtr;
+
+    if (blockPtr != NULL) {
+	slabPtr->freePtr = blockPtr->nextBlock;
+    } else if (slabPtr->unusedPtr != NULL) {
+	blockPtr = (Block *) slabPtr->unusedPtr;
+	slabPtr->unusedPtr += slabPtr->blockSize;
+	if (slabPtr->unusedPtr + slabPtr->blockSize
+		> (char *) slabPtr + SLAB_SIZE) {
+	    slabPtr->unusedPtr = NULL;
+	}
+    } else {
+	return NULL;
+    }
+    slabPtr->numUsed++;
+    return blockPtr;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclpAlloc --
+ *
+ *	Allocate memory.
+ *
+ * Results:
+ *	Pointer to memory just beyond Block pointer.
+ *
+ * Side effects:
+ *	May take a slab for the size class.
+ *
+ *----------------------------------------------------------------------
+ */
+
+void *
+TclpAlloc(
+    size_t reqSize)
+{
+    Cache *cachePtr;
+    Block *blockPtr;
+    Slab *slabPtr;
+    int sizeClass;
+    size_t size;
+
+    GETCACHE(cachePtr);
+
+    /*
+     * Increment the requested size to include room for the Block structure.
+     * Call TclpSysAlloc() directly if the required amount is greater than the
+     * largest size class, otherwise pop a block of the class from the current
+     * slab, finding another slab if that one is exhausted.
+     */
+
+    size = reqSize + sizeof(Block);
+#if RCHECK
+    size++;
+#endif
+    if (size > SLAB_MAXALLOC) {
+	blockPtr = (Block *)TclpSysAlloc(size);
+	if (blockPtr == NULL) {
+	    return NULL;
+	}
+	cachePtr->totalAssigned += reqSize;
+	return Block2Ptr(blockPtr, NCLASSES, reqSize);
+    }
+
+    sizeClass = sizeClasses[(size + TCL_ALLOCALIGN - 1) / TCL_ALLOCALIGN];
+    slabPtr = cachePtr->classes[sizeClass].partialPtr;
+    if (slabPtr == NULL || (blockPtr = SlabPop(slabPtr)) == NULL) {
+	blockPtr = GetSlabBlock(cachePtr, sizeClass);
+	if (blockPtr == NULL) {
+	    return NULL;
+	}
+    }
+    cachePtr->classes[sizeClass].numFree--;
+    cachePtr->classes[sizeClass].numRemoves++;
+    cachePtr->classes[sizeClass].totalAssigned += reqSize;
+    return Block2Ptr(blockPtr, sizeClass, reqSize);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclpFree --
+ *
+ *	Return blocks to their slab.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	May give up an empty slab.
+ *
+ *----------------------------------------------------------------------
+ */
+
+void
+TclpFree(
+    void *ptr)
+{
+    Cache *cachePtr;
+    Block *blockPtr;
+    Slab *slabPtr, *headPtr;
+    SizeClass *clsPtr;
+    int sizeClass;
+
+    if (ptr == NULL) {
+	return;
+    }
+
+    GETCACHE(cachePtr);
+
+    /*
+     * Get the block back from the user pointer and call system free directly
+     * for large blocks. Blocks of a slab owned by another thread are handed
+     * to that thread through the remote list of the slab, otherwise the block
+     * is pushed back on the free list of the slab.
+     */
+
+    blockPtr = Ptr2Block(ptr);
+    sizeClass = blockPtr->sourceBucket;
+    if (sizeClass == NCLASSES) {
+	cachePtr->totalAssigned -= blockPtr->blockReqSize;
+	TclpSysFree(blockPtr);
+	return;
+    }
+
+    clsPtr = &cachePtr->classes[sizeClass];
+    clsPtr->totalAssigned -= blockPtr->blockReqSize;
+    slabPtr = Ptr2Slab(blockPtr);
+    if (slabPtr->ownerPtr != cachePtr) {
+	RemoteFree(slabPtr, blockPtr);
+	return;
+    }
+
+    blockPtr->nextBlock = slabPtr->freePtr;
+    slabPtr->freePtr = blockPtr;
+    slabPtr->numUsed--;
+    clsPtr->numFree++;
+    clsPtr->numInserts++;
+
+    if (slabPtr->isFull) {
+	if (clsPtr->sweepPtr == slabPtr) {
+	    clsPtr->sweepPtr = slabPtr->nextPtr;
+	}
+	SlabUnlink(&clsPtr->fullPtr, slabPtr);
+	slabPtr->isFull = 0;
+
+	/*
+	 * Keep allocating from the current slab, so that this one gets the
+	 * chance to become empty.
+	 */
+
+	headPtr = clsPtr->partialPtr;
+	if (headPtr == NULL) {
+	    SlabLink(&clsPtr->partialPtr, slabPtr);
+	} else {
+	    SlabLink(&headPtr->nextPtr, slabPtr);
+	    slabPtr->prevPtr = headPtr;
+	}
+    } else if (slabPtr->numUsed == 0 && slabPtr != clsPtr->partialPtr) {
+	SlabUnlink(&clsPtr->partialPtr, slabPtr);
+	EmptySlab(cachePtr, slabPtr);
+    }
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclpRealloc --
+ *
+ *	Re-allocate memory to a larger or smaller size.
+ *
+ * Results:
+ *	Pointer to memory just beyond Block pointer.
+ *
+ * Side effects:
+ *	Previous memory, if any, may be freed.
+ *
+ *----------------------------------------------------------------------
+ */
+
+void *
+TclpRealloc(
+    void *ptr,
+    size_t reqSize)
+{
+    Cache *cachePtr;
+    Block *blockPtr;
+    void *newPtr;
+    size_t size, min;
+    int sizeClass;
+
+    if (ptr == NULL) {
+	return TclpAlloc(reqSize);
+    }
+
+    GETCACHE(cachePtr);
+
+    /*
+     * If the block is a slab block and the new size maps to the same size
+     * class, simply return the existing pointer. Otherwise, if the block is a
+     * system block and the new size would also require a system block, call
+     * TclpSysRealloc() directly.
+     */
+
+    blockPtr = Ptr2Block(ptr);
+    size = reqSize + sizeof(Block);
+#if RCHECK
+    size++;
+#endif
+    sizeClass = blockPtr->sourceBucket;
+    if (sizeClass != NCLASSES) {
+	if (sizeClass > 0) {
+	    min = classInfo[sizeClass-1].blockSize;
+	} else {
+	    min = 0;
+	}
+	if (size > min && size <= classInfo[sizeClass].blockSize) {
+	    cachePtr->classes[sizeClass].totalAssigned -= blockPtr->blockReqSize;
+	    cachePtr->classes[sizeClass].totalAssigned += reqSize;
+	    return Block2Ptr(blockPtr, sizeClass, reqSize);
+	}
+    } else if (size > SLAB_MAXALLOC) {
+	cachePtr->totalAssigned -= blockPtr->blockReqSize;
+	cachePtr->totalAssigned += reqSize;
+	blockPtr = (Block*)TclpSysRealloc(blockPtr, size);
+	if (blockPtr == NULL) {
+	    return NULL;
+	}
+	return Block2Ptr(blockPtr, NCLASSES, reqSize);
+    }
+
+    /*
+     * Finally, perform an expensive malloc/copy/free.
+     */
+
+    newPtr = TclpAlloc(reqSize);
+    if (newPtr != NULL) {
+	if (reqSize > blockPtr->blockReqSize) {
+	    reqSize = blockPtr->blockReqSize;
+	}
+	memcpy(newPtr, ptr, reqSize);
+	TclpFree(ptr);
+    }
+    return newPtr;
+}
+
+#else /* !USE_SLAB_ALLOC */
+
 /*
  *----------------------------------------------------------------------
  *
@@ -486,6 +920,8 @@ TclpRealloc(
     return newPtr;
 }
 
+#endif /* USE_SLAB_ALLOC */
+
 /*
  *----------------------------------------------------------------------
  *
@@ -521,33 +957,7 @@ TclThreadAllocObj(void)
      */
 
     if (cachePtr->numObjects == 0) {
-	size_t numMove;
-
-	Tcl_MutexLock(objLockPtr);
-	numMove = sharedPtr->numObjects;
-	if (numMove > 0) {
-	    if (numMove > NOBJALLOC) {
-		numMove = NOBJALLOC;
-	    }
-	    MoveObjs(sharedPtr, cachePtr, numMove);
-	}
-	Tcl_MutexUnlock(objLockPtr);
-	if (cachePtr->numObjects == 0) {
-	    Tcl_Obj *newObjsPtr;
-
-	    cachePtr->numObjects = numMove = NOBJALLOC;
-	    newObjsPtr = (Tcl_Obj *)TclpSysAlloc(sizeof(Tcl_Obj) * numMove);
-	    if (newObjsPtr == NULL) {
-		Tcl_Panic("alloc: could not allocate %" TCL_Z_MODIFIER "u new objects", numMove);
-	    }
-	    cachePtr->lastPtr = newObjsPtr + numMove - 1;
-	    objPtr = cachePtr->firstObjPtr;	/* NULL */
-	    while (numMove-- > 0) {
-		newObjsPtr[numMove].internalRep.twoPtrValue.ptr1 = objPtr;
-		objPtr = newObjsPtr + numMove;
-	    }
-	    cachePtr->firstObjPtr = newObjsPtr;
-	}
+	GetObjs(cachePtr, 1);
     }
 
     /*
@@ -563,34 +973,75 @@ TclThreadAllocObj(void)
 /*
  *----------------------------------------------------------------------
  *
- * TclThreadFreeObj --
+ * TclThreadAllocObjs --
  *
- *	Return a free Tcl_Obj to the per-thread cache.
+ *	Allocate a number of Tcl_Obj's from the per-thread cache at once.
  *
  * Results:
- *	None.
+ *	Pointers to uninitialized Tcl_Obj's are stored in objv.
  *
  * Side effects:
- *	May move free Tcl_Obj's to shared list upon hitting high water mark.
- *
- * Note:
- *	If this code is updated, the changes need to be reflected in the macro
- *	TclAllocObjStorageEx() defined in tclInt.h
+ *	May move Tcl_Obj's from shared cache or allocate new Tcl_Obj's if
+ *	there are not enough in the list.
  *
  *----------------------------------------------------------------------
  */
 
 void
-TclThreadFreeObj(
-    Tcl_Obj *objPtr)
+TclThreadAllocObjs(
+    size_t objc,
+    Tcl_Obj **objv)
 {
     Cache *cachePtr;
+    Tcl_Obj *objPtr;
+    size_t i;
 
     GETCACHE(cachePtr);
 
-    /*
-     * Get this thread's list and push on the free Tcl_Obj.
-     */
+    if (cachePtr->numObjects < objc) {
+	GetObjs(cachePtr, objc - cachePtr->numObjects);
+    }
+
+    objPtr = cachePtr->firstObjPtr;
+    for (i = 0; i < objc; i++) {
+	objv[i] = objPtr;
+	objPtr = (Tcl_Obj *)objPtr->internalRep.twoPtrValue.ptr1;
+    }
+    cachePtr->firstObjPtr = objPtr;
+    cachePtr->numObjects -= objc;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclThreadFreeObj --
+ *
+ *	Return a free Tcl_Obj to the per-thread cache.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	May move free Tcl_Obj's to shared list upon hitting high water mark.
+ *
+ * Note:
+ *	If this code is updated, the changes need to be reflected in the macro
+ *	TclAllocObjStorageEx() defined in tclInt.h
+ *
+ *----------------------------------------------------------------------
+ */
+
+void
+TclThreadFreeObj(
+    Tcl_Obj *objPtr)
+{
+    Cache *cachePtr;
+
+    GETCACHE(cachePtr);
+
+    /*
+     * Get this thread's list and push on the free Tcl_Obj.
+     */
 
     objPtr->internalRep.twoPtrValue.ptr1 = cachePtr->firstObjPtr;
     cachePtr->firstObjPtr = objPtr;
@@ -609,12 +1060,62 @@ TclThreadFreeObj(
     }
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclThreadFreeObjs --
+ *
+ *	Return a chain of free Tcl_Obj's, linked through their
+ *	internalRep.twoPtrValue.ptr1 field, to the per-thread cache at once.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	May move free Tcl_Obj's to shared list upon hitting high water mark,
+ *	all in one batch.
+ *
+ *----------------------------------------------------------------------
+ */
+
+void
+TclThreadFreeObjs(
+    Tcl_Obj *firstPtr,		/* First object of the chain. */
+    Tcl_Obj *lastPtr,		/* Last object of the chain. */
+    size_t numObjs)		/* Number of objects in the chain. */
+{
+    Cache *cachePtr;
+
+    GETCACHE(cachePtr);
+
+    lastPtr->internalRep.twoPtrValue.ptr1 = cachePtr->firstObjPtr;
+    cachePtr->firstObjPtr = firstPtr;
+    if (cachePtr->numObjects == 0) {
+	cachePtr->lastPtr = lastPtr;
+    }
+    cachePtr->numObjects += numObjs;
+
+    /*
+     * Keep as many objects as a single TclThreadFreeObj() would after
+     * hitting the high water mark, and hand the rest to the shared list.
+     */
+
+    if (cachePtr->numObjects > NOBJHIGH) {
+	PutObjs(cachePtr, cachePtr->numObjects - (NOBJHIGH - NOBJALLOC));
+    }
+}
+
 /*
  *----------------------------------------------------------------------
  *
  * Tcl_GetMemoryInfo --
  *
- *	Return a list-of-lists of memory stats.
+ *	Return a list-of-lists of memory stats. Each cache is described by
+ *	its name followed by one element per bucket, holding the block size,
+ *	number of free blocks, removes, inserts, total space assigned and
+ *	number of locks. With the slab backend there is one element per size
+ *	class, where the number of locks is replaced by the number of blocks
+ *	freed by other threads and the number of slabs.
  *
  * Results:
  *	None.
@@ -643,6 +1144,26 @@ Tcl_GetMemoryInfo(
 	    sprintf(buf, "thread%p", cachePtr->owner);
 	    Tcl_DStringAppendElement(dsPtr, buf);
 	}
+#ifdef USE_SLAB_ALLOC
+	/*
+	 * The shared cache owns no slabs; its numSlabs counts the orphaned
+	 * slabs of each class.
+	 */
+
+	for (n = 0; n < (unsigned int) numClasses; ++n) {
+	    sprintf(buf, "%" TCL_Z_MODIFIER "u %" TCL_Z_MODIFIER "u %" TCL_Z_MODIFIER "u %"
+		    TCL_Z_MODIFIER "u %" TCL_Z_MODIFIER "u %" TCL_Z_MODIFIER "u %"
+		    TCL_Z_MODIFIER "u",
+		    classInfo[n].blockSize,
+		    cachePtr->classes[n].numFree,
+		    cachePtr->classes[n].numRemoves,
+		    cachePtr->classes[n].numInserts,
+		    cachePtr->classes[n].totalAssigned,
+		    cachePtr->classes[n].numRemote,
+		    cachePtr->classes[n].numSlabs);
+	    Tcl_DStringAppendElement(dsPtr, buf);
+	}
+#else
 	for (n = 0; n < NBUCKETS; ++n) {
 	    sprintf(buf, "%" TCL_Z_MODIFIER "u %" TCL_Z_MODIFIER "u %" TCL_Z_MODIFIER "u %"
 		    TCL_Z_MODIFIER "u %" TCL_Z_MODIFIER "u %" TCL_Z_MODIFIER "u",
@@ -654,12 +1175,71 @@ Tcl_GetMemoryInfo(
 		    cachePtr->buckets[n].numLocks);
 	    Tcl_DStringAppendElement(dsPtr, buf);
 	}
+#endif
 	Tcl_DStringEndSublist(dsPtr);
 	cachePtr = cachePtr->nextPtr;
     }
     Tcl_MutexUnlock(listLockPtr);
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * GetObjs --
+ *
+ *	Add at least numNeeded Tcl_Obj's to a thread cache, moving them from
+ *	the shared cache if possible and allocating new ones otherwise.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	None.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+GetObjs(
+    Cache *cachePtr,
+    size_t numNeeded)
+{
+    Tcl_Obj *newObjsPtr, *objPtr;
+    size_t numMove;
+
+    Tcl_MutexLock(objLockPtr);
+    numMove = sharedPtr->numObjects;
+    if (numMove > 0) {
+	if (numMove > NOBJALLOC && numMove > numNeeded) {
+	    numMove = (numNeeded > NOBJALLOC) ? numNeeded : NOBJALLOC;
+	}
+	MoveObjs(sharedPtr, cachePtr, numMove);
+    }
+    Tcl_MutexUnlock(objLockPtr);
+    if (numMove >= numNeeded) {
+	return;
+    }
+
+    numMove = numNeeded - numMove;
+    if (numMove < NOBJALLOC) {
+	numMove = NOBJALLOC;
+    }
+    newObjsPtr = (Tcl_Obj *)TclpSysAlloc(sizeof(Tcl_Obj) * numMove);
+    if (newObjsPtr == NULL) {
+	Tcl_Panic("alloc: could not allocate %" TCL_Z_MODIFIER "u new objects", numMove);
+    }
+    if (cachePtr->numObjects == 0) {
+	cachePtr->lastPtr = newObjsPtr + numMove - 1;
+    }
+    cachePtr->numObjects += numMove;
+    objPtr = cachePtr->firstObjPtr;
+    while (numMove-- > 0) {
+	newObjsPtr[numMove].internalRep.twoPtrValue.ptr1 = objPtr;
+	objPtr = newObjsPtr + numMove;
+    }
+    cachePtr->firstObjPtr = newObjsPtr;
+}
+
 /*
  *----------------------------------------------------------------------
  *
@@ -684,6 +1264,7 @@ MoveObjs(
 {
     Tcl_Obj *objPtr = fromPtr->firstObjPtr;
     Tcl_Obj *fromFirstObjPtr = objPtr;
+    int toEmpty = (toPtr->numObjects == 0);
 
     toPtr->numObjects += numMove;
     fromPtr->numObjects -= numMove;
@@ -703,8 +1284,12 @@ MoveObjs(
      * just have to update the first and last.
      */
 
-    toPtr->lastPtr = objPtr;
-    objPtr->internalRep.twoPtrValue.ptr1 = toPtr->firstObjPtr; /* NULL */
+    if (toEmpty) {
+	toPtr->lastPtr = objPtr;
+	objPtr->internalRep.twoPtrValue.ptr1 = NULL;
+    } else {
+	objPtr->internalRep.twoPtrValue.ptr1 = toPtr->firstObjPtr;
+    }
     toPtr->firstObjPtr = fromFirstObjPtr;
 }
 
@@ -816,6 +1401,495 @@ Ptr2Block(
     return blockPtr;
 }
 
+#ifdef USE_SLAB_ALLOC
+/*
+ *----------------------------------------------------------------------
+ *
+ * RemoteFree, ReclaimRemote --
+ *
+ *	Push a block freed by another thread on the remote list of its slab,
+ *	and move all blocks of that list to the free list of the slab on
+ *	behalf of the owner. The list is only ever pushed to or taken as a
+ *	whole, so compare-and-swap needs no protection against reuse of the
+ *	head; without atomic operations the pool lock is used instead.
+ *
+ * Results:
+ *	ReclaimRemote returns the number of blocks reclaimed.
+ *
+ * Side effects:
+ *	None.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+RemoteFree(
+    Slab *slabPtr,
+    Block *blockPtr)
+{
+#if defined(__GNUC__)
+    Block *firstPtr = __atomic_load_n(&slabPtr->remotePtr, __ATOMIC_RELAXED);
+
+    do {
+	blockPtr->nextBlock = firstPtr;
+    } while (!__atomic_compare_exchange_n(&slabPtr->remotePtr, &firstPtr,
+	    blockPtr, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+#elif defined(_WIN32)
+    Block *firstPtr;
+
+    do {
+	firstPtr = *(Block *volatile *) &slabPtr->remotePtr;
+	blockPtr->nextBlock = firstPtr;
+    } while (InterlockedCompareExchangePointer(
+	    (PVOID volatile *) &slabPtr->remotePtr, blockPtr, firstPtr)
+	    != firstPtr);
+#else
+    Tcl_MutexLock(poolLockPtr);
+    blockPtr->nextBlock = slabPtr->remotePtr;
+    slabPtr->remotePtr = blockPtr;
+    Tcl_MutexUnlock(poolLockPtr);
+#endif
+}
+
+static size_t
+ReclaimRemote(
+    Slab *slabPtr)
+{
+    Block *firstPtr, *lastPtr;
+    size_t n;
+
+#if defined(__GNUC__)
+    if (__atomic_load_n(&slabPtr->remotePtr, __ATOMIC_RELAXED) == NULL) {
+	return 0;
+    }
+    firstPtr = __atomic_exchange_n(&slabPtr->remotePtr, NULL,
+	    __ATOMIC_ACQUIRE);
+#elif defined(_WIN32)
+    if (*(Block *volatile *) &slabPtr->remotePtr == NULL) {
+	return 0;
+    }
+    firstPtr = (Block *) InterlockedExchangePointer(
+	    (PVOID volatile *) &slabPtr->remotePtr, NULL);
+#else
+    Tcl_MutexLock(poolLockPtr);
+    firstPtr = slabPtr->remotePtr;
+    slabPtr->remotePtr = NULL;
+    Tcl_MutexUnlock(poolLockPtr);
+#endif
+    if (firstPtr == NULL) {
+	return 0;
+    }
+
+    n = 1;
+    for (lastPtr = firstPtr; lastPtr->nextBlock != NULL;
+	    lastPtr = lastPtr->nextBlock) {
+	n++;
+    }
+    lastPtr->nextBlock = slabPtr->freePtr;
+    slabPtr->freePtr = firstPtr;
+    slabPtr->numUsed -= n;
+    return n;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * GetSlabBlock --
+ *
+ *	Get a block of a size class when the current slab of the class is
+ *	exhausted.
+ *
+ * Results:
+ *	The block or NULL if no memory is available.
+ *
+ * Side effects:
+ *	Exhausted slabs are moved to the full list, full slabs that got
+ *	blocks back from other threads are moved to the partial list, and a
+ *	new slab may be adopted or taken.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static Block *
+GetSlabBlock(
+    Cache *cachePtr,
+    int sizeClass)
+{
+    SizeClass *clsPtr = &cachePtr->classes[sizeClass];
+    Slab *slabPtr;
+    Block *blockPtr;
+    size_t n;
+    int i;
+
+    /*
+     * Retire the exhausted slabs at the head of the partial list, unless
+     * other threads have given some blocks back to them.
+     */
+
+    while ((slabPtr = clsPtr->partialPtr) != NULL) {
+	n = ReclaimRemote(slabPtr);
+	clsPtr->numFree += n;
+	clsPtr->numRemote += n;
+	blockPtr = SlabPop(slabPtr);
+	if (blockPtr != NULL) {
+	    return blockPtr;
+	}
+	SlabUnlink(&clsPtr->partialPtr, slabPtr);
+	SlabLink(&clsPtr->fullPtr, slabPtr);
+	slabPtr->isFull = 1;
+    }
+
+    /*
+     * Look at a few full slabs in turn for blocks freed by other threads
+     * before taking a new slab. Looking at all of them would make filling
+     * memory quadratic.
+     */
+
+    for (i = 0; i < SLAB_SWEEP && clsPtr->fullPtr != NULL; i++) {
+	slabPtr = clsPtr->sweepPtr;
+	if (slabPtr == NULL) {
+	    slabPtr = clsPtr->fullPtr;
+	}
+	clsPtr->sweepPtr = slabPtr->nextPtr;
+	n = ReclaimRemote(slabPtr);
+	if (n == 0) {
+	    continue;
+	}
+	clsPtr->numFree += n;
+	clsPtr->numRemote += n;
+	SlabUnlink(&clsPtr->fullPtr, slabPtr);
+	slabPtr->isFull = 0;
+	if (slabPtr->numUsed == 0 && clsPtr->partialPtr != NULL) {
+	    EmptySlab(cachePtr, slabPtr);
+	} else {
+	    SlabLink(&clsPtr->partialPtr, slabPtr);
+	}
+    }
+
+    slabPtr = clsPtr->partialPtr;
+    if (slabPtr == NULL) {
+	slabPtr = AdoptSlab(cachePtr, sizeClass);
+	if (slabPtr == NULL) {
+	    slabPtr = NewSlab(cachePtr, sizeClass);
+	    if (slabPtr == NULL) {
+		return NULL;
+	    }
+	}
+	SlabLink(&clsPtr->partialPtr, slabPtr);
+    }
+    return SlabPop(slabPtr);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * AdoptSlab --
+ *
+ *	Take ownership of slabs of a size class orphaned by exited threads.
+ *
+ * Results:
+ *	A slab with blocks available or NULL if there is none. Adopted slabs
+ *	without available blocks are put on the full list of the class.
+ *
+ * Side effects:
+ *	None.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static Slab *
+AdoptSlab(
+    Cache *cachePtr,
+    int sizeClass)
+{
+    SizeClass *clsPtr = &cachePtr->classes[sizeClass];
+    Slab *slabPtr;
+    size_t n;
+
+    /*
+     * Note the dirty read of the orphan list before acquiring the lock.
+     */
+
+    while (orphanPtrs[sizeClass] != NULL) {
+	Tcl_MutexLock(poolLockPtr);
+	slabPtr = orphanPtrs[sizeClass];
+	if (slabPtr != NULL) {
+	    orphanPtrs[sizeClass] = slabPtr->nextPtr;
+	    sharedPtr->classes[sizeClass].numSlabs--;
+	    slabPtr->ownerPtr = cachePtr;
+	}
+	Tcl_MutexUnlock(poolLockPtr);
+	if (slabPtr == NULL) {
+	    break;
+	}
+
+	n = ReclaimRemote(slabPtr);
+	clsPtr->numRemote += n;
+	clsPtr->numFree += slabPtr->numBlocks - slabPtr->numUsed;
+	clsPtr->numSlabs++;
+	if (slabPtr->freePtr != NULL || slabPtr->unusedPtr != NULL) {
+	    return slabPtr;
+	}
+	SlabLink(&clsPtr->fullPtr, slabPtr);
+	slabPtr->isFull = 1;
+    }
+    return NULL;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * NewSlab --
+ *
+ *	Take an empty slab for a size class, from the slabs kept by this
+ *	thread, from the global pool or from the system.
+ *
+ * Results:
+ *	The slab or NULL if no memory is available.
+ *
+ * Side effects:
+ *	May allocate SLAB_CHUNK slabs from the system.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static Slab *
+NewSlab(
+    Cache *cachePtr,
+    int sizeClass)
+{
+    Slab *slabPtr = cachePtr->emptyPtr;
+
+    if (slabPtr != NULL) {
+	cachePtr->emptyPtr = slabPtr->nextPtr;
+	cachePtr->numEmpty--;
+    } else {
+	Tcl_MutexLock(poolLockPtr);
+	slabPtr = poolPtr;
+	if (slabPtr != NULL) {
+	    poolPtr = slabPtr->nextPtr;
+	} else {
+	    slabPtr = SysAllocSlabs();
+	}
+	Tcl_MutexUnlock(poolLockPtr);
+	if (slabPtr == NULL) {
+	    return NULL;
+	}
+    }
+
+    slabPtr->ownerPtr = cachePtr;
+    slabPtr->freePtr = NULL;
+    slabPtr->remotePtr = NULL;
+    slabPtr->unusedPtr = (char *) slabPtr + SLAB_HDRSIZE;
+    slabPtr->blockSize = classInfo[sizeClass].blockSize;
+    slabPtr->numBlocks = classInfo[sizeClass].numBlocks;
+    slabPtr->numUsed = 0;
+    slabPtr->sizeClass = sizeClass;
+    slabPtr->isFull = 0;
+    cachePtr->classes[sizeClass].numFree += slabPtr->numBlocks;
+    cachePtr->classes[sizeClass].numSlabs++;
+    return slabPtr;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * SysAllocSlabs --
+ *
+ *	Allocate SLAB_CHUNK aligned slabs from the system. Must be called
+ *	with the pool lock held.
+ *
+ * Results:
+ *	The first slab or NULL if no memory is available.
+ *
+ * Side effects:
+ *	The other slabs are put in the global pool.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static Slab *
+SysAllocSlabs(void)
+{
+    size_t size = SLAB_CHUNK * SLAB_SIZE;
+    char *memPtr, *alignedPtr;
+    Slab *slabPtr;
+    int i;
+
+#ifdef _WIN32
+    memPtr = (char *) VirtualAlloc(NULL, size + SLAB_SIZE,
+	    MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (memPtr == NULL) {
+	return NULL;
+    }
+    alignedPtr = (char *) (((size_t) memPtr + SLAB_SIZE - 1)
+	    & ~(SLAB_SIZE - 1));
+#else
+    memPtr = (char *) mmap(NULL, size + SLAB_SIZE, PROT_READ | PROT_WRITE,
+	    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memPtr == (char *) MAP_FAILED) {
+	return NULL;
+    }
+    alignedPtr = (char *) (((size_t) memPtr + SLAB_SIZE - 1)
+	    & ~(SLAB_SIZE - 1));
+
+    /*
+     * Give the unaligned head and tail of the mapping back.
+     */
+
+    if (alignedPtr > memPtr) {
+	munmap(memPtr, alignedPtr - memPtr);
+    }
+    if (memPtr + SLAB_SIZE > alignedPtr) {
+	munmap(alignedPtr + size, memPtr + SLAB_SIZE - alignedPtr);
+    }
+#endif
+
+    for (i = SLAB_CHUNK - 1; i > 0; i--) {
+	slabPtr = (Slab *) (alignedPtr + i * SLAB_SIZE);
+	slabPtr->nextPtr = poolPtr;
+	poolPtr = slabPtr;
+    }
+    return (Slab *) alignedPtr;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * EmptySlab, TrimEmptySlabs --
+ *
+ *	Keep a slab that became empty for reuse by this thread, and move the
+ *	empty slabs beyond the given number to the global pool after handing
+ *	their pages back to the system. The first page of each slab, which
+ *	holds its header, is kept.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	Trimming happens when more than SLAB_KEEP_EMPTY slabs are kept, down
+ *	to half that number, so that a thread repeatedly filling and emptying
+ *	a slab does not call into the system each time.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+EmptySlab(
+    Cache *cachePtr,
+    Slab *slabPtr)
+{
+    SizeClass *clsPtr = &cachePtr->classes[slabPtr->sizeClass];
+
+    clsPtr->numFree -= slabPtr->numBlocks;
+    clsPtr->numSlabs--;
+    slabPtr->ownerPtr = NULL;
+    slabPtr->nextPtr = cachePtr->emptyPtr;
+    cachePtr->emptyPtr = slabPtr;
+    if (++cachePtr->numEmpty > SLAB_KEEP_EMPTY) {
+	TrimEmptySlabs(cachePtr, SLAB_KEEP_EMPTY / 2);
+    }
+}
+
+static void
+TrimEmptySlabs(
+    Cache *cachePtr,
+    size_t keep)
+{
+    Slab **nextPtrPtr = &cachePtr->emptyPtr;
+    Slab *firstPtr, *slabPtr, *lastPtr = NULL;
+
+    /*
+     * The most recently emptied slabs are kept, their pages are most likely
+     * still in the processor caches.
+     */
+
+    while (keep-- > 0 && *nextPtrPtr != NULL) {
+	nextPtrPtr = &(*nextPtrPtr)->nextPtr;
+    }
+    firstPtr = *nextPtrPtr;
+    *nextPtrPtr = NULL;
+
+    for (slabPtr = firstPtr; slabPtr != NULL; slabPtr = slabPtr->nextPtr) {
+	if (pageSize < SLAB_SIZE) {
+#ifdef _WIN32
+	    VirtualAlloc((char *) slabPtr + pageSize, SLAB_SIZE - pageSize,
+		    MEM_RESET, PAGE_READWRITE);
+#elif defined(MADV_DONTNEED)
+	    madvise((char *) slabPtr + pageSize, SLAB_SIZE - pageSize,
+		    MADV_DONTNEED);
+#endif
+	}
+	cachePtr->numEmpty--;
+	lastPtr = slabPtr;
+    }
+
+    if (lastPtr != NULL) {
+	Tcl_MutexLock(poolLockPtr);
+	lastPtr->nextPtr = poolPtr;
+	poolPtr = firstPtr;
+	Tcl_MutexUnlock(poolLockPtr);
+    }
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * ReleaseSlabs --
+ *
+ *	Give up all slabs of a cache whose thread is exiting.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	Empty slabs go to the global pool, the others are orphaned until
+ *	another thread adopts them.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+ReleaseSlabs(
+    Cache *cachePtr)
+{
+    SizeClass *clsPtr;
+    Slab *slabPtr;
+    int n;
+
+    for (n = 0; n < numClasses; n++) {
+	clsPtr = &cachePtr->classes[n];
+	while (clsPtr->partialPtr != NULL || clsPtr->fullPtr != NULL) {
+	    slabPtr = clsPtr->partialPtr;
+	    if (slabPtr != NULL) {
+		clsPtr->partialPtr = slabPtr->nextPtr;
+	    } else {
+		slabPtr = clsPtr->fullPtr;
+		clsPtr->fullPtr = slabPtr->nextPtr;
+	    }
+	    slabPtr->isFull = 0;
+	    ReclaimRemote(slabPtr);
+	    if (slabPtr->numUsed == 0) {
+		slabPtr->ownerPtr = NULL;
+		slabPtr->nextPtr = cachePtr->emptyPtr;
+		cachePtr->emptyPtr = slabPtr;
+		cachePtr->numEmpty++;
+		continue;
+	    }
+
+	    Tcl_MutexLock(poolLockPtr);
+	    slabPtr->ownerPtr = NULL;
+	    slabPtr->nextPtr = orphanPtrs[n];
+	    orphanPtrs[n] = slabPtr;
+	    sharedPtr->classes[n].numSlabs++;
+	    Tcl_MutexUnlock(poolLockPtr);
+	}
+    }
+    TrimEmptySlabs(cachePtr, 0);
+}
+
+#else /* !USE_SLAB_ALLOC */
+
 /*
  *----------------------------------------------------------------------
  *
@@ -1029,6 +2103,8 @@ GetBlocks(
     return 1;
 }
 
+#endif /* USE_SLAB_ALLOC */
+
 /*
  *----------------------------------------------------------------------
  *
@@ -1050,9 +2126,43 @@ void
 TclInitThreadAlloc(void)
 {
     unsigned int i;
+#ifdef USE_SLAB_ALLOC
+    size_t size, step;
+#endif
 
     listLockPtr = TclpNewAllocMutex();
     objLockPtr = TclpNewAllocMutex();
+#ifdef USE_SLAB_ALLOC
+    /*
+     * Size classes are spaced by the alignment up to eight times the
+     * alignment, and by a quarter of the power of two below them beyond.
+     */
+
+    poolLockPtr = TclpNewAllocMutex();
+    numClasses = 0;
+    for (size = MINALLOC; size <= SLAB_MAXALLOC; size += step) {
+	if (numClasses == NCLASSES) {
+	    Tcl_Panic("alloc: too many size classes");
+	}
+	classInfo[numClasses].blockSize = size;
+	classInfo[numClasses].numBlocks = (SLAB_SIZE - SLAB_HDRSIZE) / size;
+	numClasses++;
+	for (step = TCL_ALLOCALIGN; step * 8 <= size; step <<= 1) {
+	    /* Empty loop body. */
+	}
+    }
+    for (i = 0, size = 0; size <= SLAB_MAXALLOC; size += TCL_ALLOCALIGN) {
+	while (classInfo[i].blockSize < size) {
+	    i++;
+	}
+	sizeClasses[size / TCL_ALLOCALIGN] = (unsigned char) i;
+    }
+#ifdef _WIN32
+    pageSize = 4096;
+#else
+    pageSize = (size_t) sysconf(_SC_PAGESIZE);
+#endif
+#else
     for (i = 0; i < NBUCKETS; ++i) {
 	bucketInfo[i].blockSize = MINALLOC << i;
 	bucketInfo[i].maxBlocks = ((size_t)1) << (NBUCKETS - 1 - i);
@@ -1060,6 +2170,7 @@ TclInitThreadAlloc(void)
 		(size_t)1 << (NBUCKETS - 2 - i) : 1;
 	bucketInfo[i].lockPtr = TclpNewAllocMutex();
     }
+#endif
     TclpInitAllocCache();
 }
 
@@ -1083,12 +2194,22 @@ TclInitThreadAlloc(void)
 void
 TclFinalizeThreadAlloc(void)
 {
+#ifdef USE_SLAB_ALLOC
+    /*
+     * Slabs are not given back to the system, those in the pool or orphaned
+     * are kept for the case the allocator gets initialized again.
+     */
+
+    TclpFreeAllocMutex(poolLockPtr);
+    poolLockPtr = NULL;
+#else
     unsigned int i;
 
     for (i = 0; i < NBUCKETS; ++i) {
 	TclpFreeAllocMutex(bucketInfo[i].lockPtr);
 	bucketInfo[i].lockPtr = NULL;
     }
+#endif
 
     TclpFreeAllocMutex(objLockPtr);
     objLockPtr = NULL;
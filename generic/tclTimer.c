@@ -14,8 +14,11 @@
 
 /*
  * For each timer callback that's pending there is one record of the following
- * type. The normal handlers (created by Tcl_CreateTimerHandler) are chained
- * together in a list sorted by time (earliest event first).
+ * type. The normal handlers (created by Tcl_CreateTimerHandler) are kept in a
+ * binary heap ordered by time (earliest event first), and handlers due at the
+ * same time by token, so that they fire in the order they were created. A hash
+ * table finds handlers by token, so that they can be deleted without a
+ * search.
  */
 
 typedef struct TimerHandler {
@@ -23,9 +26,8 @@ typedef struct TimerHandler {
     Tcl_TimerProc *proc;	/* Function to call. */
     ClientData clientData;	/* Argument to pass to proc. */
     Tcl_TimerToken token;	/* Identifies handler so it can be deleted. */
-    struct TimerHandler *nextPtr;
-				/* Next event in queue, or NULL for end of
-				 * queue. */
+    Tcl_HashEntry *hPtr;	/* Entry for the token in the timer table. */
+    size_t heapIndex;		/* Position of the handler in the heap. */
 } TimerHandler;
 
 /*
@@ -47,8 +49,11 @@ typedef struct AfterInfo {
 				 * handler rather than as a timer handler.
 				 * NULL means this is an "after idle" handler
 				 * rather than a timer handler. */
+    int commandIsId;		/* Set if the command looks like an "after"
+				 * identifier; see AFTER_CANCEL. */
     struct AfterInfo *nextPtr;	/* Next in list of all "after" commands for
 				 * this interpreter. */
+    struct AfterInfo *prevPtr;	/* Previous in that list, or NULL. */
 } AfterInfo;
 
 /*
@@ -63,6 +68,10 @@ typedef struct AfterAssocData {
     AfterInfo *firstAfterPtr;	/* First in list of all "after" commands still
 				 * pending for this interpreter, or NULL if
 				 * none. */
+    Tcl_HashTable idTable;	/* Maps the identifiers of those commands to
+				 * their AfterInfo. */
+    int numIdCommands;		/* Number of those commands that look like
+				 * "after" identifiers. */
 } AfterAssocData;
 
 /*
@@ -92,7 +101,15 @@ typedef struct IdleHandler {
  */
 
 typedef struct {
-    TimerHandler *firstTimerHandlerPtr;	/* First event in queue. */
+    TimerHandler **timerHeap;	/* Pending timers. Each is due no later than
+				 * the two at 2i+1 and 2i+2 after it, so the
+				 * first is the next due. NULL until a timer
+				 * is created. */
+    size_t numTimers;		/* Number of timers in the heap. */
+    size_t maxTimers;		/* Number of slots allocated for it. */
+    Tcl_HashTable timerTable;	/* Maps the tokens of the pending timers to
+				 * their TimerHandler. Initialized with the
+				 * heap. */
     int lastTimerId;		/* Timer identifier of most recently created
 				 * timer. */
     int timerPending;		/* 1 if a timer event is in the queue. */
@@ -131,6 +148,18 @@ static Tcl_ThreadDataKey dataKey;
     (1000*((Tcl_WideInt)(t1).sec - (Tcl_WideInt)(t2).sec) + \
 	    ((long)(t1).usec - (long)(t2).usec + 999)/1000)
 
+/*
+ * The order of timer handlers in the heap: by time, then by token. Tokens are
+ * compared as in TimerHandlerEventProc, so that the order survives their
+ * wrapping around.
+ */
+
+#define TIMER_BEFORE(t1Ptr, t2Ptr) \
+    (TCL_TIME_BEFORE((t1Ptr)->time, (t2Ptr)->time) \
+	    || ((t1Ptr)->time.sec == (t2Ptr)->time.sec \
+		&& (t1Ptr)->time.usec == (t2Ptr)->time.usec \
+		&& (PTR2INT((t1Ptr)->token) - PTR2INT((t2Ptr)->token)) < 0))
+
 /*
  * Sleeps under that number of milliseconds don't get double-checked
  * and are done in exactly one Tcl_Sleep(). This to limit gettimeofday()s.
@@ -158,6 +187,15 @@ static void		FreeAfterPtr(AfterInfo *afterPtr);
 static AfterInfo *	GetAfterEvent(AfterAssocData *assocPtr,
 			    Tcl_Obj *commandPtr);
 static ThreadSpecificData *InitTimer(void);
+static void		LinkAfterInfo(AfterAssocData *assocPtr,
+			    AfterInfo *afterPtr);
+static void		SiftDown(ThreadSpecificData *tsdPtr, size_t index,
+			    TimerHandler *timerHandlerPtr);
+static void		SiftUp(ThreadSpecificData *tsdPtr, size_t index,
+			    TimerHandler *timerHandlerPtr);
+static void		TimerHeapRemove(ThreadSpecificData *tsdPtr,
+			    TimerHandler *timerHandlerPtr);
+static void		UnlinkAfterInfo(AfterInfo *afterPtr);
 static void		TimerExitProc(ClientData clientData);
 static int		TimerHandlerEventProc(Tcl_Event *evPtr, int flags);
 static void		TimerCheckProc(ClientData clientData, int flags);
@@ -216,15 +254,117 @@ TimerExitProc(
     ThreadSpecificData *tsdPtr = (ThreadSpecificData *)TclThreadDataKeyGet(&dataKey);
 
     Tcl_DeleteEventSource(TimerSetupProc, TimerCheckProc, NULL);
-    if (tsdPtr != NULL) {
-	TimerHandler *timerHandlerPtr;
-
-	timerHandlerPtr = tsdPtr->firstTimerHandlerPtr;
-	while (timerHandlerPtr != NULL) {
-	    tsdPtr->firstTimerHandlerPtr = timerHandlerPtr->nextPtr;
-	    Tcl_Free(timerHandlerPtr);
-	    timerHandlerPtr = tsdPtr->firstTimerHandlerPtr;
+    if (tsdPtr != NULL && tsdPtr->timerHeap != NULL) {
+	while (tsdPtr->numTimers > 0) {
+	    Tcl_Free(tsdPtr->timerHeap[--tsdPtr->numTimers]);
+	}
+	Tcl_Free(tsdPtr->timerHeap);
+	tsdPtr->timerHeap = NULL;
+	tsdPtr->maxTimers = 0;
+	Tcl_DeleteHashTable(&tsdPtr->timerTable);
+    }
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * SiftUp, SiftDown --
+ *
+ *	Place a timer handler in the heap, starting from a free slot at index
+ *	and moving towards the first slot (SiftUp) or away from it (SiftDown)
+ *	for as long as the handler is out of order there.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	Handlers are moved in the heap.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+SiftUp(
+    ThreadSpecificData *tsdPtr,
+    size_t index,
+    TimerHandler *timerHandlerPtr)
+{
+    TimerHandler **heap = tsdPtr->timerHeap;
+
+    while (index > 0) {
+	size_t parent = (index - 1) / 2;
+
+	if (!TIMER_BEFORE(timerHandlerPtr, heap[parent])) {
+	    break;
+	}
+	heap[index] = heap[parent];
+	heap[index]->heapIndex = index;
+	index = parent;
+    }
+    heap[index] = timerHandlerPtr;
+    timerHandlerPtr->heapIndex = index;
+}
+
+static void
+SiftDown(
+    ThreadSpecificData *tsdPtr,
+    size_t index,
+    TimerHandler *timerHandlerPtr)
+{
+    TimerHandler **heap = tsdPtr->timerHeap;
+    size_t child;
+
+    while ((child = 2 * index + 1) < tsdPtr->numTimers) {
+	if (child + 1 < tsdPtr->numTimers
+		&& TIMER_BEFORE(heap[child + 1], heap[child])) {
+	    child++;
+	}
+	if (!TIMER_BEFORE(heap[child], timerHandlerPtr)) {
+	    break;
 	}
+	heap[index] = heap[child];
+	heap[index]->heapIndex = index;
+	index = child;
+    }
+    heap[index] = timerHandlerPtr;
+    timerHandlerPtr->heapIndex = index;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TimerHeapRemove --
+ *
+ *	Takes a timer handler out of the heap and the timer table, without
+ *	freeing it.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	The last handler in the heap is moved into the place of the one
+ *	removed.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+TimerHeapRemove(
+    ThreadSpecificData *tsdPtr,
+    TimerHandler *timerHandlerPtr)
+{
+    size_t index = timerHandlerPtr->heapIndex;
+    TimerHandler *lastPtr = tsdPtr->timerHeap[--tsdPtr->numTimers];
+
+    Tcl_DeleteHashEntry(timerHandlerPtr->hPtr);
+    if (lastPtr == timerHandlerPtr) {
+	return;
+    }
+    if (index > 0
+	    && TIMER_BEFORE(lastPtr, tsdPtr->timerHeap[(index - 1) / 2])) {
+	SiftUp(tsdPtr, index, lastPtr);
+    } else {
+	SiftDown(tsdPtr, index, lastPtr);
     }
 }
 
@@ -294,9 +434,18 @@ TclCreateAbsoluteTimerHandler(
     Tcl_TimerProc *proc,
     ClientData clientData)
 {
-    TimerHandler *timerHandlerPtr, *tPtr2, *prevPtr;
+    TimerHandler *timerHandlerPtr;
+    int isNew;
     ThreadSpecificData *tsdPtr = InitTimer();
 
+    if (tsdPtr->numTimers == tsdPtr->maxTimers) {
+	if (tsdPtr->timerHeap == NULL) {
+	    Tcl_InitHashTable(&tsdPtr->timerTable, TCL_ONE_WORD_KEYS);
+	}
+	tsdPtr->maxTimers = tsdPtr->maxTimers ? 2 * tsdPtr->maxTimers : 16;
+	tsdPtr->timerHeap = (TimerHandler **)Tcl_Realloc(tsdPtr->timerHeap,
+		tsdPtr->maxTimers * sizeof(TimerHandler *));
+    }
     timerHandlerPtr = (TimerHandler *)Tcl_Alloc(sizeof(TimerHandler));
 
     /*
@@ -306,26 +455,30 @@ TclCreateAbsoluteTimerHandler(
     memcpy(&timerHandlerPtr->time, timePtr, sizeof(Tcl_Time));
     timerHandlerPtr->proc = proc;
     timerHandlerPtr->clientData = clientData;
-    tsdPtr->lastTimerId++;
+
+    /*
+     * Pick the next token that is not NULL and not still in use (after the
+     * identifiers have wrapped around).
+     */
+
+    do {
+	tsdPtr->lastTimerId++;
+	if (tsdPtr->lastTimerId == 0) {
+	    continue;
+	}
+	timerHandlerPtr->hPtr = Tcl_CreateHashEntry(&tsdPtr->timerTable,
+		INT2PTR(tsdPtr->lastTimerId), &isNew);
+    } while (tsdPtr->lastTimerId == 0 || !isNew);
+    Tcl_SetHashValue(timerHandlerPtr->hPtr, timerHandlerPtr);
     timerHandlerPtr->token = (Tcl_TimerToken) INT2PTR(tsdPtr->lastTimerId);
 
     /*
-     * Add the event to the queue in the correct position (ordered by event
+     * Add the event to the heap in the correct position (ordered by event
      * firing time).
      */
 
-    for (tPtr2 = tsdPtr->firstTimerHandlerPtr, prevPtr = NULL; tPtr2 != NULL;
-	    prevPtr = tPtr2, tPtr2 = tPtr2->nextPtr) {
-	if (TCL_TIME_BEFORE(timerHandlerPtr->time, tPtr2->time)) {
-	    break;
-	}
-    }
-    timerHandlerPtr->nextPtr = tPtr2;
-    if (prevPtr == NULL) {
-	tsdPtr->firstTimerHandlerPtr = timerHandlerPtr;
-    } else {
-	prevPtr->nextPtr = timerHandlerPtr;
-    }
+    tsdPtr->numTimers++;
+    SiftUp(tsdPtr, tsdPtr->numTimers - 1, timerHandlerPtr);
 
     TimerSetupProc(NULL, TCL_ALL_EVENTS);
 
@@ -355,27 +508,21 @@ Tcl_DeleteTimerHandler(
     Tcl_TimerToken token)	/* Result previously returned by
 				 * Tcl_DeleteTimerHandler. */
 {
-    TimerHandler *timerHandlerPtr, *prevPtr;
+    TimerHandler *timerHandlerPtr;
+    Tcl_HashEntry *hPtr;
     ThreadSpecificData *tsdPtr = InitTimer();
 
-    if (token == NULL) {
+    if (token == NULL || tsdPtr->numTimers == 0) {
 	return;
     }
 
-    for (timerHandlerPtr = tsdPtr->firstTimerHandlerPtr, prevPtr = NULL;
-	    timerHandlerPtr != NULL; prevPtr = timerHandlerPtr,
-	    timerHandlerPtr = timerHandlerPtr->nextPtr) {
-	if (timerHandlerPtr->token != token) {
-	    continue;
-	}
-	if (prevPtr == NULL) {
-	    tsdPtr->firstTimerHandlerPtr = timerHandlerPtr->nextPtr;
-	} else {
-	    prevPtr->nextPtr = timerHandlerPtr->nextPtr;
-	}
-	Tcl_Free(timerHandlerPtr);
+    hPtr = Tcl_FindHashEntry(&tsdPtr->timerTable, token);
+    if (hPtr == NULL) {
 	return;
     }
+    timerHandlerPtr = (TimerHandler *)Tcl_GetHashValue(hPtr);
+    TimerHeapRemove(tsdPtr, timerHandlerPtr);
+    Tcl_Free(timerHandlerPtr);
 }
 
 /*
@@ -412,15 +559,14 @@ TimerSetupProc(
 
 	blockTime.sec = 0;
 	blockTime.usec = 0;
-    } else if ((flags & TCL_TIMER_EVENTS) && tsdPtr->firstTimerHandlerPtr) {
+    } else if ((flags & TCL_TIMER_EVENTS) && tsdPtr->numTimers) {
 	/*
 	 * Compute the timeout for the next timer on the list.
 	 */
 
 	Tcl_GetTime(&blockTime);
-	blockTime.sec = tsdPtr->firstTimerHandlerPtr->time.sec - blockTime.sec;
-	blockTime.usec = tsdPtr->firstTimerHandlerPtr->time.usec -
-		blockTime.usec;
+	blockTime.sec = tsdPtr->timerHeap[0]->time.sec - blockTime.sec;
+	blockTime.usec = tsdPtr->timerHeap[0]->time.usec - blockTime.usec;
 	if (blockTime.usec < 0) {
 	    blockTime.sec -= 1;
 	    blockTime.usec += 1000000;
@@ -463,15 +609,14 @@ TimerCheckProc(
     Tcl_Time blockTime;
     ThreadSpecificData *tsdPtr = InitTimer();
 
-    if ((flags & TCL_TIMER_EVENTS) && tsdPtr->firstTimerHandlerPtr) {
+    if ((flags & TCL_TIMER_EVENTS) && tsdPtr->numTimers) {
 	/*
 	 * Compute the timeout for the next timer on the list.
 	 */
 
 	Tcl_GetTime(&blockTime);
-	blockTime.sec = tsdPtr->firstTimerHandlerPtr->time.sec - blockTime.sec;
-	blockTime.usec = tsdPtr->firstTimerHandlerPtr->time.usec -
-		blockTime.usec;
+	blockTime.sec = tsdPtr->timerHeap[0]->time.sec - blockTime.sec;
+	blockTime.usec = tsdPtr->timerHeap[0]->time.usec - blockTime.usec;
 	if (blockTime.usec < 0) {
 	    blockTime.sec -= 1;
 	    blockTime.usec += 1000000;
@@ -522,7 +667,7 @@ TimerHandlerEventProc(
     int flags)			/* Flags that indicate what events to handle,
 				 * such as TCL_FILE_EVENTS. */
 {
-    TimerHandler *timerHandlerPtr, **nextPtrPtr;
+    TimerHandler *timerHandlerPtr;
     Tcl_Time time;
     int currentTimerId;
     ThreadSpecificData *tsdPtr = InitTimer();
@@ -556,21 +701,17 @@ TimerHandlerEventProc(
      *	  only way a new timer will even be considered runnable is if its
      *	  expiration time is within the same millisecond as the current time.
      *	  This is fairly likely on Windows, since it has a course granularity
-     *	  clock. Since timers are placed on the queue in time order with the
-     *	  most recently created handler appearing after earlier ones with the
-     *	  same expiration time, we don't have to worry about newer generation
-     *	  timers appearing before later ones.
+     *	  clock. Since timers are ordered by time with the most recently
+     *	  created handler coming after earlier ones with the same expiration
+     *	  time, we don't have to worry about newer generation timers appearing
+     *	  before later ones.
      */
 
     tsdPtr->timerPending = 0;
     currentTimerId = tsdPtr->lastTimerId;
     Tcl_GetTime(&time);
-    while (1) {
-	nextPtrPtr = &tsdPtr->firstTimerHandlerPtr;
-	timerHandlerPtr = tsdPtr->firstTimerHandlerPtr;
-	if (timerHandlerPtr == NULL) {
-	    break;
-	}
+    while (tsdPtr->numTimers > 0) {
+	timerHandlerPtr = tsdPtr->timerHeap[0];
 
 	if (TCL_TIME_BEFORE(time, timerHandlerPtr->time)) {
 	    break;
@@ -589,7 +730,7 @@ TimerHandlerEventProc(
 	 * potential reentrancy problems.
 	 */
 
-	*nextPtrPtr = timerHandlerPtr->nextPtr;
+	TimerHeapRemove(tsdPtr, timerHandlerPtr);
 	timerHandlerPtr->proc(timerHandlerPtr->clientData);
 	Tcl_Free(timerHandlerPtr);
     }
@@ -810,6 +951,8 @@ Tcl_AfterObjCmd(
 	assocPtr = (AfterAssocData *)Tcl_Alloc(sizeof(AfterAssocData));
 	assocPtr->interp = interp;
 	assocPtr->firstAfterPtr = NULL;
+	Tcl_InitHashTable(&assocPtr->idTable, TCL_ONE_WORD_KEYS);
+	assocPtr->numIdCommands = 0;
 	Tcl_SetAssocData(interp, "tclAfter", AfterCleanupProc, assocPtr);
     }
 
@@ -874,8 +1017,7 @@ Tcl_AfterObjCmd(
 	}
 	afterPtr->token = TclCreateAbsoluteTimerHandler(&wakeup,
 		AfterProc, afterPtr);
-	afterPtr->nextPtr = assocPtr->firstAfterPtr;
-	assocPtr->firstAfterPtr = afterPtr;
+	LinkAfterInfo(assocPtr, afterPtr);
 	Tcl_SetObjResult(interp, Tcl_ObjPrintf("after#%d", afterPtr->id));
 	return TCL_OK;
     }
@@ -894,17 +1036,30 @@ Tcl_AfterObjCmd(
 	    commandPtr = Tcl_ConcatObj(objc-2, objv+2);
 	}
 	command = Tcl_GetStringFromObj(commandPtr, &length);
-	for (afterPtr = assocPtr->firstAfterPtr;  afterPtr != NULL;
-		afterPtr = afterPtr->nextPtr) {
-	    tempCommand = Tcl_GetStringFromObj(afterPtr->commandPtr,
-		    &tempLength);
-	    if ((length == tempLength)
-		    && !memcmp(command, tempCommand, length)) {
-		break;
-	    }
+
+	/*
+	 * A command matching the argument is cancelled in preference to the
+	 * event it identifies, so unless no command looks like an identifier,
+	 * the commands must be searched first.
+	 */
+
+	afterPtr = NULL;
+	if (assocPtr->numIdCommands == 0) {
+	    afterPtr = GetAfterEvent(assocPtr, commandPtr);
 	}
 	if (afterPtr == NULL) {
-	    afterPtr = GetAfterEvent(assocPtr, commandPtr);
+	    for (afterPtr = assocPtr->firstAfterPtr;  afterPtr != NULL;
+		    afterPtr = afterPtr->nextPtr) {
+		tempCommand = Tcl_GetStringFromObj(afterPtr->commandPtr,
+			&tempLength);
+		if ((length == tempLength)
+			&& !memcmp(command, tempCommand, length)) {
+		    break;
+		}
+	    }
+	    if (afterPtr == NULL && assocPtr->numIdCommands != 0) {
+		afterPtr = GetAfterEvent(assocPtr, commandPtr);
+	    }
 	}
 	if (objc != 3) {
 	    Tcl_DecrRefCount(commandPtr);
@@ -935,8 +1090,7 @@ Tcl_AfterObjCmd(
 	afterPtr->id = tsdPtr->afterId;
 	tsdPtr->afterId += 1;
 	afterPtr->token = NULL;
-	afterPtr->nextPtr = assocPtr->firstAfterPtr;
-	assocPtr->firstAfterPtr = afterPtr;
+	LinkAfterInfo(assocPtr, afterPtr);
 	Tcl_DoWhenIdle(AfterProc, afterPtr);
 	Tcl_SetObjResult(interp, Tcl_ObjPrintf("after#%d", afterPtr->id));
 	break;
@@ -1106,7 +1260,7 @@ GetAfterEvent(
 {
     const char *cmdString;	/* Textual identifier for after event, such as
 				 * "after#6". */
-    AfterInfo *afterPtr;
+    Tcl_HashEntry *hPtr;
     int id;
     char *end;
 
@@ -1119,13 +1273,79 @@ GetAfterEvent(
     if ((end == cmdString) || (*end != 0)) {
 	return NULL;
     }
-    for (afterPtr = assocPtr->firstAfterPtr; afterPtr != NULL;
-	    afterPtr = afterPtr->nextPtr) {
-	if (afterPtr->id == id) {
-	    return afterPtr;
-	}
+    hPtr = Tcl_FindHashEntry(&assocPtr->idTable, INT2PTR(id));
+    if (hPtr == NULL) {
+	return NULL;
+    }
+    return (AfterInfo *)Tcl_GetHashValue(hPtr);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * LinkAfterInfo, UnlinkAfterInfo --
+ *
+ *	Add an "after" command to the front of the list of those pending for
+ *	an interpreter, and remove it again.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	The identifier of the command is entered in, or removed from, the
+ *	table used by GetAfterEvent.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+LinkAfterInfo(
+    AfterAssocData *assocPtr,
+    AfterInfo *afterPtr)
+{
+    Tcl_HashEntry *hPtr;
+    int isNew;
+
+    hPtr = Tcl_CreateHashEntry(&assocPtr->idTable, INT2PTR(afterPtr->id),
+	    &isNew);
+    Tcl_SetHashValue(hPtr, afterPtr);
+    afterPtr->commandIsId =
+	    (strncmp(TclGetString(afterPtr->commandPtr), "after#", 6) == 0);
+    if (afterPtr->commandIsId) {
+	assocPtr->numIdCommands++;
+    }
+
+    afterPtr->prevPtr = NULL;
+    afterPtr->nextPtr = assocPtr->firstAfterPtr;
+    if (afterPtr->nextPtr != NULL) {
+	afterPtr->nextPtr->prevPtr = afterPtr;
+    }
+    assocPtr->firstAfterPtr = afterPtr;
+}
+
+static void
+UnlinkAfterInfo(
+    AfterInfo *afterPtr)
+{
+    AfterAssocData *assocPtr = afterPtr->assocPtr;
+    Tcl_HashEntry *hPtr;
+
+    hPtr = Tcl_FindHashEntry(&assocPtr->idTable, INT2PTR(afterPtr->id));
+    if (hPtr != NULL && Tcl_GetHashValue(hPtr) == afterPtr) {
+	Tcl_DeleteHashEntry(hPtr);
+    }
+    if (afterPtr->commandIsId) {
+	assocPtr->numIdCommands--;
+    }
+
+    if (afterPtr->prevPtr == NULL) {
+	assocPtr->firstAfterPtr = afterPtr->nextPtr;
+    } else {
+	afterPtr->prevPtr->nextPtr = afterPtr->nextPtr;
+    }
+    if (afterPtr->nextPtr != NULL) {
+	afterPtr->nextPtr->prevPtr = afterPtr->prevPtr;
     }
-    return NULL;
 }
 
 /*
@@ -1153,7 +1373,6 @@ AfterProc(
 {
     AfterInfo *afterPtr = (AfterInfo *)clientData;
     AfterAssocData *assocPtr = afterPtr->assocPtr;
-    AfterInfo *prevPtr;
     int result;
     Tcl_Interp *interp;
 
@@ -1163,15 +1382,7 @@ AfterProc(
      * a core dump.
      */
 
-    if (assocPtr->firstAfterPtr == afterPtr) {
-	assocPtr->firstAfterPtr = afterPtr->nextPtr;
-    } else {
-	for (prevPtr = assocPtr->firstAfterPtr; prevPtr->nextPtr != afterPtr;
-		prevPtr = prevPtr->nextPtr) {
-	    /* Empty loop body. */
-	}
-	prevPtr->nextPtr = afterPtr->nextPtr;
-    }
+    UnlinkAfterInfo(afterPtr);
 
     /*
      * Execute the callback.
@@ -1216,18 +1427,7 @@ static void
 FreeAfterPtr(
     AfterInfo *afterPtr)		/* Command to be deleted. */
 {
-    AfterInfo *prevPtr;
-    AfterAssocData *assocPtr = afterPtr->assocPtr;
-
-    if (assocPtr->firstAfterPtr == afterPtr) {
-	assocPtr->firstAfterPtr = afterPtr->nextPtr;
-    } else {
-	for (prevPtr = assocPtr->firstAfterPtr; prevPtr->nextPtr != afterPtr;
-		prevPtr = prevPtr->nextPtr) {
-	    /* Empty loop body. */
-	}
-	prevPtr->nextPtr = afterPtr->nextPtr;
-    }
+    UnlinkAfterInfo(afterPtr);
     Tcl_DecrRefCount(afterPtr->commandPtr);
     Tcl_Free(afterPtr);
 }
@@ -1269,6 +1469,7 @@ AfterCleanupProc(
 	Tcl_DecrRefCount(afterPtr->commandPtr);
 	Tcl_Free(afterPtr);
     }
+    Tcl_DeleteHashTable(&assocPtr->idTable);
     Tcl_Free(assocPtr);
 }
 
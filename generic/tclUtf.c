@@ -83,6 +83,819 @@ static const unsigned char complete[256] = {
     3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,4,4,4,4,4,1,1,1,1,1,1,1,1,1,1,1
 };
 
+/*
+ *---------------------------------------------------------------------------
+ *
+ * Bulk kernels --
+ *
+ *	Long strings are mostly handled a block of bytes at a time by the
+ *	kernels below. Each has a portable scalar version, SSE2 or NEON
+ *	versions chosen at compile time, and on x86 an AVX2 version chosen at
+ *	run time when the compiler can target it. All of them stop at the
+ *	first byte they cannot handle and leave the rest to the
+ *	character-at-a-time code, so they never change a result.
+ *
+ *	asciiCopy	Copy the leading run of bytes 0x01-0x7F.
+ *	asciiToUCS4	Widen the leading run of bytes below 0x80 into ints.
+ *	ucs4ToAscii	Narrow the leading run of chars 0x01-0x7F into bytes.
+ *			(\0 is excluded as it is stored as \xC0\x80.)
+ *	countChars	Count the chars in the leading run of blocks that hold
+ *			nothing but sequences Tcl_UtfToUniChar decodes as a
+ *			whole, validating them along the way. Sequences
+ *			decoded byte by byte (overlong forms, naked trail
+ *			bytes, and so on) end the run. The result ends on a
+ *			character boundary. The number of 4-byte sequences is
+ *			reported too, since they count twice in UTF-16.
+ *	utf16ToAscii	Narrow the leading run of UTF-16 units 0x01-0x7F, in
+ *			either byte order, into bytes.
+ *	asciiToUtf16	Widen the leading run of bytes 0x01-0x7F into UTF-16
+ *			units in either byte order.
+ *
+ *---------------------------------------------------------------------------
+ */
+
+typedef struct {
+    size_t (*asciiCopy)(const char *src, size_t length, char *dst);
+    size_t (*asciiToUCS4)(const char *src, size_t length, int *dst);
+    size_t (*ucs4ToAscii)(const int *src, size_t length, char *dst);
+    size_t (*countChars)(const char *src, size_t length,
+	    size_t *numCharsPtr, size_t *numQuadsPtr);
+    size_t (*utf16ToAscii)(const char *src, size_t numUnits, int le,
+	    char *dst);
+    size_t (*asciiToUtf16)(const char *src, size_t length, int le,
+	    char *dst);
+} UtfKernels;
+
+#if defined(__SSE2__) || defined(_M_X64) \
+	|| (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#   define UTF_SSE2 1
+#   include <emmintrin.h>
+#   if (defined(__x86_64__) || defined(__i386__)) && (defined(__clang__) \
+	    || (defined(__GNUC__) && (__GNUC__ >= 5)))
+#	define UTF_AVX2 1
+#	include <immintrin.h>
+#	define UTF_AVX2_TARGET __attribute__((target("avx2")))
+#   endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#   define UTF_NEON 1
+#   include <arm_neon.h>
+#endif
+
+/*
+ * Shortest run of bytes worth handing to a kernel.
+ */
+
+#define UTF_BULK_MIN 32
+
+#define ASCII_WORD_MASK ((Tcl_WideUInt) 0x8080808080808080)
+#define ASCII_WORD_ONES ((Tcl_WideUInt) 0x0101010101010101)
+
+/*
+ * Whether a byte is in 0x01-0x7F, the ones that stand for themselves in
+ * every encoding the kernels serve.
+ */
+
+#define IS_PLAIN_ASCII(byte)	((unsigned) (UCHAR(byte) - 1) < 0x7F)
+
+static size_t
+AsciiCopyScalar(
+    const char *src,
+    size_t length,
+    char *dst)
+{
+    size_t i = 0;
+    Tcl_WideUInt word;
+
+    while (i + sizeof(word) <= length) {
+	memcpy(&word, src + i, sizeof(word));
+	if ((word | ((word - ASCII_WORD_ONES) & ~word)) & ASCII_WORD_MASK) {
+	    break;
+	}
+	memcpy(dst + i, &word, sizeof(word));
+	i += sizeof(word);
+    }
+    while ((i < length) && IS_PLAIN_ASCII(src[i])) {
+	dst[i] = src[i];
+	i++;
+    }
+    return i;
+}
+
+static size_t
+AsciiToUCS4Scalar(
+    const char *src,
+    size_t length,
+    int *dst)
+{
+    size_t i = 0;
+
+    while ((i < length) && (UCHAR(src[i]) < 0x80)) {
+	dst[i] = UCHAR(src[i]);
+	i++;
+    }
+    return i;
+}
+
+static size_t
+UCS4ToAsciiScalar(
+    const int *src,
+    size_t length,
+    char *dst)
+{
+    size_t i = 0;
+
+    while ((i < length) && ((unsigned)(src[i] - 1) < (UNICODE_SELF - 1))) {
+	dst[i] = (char) src[i];
+	i++;
+    }
+    return i;
+}
+
+/*
+ * Given the position just past the last of a run of validated blocks, back
+ * up over a character whose lead byte is in the run but whose trail bytes
+ * are not, so that the caller resumes on a character boundary.
+ */
+
+static size_t
+BackUpToBoundary(
+    const char *src,
+    size_t end,
+    size_t *numCharsPtr,
+    size_t *numQuadsPtr)
+{
+    size_t j;
+
+    for (j = 1; (j <= 3) && (j <= end); j++) {
+	unsigned char byte = UCHAR(src[end - j]);
+
+	if (byte >= 0xC0) {
+	    if (totalBytes[byte] > j) {
+		(*numCharsPtr)--;
+		if (byte >= 0xF0) {
+		    (*numQuadsPtr)--;
+		}
+		return end - j;
+	    }
+	    break;
+	}
+	if (byte < 0x80) {
+	    break;
+	}
+    }
+    return end;
+}
+
+static size_t
+CountCharsScalar(
+    const char *src,
+    size_t length,
+    size_t *numCharsPtr,
+    TCL_UNUSED(size_t *) /*numQuadsPtr*/)
+{
+    size_t i = 0;
+    Tcl_WideUInt word;
+
+    while (i + sizeof(word) <= length) {
+	memcpy(&word, src + i, sizeof(word));
+	if (word & ASCII_WORD_MASK) {
+	    break;
+	}
+	i += sizeof(word);
+    }
+    *numCharsPtr += i;
+    return i;
+}
+
+static size_t
+Utf16ToAsciiScalar(
+    const char *src,
+    size_t numUnits,
+    int le,
+    char *dst)
+{
+    size_t i = 0;
+
+    while (i < numUnits) {
+	const char *unit = src + 2 * i;
+
+	if (unit[le ? 1 : 0] || !IS_PLAIN_ASCII(unit[le ? 0 : 1])) {
+	    break;
+	}
+	dst[i] = unit[le ? 0 : 1];
+	i++;
+    }
+    return i;
+}
+
+static size_t
+AsciiToUtf16Scalar(
+    const char *src,
+    size_t length,
+    int le,
+    char *dst)
+{
+    size_t i = 0;
+
+    while ((i < length) && IS_PLAIN_ASCII(src[i])) {
+	dst[2 * i + (le ? 0 : 1)] = src[i];
+	dst[2 * i + (le ? 1 : 0)] = 0;
+	i++;
+    }
+    return i;
+}
+
+static const UtfKernels scalarKernels = {
+    AsciiCopyScalar, AsciiToUCS4Scalar, UCS4ToAsciiScalar, CountCharsScalar,
+    Utf16ToAsciiScalar, AsciiToUtf16Scalar
+};
+
+#ifdef UTF_SSE2
+/*
+ * Unsigned byte comparison, which SSE2 lacks.
+ */
+
+#define SSE2_GE(x, k) \
+    _mm_cmpeq_epi8(_mm_max_epu8((x), _mm_set1_epi8((char) (k))), (x))
+
+/*
+ * Mask of the bytes of v that are \0 or 0x80 and up.
+ */
+
+#define SSE2_NOT_PLAIN(v) \
+    _mm_movemask_epi8(_mm_or_si128((v), \
+	    _mm_cmpeq_epi8((v), _mm_setzero_si128())))
+
+static size_t
+AsciiCopySSE2(
+    const char *src,
+    size_t length,
+    char *dst)
+{
+    size_t i = 0;
+
+    while (i + 16 <= length) {
+	__m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+
+	if (SSE2_NOT_PLAIN(v)) {
+	    break;
+	}
+	_mm_storeu_si128((__m128i *) (dst + i), v);
+	i += 16;
+    }
+    return i + AsciiCopyScalar(src + i, length - i, dst + i);
+}
+
+static size_t
+AsciiToUCS4SSE2(
+    const char *src,
+    size_t length,
+    int *dst)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+
+    while (i + 16 <= length) {
+	__m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+	__m128i lo, hi;
+
+	if (_mm_movemask_epi8(v)) {
+	    break;
+	}
+	lo = _mm_unpacklo_epi8(v, zero);
+	hi = _mm_unpackhi_epi8(v, zero);
+	_mm_storeu_si128((__m128i *) (dst + i), _mm_unpacklo_epi16(lo, zero));
+	_mm_storeu_si128((__m128i *) (dst + i + 4), _mm_unpackhi_epi16(lo, zero));
+	_mm_storeu_si128((__m128i *) (dst + i + 8), _mm_unpacklo_epi16(hi, zero));
+	_mm_storeu_si128((__m128i *) (dst + i + 12), _mm_unpackhi_epi16(hi, zero));
+	i += 16;
+    }
+    return i + AsciiToUCS4Scalar(src + i, length - i, dst + i);
+}
+
+static size_t
+UCS4ToAsciiSSE2(
+    const int *src,
+    size_t length,
+    char *dst)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i limit = _mm_set1_epi32(UNICODE_SELF);
+    size_t i = 0;
+
+    while (i + 16 <= length) {
+	__m128i a = _mm_loadu_si128((const __m128i *) (src + i));
+	__m128i b = _mm_loadu_si128((const __m128i *) (src + i + 4));
+	__m128i c = _mm_loadu_si128((const __m128i *) (src + i + 8));
+	__m128i d = _mm_loadu_si128((const __m128i *) (src + i + 12));
+	__m128i ok = _mm_and_si128(
+		_mm_and_si128(_mm_cmpgt_epi32(a, zero), _mm_cmplt_epi32(a, limit)),
+		_mm_and_si128(_mm_cmpgt_epi32(b, zero), _mm_cmplt_epi32(b, limit)));
+
+	ok = _mm_and_si128(ok, _mm_and_si128(
+		_mm_and_si128(_mm_cmpgt_epi32(c, zero), _mm_cmplt_epi32(c, limit)),
+		_mm_and_si128(_mm_cmpgt_epi32(d, zero), _mm_cmplt_epi32(d, limit))));
+	if (_mm_movemask_epi8(ok) != 0xFFFF) {
+	    break;
+	}
+	_mm_storeu_si128((__m128i *) (dst + i), _mm_packus_epi16(
+		_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+	i += 16;
+    }
+    return i + UCS4ToAsciiScalar(src + i, length - i, dst + i);
+}
+
+static size_t
+CountCharsSSE2(
+    const char *src,
+    size_t length,
+    size_t *numCharsPtr,
+    size_t *numQuadsPtr)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    __m128i prev = zero, chars = zero, quads = zero;
+    size_t i = 0;
+
+    while (i + 16 <= length) {
+	__m128i cur = _mm_loadu_si128((const __m128i *) (src + i));
+	__m128i p1, p2, p3, cont, bad;
+
+	if (!_mm_movemask_epi8(_mm_or_si128(cur, _mm_srli_si128(prev, 13)))) {
+	    /*
+	     * Nothing but ASCII, and no character still open.
+	     */
+
+	    chars = _mm_add_epi64(chars, _mm_sad_epu8(one, zero));
+	    prev = cur;
+	    i += 16;
+	    continue;
+	}
+
+	/*
+	 * The bytes 1, 2 and 3 positions back, and whether each byte is a
+	 * trail byte. A byte must be a trail byte exactly when one of those
+	 * is a lead byte that reaches it.
+	 */
+
+	p1 = _mm_or_si128(_mm_slli_si128(cur, 1), _mm_srli_si128(prev, 15));
+	p2 = _mm_or_si128(_mm_slli_si128(cur, 2), _mm_srli_si128(prev, 14));
+	p3 = _mm_or_si128(_mm_slli_si128(cur, 3), _mm_srli_si128(prev, 13));
+	cont = _mm_cmplt_epi8(cur, _mm_set1_epi8(-0x40));
+	bad = _mm_xor_si128(cont, _mm_or_si128(SSE2_GE(p1, 0xC0),
+		_mm_or_si128(SSE2_GE(p2, 0xE0), SSE2_GE(p3, 0xF0))));
+
+	/*
+	 * Lead bytes that are never decoded as a whole: \xC0, \xC1 and \xF5
+	 * and up. Then the second bytes that make a sequence overlong or out
+	 * of range.
+	 */
+
+	bad = _mm_or_si128(bad, _mm_or_si128(SSE2_GE(cur, 0xF5),
+		_mm_cmpeq_epi8(_mm_and_si128(cur, _mm_set1_epi8((char) 0xFE)),
+		_mm_set1_epi8((char) 0xC0))));
+	bad = _mm_or_si128(bad, _mm_andnot_si128(SSE2_GE(cur, 0xA0),
+		_mm_cmpeq_epi8(p1, _mm_set1_epi8((char) 0xE0))));
+	bad = _mm_or_si128(bad, _mm_andnot_si128(SSE2_GE(cur, 0x90),
+		_mm_cmpeq_epi8(p1, _mm_set1_epi8((char) 0xF0))));
+	bad = _mm_or_si128(bad, _mm_and_si128(SSE2_GE(cur, 0x90),
+		_mm_cmpeq_epi8(p1, _mm_set1_epi8((char) 0xF4))));
+	if (_mm_movemask_epi8(bad)) {
+	    break;
+	}
+	chars = _mm_add_epi64(chars,
+		_mm_sad_epu8(_mm_andnot_si128(cont, one), zero));
+	quads = _mm_add_epi64(quads,
+		_mm_sad_epu8(_mm_and_si128(SSE2_GE(cur, 0xF0), one), zero));
+	prev = cur;
+	i += 16;
+    }
+    {
+	Tcl_WideUInt sums[2];
+
+	_mm_storeu_si128((__m128i *) sums, chars);
+	*numCharsPtr += (size_t) (sums[0] + sums[1]);
+	_mm_storeu_si128((__m128i *) sums, quads);
+	*numQuadsPtr += (size_t) (sums[0] + sums[1]);
+    }
+    return BackUpToBoundary(src, i, numCharsPtr, numQuadsPtr);
+}
+
+/*
+ * Swap the bytes of each 16-bit unit.
+ */
+
+#define SSE2_SWAP16(v) \
+    _mm_or_si128(_mm_slli_epi16((v), 8), _mm_srli_epi16((v), 8))
+
+static size_t
+Utf16ToAsciiSSE2(
+    const char *src,
+    size_t numUnits,
+    int le,
+    char *dst)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i limit = _mm_set1_epi16(0x80);
+    size_t i = 0;
+
+    while (i + 16 <= numUnits) {
+	__m128i a = _mm_loadu_si128((const __m128i *) (src + 2 * i));
+	__m128i b = _mm_loadu_si128((const __m128i *) (src + 2 * i + 16));
+
+	if (!le) {
+	    a = SSE2_SWAP16(a);
+	    b = SSE2_SWAP16(b);
+	}
+	if (_mm_movemask_epi8(_mm_and_si128(
+		_mm_and_si128(_mm_cmpgt_epi16(a, zero), _mm_cmplt_epi16(a, limit)),
+		_mm_and_si128(_mm_cmpgt_epi16(b, zero), _mm_cmplt_epi16(b, limit))))
+		!= 0xFFFF) {
+	    break;
+	}
+	_mm_storeu_si128((__m128i *) (dst + i), _mm_packus_epi16(a, b));
+	i += 16;
+    }
+    return i + Utf16ToAsciiScalar(src + 2 * i, numUnits - i, le, dst + i);
+}
+
+static size_t
+AsciiToUtf16SSE2(
+    const char *src,
+    size_t length,
+    int le,
+    char *dst)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+
+    while (i + 16 <= length) {
+	__m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+
+	if (SSE2_NOT_PLAIN(v)) {
+	    break;
+	}
+	if (le) {
+	    _mm_storeu_si128((__m128i *) (dst + 2 * i),
+		    _mm_unpacklo_epi8(v, zero));
+	    _mm_storeu_si128((__m128i *) (dst + 2 * i + 16),
+		    _mm_unpackhi_epi8(v, zero));
+	} else {
+	    _mm_storeu_si128((__m128i *) (dst + 2 * i),
+		    _mm_unpacklo_epi8(zero, v));
+	    _mm_storeu_si128((__m128i *) (dst + 2 * i + 16),
+		    _mm_unpackhi_epi8(zero, v));
+	}
+	i += 16;
+    }
+    return i + AsciiToUtf16Scalar(src + i, length - i, le, dst + 2 * i);
+}
+
+static const UtfKernels sse2Kernels = {
+    AsciiCopySSE2, AsciiToUCS4SSE2, UCS4ToAsciiSSE2, CountCharsSSE2,
+    Utf16ToAsciiSSE2, AsciiToUtf16SSE2
+};
+#endif /* UTF_SSE2 */
+
+#ifdef UTF_AVX2
+#define AVX2_GE(x, k) \
+    _mm256_cmpeq_epi8(_mm256_max_epu8((x), _mm256_set1_epi8((char) (k))), (x))
+
+/*
+ * The bytes n positions back from those of cur, the first n of which are the
+ * last of prev.
+ */
+
+#define AVX2_PREV(cur, prev, n) \
+    _mm256_alignr_epi8((cur), _mm256_permute2x128_si256((prev), (cur), 0x21), \
+	    16 - (n))
+
+static UTF_AVX2_TARGET size_t
+CountCharsAVX2(
+    const char *src,
+    size_t length,
+    size_t *numCharsPtr,
+    size_t *numQuadsPtr)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+    __m256i prev = zero, chars = zero, quads = zero;
+    size_t i = 0;
+
+    while (i + 32 <= length) {
+	__m256i cur = _mm256_loadu_si256((const __m256i *) (src + i));
+	__m256i p1, p2, p3, cont, bad;
+
+	if (!_mm256_movemask_epi8(_mm256_or_si256(cur,
+		_mm256_and_si256(prev, _mm256_set_epi8(
+		-1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0))))) {
+	    chars = _mm256_add_epi64(chars, _mm256_sad_epu8(one, zero));
+	    prev = cur;
+	    i += 32;
+	    continue;
+	}
+
+	/*
+	 * As in CountCharsSSE2.
+	 */
+
+	p1 = AVX2_PREV(cur, prev, 1);
+	p2 = AVX2_PREV(cur, prev, 2);
+	p3 = AVX2_PREV(cur, prev, 3);
+	cont = _mm256_cmpgt_epi8(_mm256_set1_epi8(-0x40), cur);
+	bad = _mm256_xor_si256(cont, _mm256_or_si256(AVX2_GE(p1, 0xC0),
+		_mm256_or_si256(AVX2_GE(p2, 0xE0), AVX2_GE(p3, 0xF0))));
+	bad = _mm256_or_si256(bad, _mm256_or_si256(AVX2_GE(cur, 0xF5),
+		_mm256_cmpeq_epi8(_mm256_and_si256(cur,
+		_mm256_set1_epi8((char) 0xFE)), _mm256_set1_epi8((char) 0xC0))));
+	bad = _mm256_or_si256(bad, _mm256_andnot_si256(AVX2_GE(cur, 0xA0),
+		_mm256_cmpeq_epi8(p1, _mm256_set1_epi8((char) 0xE0))));
+	bad = _mm256_or_si256(bad, _mm256_andnot_si256(AVX2_GE(cur, 0x90),
+		_mm256_cmpeq_epi8(p1, _mm256_set1_epi8((char) 0xF0))));
+	bad = _mm256_or_si256(bad, _mm256_and_si256(AVX2_GE(cur, 0x90),
+		_mm256_cmpeq_epi8(p1, _mm256_set1_epi8((char) 0xF4))));
+	if (_mm256_movemask_epi8(bad)) {
+	    break;
+	}
+	chars = _mm256_add_epi64(chars,
+		_mm256_sad_epu8(_mm256_andnot_si256(cont, one), zero));
+	quads = _mm256_add_epi64(quads, _mm256_sad_epu8(
+		_mm256_and_si256(AVX2_GE(cur, 0xF0), one), zero));
+	prev = cur;
+	i += 32;
+    }
+    {
+	Tcl_WideUInt sums[4];
+
+	_mm256_storeu_si256((__m256i *) sums, chars);
+	*numCharsPtr += (size_t) (sums[0] + sums[1] + sums[2] + sums[3]);
+	_mm256_storeu_si256((__m256i *) sums, quads);
+	*numQuadsPtr += (size_t) (sums[0] + sums[1] + sums[2] + sums[3]);
+    }
+    return BackUpToBoundary(src, i, numCharsPtr, numQuadsPtr);
+}
+
+/*
+ * The copies and conversions keep their 128-bit versions: they are bound by
+ * the stores, and the runs they get are often short enough that waking the
+ * upper halves of the registers costs more than it saves.
+ */
+
+static const UtfKernels avx2Kernels = {
+    AsciiCopySSE2, AsciiToUCS4SSE2, UCS4ToAsciiSSE2, CountCharsAVX2,
+    Utf16ToAsciiSSE2, AsciiToUtf16SSE2
+};
+#endif /* UTF_AVX2 */
+
+#ifdef UTF_NEON
+#define NEON_TEST(v)	(vmaxvq_u8(v) != 0)
+
+#define NEON_NOT_PLAIN(v) \
+    ((vmaxvq_u8(v) >= 0x80) || (vminvq_u8(v) == 0))
+
+static size_t
+AsciiCopyNEON(
+    const char *src,
+    size_t length,
+    char *dst)
+{
+    size_t i = 0;
+
+    while (i + 16 <= length) {
+	uint8x16_t v = vld1q_u8((const uint8_t *) (src + i));
+
+	if (NEON_NOT_PLAIN(v)) {
+	    break;
+	}
+	vst1q_u8((uint8_t *) (dst + i), v);
+	i += 16;
+    }
+    return i + AsciiCopyScalar(src + i, length - i, dst + i);
+}
+
+static size_t
+AsciiToUCS4NEON(
+    const char *src,
+    size_t length,
+    int *dst)
+{
+    size_t i = 0;
+
+    while (i + 16 <= length) {
+	uint8x16_t v = vld1q_u8((const uint8_t *) (src + i));
+	uint16x8_t lo, hi;
+
+	if (vmaxvq_u8(v) >= 0x80) {
+	    break;
+	}
+	lo = vmovl_u8(vget_low_u8(v));
+	hi = vmovl_u8(vget_high_u8(v));
+	vst1q_u32((uint32_t *) (dst + i), vmovl_u16(vget_low_u16(lo)));
+	vst1q_u32((uint32_t *) (dst + i + 4), vmovl_u16(vget_high_u16(lo)));
+	vst1q_u32((uint32_t *) (dst + i + 8), vmovl_u16(vget_low_u16(hi)));
+	vst1q_u32((uint32_t *) (dst + i + 12), vmovl_u16(vget_high_u16(hi)));
+	i += 16;
+    }
+    return i + AsciiToUCS4Scalar(src + i, length - i, dst + i);
+}
+
+static size_t
+UCS4ToAsciiNEON(
+    const int *src,
+    size_t length,
+    char *dst)
+{
+    const uint32x4_t limit = vdupq_n_u32(UNICODE_SELF - 1);
+    size_t i = 0;
+
+    while (i + 16 <= length) {
+	uint32x4_t a = vld1q_u32((const uint32_t *) (src + i));
+	uint32x4_t b = vld1q_u32((const uint32_t *) (src + i + 4));
+	uint32x4_t c = vld1q_u32((const uint32_t *) (src + i + 8));
+	uint32x4_t d = vld1q_u32((const uint32_t *) (src + i + 12));
+	uint32x4_t one = vdupq_n_u32(1);
+	uint32x4_t over = vorrq_u32(
+		vorrq_u32(vcgeq_u32(vsubq_u32(a, one), limit),
+			vcgeq_u32(vsubq_u32(b, one), limit)),
+		vorrq_u32(vcgeq_u32(vsubq_u32(c, one), limit),
+			vcgeq_u32(vsubq_u32(d, one), limit)));
+
+	if (vmaxvq_u32(over)) {
+	    break;
+	}
+	vst1q_u8((uint8_t *) (dst + i), vcombine_u8(
+		vmovn_u16(vcombine_u16(vmovn_u32(a), vmovn_u32(b))),
+		vmovn_u16(vcombine_u16(vmovn_u32(c), vmovn_u32(d)))));
+	i += 16;
+    }
+    return i + UCS4ToAsciiScalar(src + i, length - i, dst + i);
+}
+
+static size_t
+CountCharsNEON(
+    const char *src,
+    size_t length,
+    size_t *numCharsPtr,
+    size_t *numQuadsPtr)
+{
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t one = vdupq_n_u8(1);
+    uint8x16_t prev = zero;
+    size_t i = 0, chars = 0, quads = 0;
+
+    while (i + 16 <= length) {
+	uint8x16_t cur = vld1q_u8((const uint8_t *) (src + i));
+	uint8x16_t p1, p2, p3, cont, bad;
+
+	if (vmaxvq_u8(vorrq_u8(cur, vextq_u8(prev, zero, 13))) < 0x80) {
+	    chars += 16;
+	    prev = cur;
+	    i += 16;
+	    continue;
+	}
+
+	/*
+	 * As in CountCharsSSE2.
+	 */
+
+	p1 = vextq_u8(prev, cur, 15);
+	p2 = vextq_u8(prev, cur, 14);
+	p3 = vextq_u8(prev, cur, 13);
+	cont = vcltq_u8(vsubq_u8(cur, vdupq_n_u8(0x80)), vdupq_n_u8(0x40));
+	bad = veorq_u8(cont, vorrq_u8(vcgeq_u8(p1, vdupq_n_u8(0xC0)),
+		vorrq_u8(vcgeq_u8(p2, vdupq_n_u8(0xE0)),
+		vcgeq_u8(p3, vdupq_n_u8(0xF0)))));
+	bad = vorrq_u8(bad, vorrq_u8(vcgeq_u8(cur, vdupq_n_u8(0xF5)),
+		vceqq_u8(vandq_u8(cur, vdupq_n_u8(0xFE)), vdupq_n_u8(0xC0))));
+	bad = vorrq_u8(bad, vandq_u8(vcltq_u8(cur, vdupq_n_u8(0xA0)),
+		vceqq_u8(p1, vdupq_n_u8(0xE0))));
+	bad = vorrq_u8(bad, vandq_u8(vcltq_u8(cur, vdupq_n_u8(0x90)),
+		vceqq_u8(p1, vdupq_n_u8(0xF0))));
+	bad = vorrq_u8(bad, vandq_u8(vcgeq_u8(cur, vdupq_n_u8(0x90)),
+		vceqq_u8(p1, vdupq_n_u8(0xF4))));
+	if (NEON_TEST(bad)) {
+	    break;
+	}
+	chars += vaddvq_u8(vbicq_u8(one, cont));
+	quads += vaddvq_u8(vandq_u8(vcgeq_u8(cur, vdupq_n_u8(0xF0)), one));
+	prev = cur;
+	i += 16;
+    }
+    *numCharsPtr += chars;
+    *numQuadsPtr += quads;
+    return BackUpToBoundary(src, i, numCharsPtr, numQuadsPtr);
+}
+
+static size_t
+Utf16ToAsciiNEON(
+    const char *src,
+    size_t numUnits,
+    int le,
+    char *dst)
+{
+    size_t i = 0;
+
+    while (i + 16 <= numUnits) {
+	uint8x16_t a = vld1q_u8((const uint8_t *) (src + 2 * i));
+	uint8x16_t b = vld1q_u8((const uint8_t *) (src + 2 * i + 16));
+	uint16x8_t ua, ub;
+
+	if (!le) {
+	    a = vrev16q_u8(a);
+	    b = vrev16q_u8(b);
+	}
+	ua = vreinterpretq_u16_u8(a);
+	ub = vreinterpretq_u16_u8(b);
+	if ((vmaxvq_u16(vmaxq_u16(ua, ub)) >= 0x80)
+		|| (vminvq_u16(vminq_u16(ua, ub)) == 0)) {
+	    break;
+	}
+	vst1q_u8((uint8_t *) (dst + i),
+		vcombine_u8(vmovn_u16(ua), vmovn_u16(ub)));
+	i += 16;
+    }
+    return i + Utf16ToAsciiScalar(src + 2 * i, numUnits - i, le, dst + i);
+}
+
+static size_t
+AsciiToUtf16NEON(
+    const char *src,
+    size_t length,
+    int le,
+    char *dst)
+{
+    size_t i = 0;
+
+    while (i + 16 <= length) {
+	uint8x16_t v = vld1q_u8((const uint8_t *) (src + i));
+	uint8x16_t lo, hi;
+
+	if (NEON_NOT_PLAIN(v)) {
+	    break;
+	}
+	lo = vreinterpretq_u8_u16(vmovl_u8(vget_low_u8(v)));
+	hi = vreinterpretq_u8_u16(vmovl_u8(vget_high_u8(v)));
+	if (!le) {
+	    lo = vrev16q_u8(lo);
+	    hi = vrev16q_u8(hi);
+	}
+	vst1q_u8((uint8_t *) (dst + 2 * i), lo);
+	vst1q_u8((uint8_t *) (dst + 2 * i + 16), hi);
+	i += 16;
+    }
+    return i + AsciiToUtf16Scalar(src + i, length - i, le, dst + 2 * i);
+}
+
+static const UtfKernels neonKernels = {
+    AsciiCopyNEON, AsciiToUCS4NEON, UCS4ToAsciiNEON, CountCharsNEON,
+    Utf16ToAsciiNEON, AsciiToUtf16NEON
+};
+#endif /* UTF_NEON */
+
+/*
+ * The kernels in use, picked on first use. Racing threads all pick the same
+ * ones, so the unguarded store is harmless.
+ */
+
+static const UtfKernels *utfKernels = NULL;
+
+static const UtfKernels *
+ChooseUtfKernels(void)
+{
+    const UtfKernels *kernels = &scalarKernels;
+
+#if defined(UTF_SSE2)
+    kernels = &sse2Kernels;
+#   ifdef UTF_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+	kernels = &avx2Kernels;
+    }
+#   endif
+#elif defined(UTF_NEON)
+    kernels = &neonKernels;
+#endif
+    utfKernels = kernels;
+    return kernels;
+}
+
+#define Kernels() (utfKernels ? utfKernels : ChooseUtfKernels())
+
+/*
+ * Whether the 8 bytes at src are all ASCII, which is when a call to one of
+ * the ASCII kernels is likely to pay off.
+ */
+
+static inline int
+AsciiWordAt(
+    const char *src)
+{
+    Tcl_WideUInt word;
+
+    memcpy(&word, src, sizeof(word));
+    return !(word & ASCII_WORD_MASK);
+}
+
 /*
  * Functions used only in this module.
  */
@@ -120,6 +933,82 @@ TclUtfCount(
     }
     return 3;
 }
+
+/*
+ *---------------------------------------------------------------------------
+ *
+ * TclUtfAsciiToUCS4 --
+ *
+ *	Widen the run of ASCII bytes at the start of a UTF-8 string into UCS4
+ *	code points, a block at a time where the processor allows.
+ *
+ * Results:
+ *	The number of bytes converted, which is the length of the run, at
+ *	most length.
+ *
+ * Side effects:
+ *	Stores that many code points at dst.
+ *
+ *---------------------------------------------------------------------------
+ */
+
+size_t
+TclUtfAsciiToUCS4(
+    const char *src,		/* The UTF-8 string. */
+    size_t length,		/* Most bytes to convert. */
+    int *dst)			/* Where to store the code points. */
+{
+    return Kernels()->asciiToUCS4(src, length, dst);
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *
+ * TclAsciiCopy, TclUtf16ToAscii, TclAsciiToUtf16 --
+ *
+ *	Bulk steps for the encoders in tclEncoding.c. Each converts the run
+ *	of characters 0x01-0x7F at the start of src, a block at a time where
+ *	the processor allows: TclAsciiCopy copies bytes, TclUtf16ToAscii
+ *	narrows UTF-16 units and TclAsciiToUtf16 widens bytes into UTF-16
+ *	units, little-endian when le is nonzero.
+ *
+ * Results:
+ *	The number of characters converted, at most length (or numUnits).
+ *
+ * Side effects:
+ *	Stores the converted characters at dst.
+ *
+ *---------------------------------------------------------------------------
+ */
+
+size_t
+TclAsciiCopy(
+    const char *src,		/* The bytes to copy. */
+    size_t length,		/* Most bytes to copy. */
+    char *dst)			/* Where to copy them. */
+{
+    return Kernels()->asciiCopy(src, length, dst);
+}
+
+size_t
+TclUtf16ToAscii(
+    const char *src,		/* The UTF-16 units. */
+    size_t numUnits,		/* Most units to convert. */
+    int le,			/* Whether they are little-endian. */
+    char *dst)			/* Where to store the bytes. */
+{
+    return Kernels()->utf16ToAscii(src, numUnits, le, dst);
+}
+
+size_t
+TclAsciiToUtf16(
+    const char *src,		/* The bytes to convert. */
+    size_t length,		/* Most bytes to convert. */
+    int le,			/* Whether to store little-endian units. */
+    char *dst)			/* Where to store the units. */
+{
+    return Kernels()->asciiToUtf16(src, length, le, dst);
+}
 
 /*
  *---------------------------------------------------------------------------
@@ -330,6 +1219,15 @@ Tcl_UniCharToUtfDString(
     p = string;
     wEnd = uniStr + uniLength;
     for (w = uniStr; w < wEnd; ) {
+	if ((wEnd - w >= UTF_BULK_MIN)
+		&& ((unsigned)(w[0] - 1) < (UNICODE_SELF - 1))
+		&& ((unsigned)(w[1] - 1) < (UNICODE_SELF - 1))) {
+	    size_t n = Kernels()->ucs4ToAscii(w, wEnd - w, p);
+
+	    w += n;
+	    p += n;
+	    continue;
+	}
 	p += Tcl_UniCharToUtf(*w, p);
 	w++;
     }
@@ -678,6 +1576,13 @@ Tcl_UtfToUniCharDString(
     endPtr = src + length;
     optPtr = endPtr - 4;
     while (p <= optPtr) {
+	if ((endPtr - p >= UTF_BULK_MIN) && AsciiWordAt(p)) {
+	    size_t n = Kernels()->asciiToUCS4(p, endPtr - p, w);
+
+	    p += n;
+	    w += n;
+	    continue;
+	}
 	p += TclUtfToUCS4(p, &ch);
 	*w++ = ch;
     }
@@ -831,8 +1736,25 @@ Tcl_NumUtfChars(
 	 */
 	while (src <= optPtr
 		/* && Tcl_UtfCharComplete(src, endPtr - src) */ ) {
-	    src += TclUtfToUniChar(src, &ch);
-	    i++;
+	    const char *stop = src + UTF_BULK_MIN;
+
+	    if (endPtr - src >= UTF_BULK_MIN) {
+		size_t numQuads = 0;
+
+		src += Kernels()->countChars(src, endPtr - src, &i,
+			&numQuads);
+		stop = src + UTF_BULK_MIN;
+	    }
+
+	    /*
+	     * Step past whatever stopped the kernel one character at a time
+	     * before handing it the rest.
+	     */
+
+	    while ((src <= optPtr) && (src < stop)) {
+		src += TclUtfToUniChar(src, &ch);
+		i++;
+	    }
 	}
 	/* Loop over the remaining string where call must happen */
 	while (src < endPtr) {
@@ -883,8 +1805,26 @@ TclNumUtfChars(
 	 */
 	while (src <= optPtr
 		/* && Tcl_UtfCharComplete(src, endPtr - src) */ ) {
-	    src += Tcl_UtfToChar16(src, &ch);
-	    i++;
+	    const char *stop = src + UTF_BULK_MIN;
+
+	    if (endPtr - src >= UTF_BULK_MIN) {
+		size_t numQuads = 0;
+
+		src += Kernels()->countChars(src, endPtr - src, &i,
+			&numQuads);
+		i += numQuads;
+		stop = src + UTF_BULK_MIN;
+	    }
+
+	    /*
+	     * Step past whatever stopped the kernel one character at a time
+	     * before handing it the rest.
+	     */
+
+	    while ((src <= optPtr) && (src < stop)) {
+		src += Tcl_UtfToChar16(src, &ch);
+		i++;
+	    }
 	}
 	/* Loop over the remaining string where call must happen */
 	while (src < endPtr) {
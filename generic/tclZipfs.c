@@ -409,7 +409,7 @@ static const Tcl_Filesystem zipfsFilesystem = {
 
 static Tcl_ChannelType ZipChannelType = {
     "zip",			/* Type name. */
-    TCL_CHANNEL_VERSION_5,
+    TCL_CHANNEL_VERSION_6,
     TCL_CLOSE2PROC,		/* Close channel, clean instance data */
     ZipChannelRead,		/* Handle read request */
     ZipChannelWrite,		/* Handle write request */
@@ -426,6 +426,7 @@ static Tcl_ChannelType ZipChannelType = {
     ZipChannelWideSeek,		/* Wide seek function, NULL'able */
     NULL,			/* Thread action function, NULL'able */
     NULL,			/* Truncate function, NULL'able */
+    NULL			/* Scatter/gather output proc. */
 };
 
 /*
@@ -205,7 +205,7 @@ static void		ZlibTransformTimerRun(void *clientData);
 
 static const Tcl_ChannelType zlibChannelType = {
     "zlib",
-    TCL_CHANNEL_VERSION_5,
+    TCL_CHANNEL_VERSION_6,
     NULL,
     ZlibTransformInput,
     ZlibTransformOutput,
@@ -220,7 +220,8 @@ static const Tcl_ChannelType zlibChannelType = {
     ZlibTransformEventHandler,
     NULL,			/* wideSeekProc */
     NULL,
-    NULL
+    NULL,
+    NULL			/* scatter/gather output proc. */
 };
 
 /*
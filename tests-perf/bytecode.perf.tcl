@@ -0,0 +1,163 @@
+#!/usr/bin/tclsh
+
+# ------------------------------------------------------------------------
+#
+# bytecode.perf.tcl --
+#
+#  This file provides performance tests for comparison of tcl-speed
+#  of the bytecode engine (instruction dispatch in TEBC): tight loops,
+#  expressions and list operations inside compiled procs.
+#
+# ------------------------------------------------------------------------
+#
+# See the file "license.terms" for information on usage and redistribution
+# of this file.
+#
+
+
+if {![namespace exists ::tclTestPerf]} {
+  source [file join [file dirname [info script]] test-performance.tcl]
+}
+
+
+namespace eval ::tclTestPerf-Bytecode {
+
+namespace path {::tclTestPerf}
+
+# All bodies are procs, so that the measured code is compiled with local
+# variable slots (the common case in real applications).
+
+proc loop-for {n} {
+  for {set i 0} {$i < $n} {incr i} {}
+}
+proc loop-while {n} {
+  set i 0
+  while {$i < $n} {incr i}
+}
+proc loop-sum {n} {
+  set s 0
+  for {set i 0} {$i < $n} {incr i} {
+    set s [expr {$s + $i}]
+  }
+  return $s
+}
+proc loop-nested {n} {
+  set s 0
+  for {set i 0} {$i < $n} {incr i} {
+    for {set j 0} {$j < 10} {incr j} {
+      incr s
+    }
+  }
+  return $s
+}
+
+proc expr-int {n} {
+  set a 3; set b 7; set r 0
+  for {set i 0} {$i < $n} {incr i} {
+    set r [expr {($a * $i + $b) % 1000 - ($i >> 2) + ($i & 15)}]
+  }
+  return $r
+}
+proc expr-double {n} {
+  set a 3.5; set b 7.25; set r 0.0
+  for {set i 0} {$i < $n} {incr i} {
+    set r [expr {$r * 0.5 + $a * $i / $b}]
+  }
+  return $r
+}
+proc expr-cmp {n} {
+  set c 0
+  for {set i 0} {$i < $n} {incr i} {
+    if {$i % 3 == 0 || ($i > 100 && $i <= 200)} {incr c}
+  }
+  return $c
+}
+
+proc list-foreach {l} {
+  set s 0
+  foreach e $l {incr s $e}
+  return $s
+}
+proc list-lindex {l} {
+  set s 0
+  set n [llength $l]
+  for {set i 0} {$i < $n} {incr i} {
+    incr s [lindex $l $i]
+  }
+  return $s
+}
+proc list-lappend {n} {
+  set l {}
+  for {set i 0} {$i < $n} {incr i} {lappend l $i}
+  return [llength $l]
+}
+proc list-lset {l} {
+  set n [llength $l]
+  for {set i 0} {$i < $n} {incr i} {
+    lset l $i [expr {[lindex $l $i] * 2}]
+  }
+  return [llength $l]
+}
+proc list-lmap {l} {
+  llength [lmap e $l {expr {$e + 1}}]
+}
+
+proc test-loops {{reptime 1000}} {
+  _test_run -uplevel $reptime {
+    # empty for loop (1000 iterations):
+    {loop-for 1000}
+    # empty while loop (1000 iterations):
+    {loop-while 1000}
+    # sum by expr (1000 iterations):
+    {loop-sum 1000}
+    # nested loops (100 x 10 iterations):
+    {loop-nested 100}
+  }
+}
+
+proc test-expr {{reptime 1000}} {
+  _test_run -uplevel $reptime {
+    # integer arithmetic (1000 iterations):
+    {expr-int 1000}
+    # double arithmetic (1000 iterations):
+    {expr-double 1000}
+    # comparisons and logical operators (1000 iterations):
+    {expr-cmp 1000}
+  }
+}
+
+proc test-lists {{reptime 1000}} {
+  set l1000 {}
+  for {set i 0} {$i < 1000} {incr i} {lappend l1000 $i}
+  _test_run -uplevel $reptime {
+    # foreach over 1000 elements:
+    {list-foreach $l1000}
+    # lindex by index over 1000 elements:
+    {list-lindex $l1000}
+    # lappend of 1000 elements:
+    {list-lappend 1000}
+    # lset of 1000 elements:
+    {list-lset $l1000}
+    # lmap over 1000 elements:
+    {list-lmap $l1000}
+  }
+}
+
+proc test {{reptime 1000}} {
+  test-loops $reptime
+  test-expr $reptime
+  test-lists $reptime
+
+  puts \n**OK**
+}
+
+}; # end of ::tclTestPerf-Bytecode
+
+# ------------------------------------------------------------------------
+
+# if calling direct:
+if {[info exists ::argv0] && [file tail $::argv0] eq [file tail [info script]]} {
+  array set in {-time 500}
+  array set in $argv
+  ::tclTestPerf-Bytecode::test $in(-time)
+}
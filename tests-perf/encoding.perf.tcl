@@ -0,0 +1,101 @@
+#!/usr/bin/tclsh
+
+# ------------------------------------------------------------------------
+#
+# encoding.perf.tcl --
+#
+#  This file provides performance tests for comparison of tcl-speed
+#  of channel input and output through the encoders (read, gets and
+#  puts on large files), reported as MB/s per encoding.
+#
+# ------------------------------------------------------------------------
+#
+# See the file "license.terms" for information on usage and redistribution
+# of this file.
+#
+
+
+if {![namespace exists ::tclTestPerf]} {
+  source [file join [file dirname [info script]] test-performance.tcl]
+}
+
+
+namespace eval ::tclTestPerf-Encoding {
+
+namespace path {::tclTestPerf}
+
+variable file [file join [expr {[info exists ::env(TMPDIR)] ? $::env(TMPDIR) : "/tmp"}] \
+  tcl-encoding-perf-[pid].txt]
+
+# text samples, one line each, repeated up to the file size:
+variable samples {
+  ascii   {The quick brown fox jumps over the lazy dog, 0123456789 times.}
+  latin   {Grüße aus Köln: «Ça va très bien», dit-il, à l'été prochain.}
+  cjk     {日本語のテキストです。東京都の天気は晴れ、気温は二十度です。}
+}
+
+# write the sample as a file of about $size MB in the given encoding:
+proc mkfile {enc sample size} {
+  variable file
+  set line [string repeat "$sample " 2]
+  set fd [open $file w]
+  fconfigure $fd -encoding $enc -translation lf
+  set n [expr {$size * 1048576 / ([string length [encoding convertto $enc $line]] + 1)}]
+  for {set i 0} {$i < $n} {incr i} {
+    puts $fd $line
+  }
+  close $fd
+  file size $file
+}
+
+# measure a script over the file (in the caller's scope), printing the rate
+# in MB/s of the file:
+proc rate {what reptime bytes script} {
+  set m [uplevel 1 [list timerate $script {*}$reptime]]
+  set us [lindex $m 0]
+  set mbs [expr {$us > 0 ? $bytes / $us / 1.048576 : 0}]
+  puts [format "%-28s %9.2f MB/s  %s" $what $mbs [lrange $m 0 1]]
+}
+
+proc test-io {{reptime {1000 5}} {size 8}} {
+  variable file
+  variable samples
+  foreach enc {utf-8 utf-16le iso8859-1 cp1252} {
+    foreach {name sample} $samples {
+      if {$enc in {iso8859-1 cp1252} && $name eq "cjk"} continue
+      set bytes [mkfile $enc $sample $size]
+      rate "$enc $name: read" $reptime $bytes [string map [list %E $enc %F $file] {
+        set fd [open {%F} r]; fconfigure $fd -encoding %E -translation lf
+        read $fd; close $fd
+      }]
+      rate "$enc $name: gets" $reptime $bytes [string map [list %E $enc %F $file] {
+        set fd [open {%F} r]; fconfigure $fd -encoding %E -translation lf
+        while {[gets $fd line] >= 0} {}; close $fd
+      }]
+      set fd [open $file r]; fconfigure $fd -encoding $enc -translation lf
+      set data [read $fd]; close $fd
+      rate "$enc $name: puts" $reptime $bytes [string map [list %E $enc %F $file] {
+        set fd [open {%F} w]; fconfigure $fd -encoding %E -translation lf
+        puts -nonewline $fd $data; close $fd
+      }]
+    }
+  }
+  file delete $file
+}
+
+proc test {{reptime 1000}} {
+  test-io [list $reptime 20]
+
+  puts \n**OK**
+}
+
+}; # end of ::tclTestPerf-Encoding
+
+# ------------------------------------------------------------------------
+
+# if calling direct:
+if {[info exists ::argv0] && [file tail $::argv0] eq [file tail [info script]]} {
+  array set in {-time 1000}
+  array set in $argv
+  ::tclTestPerf-Encoding::test $in(-time)
+}
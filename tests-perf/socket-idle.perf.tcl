@@ -0,0 +1,133 @@
+#!/usr/bin/tclsh
+
+# ------------------------------------------------------------------------
+#
+# socket-idle.perf.tcl --
+#
+#  This file provides performance tests for comparison of tcl-speed
+#  of socket traffic on a few connections while many others are open but
+#  idle, as in servers with many keep-alive clients. It exercises the
+#  notifier, in particular the changes of file handler masks made by the
+#  channel layer.
+#
+# ------------------------------------------------------------------------
+#
+# See the file "license.terms" for information on usage and redistribution
+# of this file.
+#
+
+
+if {![namespace exists ::tclTestPerf]} {
+  source [file join [file dirname [info script]] test-performance.tcl]
+}
+
+
+namespace eval ::tclTestPerf-Socket-Idle {
+
+namespace path {::tclTestPerf}
+
+# the server answers every line with the same line, all lines received at
+# once in a single write:
+proc accept {chan args} {
+  fconfigure $chan -blocking 0 -buffering full
+  fileevent $chan readable [list [namespace current]::echo $chan]
+  lappend ::sio(server) $chan
+}
+proc echo {chan} {
+  while {[gets $chan line] >= 0} {
+    puts $chan $line
+  }
+  flush $chan
+  if {[eof $chan]} {
+    close $chan
+  }
+}
+proc response {chan} {
+  if {[gets $chan line] >= 0} {
+    incr ::sio(got)
+  }
+}
+
+# open $howmuch connections, of which only the last ones are used later:
+proc open-all {howmuch} {
+  set ::sio(listen) [socket -server [namespace current]::accept -myaddr 127.0.0.1 0]
+  set port [lindex [fconfigure $::sio(listen) -sockname] 2]
+  set ::sio(server) {}
+  set ::sio(client) {}
+  for {set i 0} {$i < $howmuch} {incr i} {
+    set chan [socket 127.0.0.1 $port]
+    fconfigure $chan -blocking 0 -buffering line
+    fileevent $chan readable [list [namespace current]::response $chan]
+    lappend ::sio(client) $chan
+  }
+  while {[llength $::sio(server)] < $howmuch} {
+    vwait ::sio(server)
+  }
+  set ::sio(active) [lindex $::sio(client) end]
+  set ::sio(got) 0
+}
+proc close-all {} {
+  foreach chan [concat $::sio(client) $::sio(server)] {
+    catch {close $chan}
+  }
+  close $::sio(listen)
+  unset -nocomplain ::sio
+}
+
+# send $n lines at once on the active connection and wait for the answers:
+proc round-trip {{n 1}} {
+  set ::sio(got) 0
+  puts -nonewline $::sio(active) [string repeat "ping\n" $n]
+  flush $::sio(active)
+  while {$::sio(got) < $n} {
+    vwait ::sio(got)
+  }
+}
+
+# send one line on each of the last $k connections and wait for the answers:
+proc round-trip-many {k} {
+  set ::sio(got) 0
+  foreach chan [lrange $::sio(client) end-[expr {$k - 1}] end] {
+    puts $chan ping
+  }
+  while {$::sio(got) < $k} {
+    vwait ::sio(got)
+  }
+}
+
+proc test-idle {{reptime 1000} {howmuch 1000}} {
+  puts "*** few active connections among $howmuch ***"
+  _test_run $reptime [string map [list \$howmuch $howmuch] {
+    setup {::tclTestPerf-Socket-Idle::open-all $howmuch}
+
+    # one request and response:
+    {::tclTestPerf-Socket-Idle::round-trip}
+    # ten pipelined requests (answers served from the channel buffers):
+    {::tclTestPerf-Socket-Idle::round-trip 10}
+    # a hundred pipelined requests:
+    {::tclTestPerf-Socket-Idle::round-trip 100}
+    # one request on each of ten connections:
+    {::tclTestPerf-Socket-Idle::round-trip-many 10}
+
+    cleanup {::tclTestPerf-Socket-Idle::close-all}
+  }]
+}
+
+proc test {{reptime 1000}} {
+  foreach howmuch {10 1000 4000} {
+    test-idle $reptime $howmuch
+  }
+
+  puts \n**OK**
+}
+
+}; # end of ::tclTestPerf-Socket-Idle
+
+# ------------------------------------------------------------------------
+
+# if calling direct:
+if {[info exists ::argv0] && [file tail $::argv0] eq [file tail [info script]]} {
+  array set in {-time 500}
+  array set in $argv
+  ::tclTestPerf-Socket-Idle::test $in(-time)
+}
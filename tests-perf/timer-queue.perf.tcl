@@ -0,0 +1,96 @@
+#!/usr/bin/tclsh
+
+# ------------------------------------------------------------------------
+#
+# timer-queue.perf.tcl --
+#
+#  This file provides performance tests for comparison of tcl-speed
+#  of timer events with many timers pending, as in servers that keep a
+#  timeout per connection (creation, cancellation and firing).
+#
+# ------------------------------------------------------------------------
+#
+# See the file "license.terms" for information on usage and redistribution
+# of this file.
+#
+
+
+if {![namespace exists ::tclTestPerf]} {
+  source [file join [file dirname [info script]] test-performance.tcl]
+}
+
+
+namespace eval ::tclTestPerf-Timer-Queue {
+
+namespace path {::tclTestPerf}
+
+# fill the queue with $howmuch long timeouts (ids in ::tm), spread over a
+# minute so that new timers land anywhere in the queue:
+proc fill {howmuch} {
+  unset -nocomplain ::tm
+  for {set i 0} {$i < $howmuch} {incr i} {
+    set ::tm($i) [after [expr {60000 + $i * 7919 % 60000}] {set foo bar}]
+  }
+}
+
+proc test-pending {{reptime 1000} {howmuch 10000}} {
+  puts "*** $howmuch timers pending ***"
+  _test_run $reptime [string map [list \$howmuch $howmuch] {
+    setup {::tclTestPerf-Timer-Queue::fill $howmuch}
+
+    # create and cancel a timeout (per request):
+    {after cancel [after 30000 {set foo bar}]}
+    # create and cancel a timeout due before all others:
+    {after cancel [after 10 {set foo bar}]}
+    # cancel and re-arm a random pending timeout (keep-alive):
+    {set i [expr {int(rand()*$howmuch)}]; after cancel $::tm($i); set ::tm($i) [after [expr {60000 + $i}] {set foo bar}]}
+    # look up a random pending timeout:
+    {after info $::tm([expr {int(rand()*$howmuch)}])}
+    # fire an immediate timer among them:
+    {after 0 {set foo bar}; update}
+
+    cleanup {foreach i [after info] {after cancel $i}; unset -nocomplain ::tm}
+  }]
+}
+
+proc test-churn {{reptime {1000 10000}} {howmuch 10000}} {
+  puts "*** $howmuch timers pending, up to [lindex $reptime 1] cancelled ***"
+  _test_run -no-result $reptime [string map [list \{*\}\$reptime $reptime \$howmuch $howmuch] {
+    setup {::tclTestPerf-Timer-Queue::fill $howmuch}
+
+    # cancel forwards the pending timeouts:
+    setup {set i -1}
+    {after cancel $::tm([incr i]); if {$i >= $howmuch - 1} break}
+    # create them again:
+    setup {set i -1}
+    {set ::tm([incr i]) [after [expr {60000 + $i * 7919 % 60000}] {set foo bar}]; if {$i >= $howmuch - 1} break}
+    # cancel backwards:
+    setup {set i $howmuch}
+    {after cancel $::tm([incr i -1]); if {$i <= 0} break}
+
+    cleanup {foreach i [after info] {after cancel $i}; unset -nocomplain ::tm}
+  }]
+}
+
+proc test {{reptime 1000}} {
+  foreach howmuch {1000 10000 50000} {
+    test-pending $reptime $howmuch
+  }
+  puts ""
+  foreach howmuch {10000 50000} {
+    test-churn [list $reptime $howmuch] $howmuch
+  }
+
+  puts \n**OK**
+}
+
+}; # end of ::tclTestPerf-Timer-Queue
+
+# ------------------------------------------------------------------------
+
+# if calling direct:
+if {[info exists ::argv0] && [file tail $::argv0] eq [file tail [info script]]} {
+  array set in {-time 500}
+  array set in $argv
+  ::tclTestPerf-Timer-Queue::test $in(-time)
+}
@@ -0,0 +1,90 @@
+#!/usr/bin/tclsh
+
+# ------------------------------------------------------------------------
+#
+# utf.perf.tcl --
+#
+#  This file provides performance tests for comparison of tcl-speed
+#  of the bulk UTF-8 handling (character counting, indexing and the
+#  conversion to and from the internal unicode representation).
+#
+# ------------------------------------------------------------------------
+#
+# See the file "license.terms" for information on usage and redistribution
+# of this file.
+#
+
+
+if {![namespace exists ::tclTestPerf]} {
+  source [file join [file dirname [info script]] test-performance.tcl]
+}
+
+
+namespace eval ::tclTestPerf-Utf {
+
+namespace path {::tclTestPerf}
+
+# each script builds a fresh string ("$s "), so that nothing cached in the
+# object from the previous iteration is reused; results are not shown, they
+# are megabytes long:
+proc test-count {{reptime 1000}} {
+  _test_run -no-result $reptime {
+    setup {string length [set ::s [string repeat "The quick brown fox jumps over the lazy dog. " 100000]]}
+    # length of 4.5 MB ASCII:
+    {string length "$::s "}
+    # index near the end of 4.5 MB ASCII:
+    {string index "$::s " end-10}
+    # range of 4.5 MB ASCII:
+    {string range "$::s " 1 end-1}
+
+    setup {string length [set ::s [string repeat "Grüße aus Köln, café. " 100000]]}
+    # length of 2.7 MB Latin text:
+    {string length "$::s "}
+    # index near the end of 2.7 MB Latin text:
+    {string index "$::s " end-10}
+    # range of 2.7 MB Latin text:
+    {string range "$::s " 1 end-1}
+
+    setup {string length [set ::s [string repeat "日本語のテキストです。" 100000]]}
+    # length of 3.3 MB CJK text:
+    {string length "$::s "}
+    # index near the end of 3.3 MB CJK text:
+    {string index "$::s " end-10}
+    # range of 3.3 MB CJK text:
+    {string range "$::s " 1 end-1}
+
+    cleanup {unset ::s}
+  }
+}
+
+proc test-convert {{reptime 1000}} {
+  _test_run -no-result $reptime {
+    setup {string length [set ::s [string repeat "The quick brown fox jumps over the lazy dog. " 100000]]}
+    # append to the unicode rep of 4.5 MB ASCII:
+    {set x [string index "$::s " 0]; append x $::s; string index $x end}
+
+    setup {string length [set ::s [string repeat "Grüße aus Köln, café. " 100000]]}
+    # append to the unicode rep of 2.7 MB Latin text:
+    {set x [string index "$::s " 0]; append x $::s; string index $x end}
+
+    cleanup {unset -nocomplain ::s x}
+  }
+}
+
+proc test {{reptime 1000}} {
+  test-count $reptime
+  test-convert $reptime
+
+  puts \n**OK**
+}
+
+}; # end of ::tclTestPerf-Utf
+
+# ------------------------------------------------------------------------
+
+# if calling direct:
+if {[info exists ::argv0] && [file tail $::argv0] eq [file tail [info script]]} {
+  array set in {-time 500}
+  array set in $argv
+  ::tclTestPerf-Utf::test $in(-time)
+}
@@ -5,6 +5,14 @@
  *	Linux-specific notifier, which is the lowest-level part of the Tcl
  *	event loop. This file works together with generic/tclNotify.c.
  *
+ *	If Tcl is configured with --enable-io-uring, the notifier uses an
+ *	io_uring(7) instance instead of the epoll(7) fd whenever the running
+ *	kernel supports it, and falls back to epoll(7) otherwise.
+ *
+ *	If Tcl is configured with --enable-epoll-et, fds are registered with
+ *	epoll(7) once, edge-triggered, and their readiness is tracked here, so
+ *	that changes of the mask of a file handler need no system call.
+ *
  * Copyright © 1995-1997 Sun Microsystems, Inc.
  * Copyright © 2016 Lucio Andrés Illanes Albornoz <l.illanes@gmx.de>
  *
@@ -26,6 +34,23 @@
 #include <sys/eventfd.h>
 #endif /* HAVE_EVENTFD */
 #include <sys/queue.h>
+#ifdef NOTIFIER_EPOLL_ET
+#include <poll.h>
+#endif /* NOTIFIER_EPOLL_ET */
+#ifdef HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+/*
+ * Number of submission queue entries of the per-thread io_uring(7) instance.
+ * The completion queue is sized to RING_CQ_ENTRIES, so that the completions
+ * of a large number of registered fds fit in without overflowing.
+ */
+
+#define RING_SQ_ENTRIES	256
+#define RING_CQ_ENTRIES	8192
+#endif /* HAVE_IO_URING */
 
 /*
  * This structure is used to keep track of the notifier info for a registered
@@ -51,6 +76,25 @@ typedef struct FileHandler {
     struct PlatformEventData *pedPtr;
 				/* Pointer to PlatformEventData associating this
 				 * FileHandler with epoll(7) events. */
+#ifdef HAVE_IO_URING
+    int isRegular;		/* 1 if the fd is a regular file or directory,
+				 * as found when the FileHandler was created;
+				 * such fds cannot be polled. */
+#endif /* HAVE_IO_URING */
+#ifdef NOTIFIER_EPOLL_ET
+    unsigned edgeEvents;	/* Events the fd is registered for with
+				 * EPOLLET, or 0 if it is not. Conditions are
+				 * added when the mask first needs them, and
+				 * are kept from then on. */
+    int cachedMask;		/* Mask of TCL_* conditions of the fd last seen
+				 * by epoll(7) or poll(2). May claim more than
+				 * the fd is ready for, never less. */
+    int onCheckList;		/* 1 if on the list of FileHandlers whose
+				 * readiness is checked before the next
+				 * wait. */
+    LIST_ENTRY(FileHandler) checkNode;
+				/* Next/previous in that list. */
+#endif /* NOTIFIER_EPOLL_ET */
 } FileHandler;
 
 /*
@@ -63,8 +107,49 @@ struct ThreadSpecificData;
 struct PlatformEventData {
     FileHandler *filePtr;
     struct ThreadSpecificData *tsdPtr;
+#ifdef HAVE_IO_URING
+    unsigned events;		/* Mask of poll(2) events requested by the
+				 * most recent IORING_OP_POLL_ADD. */
+    int numPolls;		/* Number of IORING_OP_POLL_ADD requests
+				 * whose completion has not been reaped. */
+    LIST_ENTRY(PlatformEventData) orphanNode;
+				/* Next/previous in list of structs whose
+				 * FileHandler was deleted while a poll
+				 * request was still in flight. */
+#endif /* HAVE_IO_URING */
 };
 
+#ifdef HAVE_IO_URING
+/*
+ * The following structure describes the per-thread io_uring(7) instance and
+ * its submission and completion queues mapped into our address space. Poll
+ * requests are one-shot and are re-armed whenever one completes; this keeps
+ * the level-triggered semantics the rest of the notifier relies on, while
+ * all (re-)registrations made since the last wait are handed to the kernel
+ * with the same io_uring_enter(2) call that waits for events.
+ */
+
+LIST_HEAD(PlatformOrphanList, PlatformEventData);
+typedef struct PlatformRing {
+    int fd;			/* io_uring(7) fd, or -1 if the epoll(7) fd
+				 * is used instead. */
+    unsigned *sqHead, *sqTail;	/* Submission queue indices. */
+    unsigned *sqArray;		/* Submission queue index array. */
+    unsigned sqMask, sqEntries;
+    struct io_uring_sqe *sqes;	/* Submission queue entries. */
+    unsigned *cqHead, *cqTail;	/* Completion queue indices. */
+    unsigned cqMask;
+    struct io_uring_cqe *cqes;	/* Completion queue entries. */
+    void *sqMap, *cqMap;	/* Mappings of both queues, which may be the
+				 * same with IORING_FEAT_SINGLE_MMAP. */
+    size_t sqMapSize, cqMapSize, sqesSize;
+    struct PlatformOrphanList orphans;
+				/* PlatformEventData structs waiting for the
+				 * completion of their last poll request
+				 * before they can be freed. */
+} PlatformRing;
+#endif /* HAVE_IO_URING */
+
 /*
  * The following structure is what is added to the Tcl event queue when file
  * handlers are ready to fire.
@@ -107,10 +192,25 @@ typedef struct ThreadSpecificData {
 #endif /* HAVE_EVENTFD */
     int eventsFd;		/* epoll(7) file descriptor used to wait for
 				 * fds */
+#ifdef HAVE_IO_URING
+    PlatformRing ring;		/* io_uring(7) instance used to wait for fds
+				 * instead of eventsFd, if supported. */
+#endif /* HAVE_IO_URING */
     struct epoll_event *readyEvents;
 				/* Pointer to at most maxReadyEvents events
 				 * returned by epoll_wait(2). */
     size_t maxReadyEvents;	/* Count of epoll_events in readyEvents. */
+#ifdef NOTIFIER_EPOLL_ET
+    struct PlatformReadyFileHandlerList checkFileHandlers;
+				/* Edge-triggered FileHandlers whose cached
+				 * readiness must be checked with poll(2)
+				 * before the next wait: those an event was
+				 * queued for, and those whose mask grew to
+				 * cover a cached condition. */
+    struct pollfd *checkFds;	/* Array of maxCheckFds pollfd structs, */
+    FileHandler **checkFilePtrs;/* and of the FileHandlers they are for. */
+    size_t maxCheckFds;
+#endif /* NOTIFIER_EPOLL_ET */
     int asyncPending;		/* True when signal triggered thread. */
 } ThreadSpecificData;
 
@@ -122,10 +222,28 @@ static Tcl_ThreadDataKey dataKey;
 
 static void		PlatformEventsControl(FileHandler *filePtr,
 			    ThreadSpecificData *tsdPtr, int op, int isNew);
+#ifdef NOTIFIER_EPOLL_ET
+static int		PlatformCheckFileHandlers(ThreadSpecificData *tsdPtr);
+#endif /* NOTIFIER_EPOLL_ET */
 static void		PlatformEventsInit(void);
 static int		PlatformEventsTranslate(struct epoll_event *event);
 static int		PlatformEventsWait(struct epoll_event *events,
 			    size_t numEvents, struct timeval *timePtr);
+#ifdef HAVE_IO_URING
+static void		RingControl(FileHandler *filePtr,
+			    ThreadSpecificData *tsdPtr, int op,
+			    unsigned events);
+static int		RingEnter(PlatformRing *ringPtr, unsigned minComplete,
+			    unsigned flags, struct io_uring_getevents_arg *argPtr);
+static void		RingFinalize(PlatformRing *ringPtr);
+static struct io_uring_sqe *RingGetSqe(PlatformRing *ringPtr, int mayFail);
+static int		RingInit(PlatformRing *ringPtr);
+static void		RingPollAdd(struct io_uring_sqe *sqePtr,
+			    struct PlatformEventData *pedPtr);
+static int		RingWait(ThreadSpecificData *tsdPtr,
+			    struct epoll_event *events, size_t numEvents,
+			    struct timeval *timePtr);
+#endif /* HAVE_IO_URING */
 
 /*
  * Incorporate the base notifier implementation.
@@ -178,9 +296,9 @@ TclpInitNotifier(void)
  * Side effects:
  *	- If adding a new file descriptor, a PlatformEventData struct will be
  *	  allocated and associated with filePtr.
- *	- fstat is called on the file descriptor; if it is associated with a
- *	  regular file (S_IFREG,) filePtr is considered to be ready for I/O
- *	  and added to or deleted from the corresponding list in tsdPtr.
+ *	- If the file descriptor is associated with a regular file (S_IFREG,)
+ *	  filePtr is considered to be ready for I/O and added to or deleted
+ *	  from the corresponding list in tsdPtr.
  *	- If it is not associated with a regular file, the file descriptor is
  *	  added, modified concerning its mask of events of interest, or
  *	  deleted from the epoll file descriptor of the calling thread.
@@ -197,7 +315,6 @@ PlatformEventsControl(
 {
     struct epoll_event newEvent;
     struct PlatformEventData *newPedPtr;
-    Tcl_StatBuf fdStat;
 
     newEvent.events = 0;
     if (filePtr->mask & (TCL_READABLE | TCL_EXCEPTION)) {
@@ -219,12 +336,67 @@ PlatformEventsControl(
      * N.B. As discussed in Tcl_WaitForEvent(), epoll(7) does not support
      * regular files (S_IFREG). Therefore, filePtr is in these cases simply
      * added or deleted from the list of FileHandlers associated with regular
-     * files belonging to tsdPtr.
+     * files belonging to tsdPtr. epoll_ctl(2) tells with EPERM; io_uring
+     * would poll them, so their type is looked up once, when the
+     * FileHandler is created, rather than on every change of mask.
+     */
+
+#ifdef HAVE_IO_URING
+    if (tsdPtr->ring.fd != -1) {
+	if (isNew) {
+	    Tcl_StatBuf fdStat;
+
+	    if (TclOSfstat(filePtr->fd, &fdStat) == -1) {
+		Tcl_Panic("fstat: %s", strerror(errno));
+	    }
+	    filePtr->isRegular =
+		    S_ISREG(fdStat.st_mode) || S_ISDIR(fdStat.st_mode);
+	}
+	if (filePtr->isRegular) {
+	    if (op == EPOLL_CTL_ADD && isNew) {
+		LIST_INSERT_HEAD(&tsdPtr->firstReadyFileHandlerPtr, filePtr,
+			readyNode);
+	    } else if (op == EPOLL_CTL_DEL) {
+		LIST_REMOVE(filePtr, readyNode);
+	    }
+	} else {
+	    RingControl(filePtr, tsdPtr, op, newEvent.events);
+	}
+	return;
+    }
+#endif /* HAVE_IO_URING */
+
+#ifdef NOTIFIER_EPOLL_ET
+    /*
+     * In edge-triggered mode, fds other than the trigger stay registered for
+     * every condition their mask has needed so far. A change of mask then
+     * only has to check whether the fd may be ready for a condition added
+     * to it, which is done with the others before the next wait. Only a
+     * condition never needed before takes a system call.
      */
 
-    if (TclOSfstat(filePtr->fd, &fdStat) == -1) {
-	Tcl_Panic("fstat: %s", strerror(errno));
+    if (filePtr != tsdPtr->triggerFilePtr) {
+	if (op == EPOLL_CTL_ADD) {
+	    newEvent.events |= EPOLLET;
+	} else if (filePtr->edgeEvents) {
+	    if (op == EPOLL_CTL_MOD) {
+		if ((filePtr->cachedMask & filePtr->mask)
+			&& !filePtr->onCheckList) {
+		    LIST_INSERT_HEAD(&tsdPtr->checkFileHandlers, filePtr,
+			    checkNode);
+		    filePtr->onCheckList = 1;
+		}
+		if (!(newEvent.events & ~filePtr->edgeEvents)) {
+		    return;
+		}
+		newEvent.events |= filePtr->edgeEvents;
+	    } else if (filePtr->onCheckList) {
+		LIST_REMOVE(filePtr, checkNode);
+		filePtr->onCheckList = 0;
+	    }
+	}
     }
+#endif /* NOTIFIER_EPOLL_ET */
 
    if (epoll_ctl(tsdPtr->eventsFd, op, filePtr->fd, &newEvent) == -1) {
        switch (errno) {
@@ -245,6 +417,10 @@ PlatformEventsControl(
 	    default:
 		Tcl_Panic("epoll_ctl: %s", strerror(errno));
 	}
+#ifdef NOTIFIER_EPOLL_ET
+    } else if (newEvent.events & EPOLLET) {
+	filePtr->edgeEvents = newEvent.events;
+#endif /* NOTIFIER_EPOLL_ET */
     }
     return;
 }
@@ -267,6 +443,7 @@ PlatformEventsControl(
  *	- The per-thread eventfd(2) is closed, if non-zero, and set to -1.
  *	- The per-thread epoll(7) fd is closed, if non-zero, and set to 0.
  *	- The per-thread epoll_event structs are freed, if any, and set to 0.
+ *	- The per-thread io_uring(7) instance, if any, is torn down.
  *
  *	tsdPtr->notifierMutex is destroyed.
  *
@@ -297,6 +474,9 @@ TclpFinalizeNotifier(
 #endif /* HAVE_EVENTFD */
     Tcl_Free(tsdPtr->triggerFilePtr->pedPtr);
     Tcl_Free(tsdPtr->triggerFilePtr);
+#ifdef HAVE_IO_URING
+    RingFinalize(&tsdPtr->ring);
+#endif /* HAVE_IO_URING */
     if (tsdPtr->eventsFd > 0) {
 	close(tsdPtr->eventsFd);
 	tsdPtr->eventsFd = 0;
@@ -305,6 +485,15 @@ TclpFinalizeNotifier(
 	Tcl_Free(tsdPtr->readyEvents);
 	tsdPtr->maxReadyEvents = 0;
     }
+#ifdef NOTIFIER_EPOLL_ET
+    if (tsdPtr->checkFds) {
+	Tcl_Free(tsdPtr->checkFds);
+	Tcl_Free(tsdPtr->checkFilePtrs);
+	tsdPtr->checkFds = NULL;
+	tsdPtr->checkFilePtrs = NULL;
+	tsdPtr->maxCheckFds = 0;
+    }
+#endif /* NOTIFIER_EPOLL_ET */
     pthread_mutex_unlock(&tsdPtr->notifierMutex);
     if ((errno = pthread_mutex_destroy(&tsdPtr->notifierMutex))) {
 	Tcl_Panic("pthread_mutex_destroy: %s", strerror(errno));
@@ -327,7 +516,8 @@ TclpFinalizeNotifier(
  *	The following per-thread entities are initialised:
  *	- notifierMutex is initialised.
  *	- The eventfd(2) is created w/ EFD_CLOEXEC and EFD_NONBLOCK.
- *	- The epoll(7) fd is created w/ EPOLL_CLOEXEC.
+ *	- If supported, an io_uring(7) instance is set up. Otherwise, the
+ *	  epoll(7) fd is created w/ EPOLL_CLOEXEC.
  *	- A FileHandler struct is allocated and initialised for the
  *	  eventfd(2), registering interest for TCL_READABLE on it via
  *	  PlatformEventsControl().
@@ -361,6 +551,15 @@ PlatformEventsInit(void)
     filePtr->fd = tsdPtr->triggerPipe[0];
 #endif /* HAVE_EVENTFD */
     tsdPtr->triggerFilePtr = filePtr;
+#ifdef NOTIFIER_EPOLL_ET
+    filePtr->edgeEvents = 0;
+    filePtr->cachedMask = 0;
+    filePtr->onCheckList = 0;
+    LIST_INIT(&tsdPtr->checkFileHandlers);
+#endif /* NOTIFIER_EPOLL_ET */
+#ifdef HAVE_IO_URING
+    if (!RingInit(&tsdPtr->ring))
+#endif /* HAVE_IO_URING */
     if ((tsdPtr->eventsFd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
 	Tcl_Panic("epoll_create1: %s", strerror(errno));
     }
@@ -468,6 +667,11 @@ PlatformEventsWait(
      */
 
     gettimeofday(&tv0, NULL);
+#ifdef HAVE_IO_URING
+    if (tsdPtr->ring.fd != -1) {
+	numFound = RingWait(tsdPtr, events, numEvents, timePtr);
+    } else
+#endif /* HAVE_IO_URING */
     numFound = epoll_wait(tsdPtr->eventsFd, events, (int) numEvents, timeout);
     gettimeofday(&tv1, NULL);
     if (timePtr && (timePtr->tv_sec && timePtr->tv_usec)) {
@@ -523,6 +727,11 @@ TclpCreateFileHandler(
 	filePtr = (FileHandler *) Tcl_Alloc(sizeof(FileHandler));
 	filePtr->fd = fd;
 	filePtr->readyMask = 0;
+#ifdef NOTIFIER_EPOLL_ET
+	filePtr->edgeEvents = 0;
+	filePtr->cachedMask = 0;
+	filePtr->onCheckList = 0;
+#endif /* NOTIFIER_EPOLL_ET */
 	filePtr->nextPtr = tsdPtr->firstFileHandlerPtr;
 	tsdPtr->firstFileHandlerPtr = filePtr;
     }
@@ -576,7 +785,7 @@ TclpDeleteFileHandler(
      */
 
     PlatformEventsControl(filePtr, tsdPtr, EPOLL_CTL_DEL, 0);
-    if (filePtr->pedPtr) {
+    if (filePtr->pedPtr) {	/* Not taken over by RingControl(). */
 	Tcl_Free(filePtr->pedPtr);
     }
 
@@ -693,8 +902,18 @@ TclpWaitForEvent(
 	filePtr->readyMask = mask;
     }
 
+#ifdef NOTIFIER_EPOLL_ET
+    /*
+     * Edge-triggered fds are not reported again while they stay ready, so
+     * those that may be ready for a condition of interest are checked here,
+     * which keeps the level-triggered behaviour the channel layer relies on.
+     */
+
+    numQueued += PlatformCheckFileHandlers(tsdPtr);
+#endif /* NOTIFIER_EPOLL_ET */
+
     /*
-     * If any events were queued in the above loop, force PlatformEventsWait()
+     * If any events were queued in the above loops, force PlatformEventsWait()
      * to poll as there already are events that need to be processed at this
      * point.
      */
@@ -748,6 +967,26 @@ TclpWaitForEvent(
 	    continue;
 	}
 #endif /* HAVE_EVENTFD */
+#ifdef NOTIFIER_EPOLL_ET
+	if (filePtr->edgeEvents) {
+	    /*
+	     * An edge only tells what became ready. Remember it, and queue an
+	     * event only if the handler is interested; the fd is checked
+	     * again after it has been serviced.
+	     */
+
+	    filePtr->cachedMask |= mask;
+	    if (!(filePtr->cachedMask & filePtr->mask)) {
+		continue;
+	    }
+	    mask = filePtr->cachedMask;
+	    if (!filePtr->onCheckList) {
+		LIST_INSERT_HEAD(&tsdPtr->checkFileHandlers, filePtr,
+			checkNode);
+		filePtr->onCheckList = 1;
+	    }
+	}
+#endif /* NOTIFIER_EPOLL_ET */
 	if (!mask) {
 	    continue;
 	}
@@ -769,7 +1008,541 @@ TclpWaitForEvent(
     }
     return 0;
 }
+
+#ifdef NOTIFIER_EPOLL_ET
+/*
+ *----------------------------------------------------------------------
+ *
+ * PlatformCheckFileHandlers --
+ *
+ *	This function checks the readiness of the edge-triggered fds on the
+ *	check list of tsdPtr with a single poll(2) call, and queues Tcl events
+ *	for those that are ready for a condition of interest.
+ *
+ * Results:
+ *	Returns the number of events queued.
+ *
+ * Side effects:
+ *	The cached readiness of the fds checked is replaced by what poll(2)
+ *	returned. Those ready for a condition of interest stay on the check
+ *	list, so that they are checked again before the next wait; the others
+ *	leave it and are only checked again after epoll(7) reports a new edge
+ *	or their mask grows.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+PlatformCheckFileHandlers(
+    ThreadSpecificData *tsdPtr)
+{
+    FileHandler *filePtr;
+    size_t numFds = 0, i;
+    int mask, numQueued = 0;
+
+    LIST_FOREACH(filePtr, &tsdPtr->checkFileHandlers, checkNode) {
+	numFds++;
+    }
+    if (numFds == 0) {
+	return 0;
+    }
+    if (numFds > tsdPtr->maxCheckFds) {
+	tsdPtr->maxCheckFds = 2 * numFds;
+	tsdPtr->checkFds = (struct pollfd *) Tcl_Realloc(tsdPtr->checkFds,
+		tsdPtr->maxCheckFds * sizeof(struct pollfd));
+	tsdPtr->checkFilePtrs = (FileHandler **) Tcl_Realloc(
+		tsdPtr->checkFilePtrs,
+		tsdPtr->maxCheckFds * sizeof(FileHandler *));
+    }
+
+    /*
+     * Take all FileHandlers off the list; those still ready are put back.
+     */
+
+    i = 0;
+    LIST_FOREACH(filePtr, &tsdPtr->checkFileHandlers, checkNode) {
+	tsdPtr->checkFds[i].fd = filePtr->fd;
+	tsdPtr->checkFds[i].events = POLLIN | POLLOUT;
+	tsdPtr->checkFds[i].revents = 0;
+	tsdPtr->checkFilePtrs[i++] = filePtr;
+	filePtr->onCheckList = 0;
+    }
+    LIST_INIT(&tsdPtr->checkFileHandlers);
+
+    while (poll(tsdPtr->checkFds, numFds, 0) == -1) {
+	if (errno != EINTR) {
+	    Tcl_Panic("poll: %s", strerror(errno));
+	}
+    }
+
+    for (i = 0; i < numFds; i++) {
+	short revents = tsdPtr->checkFds[i].revents;
+
+	filePtr = tsdPtr->checkFilePtrs[i];
+	mask = 0;
+	if (revents & (POLLIN | POLLHUP)) {
+	    mask |= TCL_READABLE;
+	}
+	if (revents & POLLOUT) {
+	    mask |= TCL_WRITABLE;
+	}
+	if (revents & POLLERR) {
+	    mask |= TCL_EXCEPTION;
+	}
+	filePtr->cachedMask = mask;
+	if (!(mask & filePtr->mask)) {
+	    continue;
+	}
+	if (filePtr->readyMask == 0) {
+	    FileHandlerEvent *fileEvPtr = (FileHandlerEvent *)
+		    Tcl_Alloc(sizeof(FileHandlerEvent));
+
+	    fileEvPtr->header.proc = FileHandlerEventProc;
+	    fileEvPtr->fd = filePtr->fd;
+	    Tcl_QueueEvent((Tcl_Event *) fileEvPtr, TCL_QUEUE_TAIL);
+	    numQueued++;
+	}
+	filePtr->readyMask = mask;
+	LIST_INSERT_HEAD(&tsdPtr->checkFileHandlers, filePtr, checkNode);
+	filePtr->onCheckList = 1;
+    }
+    return numQueued;
+}
+#endif /* NOTIFIER_EPOLL_ET */
 
+#ifdef HAVE_IO_URING
+/*
+ *----------------------------------------------------------------------
+ *
+ * RingInit --
+ *
+ *	This function sets up the io_uring(7) instance of the calling thread
+ *	and maps its submission and completion queues. No liburing is needed;
+ *	the raw system calls and the ring layout of <linux/io_uring.h> are
+ *	used directly.
+ *
+ * Results:
+ *	Returns 1 if the ring is ready for use, 0 if the kernel lacks
+ *	io_uring(7) or one of the features used here (IORING_FEAT_NODROP for
+ *	never losing completions, IORING_FEAT_EXT_ARG for waiting with a
+ *	timeout), in which case the caller falls back to epoll(7). Setting
+ *	the environment variable TCL_NO_IO_URING forces that fallback, e.g.
+ *	where a seccomp filter makes io_uring(7) calls misbehave, and lets
+ *	the test suite exercise it.
+ *
+ * Side effects:
+ *	Sets ringPtr->fd to the ring fd, or to -1 on failure.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+RingInit(
+    PlatformRing *ringPtr)
+{
+    struct io_uring_params params;
+    const unsigned features = IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    char *sqMap, *cqMap;
+
+    LIST_INIT(&ringPtr->orphans);
+    if (getenv("TCL_NO_IO_URING") != NULL) {	/* INTL: Native. */
+	ringPtr->fd = -1;
+	return 0;
+    }
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = RING_CQ_ENTRIES;
+    ringPtr->fd = (int) syscall(__NR_io_uring_setup, RING_SQ_ENTRIES, &params);
+    if (ringPtr->fd == -1) {
+	return 0;
+    }
+    if ((params.features & features) != features) {
+	goto fail;
+    }
+
+    ringPtr->sqMapSize = params.sq_off.array
+	    + params.sq_entries * sizeof(unsigned);
+    ringPtr->cqMapSize = params.cq_off.cqes
+	    + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+	if (ringPtr->cqMapSize > ringPtr->sqMapSize) {
+	    ringPtr->sqMapSize = ringPtr->cqMapSize;
+	}
+	ringPtr->cqMapSize = 0;
+    }
+    ringPtr->sqMap = mmap(NULL, ringPtr->sqMapSize, PROT_READ | PROT_WRITE,
+	    MAP_SHARED | MAP_POPULATE, ringPtr->fd, IORING_OFF_SQ_RING);
+    if (ringPtr->sqMap == MAP_FAILED) {
+	goto fail;
+    }
+    if (ringPtr->cqMapSize) {
+	ringPtr->cqMap = mmap(NULL, ringPtr->cqMapSize,
+		PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		ringPtr->fd, IORING_OFF_CQ_RING);
+	if (ringPtr->cqMap == MAP_FAILED) {
+	    munmap(ringPtr->sqMap, ringPtr->sqMapSize);
+	    goto fail;
+	}
+    } else {
+	ringPtr->cqMap = ringPtr->sqMap;
+    }
+    ringPtr->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    ringPtr->sqes = (struct io_uring_sqe *) mmap(NULL, ringPtr->sqesSize,
+	    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringPtr->fd,
+	    IORING_OFF_SQES);
+    if (ringPtr->sqes == MAP_FAILED) {
+	munmap(ringPtr->sqMap, ringPtr->sqMapSize);
+	if (ringPtr->cqMapSize) {
+	    munmap(ringPtr->cqMap, ringPtr->cqMapSize);
+	}
+	goto fail;
+    }
+
+    sqMap = (char *) ringPtr->sqMap;
+    cqMap = (char *) ringPtr->cqMap;
+    ringPtr->sqHead = (unsigned *) (sqMap + params.sq_off.head);
+    ringPtr->sqTail = (unsigned *) (sqMap + params.sq_off.tail);
+    ringPtr->sqArray = (unsigned *) (sqMap + params.sq_off.array);
+    ringPtr->sqMask = *(unsigned *) (sqMap + params.sq_off.ring_mask);
+    ringPtr->sqEntries = params.sq_entries;
+    ringPtr->cqHead = (unsigned *) (cqMap + params.cq_off.head);
+    ringPtr->cqTail = (unsigned *) (cqMap + params.cq_off.tail);
+    ringPtr->cqMask = *(unsigned *) (cqMap + params.cq_off.ring_mask);
+    ringPtr->cqes = (struct io_uring_cqe *) (cqMap + params.cq_off.cqes);
+    return 1;
+
+  fail:
+    close(ringPtr->fd);
+    ringPtr->fd = -1;
+    return 0;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * RingFinalize --
+ *
+ *	This function tears down the io_uring(7) instance of the calling
+ *	thread, if any.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	The ring fd is closed, which cancels all outstanding requests, the
+ *	queues are unmapped and orphaned PlatformEventData structs are freed.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+RingFinalize(
+    PlatformRing *ringPtr)
+{
+    struct PlatformEventData *pedPtr;
+
+    if (ringPtr->fd == -1) {
+	return;
+    }
+    close(ringPtr->fd);
+    ringPtr->fd = -1;
+    munmap(ringPtr->sqes, ringPtr->sqesSize);
+    munmap(ringPtr->sqMap, ringPtr->sqMapSize);
+    if (ringPtr->cqMapSize) {
+	munmap(ringPtr->cqMap, ringPtr->cqMapSize);
+    }
+    while ((pedPtr = LIST_FIRST(&ringPtr->orphans)) != NULL) {
+	LIST_REMOVE(pedPtr, orphanNode);
+	Tcl_Free(pedPtr);
+    }
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * RingEnter --
+ *
+ *	This function hands all queued submission queue entries to the kernel
+ *	and optionally waits for completions, as per io_uring_enter(2).
+ *
+ * Results:
+ *	Returns the result of io_uring_enter(2).
+ *
+ * Side effects:
+ *	See io_uring_enter(2).
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+RingEnter(
+    PlatformRing *ringPtr,
+    unsigned minComplete,
+    unsigned flags,
+    struct io_uring_getevents_arg *argPtr)
+{
+    unsigned toSubmit = *ringPtr->sqTail
+	    - __atomic_load_n(ringPtr->sqHead, __ATOMIC_ACQUIRE);
+
+    return (int) syscall(__NR_io_uring_enter, ringPtr->fd, toSubmit,
+	    minComplete, flags, argPtr, argPtr ? sizeof(*argPtr) : 0);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * RingGetSqe --
+ *
+ *	This function returns the next free submission queue entry, handing
+ *	the queued ones to the kernel first if the queue is full.
+ *
+ * Results:
+ *	Returns a pointer to the (cleared) submission queue entry. If the
+ *	queue cannot be drained, returns NULL if mayFail is set, and panics
+ *	otherwise.
+ *
+ * Side effects:
+ *	The entry is made visible to the kernel immediately; it is submitted
+ *	with the next call to RingEnter().
+ *
+ *----------------------------------------------------------------------
+ */
+
+static struct io_uring_sqe *
+RingGetSqe(
+    PlatformRing *ringPtr,
+    int mayFail)
+{
+    unsigned tail = *ringPtr->sqTail;
+    unsigned index;
+    struct io_uring_sqe *sqePtr;
+
+    if (tail - __atomic_load_n(ringPtr->sqHead, __ATOMIC_ACQUIRE)
+	    >= ringPtr->sqEntries) {
+	/*
+	 * The kernel refuses new submissions (EBUSY) as long as completions
+	 * are backlogged; give it a chance to flush them into the completion
+	 * queue before trying once more.
+	 */
+
+	if (RingEnter(ringPtr, 0, 0, NULL) == -1 && errno == EBUSY) {
+	    RingEnter(ringPtr, 0, IORING_ENTER_GETEVENTS, NULL);
+	    RingEnter(ringPtr, 0, 0, NULL);
+	}
+	if (tail - __atomic_load_n(ringPtr->sqHead, __ATOMIC_ACQUIRE)
+		>= ringPtr->sqEntries) {
+	    if (mayFail) {
+		return NULL;
+	    }
+	    Tcl_Panic("io_uring_enter: %s", strerror(errno));
+	}
+    }
+    index = tail & ringPtr->sqMask;
+    sqePtr = &ringPtr->sqes[index];
+    memset(sqePtr, 0, sizeof(*sqePtr));
+    ringPtr->sqArray[index] = index;
+    __atomic_store_n(ringPtr->sqTail, tail + 1, __ATOMIC_RELEASE);
+    return sqePtr;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * RingPollAdd --
+ *
+ *	This function fills in sqePtr with a one-shot IORING_OP_POLL_ADD
+ *	request for the events of interest recorded in pedPtr.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	The count of outstanding poll requests of pedPtr is incremented.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+RingPollAdd(
+    struct io_uring_sqe *sqePtr,
+    struct PlatformEventData *pedPtr)
+{
+    unsigned events = pedPtr->events;
+
+#ifdef WORDS_BIGENDIAN
+    events = (events << 16) | (events >> 16);
+#endif /* WORDS_BIGENDIAN */
+    sqePtr->opcode = IORING_OP_POLL_ADD;
+    sqePtr->fd = pedPtr->filePtr->fd;
+    sqePtr->poll32_events = events;
+    sqePtr->user_data = (uintptr_t) pedPtr;
+    pedPtr->numPolls++;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * RingControl --
+ *
+ *	This function is the io_uring(7) counterpart of epoll_ctl(2) in
+ *	PlatformEventsControl(): it queues the poll requests that register,
+ *	update or cancel interest for the file descriptor of filePtr.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	Registrations and updates are merely queued, so that they reach the
+ *	kernel together with the next wait; an update that does not change
+ *	the events of interest is a no-op. Cancellations are submitted right
+ *	away, as an outstanding poll request holds a reference to the file
+ *	that would otherwise delay its close. When deleting a file handler
+ *	with a poll request in flight, its PlatformEventData struct is
+ *	detached from filePtr and freed by RingWait() once the last request
+ *	completes.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+RingControl(
+    FileHandler *filePtr,
+    ThreadSpecificData *tsdPtr,
+    int op,
+    unsigned events)
+{
+    PlatformRing *ringPtr = &tsdPtr->ring;
+    struct PlatformEventData *pedPtr = filePtr->pedPtr;
+    struct io_uring_sqe *sqePtr;
+
+    if (op != EPOLL_CTL_ADD && pedPtr->numPolls > 0) {
+	if (op == EPOLL_CTL_MOD && pedPtr->events == events) {
+	    return;
+	}
+	sqePtr = RingGetSqe(ringPtr, 0);
+	sqePtr->opcode = IORING_OP_POLL_REMOVE;
+	sqePtr->fd = -1;
+	sqePtr->addr = (uintptr_t) pedPtr;
+    }
+    if (op == EPOLL_CTL_DEL) {
+	if (pedPtr->numPolls > 0) {
+	    pedPtr->filePtr = NULL;
+	    filePtr->pedPtr = NULL;
+	    LIST_INSERT_HEAD(&ringPtr->orphans, pedPtr, orphanNode);
+	    RingEnter(ringPtr, 0, 0, NULL);
+	}
+	return;
+    }
+    if (op == EPOLL_CTL_ADD) {
+	pedPtr->numPolls = 0;
+    }
+    pedPtr->events = events;
+    RingPollAdd(RingGetSqe(ringPtr, 0), pedPtr);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * RingWait --
+ *
+ *	This function is the io_uring(7) counterpart of epoll_wait(2) in
+ *	PlatformEventsWait(): it submits all queued requests, waits for
+ *	completions for at most the time in timePtr (forever if NULL) and
+ *	translates the completed poll requests into epoll_event structs.
+ *
+ * Results:
+ *	Returns the count of events stored in events.
+ *
+ * Side effects:
+ *	Poll requests of file handlers that became ready are re-armed, to be
+ *	submitted with the next wait; a handler that has not consumed the
+ *	data by then is reported again, just like with level-triggered
+ *	epoll(7). So are requests that failed, which are reported as
+ *	EPOLLERR | EPOLLIN. Completions that do not fit into events are left
+ *	in the completion queue for the next call.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+RingWait(
+    ThreadSpecificData *tsdPtr,
+    struct epoll_event *events,
+    size_t numEvents,
+    struct timeval *timePtr)
+{
+    PlatformRing *ringPtr = &tsdPtr->ring;
+    struct io_uring_getevents_arg arg;
+    struct __kernel_timespec ts;
+    struct io_uring_cqe *cqePtr;
+    struct io_uring_sqe *sqePtr;
+    struct PlatformEventData *pedPtr;
+    unsigned head, tail, minComplete = 0;
+    int numFound = 0;
+
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    if (!timePtr) {
+	minComplete = 1;
+    } else if (timePtr->tv_sec || timePtr->tv_usec) {
+	ts.tv_sec = timePtr->tv_sec;
+	ts.tv_nsec = timePtr->tv_usec * 1000;
+	arg.ts = (uintptr_t) &ts;
+	minComplete = 1;
+    }
+    RingEnter(ringPtr, minComplete,
+	    IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg);
+
+    head = *ringPtr->cqHead;
+    tail = __atomic_load_n(ringPtr->cqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail && (size_t) numFound < numEvents; head++) {
+	cqePtr = &ringPtr->cqes[head & ringPtr->cqMask];
+	pedPtr = (struct PlatformEventData *) (uintptr_t) cqePtr->user_data;
+	if (pedPtr == NULL) {
+	    continue;			/* IORING_OP_POLL_REMOVE */
+	}
+	if (pedPtr->filePtr == NULL) {
+	    if (--pedPtr->numPolls == 0) {
+		LIST_REMOVE(pedPtr, orphanNode);
+		Tcl_Free(pedPtr);
+	    }
+	    continue;
+	}
+
+	/*
+	 * Whatever the outcome, a handler whose last outstanding request
+	 * completed needs a new one, or it would never hear of its fd again.
+	 * A request cancelled by RingControl() was replaced already, so it
+	 * only needs one if the replacement completed first.
+	 */
+
+	if (pedPtr->numPolls == 1 && pedPtr->filePtr->mask != 0) {
+	    sqePtr = RingGetSqe(ringPtr, 1);
+	    if (sqePtr == NULL) {
+		break;
+	    }
+	    RingPollAdd(sqePtr, pedPtr);
+	}
+	pedPtr->numPolls--;
+	if (cqePtr->res == 0 || cqePtr->res == -ECANCELED) {
+	    continue;
+	}
+
+	/*
+	 * A request that failed is reported as an error condition, so that
+	 * the handler gets to find out what is wrong by using the fd.
+	 */
+
+	events[numFound].events = (cqePtr->res < 0) ?
+		(EPOLLERR | EPOLLIN) : (uint32_t) cqePtr->res;
+	events[numFound].data.ptr = pedPtr;
+	numFound++;
+    }
+    __atomic_store_n(ringPtr->cqHead, head, __ATOMIC_RELEASE);
+    return numFound;
+}
+#endif /* HAVE_IO_URING */
+
 /*
  *----------------------------------------------------------------------
  *
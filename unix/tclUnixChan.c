@@ -11,6 +11,9 @@
  * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE	/* For splice(2), pipe2(2), F_SETPIPE_SZ */
+#endif
 #include "tclInt.h"	/* Internal definitions for Tcl. */
 #include "tclIO.h"	/* To get Channel type declaration. */
 
@@ -48,6 +51,39 @@
 
 #endif	/* HAVE_TERMIOS_H */
 
+#ifdef HAVE_SPLICE
+#   include <poll.h>
+#   ifdef HAVE_SYS_SENDFILE_H
+#	include <sys/sendfile.h>
+#   endif /* HAVE_SYS_SENDFILE_H */
+
+/*
+ * The state of a copy between two channels done by the kernel, see
+ * TclpOpenDirectCopy.
+ */
+
+#define DIRECT_MAX_COPY		(1 << 22)	/* Bytes per system call. */
+#define DIRECT_PIPE_SIZE	(1 << 18)	/* Capacity of splice pipes. */
+
+enum DirectCopyMethod {
+    DIRECT_COPY_RANGE,		/* copy_file_range(2) between regular
+				 * files. */
+    DIRECT_SENDFILE,		/* sendfile(2) from a regular file. */
+    DIRECT_SPLICE		/* splice(2), through pipeFds unless one of
+				 * the descriptors is a pipe. */
+};
+
+struct TclDirectCopy {
+    int inFd, outFd;		/* Descriptors of the channels. */
+    int method;			/* DirectCopyMethod in use. */
+    int inSocket;		/* Input is a socket: ECONNRESET means EOF,
+				 * as in TcpInputProc. */
+    int pipeFds[2];		/* Pipe to splice through, or -1. */
+    size_t pipeSize;		/* Capacity of that pipe. */
+    size_t numPiped;		/* Bytes in the pipe not yet written. */
+};
+#endif /* HAVE_SPLICE */
+
 /*
  * The bits supported for describing the closeMode field of TtyState.
  */
@@ -128,6 +164,9 @@ static int		FileInputProc(void *instanceData, char *buf,
 			    int toRead, int *errorCode);
 static int		FileOutputProc(void *instanceData,
 			    const char *buf, int toWrite, int *errorCode);
+static int		FileOutputVProc(void *instanceData,
+			    const Tcl_ChannelOutputVec *vecs, int numVecs,
+			    int *errorCode);
 static int		FileTruncateProc(void *instanceData,
 			    long long length);
 static long long	FileWideSeekProc(void *instanceData,
@@ -158,7 +197,7 @@ static int		TtySetOptionProc(void *instanceData,
 
 static const Tcl_ChannelType fileChannelType = {
     "file",			/* Type name. */
-    TCL_CHANNEL_VERSION_5,	/* v5 channel */
+    TCL_CHANNEL_VERSION_6,	/* v6 channel */
     NULL,		/* Close proc. */
     FileInputProc,		/* Input proc. */
     FileOutputProc,		/* Output proc. */
@@ -173,7 +212,8 @@ static const Tcl_ChannelType fileChannelType = {
     NULL,			/* handler proc. */
     FileWideSeekProc,		/* wide seek proc. */
     NULL,
-    FileTruncateProc		/* truncate proc. */
+    FileTruncateProc,		/* truncate proc. */
+    FileOutputVProc		/* scatter/gather output proc. */
 };
 
 #ifdef SUPPORTS_TTY
@@ -184,7 +224,7 @@ static const Tcl_ChannelType fileChannelType = {
 
 static const Tcl_ChannelType ttyChannelType = {
     "tty",			/* Type name. */
-    TCL_CHANNEL_VERSION_5,	/* v5 channel */
+    TCL_CHANNEL_VERSION_6,	/* v6 channel */
     NULL,		/* Close proc. */
     FileInputProc,		/* Input proc. */
     FileOutputProc,		/* Output proc. */
@@ -199,7 +239,8 @@ static const Tcl_ChannelType ttyChannelType = {
     NULL,			/* handler proc. */
     NULL,			/* wide seek proc. */
     NULL,			/* thread action proc. */
-    NULL			/* truncate proc. */
+    NULL,			/* truncate proc. */
+    FileOutputVProc		/* scatter/gather output proc. */
 };
 #endif	/* SUPPORTS_TTY */
 
@@ -331,6 +372,38 @@ FileOutputProc(
     *errorCodePtr = errno;
     return -1;
 }
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * FileOutputVProc --
+ *
+ *	This function is invoked from the generic IO level to write several
+ *	runs of queued output to a file channel with one system call.
+ *
+ * Results:
+ *	The number of bytes written is returned or -1 on error. An output
+ *	argument contains a POSIX error code if an error occurred, or zero.
+ *
+ * Side effects:
+ *	Writes output on the output device of the channel.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+FileOutputVProc(
+    void *instanceData,		/* File state. */
+    const Tcl_ChannelOutputVec *vecs,
+				/* The runs of bytes to write. */
+    int numVecs,		/* How many runs there are. */
+    int *errorCodePtr)		/* Where to store error code. */
+{
+    FileState *fsPtr = (FileState *)instanceData;
+
+    *errorCodePtr = 0;
+    return TclUnixWriteV(fsPtr->fd, 0, vecs, numVecs, errorCodePtr);
+}
 
 /*
  *----------------------------------------------------------------------
@@ -1996,6 +2069,437 @@ FileTruncateProc(
     return 0;
 }
 
+#ifdef HAVE_SPLICE
+/*
+ *----------------------------------------------------------------------
+ *
+ * DirectCopyFd --
+ *
+ *	Finds the file descriptor underlying a channel that may take part in
+ *	a copy done by the kernel. Only the file, pipe and tcp channel types
+ *	qualify, as their input and output procs are plain read(2) and
+ *	write(2) calls.
+ *
+ * Results:
+ *	1 and the descriptor and its stat(2) data if the channel qualifies,
+ *	0 otherwise.
+ *
+ * Side effects:
+ *	None.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+DirectCopyFd(
+    Tcl_Channel chan,		/* Channel to examine. */
+    int direction,		/* TCL_READABLE or TCL_WRITABLE. */
+    int *fdPtr,			/* Where to store the descriptor. */
+    Tcl_StatBuf *statPtr)	/* Where to store its stat(2) data. */
+{
+    const char *typeName = Tcl_ChannelName(Tcl_GetChannelType(chan));
+    void *handle;
+
+    if (strcmp(typeName, "file") && strcmp(typeName, "pipe")
+	    && strcmp(typeName, "tcp")) {
+	return 0;
+    }
+    if (Tcl_GetChannelHandle(chan, direction, &handle) != TCL_OK) {
+	return 0;
+    }
+    if (!strcmp(typeName, "tcp")) {
+	Tcl_DString ds;
+	int connecting;
+
+	/*
+	 * The tcp driver finishes asynchronous connects on first I/O.
+	 */
+
+	Tcl_DStringInit(&ds);
+	connecting = (Tcl_GetChannelOption(NULL, chan, "-connecting", &ds)
+		== TCL_OK) && strcmp(Tcl_DStringValue(&ds), "0");
+	Tcl_DStringFree(&ds);
+	if (connecting) {
+	    return 0;
+	}
+    }
+    *fdPtr = PTR2INT(handle);
+    return TclOSfstat(*fdPtr, statPtr) == 0;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclpOpenDirectCopy --
+ *
+ *	Checks whether the kernel can move the bytes from one channel to the
+ *	other without passing them through user space, using
+ *	copy_file_range(2) between regular files, sendfile(2) from a regular
+ *	file, and splice(2) otherwise. The caller makes sure that no
+ *	translation or encoding applies and that the channels are not
+ *	stacked.
+ *
+ * Results:
+ *	A handle for TclpDirectCopy, or NULL if the channels do not qualify.
+ *
+ * Side effects:
+ *	May create a pipe to splice(2) through.
+ *
+ *----------------------------------------------------------------------
+ */
+
+TclDirectCopy *
+TclpOpenDirectCopy(
+    Tcl_Channel inChan,		/* Channel to read from. */
+    Tcl_Channel outChan)	/* Channel to write to. */
+{
+    TclDirectCopy *dcPtr;
+    Tcl_StatBuf inStat, outStat;
+    int inFd, outFd, flags, method, size;
+
+    if (!DirectCopyFd(inChan, TCL_READABLE, &inFd, &inStat)
+	    || !DirectCopyFd(outChan, TCL_WRITABLE, &outFd, &outStat)) {
+	return NULL;
+    }
+    if (S_ISREG(outStat.st_mode)) {
+	flags = fcntl(outFd, F_GETFL);
+	if (flags == -1 || (flags & O_APPEND)) {
+	    return NULL;
+	}
+    } else if (!S_ISFIFO(outStat.st_mode) && !S_ISSOCK(outStat.st_mode)) {
+	return NULL;
+    }
+    if (S_ISREG(inStat.st_mode)) {
+	method = S_ISREG(outStat.st_mode) ? DIRECT_COPY_RANGE : DIRECT_SENDFILE;
+    } else if (S_ISFIFO(inStat.st_mode) || S_ISSOCK(inStat.st_mode)) {
+	method = DIRECT_SPLICE;
+    } else {
+	return NULL;
+    }
+
+    dcPtr = (TclDirectCopy *) Tcl_Alloc(sizeof(TclDirectCopy));
+    dcPtr->inFd = inFd;
+    dcPtr->outFd = outFd;
+    dcPtr->method = method;
+    dcPtr->inSocket = S_ISSOCK(inStat.st_mode);
+    dcPtr->pipeFds[0] = dcPtr->pipeFds[1] = -1;
+    dcPtr->pipeSize = 0;
+    dcPtr->numPiped = 0;
+    if (method == DIRECT_SPLICE && !S_ISFIFO(inStat.st_mode)
+	    && !S_ISFIFO(outStat.st_mode)) {
+	if (pipe2(dcPtr->pipeFds, O_CLOEXEC | O_NONBLOCK) != 0) {
+	    Tcl_Free(dcPtr);
+	    return NULL;
+	}
+	(void) fcntl(dcPtr->pipeFds[1], F_SETPIPE_SZ, DIRECT_PIPE_SIZE);
+	size = fcntl(dcPtr->pipeFds[1], F_GETPIPE_SZ);
+	dcPtr->pipeSize = (size > 0) ? (size_t) size : 4096;
+    }
+    return dcPtr;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * DirectCopyFailed --
+ *
+ *	Maps the errno of a failed copy system call to a TCL_DIRECT_* code.
+ *
+ * Results:
+ *	TCL_DIRECT_READ_BLOCKED or TCL_DIRECT_WRITE_BLOCKED for EAGAIN,
+ *	depending on blockedSide, TCL_DIRECT_UNSUPPORTED if the kernel cannot
+ *	do this copy, and TCL_DIRECT_READ_ERROR or TCL_DIRECT_WRITE_ERROR
+ *	otherwise, depending on errorSide.
+ *
+ * Side effects:
+ *	Sets the Tcl errno.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+DirectCopyFailed(
+    int blockedSide,		/* TCL_READABLE or TCL_WRITABLE. */
+    int errorSide)		/* TCL_READABLE or TCL_WRITABLE. */
+{
+    int errorCode = errno;
+
+    Tcl_SetErrno(errorCode);
+    switch (errorCode) {
+    case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+    case EWOULDBLOCK:
+#endif
+	return (blockedSide == TCL_READABLE)
+		? TCL_DIRECT_READ_BLOCKED : TCL_DIRECT_WRITE_BLOCKED;
+    case EINVAL:
+    case ENOSYS:
+    case EOPNOTSUPP:
+    case EXDEV:
+	return TCL_DIRECT_UNSUPPORTED;
+    }
+    return (errorSide == TCL_READABLE)
+	    ? TCL_DIRECT_READ_ERROR : TCL_DIRECT_WRITE_ERROR;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclpDirectCopy --
+ *
+ *	Moves up to toCopy bytes (all available if toCopy is -1) from the
+ *	input to the output descriptor of a TclDirectCopy. Spliced data that
+ *	could not be written yet stays in the pipe and goes out first on the
+ *	next call; only the bytes actually written count as copied.
+ *
+ * Results:
+ *	One of the TCL_DIRECT_* codes. The number of bytes written is stored
+ *	in *copiedPtr.
+ *
+ * Side effects:
+ *	Moves data between the descriptors.
+ *
+ *----------------------------------------------------------------------
+ */
+
+int
+TclpDirectCopy(
+    TclDirectCopy *dcPtr,	/* Copy state from TclpOpenDirectCopy. */
+    Tcl_WideInt toCopy,		/* Bytes left to copy, or -1 for all. */
+    Tcl_WideInt *copiedPtr)	/* Where to store the bytes written. */
+{
+    size_t size = (toCopy < 0 || toCopy > DIRECT_MAX_COPY)
+	    ? DIRECT_MAX_COPY : (size_t) toCopy;
+    ssize_t n;
+    struct pollfd pfd;
+
+    *copiedPtr = 0;
+    switch (dcPtr->method) {
+    case DIRECT_COPY_RANGE:
+#ifdef HAVE_COPY_FILE_RANGE
+	do {
+	    n = copy_file_range(dcPtr->inFd, NULL, dcPtr->outFd, NULL, size,
+		    0);
+	} while (n == -1 && errno == EINTR);
+	if (n != -1 || DirectCopyFailed(TCL_WRITABLE, TCL_WRITABLE)
+		!= TCL_DIRECT_UNSUPPORTED) {
+	    break;
+	}
+
+	/*
+	 * Older kernels cannot copy_file_range(2) across file systems.
+	 */
+#endif /* HAVE_COPY_FILE_RANGE */
+	dcPtr->method = DIRECT_SENDFILE;
+	return TclpDirectCopy(dcPtr, toCopy, copiedPtr);
+
+    case DIRECT_SENDFILE:
+#ifdef HAVE_SYS_SENDFILE_H
+	do {
+	    n = sendfile(dcPtr->outFd, dcPtr->inFd, NULL, size);
+	} while (n == -1 && errno == EINTR);
+	break;
+#else
+	dcPtr->method = DIRECT_SPLICE;
+	return TclpDirectCopy(dcPtr, toCopy, copiedPtr);
+#endif /* HAVE_SYS_SENDFILE_H */
+
+    default:
+	if (dcPtr->pipeFds[0] == -1) {
+	    /*
+	     * One of the descriptors is a pipe, splice(2) directly.
+	     */
+
+	    do {
+		n = splice(dcPtr->inFd, NULL, dcPtr->outFd, NULL, size,
+			SPLICE_F_MOVE);
+	    } while (n == -1 && errno == EINTR);
+	    if (n == -1) {
+		int errorCode = errno;
+
+		/*
+		 * Find out which side is blocked; also, splice(2) reports a
+		 * closed output pipe even if the input is at EOF, which
+		 * read(2) would have seen first.
+		 */
+
+		pfd.fd = dcPtr->inFd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		(void) poll(&pfd, 1, 0);
+		if ((pfd.revents & (POLLIN | POLLHUP)) == POLLHUP) {
+		    return TCL_DIRECT_EOF;
+		}
+		errno = errorCode;
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+		    return DirectCopyFailed(pfd.revents ? TCL_WRITABLE
+			    : TCL_READABLE, TCL_READABLE);
+		}
+	    }
+	    break;
+	}
+
+	if (dcPtr->numPiped == 0) {
+	    if (size > dcPtr->pipeSize) {
+		size = dcPtr->pipeSize;
+	    }
+	    do {
+		n = splice(dcPtr->inFd, NULL, dcPtr->pipeFds[1], NULL, size,
+			SPLICE_F_MOVE);
+	    } while (n == -1 && errno == EINTR);
+	    if (n == 0 || (n == -1 && errno == ECONNRESET && dcPtr->inSocket)) {
+		return TCL_DIRECT_EOF;
+	    } else if (n == -1) {
+		return DirectCopyFailed(TCL_READABLE, TCL_READABLE);
+	    }
+	    dcPtr->numPiped = n;
+	}
+	do {
+	    n = splice(dcPtr->pipeFds[0], NULL, dcPtr->outFd, NULL,
+		    dcPtr->numPiped, SPLICE_F_MOVE);
+	} while (n == -1 && errno == EINTR);
+	if (n == -1) {
+	    int code = DirectCopyFailed(TCL_WRITABLE, TCL_WRITABLE);
+
+	    /*
+	     * Spliced bytes cannot be handed back to the buffered copy.
+	     */
+
+	    return (code == TCL_DIRECT_UNSUPPORTED)
+		    ? TCL_DIRECT_WRITE_ERROR : code;
+	}
+	dcPtr->numPiped -= n;
+	*copiedPtr = n;
+	return TCL_DIRECT_OK;
+    }
+
+    if (n > 0) {
+	*copiedPtr = n;
+	return TCL_DIRECT_OK;
+    } else if (n == 0 || (errno == ECONNRESET && dcPtr->inSocket)) {
+	return TCL_DIRECT_EOF;
+    } else if (errno == EIO) {
+	return DirectCopyFailed(TCL_WRITABLE, TCL_READABLE);
+    }
+    return DirectCopyFailed(TCL_WRITABLE, TCL_WRITABLE);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclpDirectCopyPending, TclpReadDirectCopyPending --
+ *
+ *	When the output blocks or fails, splice(2) may have moved bytes from
+ *	the input into the pipe that are not written yet. TclpDirectCopyPending
+ *	tells how many, TclpReadDirectCopyPending reads them all into buf,
+ *	which must have room for them, so that they are not lost when the copy
+ *	stops or falls back to the channel buffers.
+ *
+ * Results:
+ *	The number of bytes, and 0 or a POSIX error code respectively.
+ *
+ * Side effects:
+ *	TclpReadDirectCopyPending empties the pipe.
+ *
+ *----------------------------------------------------------------------
+ */
+
+size_t
+TclpDirectCopyPending(
+    TclDirectCopy *dcPtr)
+{
+    return dcPtr->numPiped;
+}
+
+int
+TclpReadDirectCopyPending(
+    TclDirectCopy *dcPtr,
+    char *buf)			/* Where to store the bytes. */
+{
+    ssize_t n;
+
+    while (dcPtr->numPiped > 0) {
+	do {
+	    n = read(dcPtr->pipeFds[0], buf, dcPtr->numPiped);
+	} while (n == -1 && errno == EINTR);
+	if (n <= 0) {
+	    return (n == 0) ? EIO : errno;
+	}
+	buf += n;
+	dcPtr->numPiped -= n;
+    }
+    return 0;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclpCloseDirectCopy --
+ *
+ *	Releases a TclDirectCopy.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	Closes the pipe spliced through, if any.
+ *
+ *----------------------------------------------------------------------
+ */
+
+void
+TclpCloseDirectCopy(
+    TclDirectCopy *dcPtr)
+{
+    if (dcPtr->pipeFds[0] != -1) {
+	close(dcPtr->pipeFds[0]);
+	close(dcPtr->pipeFds[1]);
+    }
+    Tcl_Free(dcPtr);
+}
+
+#else /* !HAVE_SPLICE */
+
+TclDirectCopy *
+TclpOpenDirectCopy(
+    TCL_UNUSED(Tcl_Channel),
+    TCL_UNUSED(Tcl_Channel))
+{
+    return NULL;
+}
+
+int
+TclpDirectCopy(
+    TCL_UNUSED(TclDirectCopy *),
+    TCL_UNUSED(Tcl_WideInt),
+    Tcl_WideInt *copiedPtr)
+{
+    *copiedPtr = 0;
+    return TCL_DIRECT_UNSUPPORTED;
+}
+
+size_t
+TclpDirectCopyPending(
+    TCL_UNUSED(TclDirectCopy *))
+{
+    return 0;
+}
+
+int
+TclpReadDirectCopyPending(
+    TCL_UNUSED(TclDirectCopy *),
+    TCL_UNUSED(char *))
+{
+    return 0;
+}
+
+void
+TclpCloseDirectCopy(
+    TCL_UNUSED(TclDirectCopy *))
+{
+}
+#endif /* HAVE_SPLICE */
+
 /*
  * Local Variables:
  * mode: c
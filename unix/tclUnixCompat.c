@@ -10,6 +10,7 @@
 #include "tclInt.h"
 #include <errno.h>
 #include <string.h>
+#include <sys/uio.h>
 
 /*
  * See also: SC_BLOCKING_STYLE in unix/tcl.m4
@@ -158,6 +159,74 @@ TclUnixSetBlockingMode(
     return ioctl(fd, FIONBIO, &state);
 #endif /* !USE_FIONBIO */
 }
+
+/*
+ *---------------------------------------------------------------------------
+ *
+ * TclUnixWriteV --
+ *
+ *	Write a sequence of byte runs to a file descriptor with a single
+ *	writev() call, or sendmsg() for sockets since only send and friends
+ *	report errors reliably there. Used as the guts of the scatter/gather
+ *	output procs of the file, pipe and socket channel drivers.
+ *
+ * Results:
+ *	The number of bytes written, which may be fewer than requested, or -1
+ *	with the POSIX error code stored in *errorCodePtr.
+ *
+ * Side effects:
+ *	None, beyond the output itself.
+ *
+ *---------------------------------------------------------------------------
+ */
+
+#ifndef IOV_MAX
+#   ifdef UIO_MAXIOV
+#	define IOV_MAX UIO_MAXIOV
+#   else
+#	define IOV_MAX 16	/* The POSIX minimum. */
+#   endif
+#endif
+#define WRITEV_STATIC_VECS 64
+
+int
+TclUnixWriteV(
+    int fd,			/* File descriptor to write to. */
+    int isSocket,		/* Whether fd is a socket. */
+    const Tcl_ChannelOutputVec *vecs,
+				/* The runs of bytes to write. */
+    int numVecs,		/* How many runs there are. */
+    int *errorCodePtr)		/* Where to store error code. */
+{
+    struct iovec iov[WRITEV_STATIC_VECS];
+    int i, written;
+
+    if (numVecs > WRITEV_STATIC_VECS) {
+	numVecs = WRITEV_STATIC_VECS;
+    }
+    if (numVecs > IOV_MAX) {
+	numVecs = IOV_MAX;
+    }
+    for (i = 0; i < numVecs; i++) {
+	iov[i].iov_base = (void *) vecs[i].buf;
+	iov[i].iov_len = vecs[i].toWrite;
+    }
+    if (isSocket) {
+	struct msghdr msg;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = numVecs;
+	written = sendmsg(fd, &msg, 0);
+    } else {
+	written = writev(fd, iov, numVecs);
+    }
+    if (written < 0) {
+	*errorCodePtr = errno;
+	return -1;
+    }
+    return written;
+}
 
 /*
  *---------------------------------------------------------------------------
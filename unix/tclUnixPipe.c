@@ -57,6 +57,9 @@ static int		PipeInputProc(void *instanceData, char *buf,
 			    int toRead, int *errorCode);
 static int		PipeOutputProc(void *instanceData,
 			    const char *buf, int toWrite, int *errorCode);
+static int		PipeOutputVProc(void *instanceData,
+			    const Tcl_ChannelOutputVec *vecs, int numVecs,
+			    int *errorCode);
 static void		PipeWatchProc(void *instanceData, int mask);
 static void		RestoreSignals(void);
 static int		SetupStdFile(TclFile file, int type);
@@ -68,7 +71,7 @@ static int		SetupStdFile(TclFile file, int type);
 
 static const Tcl_ChannelType pipeChannelType = {
     "pipe",			/* Type name. */
-    TCL_CHANNEL_VERSION_5,	/* v5 channel */
+    TCL_CHANNEL_VERSION_6,	/* v6 channel */
     NULL,		/* Close proc. */
     PipeInputProc,		/* Input proc. */
     PipeOutputProc,		/* Output proc. */
@@ -83,7 +86,8 @@ static const Tcl_ChannelType pipeChannelType = {
     NULL,			/* handler proc. */
     NULL,			/* wide seek proc */
     NULL,			/* thread action proc */
-    NULL			/* truncation */
+    NULL,			/* truncation */
+    PipeOutputVProc		/* scatter/gather output */
 };
 
 /*
@@ -1114,6 +1118,48 @@ PipeOutputProc(
     }
     return written;
 }
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * PipeOutputVProc--
+ *
+ *	This function is invoked from the generic IO level to write several
+ *	runs of queued output to a command pipeline based channel with one
+ *	system call.
+ *
+ * Results:
+ *	The number of bytes written is returned or -1 on error. An output
+ *	argument contains a POSIX error code if an error occurred, or zero.
+ *
+ * Side effects:
+ *	Writes output on the output device of the channel.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+PipeOutputVProc(
+    void *instanceData,		/* Pipe state. */
+    const Tcl_ChannelOutputVec *vecs,
+				/* The runs of bytes to write. */
+    int numVecs,		/* How many runs there are. */
+    int *errorCodePtr)		/* Where to store error code. */
+{
+    PipeState *psPtr = (PipeState *)instanceData;
+    int written;
+
+    /*
+     * Retry on interrupts, as PipeOutputProc does. [Bug #415131]
+     */
+
+    do {
+	*errorCodePtr = 0;
+	written = TclUnixWriteV(GetFd(psPtr->outFile), 0, vecs, numVecs,
+		errorCodePtr);
+    } while ((written < 0) && (*errorCodePtr == EINTR));
+    return written;
+}
 
 /*
  *----------------------------------------------------------------------
@@ -717,6 +717,11 @@ MODULE_SCOPE struct hostent *	TclpGetHostByAddr(const char *addr,
 MODULE_SCOPE void *TclpMakeTcpClientChannelMode(
 				    void *tcpSocket, int mode);
 
+struct Tcl_ChannelOutputVec;
+MODULE_SCOPE int		TclUnixWriteV(int fd, int isSocket,
+				    const struct Tcl_ChannelOutputVec *vecs,
+				    int numVecs, int *errorCodePtr);
+
 #endif /* _TCLUNIXPORT */
 
 /*
@@ -125,6 +125,16 @@ struct TcpState {
 
 #define SOCKET_BUFSIZE	4096
 
+/*
+ * The following defines how many pending connections TcpAccept takes from
+ * the listen queue of a server socket each time the event loop reports it
+ * readable. Taking more than one saves a trip through the notifier per
+ * connection when clients arrive in bursts; the limit keeps a flood of
+ * connections from starving other event sources.
+ */
+
+#define TCP_ACCEPT_BATCH	16
+
 /*
  * Static routines for this file:
  */
@@ -132,6 +142,7 @@ struct TcpState {
 static void		TcpAsyncCallback(void *clientData, int mask);
 static int		TcpConnect(Tcl_Interp *interp, TcpState *state);
 static void		TcpAccept(void *data, int mask);
+static void		TcpFreeState(void *blockPtr);
 static int		TcpBlockModeProc(void *data, int mode);
 static int		TcpCloseProc(void *instanceData,
 			    Tcl_Interp *interp);
@@ -146,6 +157,9 @@ static int		TcpInputProc(void *instanceData, char *buf,
 			    int toRead, int *errorCode);
 static int		TcpOutputProc(void *instanceData,
 			    const char *buf, int toWrite, int *errorCode);
+static int		TcpOutputVProc(void *instanceData,
+			    const Tcl_ChannelOutputVec *vecs, int numVecs,
+			    int *errorCode);
 static void		TcpThreadActionProc(void *instanceData, int action);
 static void		TcpWatchProc(void *instanceData, int mask);
 static int		WaitForConnect(TcpState *statePtr, int *errorCodePtr);
@@ -158,7 +172,7 @@ static void		WrapNotify(void *clientData, int mask);
 
 static const Tcl_ChannelType tcpChannelType = {
     "tcp",			/* Type name. */
-    TCL_CHANNEL_VERSION_5,	/* v5 channel */
+    TCL_CHANNEL_VERSION_6,	/* v6 channel */
     NULL,		/* Close proc. */
     TcpInputProc,		/* Input proc. */
     TcpOutputProc,		/* Output proc. */
@@ -173,7 +187,8 @@ static const Tcl_ChannelType tcpChannelType = {
     NULL,			/* handler proc. */
     NULL,			/* wide seek proc. */
     TcpThreadActionProc,	/* thread action proc. */
-    NULL			/* truncate proc. */
+    NULL,			/* truncate proc. */
+    TcpOutputVProc		/* scatter/gather output proc. */
 };
 
 /*
@@ -399,6 +414,14 @@ TcpBlockModeProc(
         statePtr->cachedBlocking = mode;
         return 0;
     }
+    if (statePtr->acceptProc != NULL) {
+        /*
+         * Server sockets stay non-blocking whatever the channel says, as
+         * TcpAccept takes connections until the listen queue is empty.
+         */
+
+        return 0;
+    }
     if (TclUnixSetBlockingMode(statePtr->fds.fd, mode) < 0) {
 	return errno;
     }
@@ -599,6 +622,42 @@ TcpOutputProc(
     *errorCodePtr = errno;
     return -1;
 }
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TcpOutputVProc --
+ *
+ *	This function is invoked by the generic IO level to write several
+ *	runs of queued output to a TCP socket based channel with one system
+ *	call.
+ *
+ * Results:
+ *	The number of bytes written is returned. An output argument is set to
+ *	a POSIX error code if an error occurred, or zero.
+ *
+ * Side effects:
+ *	Writes output on the output device of the channel.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static int
+TcpOutputVProc(
+    void *instanceData,		/* Socket state. */
+    const Tcl_ChannelOutputVec *vecs,
+				/* The runs of bytes to write. */
+    int numVecs,		/* How many runs there are. */
+    int *errorCodePtr)		/* Where to store error code. */
+{
+    TcpState *statePtr = (TcpState *)instanceData;
+
+    *errorCodePtr = 0;
+    if (WaitForConnect(statePtr, errorCodePtr) != 0) {
+	return -1;
+    }
+    return TclUnixWriteV(statePtr->fds.fd, 1, vecs, numVecs, errorCodePtr);
+}
 
 /*
  *----------------------------------------------------------------------
@@ -643,9 +702,43 @@ TcpCloseProc(
 	if (close(fds->fd) < 0) {
 	    errorCode = errno;
 	}
-
+	fds->fd = -1;
     }
-    fds = statePtr->fds.next;
+
+    /*
+     * A server socket may be closed by the accept callback while TcpAccept
+     * is still working through the listen queue; it holds a reference to the
+     * state and finds the descriptors marked as closed.
+     */
+
+    Tcl_EventuallyFree(statePtr, TcpFreeState);
+    return errorCode;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * TcpFreeState --
+ *
+ *	This function is called by Tcl_EventuallyFree when the last reference
+ *	to the state of a closed socket is released.
+ *
+ * Results:
+ *	None.
+ *
+ * Side effects:
+ *	Frees the state and the memory associated with it.
+ *
+ *----------------------------------------------------------------------
+ */
+
+static void
+TcpFreeState(
+    void *blockPtr)		/* The TcpState to free. */
+{
+    TcpState *statePtr = (TcpState *)blockPtr;
+    TcpFdList *fds = statePtr->fds.next;
+
     while (fds != NULL) {
 	TcpFdList *next = fds->next;
 
@@ -659,7 +752,6 @@ TcpCloseProc(
         freeaddrinfo(statePtr->myaddrlist);
     }
     Tcl_Free(statePtr);
-    return errorCode;
 }
 
 /*
@@ -1631,6 +1723,14 @@ Tcl_OpenTcpServerEx(
 
 	fcntl(sock, F_SETFD, FD_CLOEXEC);
 
+	/*
+	 * Make the listening socket non-blocking, so that TcpAccept can drain
+	 * the listen queue and never blocks when another process or thread
+	 * sharing the socket took the connection first.
+	 */
+
+	(void) TclUnixSetBlockingMode(sock, TCL_MODE_NONBLOCKING);
+
 	/*
 	 * Set kernel space buffering
 	 */
@@ -1786,14 +1886,15 @@ Tcl_OpenTcpServerEx(
  *----------------------------------------------------------------------
  *
  * TcpAccept --
- *	Accept a TCP socket connection.	 This is called by the event loop.
+ *	Accept TCP socket connections. This is called by the event loop.
  *
  * Results:
  *	None.
  *
  * Side effects:
- *	Creates a new connection socket. Calls the registered callback for the
- *	connection acceptance mechanism.
+ *	Creates new connection sockets for up to TCP_ACCEPT_BATCH pending
+ *	connections. Calls the registered callback for the connection
+ *	acceptance mechanism for each of them.
  *
  *----------------------------------------------------------------------
  */
@@ -1804,44 +1905,64 @@ TcpAccept(
     TCL_UNUSED(int) /*mask*/)
 {
     TcpFdList *fds = (TcpFdList *)data;	/* Client data of server socket. */
+    TcpState *statePtr = fds->statePtr;
     int newsock;		/* The new client socket */
     TcpState *newSockState;	/* State for new socket. */
     address addr;		/* The remote address */
     socklen_t len;		/* For accept interface */
     char channelName[SOCK_CHAN_LENGTH];
     char host[NI_MAXHOST], port[NI_MAXSERV];
-
-    len = sizeof(addr);
-    newsock = accept(fds->fd, &addr.sa, &len);
-    if (newsock < 0) {
-	return;
-    }
+    int count;
 
     /*
-     * Set close-on-exec flag to prevent the newly accepted socket from being
-     * inherited by child processes.
+     * The accept callback may close the server socket; keep its state alive
+     * until the loop notices that the descriptor was closed.
      */
 
-    (void) fcntl(newsock, F_SETFD, FD_CLOEXEC);
+    Tcl_Preserve(statePtr);
+    for (count = 0; count < TCP_ACCEPT_BATCH && fds->fd >= 0; count++) {
+	len = sizeof(addr);
+	newsock = accept(fds->fd, &addr.sa, &len);
+	if (newsock < 0) {
+	    break;
+	}
 
-    newSockState = (TcpState *)Tcl_Alloc(sizeof(TcpState));
-    memset(newSockState, 0, sizeof(TcpState));
-    newSockState->flags = 0;
-    newSockState->fds.fd = newsock;
+	/*
+	 * Set close-on-exec flag to prevent the newly accepted socket from
+	 * being inherited by child processes.
+	 */
 
-    sprintf(channelName, SOCK_TEMPLATE, (long) newSockState);
-    newSockState->channel = Tcl_CreateChannel(&tcpChannelType, channelName,
-	    newSockState, TCL_READABLE | TCL_WRITABLE);
+	(void) fcntl(newsock, F_SETFD, FD_CLOEXEC);
 
-    Tcl_SetChannelOption(NULL, newSockState->channel, "-translation",
-	    "auto crlf");
+#ifndef __linux__
+	/*
+	 * On BSD derived systems the new socket inherits the non-blocking
+	 * mode of the listening socket, but channels start out blocking.
+	 */
+
+	(void) TclUnixSetBlockingMode(newsock, TCL_MODE_BLOCKING);
+#endif
 
-    if (fds->statePtr->acceptProc != NULL) {
-	getnameinfo(&addr.sa, len, host, sizeof(host), port, sizeof(port),
-                NI_NUMERICHOST|NI_NUMERICSERV);
-	fds->statePtr->acceptProc(fds->statePtr->acceptProcData,
-                newSockState->channel, host, atoi(port));
+	newSockState = (TcpState *)Tcl_Alloc(sizeof(TcpState));
+	memset(newSockState, 0, sizeof(TcpState));
+	newSockState->flags = 0;
+	newSockState->fds.fd = newsock;
+
+	sprintf(channelName, SOCK_TEMPLATE, (long) newSockState);
+	newSockState->channel = Tcl_CreateChannel(&tcpChannelType,
+		channelName, newSockState, TCL_READABLE | TCL_WRITABLE);
+
+	Tcl_SetChannelOption(NULL, newSockState->channel, "-translation",
+		"auto crlf");
+
+	if (statePtr->acceptProc != NULL) {
+	    getnameinfo(&addr.sa, len, host, sizeof(host), port,
+		    sizeof(port), NI_NUMERICHOST|NI_NUMERICSERV);
+	    statePtr->acceptProc(statePtr->acceptProcData,
+		    newSockState->channel, host, atoi(port));
+	}
     }
+    Tcl_Release(statePtr);
 }
 
 /*
@@ -183,6 +183,18 @@ TestfilehandlerCmd(
 	    return TCL_ERROR;
 	}
 	pipePtr->readCount = pipePtr->writeCount = 0;
+    } else if (strcmp(Tcl_GetString(objv[1]), "closeread") == 0) {
+	if (objc != 3) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "index");
+	    return TCL_ERROR;
+	}
+
+	/*
+	 * Close the fd behind the back of the notifier, so that waiting on
+	 * it fails, until "reopen" puts a new pipe under the same fd.
+	 */
+
+	close(GetFd(pipePtr->readFile));
     } else if (strcmp(Tcl_GetString(objv[1]), "counts") == 0) {
 	char buf[TCL_INTEGER_SPACE * 2];
 
@@ -271,6 +283,26 @@ TestfilehandlerCmd(
 	Tcl_AppendResult(interp, buf, NULL);
     } else if (strcmp(Tcl_GetString(objv[1]), "oneevent") == 0) {
 	Tcl_DoOneEvent(TCL_FILE_EVENTS|TCL_DONT_WAIT);
+    } else if (strcmp(Tcl_GetString(objv[1]), "reopen") == 0) {
+	TclFile readFile, writeFile;
+
+	if (objc != 3) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "index");
+	    return TCL_ERROR;
+	}
+	if (!TclpCreatePipe(&readFile, &writeFile)) {
+	    Tcl_AppendResult(interp, "couldn't open pipe: ",
+		    Tcl_PosixError(interp), NULL);
+	    return TCL_ERROR;
+	}
+	if (readFile != pipePtr->readFile) {
+	    dup2(GetFd(readFile), GetFd(pipePtr->readFile));
+	    TclpCloseFile(readFile);
+	}
+	fcntl(GetFd(pipePtr->readFile), F_SETFL, O_NONBLOCK);
+	TclpCloseFile(pipePtr->writeFile);
+	fcntl(GetFd(writeFile), F_SETFL, O_NONBLOCK);
+	pipePtr->writeFile = writeFile;
     } else if (strcmp(Tcl_GetString(objv[1]), "wait") == 0) {
 	if (objc != 5) {
 	    Tcl_WrongNumArgs(interp, 2, objv, "index readable|writable timeout");
@@ -301,8 +333,9 @@ TestfilehandlerCmd(
 	Tcl_DoOneEvent(TCL_WINDOW_EVENTS|TCL_DONT_WAIT);
     } else {
 	Tcl_AppendResult(interp, "bad option \"", Tcl_GetString(objv[1]),
-		"\": must be close, clear, counts, create, empty, fill, "
-		"fillpartial, oneevent, wait, or windowevent", NULL);
+		"\": must be close, closeread, clear, counts, create, empty, "
+		"fill, fillpartial, oneevent, reopen, wait, or windowevent",
+		NULL);
 	return TCL_ERROR;
     }
     return TCL_OK;
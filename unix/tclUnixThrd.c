@@ -278,6 +278,36 @@ TclpThreadCreate(
 #endif /* TCL_THREADS */
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclpGetCpuCount --
+ *
+ *	This procedure returns the number of processors available to run
+ *	threads.
+ *
+ * Results:
+ *	The number of online processors; 1 if unknown or in a non-threaded
+ *	build.
+ *
+ * Side effects:
+ *	None.
+ *
+ *----------------------------------------------------------------------
+ */
+
+int
+TclpGetCpuCount(void)
+{
+#if TCL_THREADS && defined(_SC_NPROCESSORS_ONLN)
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (count > 1) ? (int) count : 1;
+#else
+    return 1;
+#endif
+}
+
 /*
  *----------------------------------------------------------------------
  *
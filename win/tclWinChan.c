@@ -102,7 +102,7 @@ static int		NativeIsComPort(const WCHAR *nativeName);
 
 static const Tcl_ChannelType fileChannelType = {
     "file",			/* Type name. */
-    TCL_CHANNEL_VERSION_5,	/* v5 channel */
+    TCL_CHANNEL_VERSION_6,	/* v6 channel */
     NULL,		/* Close proc. */
     FileInputProc,		/* Input proc. */
     FileOutputProc,		/* Output proc. */
@@ -117,7 +117,8 @@ static const Tcl_ChannelType fileChannelType = {
     NULL,			/* handler proc. */
     FileWideSeekProc,		/* Wide seek proc. */
     FileThreadActionProc,	/* Thread action proc. */
-    FileTruncateProc		/* Truncate proc. */
+    FileTruncateProc,		/* Truncate proc. */
+    NULL			/* Scatter/gather output proc. */
 };
 
 /*
@@ -1521,6 +1522,63 @@ NativeIsComPort(
     return 0;
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclpOpenDirectCopy, TclpDirectCopy, TclpDirectCopyPending,
+ * TclpReadDirectCopyPending, TclpCloseDirectCopy --
+ *
+ *	Copies between channels done by the OS are not supported on Windows;
+ *	[chan copy] always moves the bytes through the channel buffers.
+ *
+ * Results:
+ *	TclpOpenDirectCopy returns NULL.
+ *
+ * Side effects:
+ *	None.
+ *
+ *----------------------------------------------------------------------
+ */
+
+TclDirectCopy *
+TclpOpenDirectCopy(
+    TCL_UNUSED(Tcl_Channel),
+    TCL_UNUSED(Tcl_Channel))
+{
+    return NULL;
+}
+
+int
+TclpDirectCopy(
+    TCL_UNUSED(TclDirectCopy *),
+    TCL_UNUSED(Tcl_WideInt),
+    Tcl_WideInt *copiedPtr)
+{
+    *copiedPtr = 0;
+    return TCL_DIRECT_UNSUPPORTED;
+}
+
+size_t
+TclpDirectCopyPending(
+    TCL_UNUSED(TclDirectCopy *))
+{
+    return 0;
+}
+
+int
+TclpReadDirectCopyPending(
+    TCL_UNUSED(TclDirectCopy *),
+    TCL_UNUSED(char *))
+{
+    return 0;
+}
+
+void
+TclpCloseDirectCopy(
+    TCL_UNUSED(TclDirectCopy *))
+{
+}
+
 /*
  * Local Variables:
  * mode: c
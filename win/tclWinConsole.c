@@ -179,7 +179,7 @@ static BOOL		WriteConsoleBytes(HANDLE hConsole,
 
 static const Tcl_ChannelType consoleChannelType = {
     "console",			/* Type name. */
-    TCL_CHANNEL_VERSION_5,	/* v5 channel */
+    TCL_CHANNEL_VERSION_6,	/* v6 channel */
     NULL,		/* Close proc. */
     ConsoleInputProc,		/* Input proc. */
     ConsoleOutputProc,		/* Output proc. */
@@ -194,7 +194,8 @@ static const Tcl_ChannelType consoleChannelType = {
     NULL,			/* Handler proc. */
     NULL,			/* Wide seek proc. */
     ConsoleThreadActionProc,	/* Thread action proc. */
-    NULL			/* Truncation proc. */
+    NULL,			/* Truncation proc. */
+    NULL			/* Scatter/gather output proc. */
 };
 
 /*
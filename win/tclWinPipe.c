@@ -202,7 +202,7 @@ static void		PipeThreadActionProc(ClientData instanceData,
 
 static const Tcl_ChannelType pipeChannelType = {
     "pipe",			/* Type name. */
-    TCL_CHANNEL_VERSION_5,	/* v5 channel */
+    TCL_CHANNEL_VERSION_6,	/* v6 channel */
     NULL,		/* Close proc. */
     PipeInputProc,		/* Input proc. */
     PipeOutputProc,		/* Output proc. */
@@ -217,7 +217,8 @@ static const Tcl_ChannelType pipeChannelType = {
     NULL,			/* handler proc. */
     NULL,			/* wide seek proc */
     PipeThreadActionProc,	/* thread action proc */
-    NULL			/* truncate */
+    NULL,			/* truncate */
+    NULL			/* scatter/gather output proc. */
 };
 
 /*
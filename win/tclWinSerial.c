@@ -203,7 +203,7 @@ static int		SerialBlockingWrite(SerialInfo *infoPtr, LPVOID buf,
 
 static const Tcl_ChannelType serialChannelType = {
     "serial",			/* Type name. */
-    TCL_CHANNEL_VERSION_5,	/* v5 channel */
+    TCL_CHANNEL_VERSION_6,	/* v6 channel */
     NULL,		/* Close proc. */
     SerialInputProc,		/* Input proc. */
     SerialOutputProc,		/* Output proc. */
@@ -218,7 +218,8 @@ static const Tcl_ChannelType serialChannelType = {
     NULL,			/* handler proc. */
     NULL,			/* wide seek proc */
     SerialThreadActionProc,	/* thread action proc */
-    NULL                       /* truncate */
+    NULL,                      /* truncate */
+    NULL			/* scatter/gather output proc. */
 };
 
 /*
@@ -279,7 +279,7 @@ static Tcl_DriverGetHandleProc	TcpGetHandleProc;
 
 static const Tcl_ChannelType tcpChannelType = {
     "tcp",			/* Type name. */
-    TCL_CHANNEL_VERSION_5,	/* v5 channel */
+    TCL_CHANNEL_VERSION_6,	/* v6 channel */
     NULL,		/* Close proc. */
     TcpInputProc,		/* Input proc. */
     TcpOutputProc,		/* Output proc. */
@@ -294,7 +294,8 @@ static const Tcl_ChannelType tcpChannelType = {
     NULL,			/* handler proc. */
     NULL,			/* wide seek proc. */
     TcpThreadActionProc,	/* thread action proc. */
-    NULL			/* truncate proc. */
+    NULL,			/* truncate proc. */
+    NULL			/* scatter/gather output proc. */
 };
 
 /*
@@ -250,6 +250,37 @@ TclpThreadCreate(
     }
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * TclpGetCpuCount --
+ *
+ *	This procedure returns the number of processors available to run
+ *	threads.
+ *
+ * Results:
+ *	The number of processors; 1 in a non-threaded build.
+ *
+ * Side effects:
+ *	None.
+ *
+ *----------------------------------------------------------------------
+ */
+
+int
+TclpGetCpuCount(void)
+{
+#if TCL_THREADS
+    SYSTEM_INFO systemInfo;
+
+    GetSystemInfo(&systemInfo);
+    return (systemInfo.dwNumberOfProcessors > 1)
+	    ? (int) systemInfo.dwNumberOfProcessors : 1;
+#else
+    return 1;
+#endif
+}
+
 /*
  *----------------------------------------------------------------------
  *